@@ -0,0 +1,418 @@
+#pragma once
+
+
+#include "ObjectRegistry.h"
+#include "VulkanHelpers.h"
+#include "VulkanLoading.h"
+
+#include <array>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+#include <cstddef>
+#include <cstdint>
+
+
+/// @brief Hands out the slots [0, capacity) of a descriptor array, from a lock-free free-list.
+/// The list is a stack threaded through the free slots, its head tagged with a counter
+/// so that a slot popped and pushed back meanwhile does not fool a concurrent pop (ABA).
+class DescriptorSlotAllocator
+{
+public:
+    static constexpr uint32_t gNoSlot = std::numeric_limits<uint32_t>::max();
+
+    explicit DescriptorSlotAllocator(uint32_t aCapacity) :
+        mNext{std::make_unique<std::atomic<uint32_t>[]>(aCapacity)}
+    {
+        for(uint32_t slot = 0; slot != aCapacity; ++slot)
+        {
+            mNext[slot].store(slot + 1 == aCapacity ? gNoSlot : slot + 1, std::memory_order_relaxed);
+        }
+        mHead.store(aCapacity == 0 ? gNoSlot : 0, std::memory_order_release);
+    }
+
+    /// @return A free slot, or gNoSlot when all are in use.
+    /// @note Thread safe.
+    uint32_t acquire()
+    {
+        uint64_t head = mHead.load(std::memory_order_acquire);
+        while(true)
+        {
+            const uint32_t slot = (uint32_t)head;
+            if(slot == gNoSlot)
+            {
+                return gNoSlot;
+            }
+            // Possibly stale if the slot was popped meanwhile, in which case the tag changed and the exchange fails
+            const uint32_t next = mNext[slot].load(std::memory_order_relaxed);
+            if(mHead.compare_exchange_weak(head, retag(head, next), std::memory_order_acquire, std::memory_order_acquire))
+            {
+                return slot;
+            }
+        }
+    }
+
+    /// @note Thread safe.
+    void release(uint32_t aSlot)
+    {
+        uint64_t head = mHead.load(std::memory_order_relaxed);
+        do
+        {
+            mNext[aSlot].store((uint32_t)head, std::memory_order_relaxed);
+        }
+        while(!mHead.compare_exchange_weak(head, retag(head, aSlot), std::memory_order_release, std::memory_order_relaxed));
+    }
+
+private:
+    /// @brief The head pointing to aSlot, with the tag of aHead incremented.
+    static uint64_t retag(uint64_t aHead, uint32_t aSlot)
+    {
+        return ((aHead >> 32) + 1) << 32 | aSlot;
+    }
+
+    // Low 32 bits: the first free slot, high 32 bits: the tag
+    std::atomic<uint64_t> mHead;
+    // The free slot following each free slot
+    std::unique_ptr<std::atomic<uint32_t>[]> mNext;
+};
+
+
+/// @brief The descriptor set of the bindless resources (see gBindlessBindings):
+/// resources are registered once, then addressed by their slot (pushed as constants) from any bindless shader.
+/// The set is bound once per command buffer, draws never bind descriptors.
+///
+/// The descriptors live either in a descriptor set, or in a mapped descriptor buffer (see BindlessBackend):
+/// the buffer backend writes each descriptor straight to its memory with vkGetDescriptorEXT(), without pool or set.
+///
+/// Registering and removing resources is thread safe: the slots come from lock-free free-lists.
+/// The descriptor set writes are serialized (the set must be externally synchronized),
+/// while the descriptor buffer writes are independent (each slot is its own range of memory).
+/// @note A slot can be removed (and reused) once the commands using it completed, which is the next frame here
+/// (frames do not overlap). Other slots can be written while the set or buffer is in use.
+class BindlessHeap
+{
+public:
+    /// @param aBackend The descriptor buffer backend requires VK_EXT_descriptor_buffer (see createDevice()),
+    /// its buffer is allocated from aHostVisibleMemoryTypeIndex (host visible and coherent).
+    /// @throw std::runtime_error if the device limits cannot hold the bindless arrays.
+    /// @note The device must be created with descriptor indexing (see createDevice()).
+    BindlessHeap(VkDevice vkDevice,
+                 VkPhysicalDevice vkPhysicalDevice,
+                 ObjectRegistry & aRegistry,
+                 BindlessBackend aBackend = BindlessBackend::DescriptorSets,
+                 uint32_t aHostVisibleMemoryTypeIndex = 0) :
+        vkDevice{vkDevice},
+        mRegistry{aRegistry},
+        mBackend{aBackend},
+        mSampledImages{gBindlessBindings[gBindlessSampledImageBinding].descriptorCount},
+        mStorageBuffers{gBindlessBindings[gBindlessStorageBufferBinding].descriptorCount},
+        mSamplers{gBindlessBindings[gBindlessSamplerBinding].descriptorCount}
+    {
+        VkPhysicalDeviceDescriptorBufferPropertiesEXT descriptorBufferProperties{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_PROPERTIES_EXT,
+        };
+        VkPhysicalDeviceVulkan12Properties vulkan12Properties{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES,
+            .pNext = mBackend == BindlessBackend::DescriptorBuffer ? &descriptorBufferProperties : nullptr,
+        };
+        VkPhysicalDeviceProperties2 properties{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+            .pNext = &vulkan12Properties,
+        };
+        vkGetPhysicalDeviceProperties2(vkPhysicalDevice, &properties);
+        // The stage limits apply to each stage of the set (all of them).
+        // Update after bind sets have their own limits, descriptor buffers are subject to the regular ones.
+        const VkPhysicalDeviceLimits & limits = properties.properties.limits;
+        const bool supported = mBackend == BindlessBackend::DescriptorSets
+            ? fitsBindings(std::min(vulkan12Properties.maxDescriptorSetUpdateAfterBindSampledImages,
+                                    vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSampledImages),
+                           std::min(vulkan12Properties.maxDescriptorSetUpdateAfterBindStorageBuffers,
+                                    vulkan12Properties.maxPerStageDescriptorUpdateAfterBindStorageBuffers),
+                           std::min(vulkan12Properties.maxDescriptorSetUpdateAfterBindSamplers,
+                                    vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSamplers))
+            : fitsBindings(std::min(limits.maxDescriptorSetSampledImages, limits.maxPerStageDescriptorSampledImages),
+                           std::min(limits.maxDescriptorSetStorageBuffers, limits.maxPerStageDescriptorStorageBuffers),
+                           std::min(limits.maxDescriptorSetSamplers, limits.maxPerStageDescriptorSamplers));
+        // All the arrays are visible to all the stages: each stage accesses all their resources
+        const uint32_t perStageResources = mBackend == BindlessBackend::DescriptorSets
+            ? vulkan12Properties.maxPerStageUpdateAfterBindResources
+            : limits.maxPerStageResources;
+        if(!supported || gPerStageResources > perStageResources)
+        {
+            throw std::runtime_error{"The device cannot hold the bindless descriptor arrays."};
+        }
+
+        // Acquired from the registry: the same handles as the layouts reflected from bindless shaders
+        mSetLayout = mRegistry.acquireDescriptorSetLayout(getBindlessSetLayoutCreateInfo(mBackend));
+        VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+            .setLayoutCount = 1,
+            .pSetLayouts = &mSetLayout,
+            .pushConstantRangeCount = 1,
+            .pPushConstantRanges = &gBindlessPushConstantRange,
+        };
+        static_assert(gBindlessSet == 0);
+        mPipelineLayout = mRegistry.acquirePipelineLayout(pipelineLayoutCreateInfo);
+
+        if(mBackend == BindlessBackend::DescriptorBuffer)
+        {
+            createDescriptorBuffer(descriptorBufferProperties, aHostVisibleMemoryTypeIndex);
+        }
+        else
+        {
+            createDescriptorSet();
+        }
+    }
+
+    BindlessHeap(const BindlessHeap &) = delete;
+    BindlessHeap & operator=(const BindlessHeap &) = delete;
+
+    /// @brief Frees the set or buffer, which must not be in use anymore.
+    void destroy()
+    {
+        if(mBackend == BindlessBackend::DescriptorBuffer)
+        {
+            vkFreeMemory(vkDevice, mBuffer.second, pAllocator);
+            vkDestroyBuffer(vkDevice, mBuffer.first, pAllocator);
+        }
+        else
+        {
+            vkDestroyDescriptorPool(vkDevice, mPool, pAllocator);
+        }
+        mRegistry.release(mPipelineLayout);
+        mRegistry.release(mSetLayout);
+    }
+
+    BindlessBackend getBackend() const
+    {
+        return mBackend;
+    }
+
+    /// @return The slot of aView in the sampled images array.
+    /// @throw std::length_error if all the slots are in use.
+    uint32_t addSampledImage(VkImageView aView, VkImageLayout aLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+    {
+        const VkDescriptorImageInfo imageInfo{.imageView = aView, .imageLayout = aLayout};
+        return add(mSampledImages, gBindlessSampledImageBinding,
+                   VkWriteDescriptorSet{.pImageInfo = &imageInfo}, VkDescriptorDataEXT{.pSampledImage = &imageInfo});
+    }
+
+    /// @return The slot of the buffer range in the storage buffers array.
+    /// @throw std::length_error if all the slots are in use.
+    /// @note With the descriptor buffer backend, descriptors hold an address and a size: the buffer must be created with
+    /// VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT, and aRange must be explicit (std::invalid_argument otherwise).
+    uint32_t addStorageBuffer(VkBuffer aBuffer, VkDeviceSize aOffset = 0, VkDeviceSize aRange = VK_WHOLE_SIZE)
+    {
+        const VkDescriptorBufferInfo bufferInfo{.buffer = aBuffer, .offset = aOffset, .range = aRange};
+        VkDescriptorAddressInfoEXT addressInfo{
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_ADDRESS_INFO_EXT,
+            .range = aRange,
+        };
+        if(mBackend == BindlessBackend::DescriptorBuffer)
+        {
+            if(aRange == VK_WHOLE_SIZE)
+            {
+                throw std::invalid_argument{"Descriptor buffers require the explicit range of storage buffers."};
+            }
+            addressInfo.address = getBufferDeviceAddress(vkDevice, aBuffer) + aOffset;
+        }
+        return add(mStorageBuffers, gBindlessStorageBufferBinding,
+                   VkWriteDescriptorSet{.pBufferInfo = &bufferInfo}, VkDescriptorDataEXT{.pStorageBuffer = &addressInfo});
+    }
+
+    /// @return The slot of aSampler in the samplers array.
+    /// @throw std::length_error if all the slots are in use.
+    uint32_t addSampler(VkSampler aSampler)
+    {
+        const VkDescriptorImageInfo imageInfo{.sampler = aSampler};
+        return add(mSamplers, gBindlessSamplerBinding,
+                   VkWriteDescriptorSet{.pImageInfo = &imageInfo}, VkDescriptorDataEXT{.pSampler = &aSampler});
+    }
+
+    // The descriptors are left as is: partially bound, they are not accessed until the slot is reused.
+    void removeSampledImage(uint32_t aSlot)
+    {
+        mSampledImages.release(aSlot);
+    }
+
+    void removeStorageBuffer(uint32_t aSlot)
+    {
+        mStorageBuffers.release(aSlot);
+    }
+
+    void removeSampler(uint32_t aSlot)
+    {
+        mSamplers.release(aSlot);
+    }
+
+    /// @brief Binds the set (or the descriptor buffer) for all the following bindless pipelines or shader objects of aBindPoint.
+    /// @note The descriptor buffer binding replaces all the descriptor buffers bound to the command buffer.
+    void bind(VkCommandBuffer vkCommandBuffer, VkPipelineBindPoint aBindPoint) const
+    {
+        if(mBackend == BindlessBackend::DescriptorBuffer)
+        {
+            const VkDescriptorBufferBindingInfoEXT descriptorBufferBindingInfo{
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT,
+                .address = mBufferAddress,
+                .usage = gDescriptorBufferUsage,
+            };
+            vkCmdBindDescriptorBuffersEXT(vkCommandBuffer, 1, &descriptorBufferBindingInfo);
+            const uint32_t bufferIndex = 0;
+            const VkDeviceSize offset = 0;
+            vkCmdSetDescriptorBufferOffsetsEXT(vkCommandBuffer, aBindPoint, mPipelineLayout, gBindlessSet, 1,
+                                               &bufferIndex, &offset);
+        }
+        else
+        {
+            vkCmdBindDescriptorSets(vkCommandBuffer, aBindPoint, mPipelineLayout, gBindlessSet, 1, &mSet, 0, nullptr);
+        }
+    }
+
+    /// @brief The layout to push the constants of bindless shaders with (using gBindlessPushConstantRange).
+    VkPipelineLayout getPipelineLayout() const
+    {
+        return mPipelineLayout;
+    }
+
+    VkDescriptorSetLayout getSetLayout() const
+    {
+        return mSetLayout;
+    }
+
+private:
+    // Mixing samplers and resources in the set, the buffer must be suitable for both
+    static constexpr VkBufferUsageFlags gDescriptorBufferUsage = VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT
+                                                                 | VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT
+                                                                 | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+
+    // Samplers do not count against the per stage resource limits
+    static constexpr uint32_t gPerStageResources = gBindlessBindings[gBindlessSampledImageBinding].descriptorCount
+                                                   + gBindlessBindings[gBindlessStorageBufferBinding].descriptorCount;
+
+    static bool fitsBindings(uint32_t aSampledImages, uint32_t aStorageBuffers, uint32_t aSamplers)
+    {
+        return gBindlessBindings[gBindlessSampledImageBinding].descriptorCount <= aSampledImages
+               && gBindlessBindings[gBindlessStorageBufferBinding].descriptorCount <= aStorageBuffers
+               && gBindlessBindings[gBindlessSamplerBinding].descriptorCount <= aSamplers;
+    }
+
+    void createDescriptorSet()
+    {
+        std::array<VkDescriptorPoolSize, gBindlessBindings.size()> poolSizes;
+        for(std::size_t bindingIdx = 0; bindingIdx != gBindlessBindings.size(); ++bindingIdx)
+        {
+            poolSizes[bindingIdx] = {
+                .type = gBindlessBindings[bindingIdx].descriptorType,
+                .descriptorCount = gBindlessBindings[bindingIdx].descriptorCount,
+            };
+        }
+        VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+            .flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+            .maxSets = 1,
+            .poolSizeCount = (uint32_t)poolSizes.size(),
+            .pPoolSizes = poolSizes.data(),
+        };
+        assertVkSuccess(vkCreateDescriptorPool(vkDevice, &descriptorPoolCreateInfo, pAllocator, &mPool));
+
+        VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+            .descriptorPool = mPool,
+            .descriptorSetCount = 1,
+            .pSetLayouts = &mSetLayout,
+        };
+        assertVkSuccess(vkAllocateDescriptorSets(vkDevice, &descriptorSetAllocateInfo, &mSet));
+        nameObject(vkDevice, mSet, "bindless_set");
+    }
+
+    /// @throw std::runtime_error if the set exceeds the range addressable by descriptor buffers.
+    void createDescriptorBuffer(const VkPhysicalDeviceDescriptorBufferPropertiesEXT & aProperties,
+                                uint32_t aHostVisibleMemoryTypeIndex)
+    {
+        VkDeviceSize layoutSize;
+        vkGetDescriptorSetLayoutSizeEXT(vkDevice, mSetLayout, &layoutSize);
+        if(layoutSize > std::min(aProperties.maxResourceDescriptorBufferRange, aProperties.maxSamplerDescriptorBufferRange))
+        {
+            throw std::runtime_error{"The bindless descriptor arrays exceed the descriptor buffer range."};
+        }
+
+        // Array elements are tightly packed from the offset of their binding
+        mDescriptorSizes[gBindlessSampledImageBinding] = aProperties.sampledImageDescriptorSize;
+        mDescriptorSizes[gBindlessStorageBufferBinding] = aProperties.storageBufferDescriptorSize;
+        mDescriptorSizes[gBindlessSamplerBinding] = aProperties.samplerDescriptorSize;
+        for(const VkDescriptorSetLayoutBinding & binding : gBindlessBindings)
+        {
+            vkGetDescriptorSetLayoutBindingOffsetEXT(vkDevice, mSetLayout, binding.binding, &mBindingOffsets[binding.binding]);
+        }
+
+        // Written by the host, read by the device: persistently mapped, coherent
+        mBuffer = createBuffer(vkDevice, layoutSize, gDescriptorBufferUsage, aHostVisibleMemoryTypeIndex,
+                               VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT);
+        nameObject(vkDevice, mBuffer.first, "bindless_descriptor_buffer");
+        void * mapping;
+        assertVkSuccess(vkMapMemory(vkDevice, mBuffer.second, 0, VK_WHOLE_SIZE, 0, &mapping));
+        mMapping = static_cast<std::byte *>(mapping);
+        mBufferAddress = getBufferDeviceAddress(vkDevice, mBuffer.first);
+    }
+
+    uint32_t add(DescriptorSlotAllocator & aAllocator, uint32_t aBinding, VkWriteDescriptorSet aWrite, VkDescriptorDataEXT aData)
+    {
+        const uint32_t slot = aAllocator.acquire();
+        if(slot == DescriptorSlotAllocator::gNoSlot)
+        {
+            throw std::length_error{"No free slot in the bindless descriptor array."};
+        }
+
+        if(mBackend == BindlessBackend::DescriptorBuffer)
+        {
+            const VkDescriptorGetInfoEXT descriptorGetInfo{
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT,
+                .type = gBindlessBindings[aBinding].descriptorType,
+                .data = aData,
+            };
+            const std::size_t size = mDescriptorSizes[aBinding];
+            vkGetDescriptorEXT(vkDevice, &descriptorGetInfo, size, mMapping + mBindingOffsets[aBinding] + slot * size);
+            return slot;
+        }
+
+        aWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        aWrite.dstSet = mSet;
+        aWrite.dstBinding = aBinding;
+        aWrite.dstArrayElement = slot;
+        aWrite.descriptorCount = 1;
+        aWrite.descriptorType = gBindlessBindings[aBinding].descriptorType;
+        {
+            std::lock_guard lock{mWriteMutex};
+            vkUpdateDescriptorSets(vkDevice, 1, &aWrite, 0, nullptr);
+        }
+        return slot;
+    }
+
+    VkDevice vkDevice; // required for Dtor
+    ObjectRegistry & mRegistry;
+    const BindlessBackend mBackend;
+
+    VkDescriptorSetLayout mSetLayout;
+    VkPipelineLayout mPipelineLayout;
+
+    // Descriptor sets backend
+    VkDescriptorPool mPool{VK_NULL_HANDLE};
+    VkDescriptorSet mSet{VK_NULL_HANDLE};
+    std::mutex mWriteMutex;
+
+    // Descriptor buffer backend, indexed by binding
+    std::pair<VkBuffer, VkDeviceMemory> mBuffer{VK_NULL_HANDLE, VK_NULL_HANDLE};
+    std::byte * mMapping{nullptr};
+    VkDeviceAddress mBufferAddress{0};
+    std::array<VkDeviceSize, gBindlessBindings.size()> mBindingOffsets{};
+    std::array<std::size_t, gBindlessBindings.size()> mDescriptorSizes{};
+
+    // One per binding
+    DescriptorSlotAllocator mSampledImages;
+    DescriptorSlotAllocator mStorageBuffers;
+    DescriptorSlotAllocator mSamplers;
+};
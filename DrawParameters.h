@@ -0,0 +1,205 @@
+#pragma once
+
+
+#include "VulkanHelpers.h"
+#include "VulkanLoading.h"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+
+// Per-draw parameters: each draw passes its own data to the shaders, without re-recording vertex data nor binding descriptors.
+// * Parameters fitting in gMaxPushedParameterSize are pushed as constants, recorded straight into the command buffer.
+// * Larger ones are written into the frame's segment of a FrameParameterRing, and only their device address is pushed:
+//   the shader declares a buffer_reference to the parameters as its push constant block.
+// The shaders read them the same way from the pipelines and the shader objects, which share the layout (see ReflectedLayout).
+
+
+/// @brief The guaranteed minimum of maxPushConstantsSize.
+constexpr std::size_t gMaxPushedParameterSize = 128;
+
+/// @brief Whether the parameters T_parameters are pushed, otherwise the shaders receive their address.
+template <class T_parameters>
+constexpr bool isPushedParameter()
+{
+    return sizeof(T_parameters) <= gMaxPushedParameterSize;
+}
+
+
+/// @brief Linear allocator of the parameters of a frame, in a persistently mapped buffer split in one segment per frame in flight.
+/// The allocations are usable as buffer references (device address), or as dynamic uniform and storage buffer offsets.
+class FrameParameterRing
+{
+public:
+    // The upper bound of minUniformBufferOffsetAlignment and minStorageBufferOffsetAlignment
+    static constexpr VkDeviceSize gMaxAlignment = 256;
+
+    struct Allocation
+    {
+        std::byte * mData;
+        VkDeviceAddress mAddress;
+        // From the start of the buffer
+        uint32_t mOffset;
+    };
+
+    /// @param aFrameCapacity The bytes available to the allocations of a frame.
+    /// @param aFrameCount The frames in flight, a segment is only reused once its frame completed.
+    /// @param aHostVisibleMemoryTypeIndex Host visible and coherent memory.
+    /// @note The device must be created with bufferDeviceAddress.
+    FrameParameterRing(VkDevice vkDevice,
+                       VkPhysicalDevice vkPhysicalDevice,
+                       VkDeviceSize aFrameCapacity,
+                       uint32_t aFrameCount,
+                       uint32_t aHostVisibleMemoryTypeIndex) :
+        vkDevice{vkDevice},
+        mFrameCount{aFrameCount}
+    {
+        // Offsets satisfy both dynamic descriptor types, and the alignment of vec4 and matrix members
+        VkPhysicalDeviceProperties2 properties{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+        };
+        vkGetPhysicalDeviceProperties2(vkPhysicalDevice, &properties);
+        const VkPhysicalDeviceLimits & limits = properties.properties.limits;
+        mAlignment = std::max({limits.minUniformBufferOffsetAlignment,
+                               limits.minStorageBufferOffsetAlignment,
+                               VkDeviceSize{16}});
+        mFrameCapacity = align(aFrameCapacity);
+
+        mBuffer = createBuffer(vkDevice,
+                               mFrameCapacity * mFrameCount,
+                               VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+                               | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                               aHostVisibleMemoryTypeIndex,
+                               VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT);
+        nameObject(vkDevice, mBuffer.first, "frame_parameter_ring");
+        void * mapping;
+        assertVkSuccess(vkMapMemory(vkDevice, mBuffer.second, 0, VK_WHOLE_SIZE, 0, &mapping));
+        mMapping = static_cast<std::byte *>(mapping);
+        mBufferAddress = getBufferDeviceAddress(vkDevice, mBuffer.first);
+    }
+
+    /// @return The frame capacity guaranteed to hold an allocation of aSize bytes, whatever the device alignment.
+    static constexpr VkDeviceSize getCapacityFor(std::size_t aSize)
+    {
+        return (aSize + gMaxAlignment - 1) / gMaxAlignment * gMaxAlignment;
+    }
+
+    FrameParameterRing(const FrameParameterRing &) = delete;
+    FrameParameterRing & operator=(const FrameParameterRing &) = delete;
+
+    /// @brief Frees the buffer, which must not be in use anymore.
+    void destroy()
+    {
+        vkFreeMemory(vkDevice, mBuffer.second, pAllocator);
+        vkDestroyBuffer(vkDevice, mBuffer.first, pAllocator);
+    }
+
+    /// @brief Moves to the segment of the next frame, discarding its previous allocations.
+    /// @note The frame which last used this segment must have completed.
+    void beginFrame()
+    {
+        mFrame = (mFrame + 1) % mFrameCount;
+        mFrameOffset.store(0, std::memory_order_relaxed);
+    }
+
+    /// @brief Sub-allocates aSize bytes in the current frame's segment.
+    /// The host writes through mData are visible to the device once the frame is submitted (coherent memory).
+    /// @throw std::length_error if the segment is full.
+    /// @note Thread safe, but not concurrently with beginFrame().
+    Allocation allocate(std::size_t aSize)
+    {
+        const VkDeviceSize size = align(aSize);
+        const VkDeviceSize offset = mFrameOffset.fetch_add(size, std::memory_order_relaxed);
+        if(offset + size > mFrameCapacity)
+        {
+            throw std::length_error{"The frame parameter ring is full."};
+        }
+
+        const VkDeviceSize bufferOffset = mFrame * mFrameCapacity + offset;
+        return Allocation{
+            .mData = mMapping + bufferOffset,
+            .mAddress = mBufferAddress + bufferOffset,
+            .mOffset = (uint32_t)bufferOffset,
+        };
+    }
+
+    VkBuffer getBuffer() const
+    {
+        return mBuffer.first;
+    }
+
+private:
+    VkDeviceSize align(VkDeviceSize aSize) const
+    {
+        return (aSize + mAlignment - 1) / mAlignment * mAlignment;
+    }
+
+    VkDevice vkDevice; // required for Dtor
+    std::pair<VkBuffer, VkDeviceMemory> mBuffer;
+    std::byte * mMapping;
+    VkDeviceAddress mBufferAddress;
+
+    VkDeviceSize mAlignment;
+    VkDeviceSize mFrameCapacity;
+    const uint32_t mFrameCount;
+    uint32_t mFrame{0};
+    std::atomic<VkDeviceSize> mFrameOffset{0};
+};
+
+
+/// @brief Sets the parameters of the next draws, through the push constants of a pipeline layout.
+/// The layout is compatible with the pipelines and shader objects created from the same shaders (see ReflectedLayout).
+class DrawParameterBinder
+{
+public:
+    /// @param aRing Required to set parameters which are not pushed.
+    DrawParameterBinder(const ReflectedLayout & aLayout, FrameParameterRing * aRing = nullptr) :
+        mPipelineLayout{aLayout.mPipelineLayout},
+        mRing{aRing}
+    {
+        // Reflection merges the push constants of all the stages in a single range
+        if(!aLayout.mPushConstantRanges.empty())
+        {
+            mPushConstantRange = aLayout.mPushConstantRanges.front();
+        }
+    }
+
+    /// @brief Pushes aParameters, or their address in the frame's ring if they do not fit in the push constants.
+    /// @note The ring allocation is valid until the ring moves to the next frame.
+    template <class T_parameters>
+    void set(VkCommandBuffer vkCommandBuffer, const T_parameters & aParameters) const
+    {
+        static_assert(std::is_trivially_copyable_v<T_parameters>, "Parameters are copied bytewise to the device.");
+
+        if constexpr(isPushedParameter<T_parameters>())
+        {
+            push(vkCommandBuffer, &aParameters, sizeof(T_parameters));
+        }
+        else
+        {
+            assert(mRing != nullptr);
+            const FrameParameterRing::Allocation allocation = mRing->allocate(sizeof(T_parameters));
+            std::memcpy(allocation.mData, &aParameters, sizeof(T_parameters));
+            push(vkCommandBuffer, &allocation.mAddress, sizeof(allocation.mAddress));
+        }
+    }
+
+private:
+    void push(VkCommandBuffer vkCommandBuffer, const void * aData, std::size_t aSize) const
+    {
+        assert(mPushConstantRange.offset == 0 && aSize <= mPushConstantRange.size);
+        vkCmdPushConstants(vkCommandBuffer, mPipelineLayout, mPushConstantRange.stageFlags, 0, (uint32_t)aSize, aData);
+    }
+
+    VkPipelineLayout mPipelineLayout;
+    VkPushConstantRange mPushConstantRange{};
+    FrameParameterRing * mRing;
+};
@@ -0,0 +1,201 @@
+#pragma once
+
+
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <functional>
+#include <span>
+#include <vector>
+
+#include <cassert>
+#include <cstdint>
+
+
+/// @brief The layout of the 64-bit draw sort keys, most significant first:
+/// the draws are grouped by pass, then by pipeline (or set of shader objects), then by material,
+/// and ordered by depth within a material. Binds are only needed where the corresponding prefix of the key changes.
+namespace drawkey {
+
+    constexpr uint32_t gPassBits = 4;
+    constexpr uint32_t gPipelineBits = 12;
+    constexpr uint32_t gMaterialBits = 16;
+    constexpr uint32_t gDepthBits = 32;
+
+    constexpr uint32_t gDepthShift = 0;
+    constexpr uint32_t gMaterialShift = gDepthShift + gDepthBits;
+    constexpr uint32_t gPipelineShift = gMaterialShift + gMaterialBits;
+    constexpr uint32_t gPassShift = gPipelineShift + gPipelineBits;
+    static_assert(gPassShift + gPassBits == 64);
+
+    /// @param aPass, aPipeline, aMaterial Must fit in gPassBits, gPipelineBits and gMaterialBits.
+    /// @param aDepth Distance to the camera (non-negative, e.g. the view depth or the clip space z),
+    /// whose float bits order as unsigned integers.
+    /// @param aBackToFront Reverses the depth order, e.g. for blended draws.
+    constexpr uint64_t make(uint32_t aPass, uint32_t aPipeline, uint32_t aMaterial, float aDepth, bool aBackToFront = false)
+    {
+        // A wider value would overflow into the field above it
+        assert(aPass < (1u << gPassBits));
+        assert(aPipeline < (1u << gPipelineBits));
+        assert(aMaterial < (1u << gMaterialBits));
+        const uint32_t depth = std::bit_cast<uint32_t>(std::max(aDepth, 0.f));
+        return uint64_t{aPass} << gPassShift
+               | uint64_t{aPipeline} << gPipelineShift
+               | uint64_t{aMaterial} << gMaterialShift
+               | uint64_t{aBackToFront ? ~depth : depth} << gDepthShift;
+    }
+
+    constexpr uint32_t getPass(uint64_t aKey)
+    {
+        return (uint32_t)(aKey >> gPassShift);
+    }
+
+    constexpr uint32_t getPipeline(uint64_t aKey)
+    {
+        return (uint32_t)(aKey >> gPipelineShift) & ((1u << gPipelineBits) - 1);
+    }
+
+    constexpr uint32_t getMaterial(uint64_t aKey)
+    {
+        return (uint32_t)(aKey >> gMaterialShift) & ((1u << gMaterialBits) - 1);
+    }
+
+} // namespace drawkey
+
+
+/// @brief A draw to sort, identified by the index of its data (e.g. its draw record).
+struct SortedDraw
+{
+    uint64_t mKey;
+    uint32_t mDrawIdx;
+};
+
+
+namespace drawsort {
+
+    // Draws per job: large enough to amortize the job overhead, small enough to balance the threads
+    constexpr std::size_t gJobDrawCount = 16 * 1024;
+
+    constexpr std::size_t gRadixBits = 8;
+    constexpr std::size_t gBucketCount = std::size_t{1} << gRadixBits;
+    using Histogram = std::array<uint32_t, gBucketCount>;
+
+    /// @brief Sorts aDraws by key, stable, with a least significant digit radix sort (8 bits per pass).
+    /// Each pass counts the digits of job ranges in parallel, then each job scatters its range at the offsets
+    /// of its buckets. Passes where all the draws share the same digit (e.g. a single pass or pipeline) are skipped.
+    /// @param aScratch Resized to the size of aDraws, kept by the caller to avoid an allocation per sort.
+    inline void sort(std::span<SortedDraw> aDraws, std::vector<SortedDraw> & aScratch, WorkerPool & aWorkers)
+    {
+        const std::size_t drawCount = aDraws.size();
+        const std::size_t jobCount = std::max<std::size_t>(1, (drawCount + gJobDrawCount - 1) / gJobDrawCount);
+        aScratch.resize(drawCount);
+        std::vector<Histogram> offsets(jobCount);
+
+        // Runs small sorts on the calling thread
+        auto forEachJob = [&](const std::function<void(std::size_t)> & aJob)
+        {
+            if(jobCount == 1)
+            {
+                aJob(0);
+            }
+            else
+            {
+                parallelFor(aWorkers, jobCount, aJob);
+            }
+        };
+
+        SortedDraw * source = aDraws.data();
+        SortedDraw * destination = aScratch.data();
+        for(std::size_t shift = 0; shift != 64; shift += gRadixBits)
+        {
+            forEachJob([&](std::size_t aJobIdx)
+            {
+                Histogram & histogram = offsets[aJobIdx];
+                histogram.fill(0);
+                const std::size_t end = std::min(drawCount, (aJobIdx + 1) * gJobDrawCount);
+                for(std::size_t drawIdx = aJobIdx * gJobDrawCount; drawIdx != end; ++drawIdx)
+                {
+                    ++histogram[(source[drawIdx].mKey >> shift) & (gBucketCount - 1)];
+                }
+            });
+
+            // Turn the counts into the offset of each job in each bucket (buckets first, jobs in order for stability)
+            uint32_t offset = 0;
+            bool skipPass = false;
+            for(std::size_t bucket = 0; bucket != gBucketCount && !skipPass; ++bucket)
+            {
+                const uint32_t bucketStart = offset;
+                for(Histogram & histogram : offsets)
+                {
+                    const uint32_t count = histogram[bucket];
+                    histogram[bucket] = offset;
+                    offset += count;
+                }
+                skipPass = bucketStart == 0 && offset == drawCount;
+            }
+            if(skipPass)
+            {
+                continue;
+            }
+
+            forEachJob([&](std::size_t aJobIdx)
+            {
+                Histogram & histogram = offsets[aJobIdx];
+                const std::size_t end = std::min(drawCount, (aJobIdx + 1) * gJobDrawCount);
+                for(std::size_t drawIdx = aJobIdx * gJobDrawCount; drawIdx != end; ++drawIdx)
+                {
+                    destination[histogram[(source[drawIdx].mKey >> shift) & (gBucketCount - 1)]++] = source[drawIdx];
+                }
+            });
+            std::swap(source, destination);
+        }
+
+        if(source != aDraws.data())
+        {
+            std::copy(source, source + drawCount, aDraws.data());
+        }
+    }
+
+
+    /// @brief The binds issued by record(), to compare orderings.
+    struct BindCounts
+    {
+        uint32_t mPipelines{0};
+        uint32_t mMaterials{0};
+        uint32_t mDraws{0};
+    };
+
+    /// @brief Records aDraws in order, only re-binding the state where the key prefix changes:
+    /// aBindPipeline(pass, pipeline) when the pass or pipeline changes (the material prefix then changes too),
+    /// aBindMaterial(material) when the material changes, and aDraw(drawIdx) for each draw.
+    template <class T_bindPipeline, class T_bindMaterial, class T_draw>
+    BindCounts record(std::span<const SortedDraw> aDraws,
+                      T_bindPipeline && aBindPipeline, T_bindMaterial && aBindMaterial, T_draw && aDraw)
+    {
+        BindCounts result;
+        // Shifted prefixes never have all their bits set: the first draw binds everything
+        uint64_t pipelinePrefix = ~uint64_t{0};
+        uint64_t materialPrefix = ~uint64_t{0};
+        for(const SortedDraw & draw : aDraws)
+        {
+            if(draw.mKey >> drawkey::gPipelineShift != pipelinePrefix)
+            {
+                pipelinePrefix = draw.mKey >> drawkey::gPipelineShift;
+                aBindPipeline(drawkey::getPass(draw.mKey), drawkey::getPipeline(draw.mKey));
+                ++result.mPipelines;
+            }
+            if(draw.mKey >> drawkey::gMaterialShift != materialPrefix)
+            {
+                materialPrefix = draw.mKey >> drawkey::gMaterialShift;
+                aBindMaterial(drawkey::getMaterial(draw.mKey));
+                ++result.mMaterials;
+            }
+            aDraw(draw.mDrawIdx);
+            ++result.mDraws;
+        }
+        return result;
+    }
+
+} // namespace drawsort
@@ -0,0 +1,54 @@
+#pragma once
+
+
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include <cstdint>
+
+
+// SPIR-V modules compiled into the executable, so that a single file is deployed and startup does no shader I/O.
+// The arrays are generated at build time by tools/EmbedShaders.cpp into shaders/spirv/EmbeddedShaders.h.
+
+
+struct EmbeddedShader
+{
+    // Source file name without the .spv extension (e.g. "Forward.vert"), as in the shader pack
+    std::string_view mName;
+    std::span<const uint32_t> mCode;
+
+    /// @brief The code as the bytes consumed by the shader creation functions.
+    std::span<const char> getChars() const
+    {
+        return {reinterpret_cast<const char *>(mCode.data()), mCode.size_bytes()};
+    }
+};
+
+
+/// @brief Binary search of aName in aShaders, which are sorted by name.
+/// Usable in constant expressions, where a missing shader is a compilation error.
+/// @throw std::out_of_range if aShaders does not contain aName.
+constexpr const EmbeddedShader & getEmbeddedShader(std::span<const EmbeddedShader> aShaders, std::string_view aName)
+{
+    std::size_t first = 0;
+    std::size_t last = aShaders.size();
+    while(first != last)
+    {
+        const std::size_t middle = first + (last - first) / 2;
+        if(aShaders[middle].mName < aName)
+        {
+            first = middle + 1;
+        }
+        else
+        {
+            last = middle;
+        }
+    }
+    if(first == aShaders.size() || aShaders[first].mName != aName)
+    {
+        throw std::out_of_range{"Shader '" + std::string{aName} + "' is not embedded."};
+    }
+    return aShaders[first];
+}
@@ -1,17 +1,133 @@
 #pragma once
 
 
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include <filesystem>
 #include <fstream>
-#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
 #include <vector>
 
+#include <cstddef>
+
 
+/// @brief Reads the whole file into memory, or returns an empty vector if it cannot be opened.
+/// @note Prefer MappedFile, which does not copy.
 std::vector<char> readFile(std::filesystem::path aPath)
 {
-    std::ifstream ifs{aPath, std::ios_base::binary};
-    return std::vector<char>{
-        std::istreambuf_iterator<char>{ifs},
-        std::istreambuf_iterator<char>{std::default_sentinel}
-    };
-}
\ No newline at end of file
+    std::ifstream ifs{aPath, std::ios_base::binary | std::ios_base::ate};
+    if(!ifs)
+    {
+        return {};
+    }
+    // Opened at the end, for the size, then a single read
+    std::vector<char> result((std::size_t)ifs.tellg());
+    ifs.seekg(0);
+    ifs.read(result.data(), result.size());
+    return result;
+}
+
+
+/// @brief Read-only view of a file mapped in the address space.
+/// The content is paged in on first access, without copy to an intermediate buffer.
+/// @note The mapping is page aligned, so it satisfies the alignment of any scalar type (notably SPIR-V words).
+class MappedFile
+{
+public:
+    /// @throw std::runtime_error if the file cannot be opened or mapped.
+    explicit MappedFile(const std::filesystem::path & aPath)
+    {
+#if defined(_WIN32)
+        HANDLE file = CreateFileW(aPath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if(file == INVALID_HANDLE_VALUE)
+        {
+            throw std::runtime_error{"Cannot open file '" + aPath.string() + "'."};
+        }
+        LARGE_INTEGER size;
+        if(GetFileSizeEx(file, &size) && size.QuadPart != 0)
+        {
+            mSize = (std::size_t)size.QuadPart;
+            // The mapping object can be closed once the view exists, the view keeps it alive.
+            if(HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr))
+            {
+                mData = static_cast<const std::byte *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                CloseHandle(mapping);
+            }
+        }
+        CloseHandle(file);
+#else
+        const int file = open(aPath.c_str(), O_RDONLY);
+        if(file == -1)
+        {
+            throw std::runtime_error{"Cannot open file '" + aPath.string() + "'."};
+        }
+        struct stat status;
+        if(fstat(file, &status) == 0 && status.st_size != 0)
+        {
+            mSize = (std::size_t)status.st_size;
+            void * mapping = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, file, 0);
+            mData = (mapping != MAP_FAILED) ? static_cast<const std::byte *>(mapping) : nullptr;
+        }
+        // The mapping keeps its own reference to the file
+        close(file);
+#endif
+        // Empty files cannot be mapped, they are represented by an empty span.
+        if(mData == nullptr && mSize != 0)
+        {
+            throw std::runtime_error{"Cannot map file '" + aPath.string() + "'."};
+        }
+    }
+
+    ~MappedFile()
+    {
+        if(mData != nullptr)
+        {
+#if defined(_WIN32)
+            UnmapViewOfFile(mData);
+#else
+            munmap(const_cast<std::byte *>(mData), mSize);
+#endif
+        }
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile & operator=(const MappedFile &) = delete;
+
+    MappedFile(MappedFile && aOther) noexcept :
+        mData{std::exchange(aOther.mData, nullptr)},
+        mSize{std::exchange(aOther.mSize, 0)}
+    {}
+
+    MappedFile & operator=(MappedFile && aOther) noexcept
+    {
+        std::swap(mData, aOther.mData);
+        std::swap(mSize, aOther.mSize);
+        return *this;
+    }
+
+    std::span<const std::byte> getBytes() const
+    {
+        return {mData, mSize};
+    }
+
+    /// @brief The content as chars, which is how the Vulkan helpers take SPIR-V code.
+    std::span<const char> getChars() const
+    {
+        return {reinterpret_cast<const char *>(mData), mSize};
+    }
+
+private:
+    const std::byte * mData{nullptr};
+    std::size_t mSize{0};
+};
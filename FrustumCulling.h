@@ -0,0 +1,399 @@
+#pragma once
+
+
+#include "Math.h"
+#include "Simd.h"
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <span>
+#include <vector>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+
+/// @brief Frustum planes, a point p is inside when dot(plane.xyz, p) + plane.w >= 0 for all planes.
+struct Frustum
+{
+    std::array<std::array<float, 4>, 6> mPlanes;
+};
+
+/// @brief Frustum of the clip volume, when positions are directly given in clip space (no camera).
+constexpr Frustum gClipVolumeFrustum{{{
+    { 1.f,  0.f,  0.f, 1.f}, // x >= -1
+    {-1.f,  0.f,  0.f, 1.f}, // x <= 1
+    { 0.f,  1.f,  0.f, 1.f}, // y >= -1
+    { 0.f, -1.f,  0.f, 1.f}, // y <= 1
+    { 0.f,  0.f,  1.f, 0.f}, // z >= 0
+    { 0.f,  0.f, -1.f, 1.f}, // z <= 1
+}}};
+
+/// @brief The frustum of aViewProjection, in the space it transforms from (e.g. the world).
+/// The planes are normalized, so the plane equation gives the distance, as the sphere test requires.
+/// see: Gribb & Hartmann, "Fast Extraction of Viewing Frustum Planes from the World-View-Projection Matrix"
+inline Frustum extractFrustum(const math::Mat4 & aViewProjection)
+{
+    const math::Mat4 rows = math::transpose(aViewProjection);
+    auto plane = [](const math::Vec4 & aRow, float aSign, const math::Vec4 & aW)
+    {
+        const math::Vec4 sum{aW.x + aSign * aRow.x, aW.y + aSign * aRow.y, aW.z + aSign * aRow.z, aW.w + aSign * aRow.w};
+        const float length = std::sqrt(sum.x * sum.x + sum.y * sum.y + sum.z * sum.z);
+        return std::array<float, 4>{sum.x / length, sum.y / length, sum.z / length, sum.w / length};
+    };
+    const math::Vec4 & w = rows.mColumns[3];
+    const math::Vec4 zero{0.f, 0.f, 0.f, 0.f};
+    return Frustum{{{
+        plane(rows.mColumns[0], 1.f, w),  // x >= -w
+        plane(rows.mColumns[0], -1.f, w), // x <= w
+        plane(rows.mColumns[1], 1.f, w),  // y >= -w
+        plane(rows.mColumns[1], -1.f, w), // y <= w
+        plane(rows.mColumns[2], 1.f, zero), // z >= 0 (Vulkan depth range)
+        plane(rows.mColumns[2], -1.f, w), // z <= w
+    }}};
+}
+
+
+struct Sphere
+{
+    math::Vec3 mCenter;
+    float mRadius;
+};
+
+struct Aabb
+{
+    math::Vec3 mMin;
+    math::Vec3 mMax;
+};
+
+/// @brief The bounds of aLocal, transformed by the affine aModel.
+/// see: Arvo, "Transforming Axis-Aligned Bounding Boxes", Graphics Gems
+inline Aabb transformAabb(const math::Mat4 & aModel, const Aabb & aLocal)
+{
+    const auto & c = aModel.mColumns;
+    Aabb result{.mMin = {c[3].x, c[3].y, c[3].z}, .mMax = {c[3].x, c[3].y, c[3].z}};
+    const float local[2][3]{{aLocal.mMin.x, aLocal.mMin.y, aLocal.mMin.z}, {aLocal.mMax.x, aLocal.mMax.y, aLocal.mMax.z}};
+    float * resultMin = &result.mMin.x;
+    float * resultMax = &result.mMax.x;
+    for(std::size_t row = 0; row != 3; ++row)
+    {
+        for(std::size_t column = 0; column != 3; ++column)
+        {
+            const float coefficient = (&c[column].x)[row];
+            const float a = coefficient * local[0][column];
+            const float b = coefficient * local[1][column];
+            resultMin[row] += std::min(a, b);
+            resultMax[row] += std::max(a, b);
+        }
+    }
+    return result;
+}
+
+/// @brief The bounding sphere of aLocal, transformed by the affine aModel (the radius follows the largest scale).
+inline Sphere transformSphere(const math::Mat4 & aModel, const Sphere & aLocal)
+{
+    const auto & c = aModel.mColumns;
+    const float scale = std::sqrt(std::max({
+        c[0].x * c[0].x + c[0].y * c[0].y + c[0].z * c[0].z,
+        c[1].x * c[1].x + c[1].y * c[1].y + c[1].z * c[1].z,
+        c[2].x * c[2].x + c[2].y * c[2].y + c[2].z * c[2].z,
+    }));
+    const math::Vec4 center = math::transform(aModel, {aLocal.mCenter.x, aLocal.mCenter.y, aLocal.mCenter.z, 1.f});
+    return {.mCenter = {center.x, center.y, center.z}, .mRadius = aLocal.mRadius * scale};
+}
+
+
+/// @brief The bounding volumes of the objects, one array per component (structure of arrays),
+/// so that the culling loads the same component of consecutive objects into a vector register.
+class BoundingVolumes
+{
+public:
+    enum Component
+    {
+        CenterX, CenterY, CenterZ, Radius,
+        MinX, MinY, MinZ,
+        MaxX, MaxY, MaxZ,
+
+        ComponentCount
+    };
+
+    std::size_t size() const
+    {
+        return mComponents[0].size();
+    }
+
+    void resize(std::size_t aCount)
+    {
+        for(std::vector<float> & component : mComponents)
+        {
+            component.resize(aCount);
+        }
+    }
+
+    void set(std::size_t aObjectIdx, const Sphere & aSphere, const Aabb & aBox)
+    {
+        const float values[ComponentCount]{
+            aSphere.mCenter.x, aSphere.mCenter.y, aSphere.mCenter.z, aSphere.mRadius,
+            aBox.mMin.x, aBox.mMin.y, aBox.mMin.z,
+            aBox.mMax.x, aBox.mMax.y, aBox.mMax.z,
+        };
+        for(std::size_t componentIdx = 0; componentIdx != ComponentCount; ++componentIdx)
+        {
+            mComponents[componentIdx][aObjectIdx] = values[componentIdx];
+        }
+    }
+
+    const float * get(Component aComponent) const
+    {
+        return mComponents[aComponent].data();
+    }
+
+private:
+    std::array<std::vector<float>, ComponentCount> mComponents;
+};
+
+
+namespace culling {
+
+    namespace detail {
+
+        /// @brief A frustum plane, with the AABB corner furthest along its normal (the "positive vertex")
+        /// resolved once per plane: the box is outside when that corner is.
+        struct Plane
+        {
+            float mX, mY, mZ, mW;
+            const float * mPositiveX;
+            const float * mPositiveY;
+            const float * mPositiveZ;
+        };
+
+        inline std::array<Plane, 6> preparePlanes(const BoundingVolumes & aVolumes, const Frustum & aFrustum)
+        {
+            std::array<Plane, 6> result;
+            for(std::size_t planeIdx = 0; planeIdx != 6; ++planeIdx)
+            {
+                const auto [x, y, z, w] = aFrustum.mPlanes[planeIdx];
+                result[planeIdx] = Plane{
+                    .mX = x, .mY = y, .mZ = z, .mW = w,
+                    .mPositiveX = aVolumes.get(x >= 0.f ? BoundingVolumes::MaxX : BoundingVolumes::MinX),
+                    .mPositiveY = aVolumes.get(y >= 0.f ? BoundingVolumes::MaxY : BoundingVolumes::MinY),
+                    .mPositiveZ = aVolumes.get(z >= 0.f ? BoundingVolumes::MaxZ : BoundingVolumes::MinZ),
+                };
+            }
+            return result;
+        }
+
+        inline bool isVisible(const BoundingVolumes & aVolumes, const std::array<Plane, 6> & aPlanes, std::size_t aObjectIdx)
+        {
+            const float x = aVolumes.get(BoundingVolumes::CenterX)[aObjectIdx];
+            const float y = aVolumes.get(BoundingVolumes::CenterY)[aObjectIdx];
+            const float z = aVolumes.get(BoundingVolumes::CenterZ)[aObjectIdx];
+            const float radius = aVolumes.get(BoundingVolumes::Radius)[aObjectIdx];
+            bool visible = true;
+            for(const Plane & plane : aPlanes)
+            {
+                visible = visible
+                    && plane.mX * x + plane.mY * y + plane.mZ * z + plane.mW >= -radius
+                    && plane.mX * plane.mPositiveX[aObjectIdx] + plane.mY * plane.mPositiveY[aObjectIdx]
+                       + plane.mZ * plane.mPositiveZ[aObjectIdx] + plane.mW >= 0.f;
+            }
+            return visible;
+        }
+
+        /// @brief Appends the objects of aVisibleMask (bit i for object aFirst + i) to aOut.
+        inline uint32_t appendVisible(uint32_t aVisibleMask, uint32_t aFirst, uint32_t * aOut)
+        {
+            uint32_t count = 0;
+            for(; aVisibleMask != 0; aVisibleMask &= aVisibleMask - 1)
+            {
+                aOut[count++] = aFirst + (uint32_t)std::countr_zero(aVisibleMask);
+            }
+            return count;
+        }
+
+    } // namespace detail
+
+
+    namespace scalar {
+
+        /// @brief Reference implementation of culling::cullRange().
+        inline uint32_t cullRange(const BoundingVolumes & aVolumes, const Frustum & aFrustum,
+                                  uint32_t aFirst, uint32_t aCount, uint32_t * aVisible)
+        {
+            const std::array<detail::Plane, 6> planes = detail::preparePlanes(aVolumes, aFrustum);
+            uint32_t visibleCount = 0;
+            for(uint32_t objectIdx = aFirst; objectIdx != aFirst + aCount; ++objectIdx)
+            {
+                if(detail::isVisible(aVolumes, planes, objectIdx))
+                {
+                    aVisible[visibleCount++] = objectIdx;
+                }
+            }
+            return visibleCount;
+        }
+
+    } // namespace scalar
+
+
+    /// @brief Writes the indices of the objects in [aFirst, aFirst + aCount) intersecting aFrustum to aVisible, in order.
+    /// An object is visible when both its sphere and its box intersect the frustum (conservatively: the tests may keep
+    /// objects close to the frustum corners). The sphere test rejects most objects, the box test refines it.
+    /// @param aVisible Must be able to hold aCount indices.
+    /// @return The number of visible objects.
+    inline uint32_t cullRange(const BoundingVolumes & aVolumes, const Frustum & aFrustum,
+                              uint32_t aFirst, uint32_t aCount, uint32_t * aVisible)
+    {
+        const std::array<detail::Plane, 6> planes = detail::preparePlanes(aVolumes, aFrustum);
+        // (Unused without intrinsics)
+        [[maybe_unused]] const float * centerX = aVolumes.get(BoundingVolumes::CenterX);
+        [[maybe_unused]] const float * centerY = aVolumes.get(BoundingVolumes::CenterY);
+        [[maybe_unused]] const float * centerZ = aVolumes.get(BoundingVolumes::CenterZ);
+        [[maybe_unused]] const float * radius = aVolumes.get(BoundingVolumes::Radius);
+
+        uint32_t objectIdx = aFirst;
+        const uint32_t end = aFirst + aCount;
+        uint32_t visibleCount = 0;
+#if defined(SIMD_AVX2)
+        for(; objectIdx + 8 <= end; objectIdx += 8)
+        {
+            const __m256 x = _mm256_loadu_ps(centerX + objectIdx);
+            const __m256 y = _mm256_loadu_ps(centerY + objectIdx);
+            const __m256 z = _mm256_loadu_ps(centerZ + objectIdx);
+            const __m256 negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(radius + objectIdx));
+            __m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for(const detail::Plane & plane : planes)
+            {
+                __m256 distance = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.mX), x), _mm256_set1_ps(plane.mW));
+                distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(plane.mY), y));
+                distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(plane.mZ), z));
+                visible = _mm256_and_ps(visible, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+            }
+            // Most batches are entirely outside (or inside): the box test is skipped for rejected batches
+            if(_mm256_movemask_ps(visible) == 0)
+            {
+                continue;
+            }
+            for(const detail::Plane & plane : planes)
+            {
+                __m256 distance = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.mX), _mm256_loadu_ps(plane.mPositiveX + objectIdx)),
+                                                _mm256_set1_ps(plane.mW));
+                distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(plane.mY), _mm256_loadu_ps(plane.mPositiveY + objectIdx)));
+                distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(plane.mZ), _mm256_loadu_ps(plane.mPositiveZ + objectIdx)));
+                visible = _mm256_and_ps(visible, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_GE_OQ));
+            }
+            visibleCount += detail::appendVisible((uint32_t)_mm256_movemask_ps(visible), objectIdx, aVisible + visibleCount);
+        }
+#elif defined(SIMD_SSE2)
+        for(; objectIdx + 4 <= end; objectIdx += 4)
+        {
+            const __m128 x = _mm_loadu_ps(centerX + objectIdx);
+            const __m128 y = _mm_loadu_ps(centerY + objectIdx);
+            const __m128 z = _mm_loadu_ps(centerZ + objectIdx);
+            const __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + objectIdx));
+            __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for(const detail::Plane & plane : planes)
+            {
+                __m128 distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.mX), x), _mm_set1_ps(plane.mW));
+                distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.mY), y));
+                distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.mZ), z));
+                visible = _mm_and_ps(visible, _mm_cmpge_ps(distance, negativeRadius));
+            }
+            // Most batches are entirely outside (or inside): the box test is skipped for rejected batches
+            if(_mm_movemask_ps(visible) == 0)
+            {
+                continue;
+            }
+            for(const detail::Plane & plane : planes)
+            {
+                __m128 distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.mX), _mm_loadu_ps(plane.mPositiveX + objectIdx)),
+                                             _mm_set1_ps(plane.mW));
+                distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.mY), _mm_loadu_ps(plane.mPositiveY + objectIdx)));
+                distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.mZ), _mm_loadu_ps(plane.mPositiveZ + objectIdx)));
+                visible = _mm_and_ps(visible, _mm_cmpge_ps(distance, _mm_setzero_ps()));
+            }
+            visibleCount += detail::appendVisible((uint32_t)_mm_movemask_ps(visible), objectIdx, aVisible + visibleCount);
+        }
+#elif defined(SIMD_NEON)
+        const uint32x4_t laneBits{1, 2, 4, 8};
+        for(; objectIdx + 4 <= end; objectIdx += 4)
+        {
+            const float32x4_t x = vld1q_f32(centerX + objectIdx);
+            const float32x4_t y = vld1q_f32(centerY + objectIdx);
+            const float32x4_t z = vld1q_f32(centerZ + objectIdx);
+            const float32x4_t negativeRadius = vnegq_f32(vld1q_f32(radius + objectIdx));
+            uint32x4_t visible = vdupq_n_u32(0xffffffff);
+            for(const detail::Plane & plane : planes)
+            {
+                float32x4_t distance = vmlaq_n_f32(vdupq_n_f32(plane.mW), x, plane.mX);
+                distance = vmlaq_n_f32(distance, y, plane.mY);
+                distance = vmlaq_n_f32(distance, z, plane.mZ);
+                visible = vandq_u32(visible, vcgeq_f32(distance, negativeRadius));
+            }
+            // Most batches are entirely outside (or inside): the box test is skipped for rejected batches
+            if(vmaxvq_u32(visible) == 0)
+            {
+                continue;
+            }
+            for(const detail::Plane & plane : planes)
+            {
+                float32x4_t distance = vmlaq_n_f32(vdupq_n_f32(plane.mW), vld1q_f32(plane.mPositiveX + objectIdx), plane.mX);
+                distance = vmlaq_n_f32(distance, vld1q_f32(plane.mPositiveY + objectIdx), plane.mY);
+                distance = vmlaq_n_f32(distance, vld1q_f32(plane.mPositiveZ + objectIdx), plane.mZ);
+                visible = vandq_u32(visible, vcgeq_f32(distance, vdupq_n_f32(0.f)));
+            }
+            visibleCount += detail::appendVisible(vaddvq_u32(vandq_u32(visible, laneBits)), objectIdx, aVisible + visibleCount);
+        }
+#endif
+        // Remainder (or everything, without intrinsics)
+        for(; objectIdx != end; ++objectIdx)
+        {
+            if(detail::isVisible(aVolumes, planes, objectIdx))
+            {
+                aVisible[visibleCount++] = objectIdx;
+            }
+        }
+        return visibleCount;
+    }
+
+
+    // Objects per job: large enough to amortize the job overhead, small enough to balance the threads
+    constexpr uint32_t gJobObjectCount = 16 * 1024;
+
+    /// @brief Culls all aVolumes, splitting them into jobs for aWorkers when there are enough objects.
+    /// Each job compacts its visible objects at the start of its own range of aVisible, then the ranges are
+    /// moved down one after the other: the result is the same list as the single threaded culling.
+    /// @param aVisible Must be able to hold aVolumes.size() indices.
+    /// @return The number of visible objects.
+    inline uint32_t cull(const BoundingVolumes & aVolumes, const Frustum & aFrustum,
+                         std::span<uint32_t> aVisible, WorkerPool & aWorkers)
+    {
+        const uint32_t objectCount = (uint32_t)aVolumes.size();
+        const uint32_t jobCount = (objectCount + gJobObjectCount - 1) / gJobObjectCount;
+        if(jobCount <= 1)
+        {
+            return cullRange(aVolumes, aFrustum, 0, objectCount, aVisible.data());
+        }
+
+        std::vector<uint32_t> jobVisibleCounts(jobCount);
+        parallelFor(aWorkers, jobCount, [&](std::size_t aJobIdx)
+        {
+            const uint32_t first = (uint32_t)aJobIdx * gJobObjectCount;
+            jobVisibleCounts[aJobIdx] =
+                cullRange(aVolumes, aFrustum, first, std::min(gJobObjectCount, objectCount - first), aVisible.data() + first);
+        });
+
+        uint32_t visibleCount = jobVisibleCounts[0];
+        for(uint32_t jobIdx = 1; jobIdx != jobCount; ++jobIdx)
+        {
+            // Never overlapping forward: the destination is at most the source
+            std::memmove(aVisible.data() + visibleCount, aVisible.data() + jobIdx * gJobObjectCount,
+                         jobVisibleCounts[jobIdx] * sizeof(uint32_t));
+            visibleCount += jobVisibleCounts[jobIdx];
+        }
+        return visibleCount;
+    }
+
+} // namespace culling
@@ -0,0 +1,694 @@
+#pragma once
+
+
+#include "FileHelper.h"
+#include "Json.h"
+#include "Math.h"
+#include "Simd.h"
+#include "TransformHierarchy.h"
+#include "VertexLayout.h"
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+
+// glTF 2.0 importer, producing GPU-ready vertex and index data.
+// see: https://registry.khronos.org/glTF/specs/2.0/glTF-2.0.html
+//
+// The JSON document is parsed on the calling thread (it is small), then the heavy work runs on the workers:
+// the buffers are loaded in parallel (mapped, or base64 decoded), then each primitive converts its accessors
+// in parallel, directly into its slice of the scene buffers (the slices are assigned up front from the accessor counts).
+// The attributes are encoded by the SIMD kernels of VertexLayout.h, the indices widened by SIMD loops.
+//
+// Supported: .gltf (external or data URI buffers) and .glb, triangle list primitives, POSITION and COLOR_0,
+// base color factors, and the node hierarchy. Sparse accessors are rejected, other attributes are ignored.
+namespace gltf {
+
+    /// @brief A draw of the scene buffers, see vkCmdDrawIndexed().
+    struct Primitive
+    {
+        uint32_t mFirstIndex;
+        uint32_t mIndexCount;
+        int32_t mVertexOffset;
+        uint32_t mVertexCount;
+        int32_t mMaterial; // -1 for the default material
+    };
+
+    struct Mesh
+    {
+        std::string mName;
+        std::vector<Primitive> mPrimitives;
+    };
+
+    struct Material
+    {
+        std::string mName;
+        std::array<float, 4> mBaseColorFactor{1.f, 1.f, 1.f, 1.f};
+        bool mDoubleSided{false};
+        bool mBlend{false}; // alphaMode BLEND
+    };
+
+    struct Node
+    {
+        std::string mName;
+        int32_t mParent{-1};
+        int32_t mMesh{-1};
+        std::vector<uint32_t> mChildren;
+        // Column-major, as in glTF
+        std::array<float, 16> mLocalMatrix{1.f, 0.f, 0.f, 0.f,
+                                           0.f, 1.f, 0.f, 0.f,
+                                           0.f, 0.f, 1.f, 0.f,
+                                           0.f, 0.f, 0.f, 1.f};
+    };
+
+    struct Scene
+    {
+        VertexLayout mLayout;
+        // All the primitives, interleaved in mLayout
+        std::vector<std::byte> mVertexData;
+        std::vector<uint32_t> mIndices;
+
+        std::vector<Mesh> mMeshes;
+        std::vector<Material> mMaterials;
+        std::vector<Node> mNodes;
+        std::vector<uint32_t> mRootNodes;
+    };
+
+
+    namespace detail {
+
+        constexpr uint32_t gGlbMagic = 0x46546c67; // "glTF"
+        constexpr uint32_t gGlbJsonChunk = 0x4e4f534a; // "JSON"
+        constexpr uint32_t gGlbBinChunk = 0x004e4942; // "BIN\0"
+
+        enum ComponentType : uint32_t
+        {
+            Byte = 5120,
+            UnsignedByte = 5121,
+            Short = 5122,
+            UnsignedShort = 5123,
+            UnsignedInt = 5125,
+            Float = 5126,
+        };
+
+        constexpr uint32_t getComponentSize(uint32_t aComponentType)
+        {
+            switch(aComponentType)
+            {
+                case Byte:
+                case UnsignedByte:
+                    return 1;
+                case Short:
+                case UnsignedShort:
+                    return 2;
+                case UnsignedInt:
+                case Float:
+                    return 4;
+            }
+            throw std::invalid_argument{"Invalid glTF component type " + std::to_string(aComponentType) + "."};
+        }
+
+        inline uint32_t getComponentCount(const std::string & aType)
+        {
+            constexpr std::pair<std::string_view, uint32_t> gTypes[]{
+                {"SCALAR", 1}, {"VEC2", 2}, {"VEC3", 3}, {"VEC4", 4}, {"MAT2", 4}, {"MAT3", 9}, {"MAT4", 16},
+            };
+            for(const auto & [name, count] : gTypes)
+            {
+                if(aType == name)
+                {
+                    return count;
+                }
+            }
+            throw std::invalid_argument{"Invalid glTF accessor type '" + aType + "'."};
+        }
+
+        /// @brief The elements of an accessor, validated against the bounds of its buffer.
+        struct AccessorView
+        {
+            const std::byte * mData;
+            std::size_t mStride;
+            uint32_t mCount;
+            uint32_t mComponentType;
+            uint32_t mComponentCount;
+            bool mNormalized;
+        };
+
+        inline std::vector<std::byte> decodeBase64(std::string_view aText)
+        {
+            auto decode = [](char aCharacter) -> int
+            {
+                if(aCharacter >= 'A' && aCharacter <= 'Z') return aCharacter - 'A';
+                if(aCharacter >= 'a' && aCharacter <= 'z') return aCharacter - 'a' + 26;
+                if(aCharacter >= '0' && aCharacter <= '9') return aCharacter - '0' + 52;
+                if(aCharacter == '+') return 62;
+                if(aCharacter == '/') return 63;
+                return -1;
+            };
+
+            std::vector<std::byte> result;
+            result.reserve(aText.size() / 4 * 3);
+            uint32_t bits = 0;
+            int bitCount = 0;
+            for(char character : aText)
+            {
+                const int value = decode(character);
+                if(value < 0)
+                {
+                    // Padding ends the data
+                    break;
+                }
+                bits = (bits << 6) | (uint32_t)value;
+                bitCount += 6;
+                if(bitCount >= 8)
+                {
+                    bitCount -= 8;
+                    result.push_back((std::byte)((bits >> bitCount) & 0xff));
+                }
+            }
+            return result;
+        }
+
+        /// @brief Widens 16-bit indices to 32-bit.
+        /// @param aIn Has no alignment requirement (buffer views only align to the component size).
+        inline void widenIndices(const std::byte * aIn, uint32_t * aOut, std::size_t aCount)
+        {
+            std::size_t indexIdx = 0;
+#if defined(SIMD_SSE2)
+            const __m128i zero = _mm_setzero_si128();
+            for(; indexIdx + 8 <= aCount; indexIdx += 8)
+            {
+                const __m128i indices = _mm_loadu_si128(reinterpret_cast<const __m128i *>(aIn + 2 * indexIdx));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(aOut + indexIdx), _mm_unpacklo_epi16(indices, zero));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(aOut + indexIdx + 4), _mm_unpackhi_epi16(indices, zero));
+            }
+#elif defined(SIMD_NEON)
+            for(; indexIdx + 8 <= aCount; indexIdx += 8)
+            {
+                const uint16x8_t indices = vreinterpretq_u16_u8(vld1q_u8(reinterpret_cast<const uint8_t *>(aIn + 2 * indexIdx)));
+                vst1q_u32(aOut + indexIdx, vmovl_u16(vget_low_u16(indices)));
+                vst1q_u32(aOut + indexIdx + 4, vmovl_u16(vget_high_u16(indices)));
+            }
+#endif
+            for(; indexIdx != aCount; ++indexIdx)
+            {
+                uint16_t index;
+                std::memcpy(&index, aIn + 2 * indexIdx, sizeof(index));
+                aOut[indexIdx] = index;
+            }
+        }
+
+        /// @brief Decodes aView elements to 4 floats each (missing components are 0, 0, 0, 1),
+        /// applying the normalization of integer components.
+        inline void decodeToFloat4(const AccessorView & aView, float * aOut)
+        {
+            const uint32_t componentCount = std::min(aView.mComponentCount, 4u);
+            for(uint32_t elementIdx = 0; elementIdx != aView.mCount; ++elementIdx)
+            {
+                const std::byte * element = aView.mData + elementIdx * aView.mStride;
+                float * out = aOut + 4 * elementIdx;
+                out[0] = out[1] = out[2] = 0.f;
+                out[3] = 1.f;
+                switch(aView.mComponentType)
+                {
+                    case Float:
+                        std::memcpy(out, element, componentCount * sizeof(float));
+                        break;
+                    case UnsignedByte:
+                    {
+#if defined(SIMD_SSE2)
+                        uint32_t packed = 0;
+                        std::memcpy(&packed, element, componentCount);
+                        const __m128i zero = _mm_setzero_si128();
+                        const __m128i widened = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int)packed), zero), zero);
+                        _mm_storeu_ps(out, _mm_mul_ps(_mm_cvtepi32_ps(widened), _mm_set1_ps(aView.mNormalized ? 1.f / 255.f : 1.f)));
+                        if(componentCount < 4)
+                        {
+                            out[3] = 1.f;
+                        }
+#else
+                        for(uint32_t componentIdx = 0; componentIdx != componentCount; ++componentIdx)
+                        {
+                            const float value = (float)std::to_integer<uint8_t>(element[componentIdx]);
+                            out[componentIdx] = aView.mNormalized ? value / 255.f : value;
+                        }
+#endif
+                        break;
+                    }
+                    case UnsignedShort:
+                        for(uint32_t componentIdx = 0; componentIdx != componentCount; ++componentIdx)
+                        {
+                            uint16_t value;
+                            std::memcpy(&value, element + 2 * componentIdx, sizeof(value));
+                            out[componentIdx] = aView.mNormalized ? value / 65535.f : (float)value;
+                        }
+                        break;
+                    default:
+                        throw std::invalid_argument{"Unsupported glTF component type for a color."};
+                }
+            }
+        }
+
+        template <std::size_t N_count>
+        std::array<float, N_count> readFloats(const json::Value & aObject, std::string_view aKey, std::array<float, N_count> aDefault)
+        {
+            if(const json::Value * value = aObject.find(aKey))
+            {
+                for(std::size_t componentIdx = 0; componentIdx != N_count; ++componentIdx)
+                {
+                    aDefault[componentIdx] = (float)(*value)[componentIdx].asNumber();
+                }
+            }
+            return aDefault;
+        }
+
+    } // namespace detail
+
+
+    /// @brief Imports the default scene of a .gltf or .glb file, its vertices encoded in aLayout.
+    /// @param aLayout Must declare the position then the color (as gFullVertexLayout and gCompactVertexLayout).
+    /// @throw std::runtime_error if a file cannot be read, std::invalid_argument if the asset is invalid or unsupported.
+    inline Scene importScene(const std::filesystem::path & aPath, WorkerPool & aWorkers, const VertexLayout & aLayout)
+    {
+        using namespace detail;
+
+        if(aLayout.mAttributes.size() != 2)
+        {
+            throw std::invalid_argument{"The layout must declare the position then the color."};
+        }
+
+        //
+        // Container and JSON
+        //
+        std::optional<MappedFile> glb;
+        std::vector<char> text;
+        std::string_view jsonText;
+        std::span<const std::byte> glbBinary;
+        if(aPath.extension() == ".glb")
+        {
+            glb.emplace(aPath);
+            const std::span<const std::byte> bytes = glb->getBytes();
+            auto readWord = [&bytes](std::size_t aOffset)
+            {
+                uint32_t word = 0;
+                if(aOffset + sizeof(word) <= bytes.size())
+                {
+                    std::memcpy(&word, bytes.data() + aOffset, sizeof(word));
+                }
+                return word;
+            };
+            if(readWord(0) != gGlbMagic || readWord(4) != 2)
+            {
+                throw std::invalid_argument{"'" + aPath.string() + "' is not a glTF 2.0 binary."};
+            }
+            // Chunks: length, type, data padded to 4 bytes
+            for(std::size_t offset = 12; offset + 8 <= bytes.size(); /*in body*/)
+            {
+                const uint32_t length = readWord(offset);
+                const uint32_t type = readWord(offset + 4);
+                if(length > bytes.size() - offset - 8)
+                {
+                    throw std::invalid_argument{"'" + aPath.string() + "' has a truncated chunk."};
+                }
+                const std::span<const std::byte> data = bytes.subspan(offset + 8, length);
+                if(type == gGlbJsonChunk)
+                {
+                    jsonText = {reinterpret_cast<const char *>(data.data()), data.size()};
+                }
+                else if(type == gGlbBinChunk && glbBinary.empty())
+                {
+                    glbBinary = data;
+                }
+                offset += 8 + (length + 3) / 4 * 4;
+            }
+        }
+        else
+        {
+            text = readFile(aPath);
+            if(text.empty())
+            {
+                throw std::runtime_error{"Cannot read '" + aPath.string() + "'."};
+            }
+            jsonText = {text.data(), text.size()};
+        }
+        const json::Value document = json::parse(jsonText);
+
+        //
+        // Buffers, loaded in parallel
+        //
+        const json::Value::Array & bufferValues = document.getArray("buffers");
+        std::vector<std::optional<MappedFile>> mappedBuffers(bufferValues.size());
+        std::vector<std::vector<std::byte>> decodedBuffers(bufferValues.size());
+        std::vector<std::span<const std::byte>> buffers(bufferValues.size());
+        parallelFor(aWorkers, bufferValues.size(), [&](std::size_t aBufferIdx)
+        {
+            const json::Value & buffer = bufferValues[aBufferIdx];
+            std::span<const std::byte> data;
+            if(const json::Value * uri = buffer.find("uri"))
+            {
+                const std::string & location = uri->asString();
+                if(location.starts_with("data:"))
+                {
+                    const std::size_t comma = location.find(',');
+                    if(comma == std::string::npos || location.rfind(";base64", comma) == std::string::npos)
+                    {
+                        throw std::invalid_argument{"Only base64 data URIs are supported."};
+                    }
+                    decodedBuffers[aBufferIdx] = decodeBase64(std::string_view{location}.substr(comma + 1));
+                    data = decodedBuffers[aBufferIdx];
+                }
+                else
+                {
+                    // Relative to the asset (percent-encoding is not supported)
+                    mappedBuffers[aBufferIdx].emplace(aPath.parent_path() / std::filesystem::u8path(location));
+                    data = mappedBuffers[aBufferIdx]->getBytes();
+                }
+            }
+            else
+            {
+                // The GLB binary chunk
+                data = glbBinary;
+            }
+            const std::size_t byteLength = (std::size_t)buffer["byteLength"].asNumber();
+            if(data.size() < byteLength)
+            {
+                throw std::invalid_argument{"glTF buffer " + std::to_string(aBufferIdx) + " is truncated."};
+            }
+            buffers[aBufferIdx] = data.first(byteLength);
+        });
+
+        //
+        // Accessors
+        //
+        const json::Value::Array & bufferViews = document.getArray("bufferViews");
+        const json::Value::Array & accessors = document.getArray("accessors");
+        auto getAccessor = [&](std::size_t aAccessorIdx) -> AccessorView
+        {
+            const json::Value & accessor = document["accessors"][aAccessorIdx];
+            if(accessor.find("sparse") != nullptr)
+            {
+                throw std::invalid_argument{"Sparse glTF accessors are not supported."};
+            }
+            AccessorView view{
+                .mData = nullptr,
+                .mStride = 0,
+                .mCount = (uint32_t)accessor["count"].asNumber(),
+                .mComponentType = (uint32_t)accessor["componentType"].asNumber(),
+                .mComponentCount = getComponentCount(accessor["type"].asString()),
+                .mNormalized = accessor.find("normalized") != nullptr && accessor["normalized"].asBool(),
+            };
+            const std::size_t elementSize = (std::size_t)getComponentSize(view.mComponentType) * view.mComponentCount;
+            if(accessor.find("bufferView") == nullptr)
+            {
+                throw std::invalid_argument{"glTF accessors without buffer view are not supported."};
+            }
+            const json::Value & bufferView = bufferViews.at((std::size_t)accessor["bufferView"].asNumber());
+            const std::span<const std::byte> buffer = buffers.at((std::size_t)bufferView["buffer"].asNumber());
+            const std::size_t viewOffset = (std::size_t)bufferView.getNumber("byteOffset", 0);
+            const std::size_t viewLength = (std::size_t)bufferView["byteLength"].asNumber();
+            const std::size_t accessorOffset = (std::size_t)accessor.getNumber("byteOffset", 0);
+            view.mStride = (std::size_t)bufferView.getNumber("byteStride", (double)elementSize);
+            const std::size_t extent = view.mCount == 0 ? 0 : (view.mCount - 1) * view.mStride + elementSize;
+            if(viewOffset > buffer.size() || viewLength > buffer.size() - viewOffset
+               || accessorOffset > viewLength || extent > viewLength - accessorOffset)
+            {
+                throw std::invalid_argument{"glTF accessor " + std::to_string(aAccessorIdx) + " is out of its buffer."};
+            }
+            view.mData = buffer.data() + viewOffset + accessorOffset;
+            return view;
+        };
+
+        //
+        // Materials, meshes and nodes
+        //
+        Scene scene;
+        scene.mLayout = aLayout;
+        for(const json::Value & material : document.getArray("materials"))
+        {
+            Material & imported = scene.mMaterials.emplace_back();
+            if(const json::Value * name = material.find("name"))
+            {
+                imported.mName = name->asString();
+            }
+            if(const json::Value * pbr = material.find("pbrMetallicRoughness"))
+            {
+                imported.mBaseColorFactor = readFloats<4>(*pbr, "baseColorFactor", imported.mBaseColorFactor);
+            }
+            imported.mDoubleSided = material.find("doubleSided") != nullptr && material["doubleSided"].asBool();
+            imported.mBlend = material.find("alphaMode") != nullptr && material["alphaMode"].asString() == "BLEND";
+        }
+
+        // The primitives to convert, with their accessors
+        struct PrimitiveSource
+        {
+            Primitive * mPrimitive;
+            std::size_t mPositions;
+            std::optional<std::size_t> mColors{};
+            std::optional<std::size_t> mIndices{};
+        };
+        std::vector<PrimitiveSource> sources;
+        uint64_t vertexCount = 0;
+        uint64_t indexCount = 0;
+        for(const json::Value & mesh : document.getArray("meshes"))
+        {
+            Mesh & imported = scene.mMeshes.emplace_back();
+            if(const json::Value * name = mesh.find("name"))
+            {
+                imported.mName = name->asString();
+            }
+            for(const json::Value & primitive : mesh["primitives"].asArray())
+            {
+                // Only triangle lists
+                if(primitive.getNumber("mode", 4) != 4)
+                {
+                    continue;
+                }
+                const json::Value & attributes = primitive["attributes"];
+                PrimitiveSource source{
+                    .mPrimitive = nullptr,
+                    .mPositions = (std::size_t)attributes["POSITION"].asNumber(),
+                };
+                if(const json::Value * colors = attributes.find("COLOR_0"))
+                {
+                    source.mColors = (std::size_t)colors->asNumber();
+                }
+                if(const json::Value * indices = primitive.find("indices"))
+                {
+                    source.mIndices = (std::size_t)indices->asNumber();
+                }
+                const uint32_t primitiveVertexCount = (uint32_t)accessors.at(source.mPositions)["count"].asNumber();
+                const uint32_t primitiveIndexCount = source.mIndices
+                    ? (uint32_t)accessors.at(*source.mIndices)["count"].asNumber()
+                    : primitiveVertexCount;
+                imported.mPrimitives.push_back({
+                    .mFirstIndex = (uint32_t)indexCount,
+                    .mIndexCount = primitiveIndexCount,
+                    .mVertexOffset = (int32_t)vertexCount,
+                    .mVertexCount = primitiveVertexCount,
+                    .mMaterial = (int32_t)primitive.getNumber("material", -1),
+                });
+                vertexCount += primitiveVertexCount;
+                indexCount += primitiveIndexCount;
+                sources.push_back(source);
+            }
+        }
+        if(vertexCount > INT32_MAX || indexCount > UINT32_MAX)
+        {
+            throw std::invalid_argument{"The glTF scene is too large for 32-bit indices."};
+        }
+        // The primitives do not move anymore
+        {
+            std::size_t sourceIdx = 0;
+            for(Mesh & mesh : scene.mMeshes)
+            {
+                for(Primitive & primitive : mesh.mPrimitives)
+                {
+                    sources[sourceIdx++].mPrimitive = &primitive;
+                }
+            }
+        }
+
+        const json::Value::Array & nodes = document.getArray("nodes");
+        scene.mNodes.resize(nodes.size());
+        for(std::size_t nodeIdx = 0; nodeIdx != nodes.size(); ++nodeIdx)
+        {
+            const json::Value & node = nodes[nodeIdx];
+            Node & imported = scene.mNodes[nodeIdx];
+            if(const json::Value * name = node.find("name"))
+            {
+                imported.mName = name->asString();
+            }
+            imported.mMesh = (int32_t)node.getNumber("mesh", -1);
+            if(node.find("matrix") != nullptr)
+            {
+                imported.mLocalMatrix = readFloats<16>(node, "matrix", imported.mLocalMatrix);
+            }
+            else
+            {
+                const auto [tx, ty, tz] = readFloats<3>(node, "translation", {0.f, 0.f, 0.f});
+                const auto [rx, ry, rz, rw] = readFloats<4>(node, "rotation", {0.f, 0.f, 0.f, 1.f});
+                const auto [sx, sy, sz] = readFloats<3>(node, "scale", {1.f, 1.f, 1.f});
+                const math::Mat4 local = math::composeTrs({tx, ty, tz}, {rx, ry, rz, rw}, {sx, sy, sz});
+                std::memcpy(imported.mLocalMatrix.data(), local.data(), sizeof(local));
+            }
+            for(const json::Value & child : node.getArray("children"))
+            {
+                const uint32_t childIdx = (uint32_t)child.asNumber();
+                if(childIdx >= nodes.size() || scene.mNodes[childIdx].mParent != -1)
+                {
+                    throw std::invalid_argument{"glTF node " + std::to_string(nodeIdx) + " has an invalid child."};
+                }
+                imported.mChildren.push_back(childIdx);
+                scene.mNodes[childIdx].mParent = (int32_t)nodeIdx;
+            }
+        }
+        const json::Value::Array & scenes = document.getArray("scenes");
+        if(!scenes.empty())
+        {
+            const json::Value & defaultScene = scenes.at((std::size_t)document.getNumber("scene", 0));
+            for(const json::Value & root : defaultScene.getArray("nodes"))
+            {
+                scene.mRootNodes.push_back((uint32_t)root.asNumber());
+            }
+        }
+        else
+        {
+            for(uint32_t nodeIdx = 0; nodeIdx != scene.mNodes.size(); ++nodeIdx)
+            {
+                if(scene.mNodes[nodeIdx].mParent == -1)
+                {
+                    scene.mRootNodes.push_back(nodeIdx);
+                }
+            }
+        }
+
+        //
+        // Primitives, converted in parallel into their slices
+        //
+        const uint32_t stride = aLayout.getStride();
+        scene.mVertexData.resize(vertexCount * stride);
+        scene.mIndices.resize(indexCount);
+        parallelFor(aWorkers, sources.size(), [&](std::size_t aSourceIdx)
+        {
+            const PrimitiveSource & source = sources[aSourceIdx];
+            const Primitive & primitive = *source.mPrimitive;
+
+            const AccessorView positions = getAccessor(source.mPositions);
+            if(positions.mComponentType != Float || positions.mComponentCount != 3)
+            {
+                throw std::invalid_argument{"glTF positions must be float 3D vectors."};
+            }
+
+            // Colors are the vertex colors, or the base color of the material
+            // (a constant source has a stride of 0)
+            const Material defaultMaterial;
+            const Material & material = primitive.mMaterial >= 0
+                ? scene.mMaterials.at(primitive.mMaterial)
+                : defaultMaterial;
+            AttributeSource colorSource{.mData = material.mBaseColorFactor.data(), .mComponentCount = 4, .mStride = 0};
+            std::vector<float> decodedColors;
+            if(source.mColors)
+            {
+                const AccessorView colors = getAccessor(*source.mColors);
+                if(colors.mCount < positions.mCount)
+                {
+                    throw std::invalid_argument{"glTF colors are fewer than the positions."};
+                }
+                if(colors.mComponentType == Float)
+                {
+                    colorSource = {.mData = reinterpret_cast<const float *>(colors.mData),
+                                   .mComponentCount = std::min(colors.mComponentCount, 4u),
+                                   .mStride = colors.mStride};
+                }
+                else
+                {
+                    decodedColors.resize(4 * (std::size_t)colors.mCount);
+                    decodeToFloat4(colors, decodedColors.data());
+                    colorSource = {.mData = decodedColors.data(), .mComponentCount = 4, .mStride = 4 * sizeof(float)};
+                }
+            }
+
+            const AttributeSource attributeSources[]{
+                {.mData = reinterpret_cast<const float *>(positions.mData), .mComponentCount = 3, .mStride = positions.mStride},
+                colorSource,
+            };
+            encodeVertices(aLayout, attributeSources, positions.mCount,
+                           scene.mVertexData.data() + (std::size_t)primitive.mVertexOffset * stride);
+
+            // Indices, relative to the primitive (the draw adds mVertexOffset)
+            uint32_t * out = scene.mIndices.data() + primitive.mFirstIndex;
+            if(!source.mIndices)
+            {
+                for(uint32_t indexIdx = 0; indexIdx != primitive.mIndexCount; ++indexIdx)
+                {
+                    out[indexIdx] = indexIdx;
+                }
+                return;
+            }
+            const AccessorView indices = getAccessor(*source.mIndices);
+            const std::size_t componentSize = getComponentSize(indices.mComponentType);
+            if(indices.mComponentCount != 1 || indices.mStride != componentSize)
+            {
+                throw std::invalid_argument{"glTF indices must be tightly packed scalars."};
+            }
+            switch(indices.mComponentType)
+            {
+                case UnsignedByte:
+                    for(uint32_t indexIdx = 0; indexIdx != indices.mCount; ++indexIdx)
+                    {
+                        out[indexIdx] = std::to_integer<uint32_t>(indices.mData[indexIdx]);
+                    }
+                    break;
+                case UnsignedShort:
+                    widenIndices(indices.mData, out, indices.mCount);
+                    break;
+                case UnsignedInt:
+                    std::memcpy(out, indices.mData, (std::size_t)indices.mCount * sizeof(uint32_t));
+                    break;
+                default:
+                    throw std::invalid_argument{"glTF indices must be unsigned integers."};
+            }
+            if(indices.mCount != 0 && *std::max_element(out, out + indices.mCount) >= primitive.mVertexCount)
+            {
+                throw std::invalid_argument{"A glTF index is out of its primitive vertices."};
+            }
+        });
+
+        return scene;
+    }
+
+
+    /// @brief The column-major world matrix of each node of aScene.
+    inline std::vector<std::array<float, 16>> computeWorldMatrices(const Scene & aScene)
+    {
+        std::vector<uint32_t> parents;
+        std::vector<math::Mat4> locals;
+        for(const Node & node : aScene.mNodes)
+        {
+            parents.push_back(node.mParent == -1 ? TransformHierarchy::gNoParent : (uint32_t)node.mParent);
+            locals.push_back(math::Mat4::fromColumnMajor(node.mLocalMatrix.data()));
+        }
+        TransformHierarchy hierarchy{parents, locals};
+        hierarchy.update();
+
+        std::vector<std::array<float, 16>> result(aScene.mNodes.size());
+        for(uint32_t nodeIdx = 0; nodeIdx != result.size(); ++nodeIdx)
+        {
+            std::memcpy(result[nodeIdx].data(), hierarchy.getWorld(hierarchy.getSlot(nodeIdx)).data(), sizeof(result[nodeIdx]));
+        }
+        return result;
+    }
+
+} // namespace gltf
@@ -0,0 +1,33 @@
+#pragma once
+
+
+#include <span>
+
+#include <cstddef>
+#include <cstdint>
+
+
+using Hash = uint64_t;
+
+
+/// @brief 64-bit FNV-1a, used to identify content (shader code, pipeline states, ...).
+/// @note Not a cryptographic hash: it keys caches, it does not authenticate data.
+/// see: http://www.isthe.com/chongo/tech/comp/fnv/index.html
+constexpr Hash hashBytes(std::span<const std::byte> aBytes, Hash aSeed = 0xcbf29ce484222325ull)
+{
+    Hash hash = aSeed;
+    for(std::byte byte : aBytes)
+    {
+        hash ^= (uint8_t)byte;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+
+/// @brief Mixes aValue into aSeed, to hash structures member by member.
+constexpr Hash hashCombine(Hash aSeed, uint64_t aValue)
+{
+    // The 64-bit variant of boost::hash_combine
+    return aSeed ^ (aValue + 0x9e3779b97f4a7c15ull + (aSeed << 12) + (aSeed >> 4));
+}
@@ -0,0 +1,353 @@
+#pragma once
+
+
+#include "DrawSorting.h"
+#include "FrustumCulling.h"
+#include "UploadService.h"
+#include "VertexData.h"
+#include "VulkanHelpers.h"
+#include "WorkerPool.h"
+
+#include <array>
+#include <random>
+#include <span>
+#include <vector>
+
+#include <cmath>
+
+
+// Toggle between the ways to issue the draws of the objects scene.
+enum class DrawPath
+{
+    // One vkCmdDrawIndexed() per object, recorded by the CPU
+    PerDrawCpu,
+    // As PerDrawCpu, only for the objects within the frustum, culled by the CPU beforehand (see FrustumCulling.h),
+    // and recorded front to back (see DrawSorting.h)
+    PerDrawCpuCulled,
+    // A single vkCmdDrawIndexedIndirectCount() sourcing all draw records from a GPU buffer
+    // (requires the drawIndirectFirstInstance feature, see generateDrawRecords())
+    IndirectCount,
+    // As IndirectCount, after a compute pass compacted the records of objects within the frustum
+    IndirectCountCulled,
+};
+
+
+/// @brief Per-object record, directly usable as an indirect draw command.
+/// @note Must match DrawRecord in Indirect.vert and Cull.comp
+struct DrawRecord
+{
+    VkDrawIndexedIndirectCommand mCommand;
+    // xyz: translation, w: uniform scale
+    std::array<float, 4> mTranslationScale;
+};
+// Indirect stride must be a multiple of 4, at least sizeof(VkDrawIndexedIndirectCommand)
+static_assert(sizeof(DrawRecord) % 4 == 0);
+
+
+/// @note Must match the push constants in Cull.comp
+struct CullPushConstants
+{
+    // First, the shader aligns its vec4 planes on 16 bytes
+    Frustum mFrustum;
+    VkDeviceAddress mObjects;
+    VkDeviceAddress mVisible;
+    VkDeviceAddress mVisibleCount;
+    uint32_t mObjectCount;
+    float mMeshRadius;
+};
+// Guaranteed minimum of maxPushConstantsSize
+static_assert(sizeof(CullPushConstants) <= 128);
+
+
+/// @brief Draws many instances of a single indexed mesh, each object having its own draw record.
+struct ObjectScene
+{
+    void destroy()
+    {
+        for(auto [buffer, memory] : {mRecords, mVisible, mVisibleCount})
+        {
+            vkDestroyBuffer(vkDevice, buffer, pAllocator);
+            vkFreeMemory(vkDevice, memory, pAllocator);
+        }
+        vkDestroyShaderEXT(vkDevice, mCullShader, pAllocator);
+        vkDestroyPipelineLayout(vkDevice, mCullLayout, pAllocator);
+        for(VkShaderEXT shader : mDrawShaders)
+        {
+            vkDestroyShaderEXT(vkDevice, shader, pAllocator);
+        }
+        vkDestroyPipelineLayout(vkDevice, mDrawLayout, pAllocator);
+    }
+
+    VkDevice vkDevice; // required for Dtor
+
+    // CPU copy of the records, used by the per-draw paths
+    std::vector<DrawRecord> mCpuRecords;
+    float mMeshRadius;
+    // Bounds of the objects, indices of the visible records, and their draw order (for the CPU culled path)
+    BoundingVolumes mVolumes;
+    std::vector<uint32_t> mCpuVisible;
+    std::vector<SortedDraw> mCpuSorted;
+    std::vector<SortedDraw> mSortScratch;
+
+    // Input records, one per object (at the object index)
+    std::pair<VkBuffer, VkDeviceMemory> mRecords;
+    // Compacted records of the visible objects, written by the culling pass
+    std::pair<VkBuffer, VkDeviceMemory> mVisible;
+    // Draw count for vkCmdDrawIndexedIndirectCount(), either all objects or the visible objects
+    std::pair<VkBuffer, VkDeviceMemory> mVisibleCount;
+    UploadService::Ticket mUpload;
+
+    VkPipelineLayout mDrawLayout;
+    // Vertex and fragment
+    std::vector<VkShaderEXT> mDrawShaders;
+    VkPipelineLayout mCullLayout{VK_NULL_HANDLE};
+    VkShaderEXT mCullShader{VK_NULL_HANDLE};
+};
+
+
+/// @brief Generate aObjectCount draw records of the indexed mesh, randomly placed in (and around) the clip volume.
+std::vector<DrawRecord> generateDrawRecords(uint32_t aObjectCount, uint32_t aIndexCount)
+{
+    std::minstd_rand generator{aObjectCount};
+    // Some objects are placed outside of the clip volume, to be culled.
+    std::uniform_real_distribution<float> position{-1.5f, 1.5f};
+    std::uniform_real_distribution<float> depth{0.f, 1.f};
+    // Shrink objects as their number increases, to keep the screen readable
+    const float scale = std::max(0.005f, 1.f / std::sqrt((float)aObjectCount));
+
+    std::vector<DrawRecord> records(aObjectCount);
+    for(uint32_t objectIdx = 0; objectIdx != aObjectCount; ++objectIdx)
+    {
+        records[objectIdx] = DrawRecord{
+            .mCommand = {
+                .indexCount = aIndexCount,
+                .instanceCount = 1,
+                .firstIndex = 0,
+                .vertexOffset = 0,
+                // Gives access to the object record from the vertex shader, via gl_InstanceIndex
+                // (indirect draws require the drawIndirectFirstInstance feature for a non-zero value)
+                .firstInstance = objectIdx,
+            },
+            .mTranslationScale = {position(generator), position(generator), depth(generator), scale},
+        };
+    }
+    return records;
+}
+
+
+ObjectScene createObjectScene(VkDevice vkDevice,
+                              UploadService & aUploadService,
+                              uint32_t aDeviceLocalMemoryTypeIndex,
+                              std::span<const DrawRecord> aRecords,
+                              float aMeshRadius,
+                              const Aabb & aMeshBounds,
+                              std::span<const char> aVertexCode,
+                              std::span<const char> aFragmentCode,
+                              std::span<const char> aCullCode)
+{
+    const VkDeviceSize recordsSize = aRecords.size_bytes();
+    const VkBufferUsageFlags usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+                                     | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT
+                                     | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+    ObjectScene scene{
+        .vkDevice = vkDevice,
+        .mCpuRecords{aRecords.begin(), aRecords.end()},
+        .mMeshRadius = aMeshRadius,
+        .mCpuVisible = std::vector<uint32_t>(aRecords.size()),
+        .mRecords = createBuffer(vkDevice, recordsSize, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                 aDeviceLocalMemoryTypeIndex, VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT),
+        .mVisible = createBuffer(vkDevice, recordsSize, usage,
+                                 aDeviceLocalMemoryTypeIndex, VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT),
+        .mVisibleCount = createBuffer(vkDevice, sizeof(uint32_t), usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                      aDeviceLocalMemoryTypeIndex, VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT),
+    };
+    // The records translate and uniformly scale the mesh
+    scene.mVolumes.resize(aRecords.size());
+    for(std::size_t objectIdx = 0; objectIdx != aRecords.size(); ++objectIdx)
+    {
+        const auto [x, y, z, scale] = aRecords[objectIdx].mTranslationScale;
+        scene.mVolumes.set(objectIdx,
+                           Sphere{.mCenter = {x, y, z}, .mRadius = aMeshRadius * scale},
+                           Aabb{
+                               .mMin = {x + aMeshBounds.mMin.x * scale, y + aMeshBounds.mMin.y * scale, z + aMeshBounds.mMin.z * scale},
+                               .mMax = {x + aMeshBounds.mMax.x * scale, y + aMeshBounds.mMax.y * scale, z + aMeshBounds.mMax.z * scale},
+                           });
+    }
+
+    nameObject(vkDevice, scene.mRecords.first, "object_records");
+    nameObject(vkDevice, scene.mVisible.first, "object_visible_records");
+    nameObject(vkDevice, scene.mVisibleCount.first, "object_visible_count");
+
+    // Records are read as indirect commands and by the shaders
+    const VkPipelineStageFlags2 recordStages = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT
+                                               | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT
+                                               | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    const VkAccessFlags2 recordAccesses = VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT;
+    aUploadService.uploadBuffer(scene.mRecords.first, 0, std::as_bytes(aRecords), recordStages, recordAccesses);
+    // Without culling, all the objects are drawn.
+    // (The culling pass resets the count before accumulating into it)
+    const uint32_t objectCount = (uint32_t)aRecords.size();
+    scene.mUpload = aUploadService.uploadBuffer(scene.mVisibleCount.first, 0,
+                                                std::as_bytes(std::span{&objectCount, 1}),
+                                                recordStages | VK_PIPELINE_STAGE_2_CLEAR_BIT,
+                                                recordAccesses | VK_ACCESS_2_TRANSFER_WRITE_BIT);
+
+    // Push constant ranges are reflected, and checked against the structures pushed when recording
+    const ShaderReflection * drawShaders[]{&getReflection(aVertexCode), &getReflection(aFragmentCode)};
+    const std::vector<VkPushConstantRange> drawPushConstantRanges = getPushConstantRanges(drawShaders);
+    assert(drawPushConstantRanges.size() == 1 && drawPushConstantRanges[0].size == sizeof(VkDeviceAddress));
+    scene.mDrawLayout = createPushConstantLayout(vkDevice, drawPushConstantRanges);
+    scene.mDrawShaders = createShaderObjects(vkDevice, aVertexCode, aFragmentCode, drawPushConstantRanges);
+
+    if(!aCullCode.empty())
+    {
+        const ShaderReflection * cullShaders[]{&getReflection(aCullCode)};
+        const std::vector<VkPushConstantRange> cullPushConstantRanges = getPushConstantRanges(cullShaders);
+        assert(cullPushConstantRanges.size() == 1 && cullPushConstantRanges[0].size == sizeof(CullPushConstants));
+        scene.mCullLayout = createPushConstantLayout(vkDevice, cullPushConstantRanges);
+        scene.mCullShader = createComputeShaderObject(vkDevice, aCullCode, cullPushConstantRanges);
+    }
+
+    return scene;
+}
+
+
+/// @brief Record the compute pass compacting the records of objects within aFrustum.
+/// @note Must be recorded outside of a render pass instance, before recordObjectDraws().
+void recordCulling(VkCommandBuffer vkCommandBuffer, const ObjectScene & aScene, const Frustum & aFrustum)
+{
+    assert(aScene.mCullShader != VK_NULL_HANDLE);
+
+    const VkDevice vkDevice = aScene.vkDevice;
+    const VkBuffer countBuffer = aScene.mVisibleCount.first;
+
+    auto recordMemoryBarrier = [vkCommandBuffer](VkPipelineStageFlags2 aSrcStage, VkAccessFlags2 aSrcAccess,
+                                                 VkPipelineStageFlags2 aDstStage, VkAccessFlags2 aDstAccess)
+    {
+        VkMemoryBarrier2 memoryBarrier2{
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+            .srcStageMask = aSrcStage,
+            .srcAccessMask = aSrcAccess,
+            .dstStageMask = aDstStage,
+            .dstAccessMask = aDstAccess,
+        };
+        VkDependencyInfo dependencyInfo{
+            .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .memoryBarrierCount = 1,
+            .pMemoryBarriers = &memoryBarrier2,
+        };
+        vkCmdPipelineBarrier2(vkCommandBuffer, &dependencyInfo);
+    };
+
+    // The previous frame draws have to be done reading the visible records before they are overwritten.
+    recordMemoryBarrier(VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT, VK_ACCESS_2_NONE,
+                        VK_PIPELINE_STAGE_2_CLEAR_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_NONE);
+    vkCmdFillBuffer(vkCommandBuffer, countBuffer, 0, sizeof(uint32_t), 0);
+    recordMemoryBarrier(VK_PIPELINE_STAGE_2_CLEAR_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                        VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+
+    const VkShaderStageFlagBits stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    vkCmdBindShadersEXT(vkCommandBuffer, 1, &stage, &aScene.mCullShader);
+
+    const uint32_t objectCount = (uint32_t)aScene.mCpuRecords.size();
+    CullPushConstants pushConstants{
+        .mFrustum = aFrustum,
+        .mObjects = getBufferDeviceAddress(vkDevice, aScene.mRecords.first),
+        .mVisible = getBufferDeviceAddress(vkDevice, aScene.mVisible.first),
+        .mVisibleCount = getBufferDeviceAddress(vkDevice, countBuffer),
+        .mObjectCount = objectCount,
+        .mMeshRadius = aScene.mMeshRadius,
+    };
+    vkCmdPushConstants(vkCommandBuffer, aScene.mCullLayout, VK_SHADER_STAGE_COMPUTE_BIT,
+                       0, sizeof(pushConstants), &pushConstants);
+
+    // Must match local_size_x in Cull.comp
+    constexpr uint32_t gWorkgroupSize = 64;
+    vkCmdDispatch(vkCommandBuffer, (objectCount + gWorkgroupSize - 1) / gWorkgroupSize, 1, 1);
+
+    recordMemoryBarrier(VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                        VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT,
+                        VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT);
+}
+
+
+/// @brief Compacts the indices of the records of objects within aFrustum, and sorts them into draw order,
+/// for the PerDrawCpuCulled path.
+void cullObjects(ObjectScene & aScene, const Frustum & aFrustum, WorkerPool & aWorkerPool)
+{
+    const uint32_t visibleCount = culling::cull(aScene.mVolumes, aFrustum, aScene.mCpuVisible, aWorkerPool);
+    aScene.mCpuSorted.resize(visibleCount);
+    for(uint32_t visibleIdx = 0; visibleIdx != visibleCount; ++visibleIdx)
+    {
+        // The objects share their shaders and have no material: the depth orders them (front to back, for early depth tests).
+        const uint32_t objectIdx = aScene.mCpuVisible[visibleIdx];
+        aScene.mCpuSorted[visibleIdx] = SortedDraw{
+            .mKey = drawkey::make(0, 0, 0, aScene.mCpuRecords[objectIdx].mTranslationScale[2]),
+            .mDrawIdx = objectIdx,
+        };
+    }
+    drawsort::sort(aScene.mCpuSorted, aScene.mSortScratch, aWorkerPool);
+}
+
+
+/// @brief Record the draws of all objects of aScene, following aPath.
+/// @note Vertex and index buffers, as well as the dynamic state, must already be set.
+/// The draw shaders are bound by this function.
+/// @return The binds and draw calls recorded.
+drawsort::BindCounts recordObjectDraws(VkCommandBuffer vkCommandBuffer, const ObjectScene & aScene, DrawPath aPath)
+{
+    auto bindShaders = [&](uint32_t /*aPass*/, uint32_t /*aPipeline*/)
+    {
+        const VkShaderStageFlagBits stageBits[]{
+            VK_SHADER_STAGE_VERTEX_BIT,
+            VK_SHADER_STAGE_FRAGMENT_BIT,
+        };
+        vkCmdBindShadersEXT(vkCommandBuffer, (uint32_t)aScene.mDrawShaders.size(), stageBits, aScene.mDrawShaders.data());
+
+        // The vertex shader always reads the input records, at the object index
+        const VkDeviceAddress records = getBufferDeviceAddress(aScene.vkDevice, aScene.mRecords.first);
+        vkCmdPushConstants(vkCommandBuffer, aScene.mDrawLayout, VK_SHADER_STAGE_VERTEX_BIT,
+                           0, sizeof(records), &records);
+    };
+    auto drawObject = [&](uint32_t aObjectIdx)
+    {
+        const VkDrawIndexedIndirectCommand & command = aScene.mCpuRecords[aObjectIdx].mCommand;
+        vkCmdDrawIndexed(vkCommandBuffer,
+                         command.indexCount, command.instanceCount, command.firstIndex,
+                         command.vertexOffset, command.firstInstance);
+    };
+
+    const uint32_t objectCount = (uint32_t)aScene.mCpuRecords.size();
+    drawsort::BindCounts result{.mPipelines = 1, .mDraws = 1};
+    switch(aPath)
+    {
+        case DrawPath::PerDrawCpu:
+            bindShaders(0, 0);
+            for(uint32_t objectIdx = 0; objectIdx != objectCount; ++objectIdx)
+            {
+                drawObject(objectIdx);
+            }
+            result.mDraws = objectCount;
+            break;
+        case DrawPath::PerDrawCpuCulled:
+            // Binds where the draw keys change
+            result = drawsort::record(aScene.mCpuSorted, bindShaders, [](uint32_t /*aMaterial*/){}, drawObject);
+            break;
+        case DrawPath::IndirectCount:
+            bindShaders(0, 0);
+            vkCmdDrawIndexedIndirectCount(vkCommandBuffer,
+                                          aScene.mRecords.first, 0,
+                                          aScene.mVisibleCount.first, 0,
+                                          objectCount, sizeof(DrawRecord));
+            break;
+        case DrawPath::IndirectCountCulled:
+            bindShaders(0, 0);
+            vkCmdDrawIndexedIndirectCount(vkCommandBuffer,
+                                          aScene.mVisible.first, 0,
+                                          aScene.mVisibleCount.first, 0,
+                                          objectCount, sizeof(DrawRecord));
+            break;
+    }
+    return result;
+}
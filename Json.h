@@ -0,0 +1,360 @@
+#pragma once
+
+
+#include <charconv>
+#include <concepts>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <cstdint>
+
+
+// Minimal JSON reader (RFC 8259), building a read-only tree. Enough for asset descriptions such as glTF:
+// the documents are small compared to the binary data they reference, so the tree favours simplicity over speed.
+namespace json {
+
+    class Value
+    {
+    public:
+        using Array = std::vector<Value>;
+        // Members in document order, looked up linearly (objects have a handful of members)
+        using Object = std::vector<std::pair<std::string, Value>>;
+
+        Value() = default;
+
+        template <class T_data>
+            requires (!std::same_as<std::remove_cvref_t<T_data>, Value>)
+        explicit Value(T_data aData) :
+            mData{std::move(aData)}
+        {}
+
+        bool isNull() const { return std::holds_alternative<std::nullptr_t>(mData); }
+        bool isBool() const { return std::holds_alternative<bool>(mData); }
+        bool isNumber() const { return std::holds_alternative<double>(mData); }
+        bool isString() const { return std::holds_alternative<std::string>(mData); }
+        bool isArray() const { return std::holds_alternative<Array>(mData); }
+        bool isObject() const { return std::holds_alternative<Object>(mData); }
+
+        /// @throw std::invalid_argument if the value is not of the requested type.
+        bool asBool() const { return get<bool>("a boolean"); }
+        double asNumber() const { return get<double>("a number"); }
+        const std::string & asString() const { return get<std::string>("a string"); }
+        const Array & asArray() const { return get<Array>("an array"); }
+        const Object & asObject() const { return get<Object>("an object"); }
+
+        /// @return The member aKey, nullptr if this is not an object or has no such member.
+        const Value * find(std::string_view aKey) const
+        {
+            if(const Object * object = std::get_if<Object>(&mData))
+            {
+                for(const auto & [key, value] : *object)
+                {
+                    if(key == aKey)
+                    {
+                        return &value;
+                    }
+                }
+            }
+            return nullptr;
+        }
+
+        /// @throw std::invalid_argument if there is no member aKey.
+        const Value & operator[](std::string_view aKey) const
+        {
+            if(const Value * value = find(aKey))
+            {
+                return *value;
+            }
+            throw std::invalid_argument{"JSON member '" + std::string{aKey} + "' is missing."};
+        }
+
+        const Value & operator[](std::size_t aIndex) const
+        {
+            const Array & array = asArray();
+            if(aIndex >= array.size())
+            {
+                throw std::invalid_argument{"JSON array index " + std::to_string(aIndex) + " is out of range."};
+            }
+            return array[aIndex];
+        }
+
+        /// @brief The number member aKey, or aDefault if it is absent.
+        double getNumber(std::string_view aKey, double aDefault) const
+        {
+            const Value * value = find(aKey);
+            return value ? value->asNumber() : aDefault;
+        }
+
+        /// @brief The elements of the array member aKey, empty if it is absent.
+        const Array & getArray(std::string_view aKey) const
+        {
+            static const Array gEmpty;
+            const Value * value = find(aKey);
+            return value ? value->asArray() : gEmpty;
+        }
+
+    private:
+        template <class T_type>
+        const T_type & get(const char * aTypeName) const
+        {
+            if(const T_type * value = std::get_if<T_type>(&mData))
+            {
+                return *value;
+            }
+            throw std::invalid_argument{std::string{"JSON value is not "} + aTypeName + "."};
+        }
+
+        std::variant<std::nullptr_t, bool, double, std::string, Array, Object> mData{nullptr};
+    };
+
+
+    namespace detail {
+
+        class Parser
+        {
+        public:
+            explicit Parser(std::string_view aText) :
+                mText{aText}
+            {}
+
+            Value parseDocument()
+            {
+                Value result = parseValue(0);
+                skipWhitespace();
+                if(mPosition != mText.size())
+                {
+                    fail("trailing characters");
+                }
+                return result;
+            }
+
+        private:
+            // Bounds the recursion on hostile documents
+            static constexpr unsigned int gMaxDepth = 256;
+
+            [[noreturn]] void fail(const char * aReason) const
+            {
+                throw std::invalid_argument{"Invalid JSON at offset " + std::to_string(mPosition) + ": " + aReason + "."};
+            }
+
+            void skipWhitespace()
+            {
+                while(mPosition != mText.size()
+                      && (mText[mPosition] == ' ' || mText[mPosition] == '\t'
+                          || mText[mPosition] == '\n' || mText[mPosition] == '\r'))
+                {
+                    ++mPosition;
+                }
+            }
+
+            char peek()
+            {
+                skipWhitespace();
+                if(mPosition == mText.size())
+                {
+                    fail("unexpected end");
+                }
+                return mText[mPosition];
+            }
+
+            void expect(char aCharacter)
+            {
+                if(peek() != aCharacter)
+                {
+                    fail("unexpected character");
+                }
+                ++mPosition;
+            }
+
+            void expectWord(std::string_view aWord)
+            {
+                if(mText.substr(mPosition, aWord.size()) != aWord)
+                {
+                    fail("invalid literal");
+                }
+                mPosition += aWord.size();
+            }
+
+            Value parseValue(unsigned int aDepth)
+            {
+                if(aDepth > gMaxDepth)
+                {
+                    fail("too deeply nested");
+                }
+                switch(peek())
+                {
+                    case '{':
+                    {
+                        ++mPosition;
+                        Value::Object object;
+                        // A comma is always followed by a member
+                        for(bool more = peek() != '}'; more; more = (peek() == ','))
+                        {
+                            if(!object.empty())
+                            {
+                                ++mPosition;
+                            }
+                            std::string key = parseString();
+                            expect(':');
+                            object.emplace_back(std::move(key), parseValue(aDepth + 1));
+                        }
+                        expect('}');
+                        return Value{std::move(object)};
+                    }
+                    case '[':
+                    {
+                        ++mPosition;
+                        Value::Array array;
+                        for(bool more = peek() != ']'; more; more = (peek() == ','))
+                        {
+                            if(!array.empty())
+                            {
+                                ++mPosition;
+                            }
+                            array.push_back(parseValue(aDepth + 1));
+                        }
+                        expect(']');
+                        return Value{std::move(array)};
+                    }
+                    case '"':
+                        return Value{parseString()};
+                    case 't':
+                        expectWord("true");
+                        return Value{true};
+                    case 'f':
+                        expectWord("false");
+                        return Value{false};
+                    case 'n':
+                        expectWord("null");
+                        return Value{};
+                    default:
+                        return Value{parseNumber()};
+                }
+            }
+
+            double parseNumber()
+            {
+                double result;
+                const char * first = mText.data() + mPosition;
+                const char * last = mText.data() + mText.size();
+                auto [end, error] = std::from_chars(first, last, result);
+                if(error != std::errc{})
+                {
+                    fail("invalid number");
+                }
+                mPosition += end - first;
+                return result;
+            }
+
+            std::string parseString()
+            {
+                expect('"');
+                std::string result;
+                while(true)
+                {
+                    if(mPosition == mText.size())
+                    {
+                        fail("unterminated string");
+                    }
+                    const char character = mText[mPosition++];
+                    if(character == '"')
+                    {
+                        return result;
+                    }
+                    if(character != '\\')
+                    {
+                        result.push_back(character);
+                        continue;
+                    }
+                    if(mPosition == mText.size())
+                    {
+                        fail("unterminated string");
+                    }
+                    switch(const char escaped = mText[mPosition++])
+                    {
+                        case 'b': result.push_back('\b'); break;
+                        case 'f': result.push_back('\f'); break;
+                        case 'n': result.push_back('\n'); break;
+                        case 'r': result.push_back('\r'); break;
+                        case 't': result.push_back('\t'); break;
+                        case 'u': appendUtf8(parseCodePoint(), result); break;
+                        default: result.push_back(escaped); break; // '"', '\\' and '/'
+                    }
+                }
+            }
+
+            uint32_t parseHex4()
+            {
+                if(mText.size() - mPosition < 4)
+                {
+                    fail("invalid unicode escape");
+                }
+                uint32_t result;
+                const char * first = mText.data() + mPosition;
+                auto [end, error] = std::from_chars(first, first + 4, result, 16);
+                if(error != std::errc{} || end != first + 4)
+                {
+                    fail("invalid unicode escape");
+                }
+                mPosition += 4;
+                return result;
+            }
+
+            uint32_t parseCodePoint()
+            {
+                uint32_t codePoint = parseHex4();
+                // Surrogate pair
+                if(codePoint >= 0xd800 && codePoint < 0xdc00 && mText.substr(mPosition, 2) == "\\u")
+                {
+                    mPosition += 2;
+                    const uint32_t low = parseHex4();
+                    codePoint = 0x10000 + ((codePoint - 0xd800) << 10) + (low - 0xdc00);
+                }
+                return codePoint;
+            }
+
+            static void appendUtf8(uint32_t aCodePoint, std::string & aOut)
+            {
+                if(aCodePoint < 0x80)
+                {
+                    aOut.push_back((char)aCodePoint);
+                }
+                else if(aCodePoint < 0x800)
+                {
+                    aOut.push_back((char)(0xc0 | (aCodePoint >> 6)));
+                    aOut.push_back((char)(0x80 | (aCodePoint & 0x3f)));
+                }
+                else if(aCodePoint < 0x10000)
+                {
+                    aOut.push_back((char)(0xe0 | (aCodePoint >> 12)));
+                    aOut.push_back((char)(0x80 | ((aCodePoint >> 6) & 0x3f)));
+                    aOut.push_back((char)(0x80 | (aCodePoint & 0x3f)));
+                }
+                else
+                {
+                    aOut.push_back((char)(0xf0 | (aCodePoint >> 18)));
+                    aOut.push_back((char)(0x80 | ((aCodePoint >> 12) & 0x3f)));
+                    aOut.push_back((char)(0x80 | ((aCodePoint >> 6) & 0x3f)));
+                    aOut.push_back((char)(0x80 | (aCodePoint & 0x3f)));
+                }
+            }
+
+            std::string_view mText;
+            std::size_t mPosition{0};
+        };
+
+    } // namespace detail
+
+
+    /// @throw std::invalid_argument if aText is not a valid JSON document.
+    inline Value parse(std::string_view aText)
+    {
+        return detail::Parser{aText}.parseDocument();
+    }
+
+} // namespace json
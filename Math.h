@@ -0,0 +1,567 @@
+#pragma once
+
+
+#include "Simd.h"
+
+#include <array>
+#include <span>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+
+// Vector, matrix and quaternion math for transforms, vectorized with the instruction set selected in Simd.h.
+//
+// Conventions, matching GLSL and glTF:
+// * matrices are column-major (columns are contiguous) and transform column vectors: `M * v`
+// * the world is right-handed, y up; the view looks down -z
+// * projections target the Vulkan clip volume: y points down, depth in [0, 1]
+//
+// math::scalar holds the reference implementations of the vectorized functions, always compiled,
+// so the intrinsics paths can be checked against them (see tools/MathBenchmark.cpp).
+namespace math {
+
+    struct Vec3
+    {
+        float x, y, z;
+    };
+
+    struct alignas(16) Vec4
+    {
+        float x, y, z, w;
+    };
+
+    /// @brief Rotation quaternion (unit length), the vector part first as in glTF.
+    struct alignas(16) Quat
+    {
+        float x, y, z, w;
+    };
+
+    struct alignas(16) Mat4
+    {
+        std::array<Vec4, 4> mColumns;
+
+        const float * data() const
+        {
+            return &mColumns[0].x;
+        }
+
+        float * data()
+        {
+            return &mColumns[0].x;
+        }
+
+        /// @param aValues 16 floats, column-major (e.g. a glTF node matrix).
+        static Mat4 fromColumnMajor(const float * aValues)
+        {
+            Mat4 result;
+            std::memcpy(result.data(), aValues, sizeof(Mat4));
+            return result;
+        }
+    };
+
+    static_assert(sizeof(Mat4) == 16 * sizeof(float));
+
+
+    //
+    // Vectors
+    //
+    constexpr Vec3 operator+(const Vec3 & aLeft, const Vec3 & aRight)
+    {
+        return {aLeft.x + aRight.x, aLeft.y + aRight.y, aLeft.z + aRight.z};
+    }
+
+    constexpr Vec3 operator-(const Vec3 & aLeft, const Vec3 & aRight)
+    {
+        return {aLeft.x - aRight.x, aLeft.y - aRight.y, aLeft.z - aRight.z};
+    }
+
+    constexpr Vec3 operator*(const Vec3 & aVector, float aScalar)
+    {
+        return {aVector.x * aScalar, aVector.y * aScalar, aVector.z * aScalar};
+    }
+
+    constexpr float dot(const Vec3 & aLeft, const Vec3 & aRight)
+    {
+        return aLeft.x * aRight.x + aLeft.y * aRight.y + aLeft.z * aRight.z;
+    }
+
+    constexpr Vec3 cross(const Vec3 & aLeft, const Vec3 & aRight)
+    {
+        return {
+            aLeft.y * aRight.z - aLeft.z * aRight.y,
+            aLeft.z * aRight.x - aLeft.x * aRight.z,
+            aLeft.x * aRight.y - aLeft.y * aRight.x,
+        };
+    }
+
+    inline float length(const Vec3 & aVector)
+    {
+        return std::sqrt(dot(aVector, aVector));
+    }
+
+    inline Vec3 normalize(const Vec3 & aVector)
+    {
+        return aVector * (1.f / length(aVector));
+    }
+
+    inline Vec4 operator+(const Vec4 & aLeft, const Vec4 & aRight)
+    {
+#if defined(SIMD_SSE2)
+        Vec4 result;
+        _mm_store_ps(&result.x, _mm_add_ps(_mm_load_ps(&aLeft.x), _mm_load_ps(&aRight.x)));
+        return result;
+#elif defined(SIMD_NEON)
+        Vec4 result;
+        vst1q_f32(&result.x, vaddq_f32(vld1q_f32(&aLeft.x), vld1q_f32(&aRight.x)));
+        return result;
+#else
+        return {aLeft.x + aRight.x, aLeft.y + aRight.y, aLeft.z + aRight.z, aLeft.w + aRight.w};
+#endif
+    }
+
+    inline Vec4 operator*(const Vec4 & aVector, float aScalar)
+    {
+#if defined(SIMD_SSE2)
+        Vec4 result;
+        _mm_store_ps(&result.x, _mm_mul_ps(_mm_load_ps(&aVector.x), _mm_set1_ps(aScalar)));
+        return result;
+#elif defined(SIMD_NEON)
+        Vec4 result;
+        vst1q_f32(&result.x, vmulq_n_f32(vld1q_f32(&aVector.x), aScalar));
+        return result;
+#else
+        return {aVector.x * aScalar, aVector.y * aScalar, aVector.z * aScalar, aVector.w * aScalar};
+#endif
+    }
+
+    inline float dot(const Vec4 & aLeft, const Vec4 & aRight)
+    {
+        return aLeft.x * aRight.x + aLeft.y * aRight.y + aLeft.z * aRight.z + aLeft.w * aRight.w;
+    }
+
+
+    //
+    // Quaternions
+    //
+    inline Quat fromAxisAngle(const Vec3 & aAxis, float aRadians)
+    {
+        const Vec3 axis = normalize(aAxis) * std::sin(0.5f * aRadians);
+        return {axis.x, axis.y, axis.z, std::cos(0.5f * aRadians)};
+    }
+
+    /// @brief The rotation aRight followed by aLeft (Hamilton product).
+    constexpr Quat operator*(const Quat & aLeft, const Quat & aRight)
+    {
+        return {
+            aLeft.w * aRight.x + aLeft.x * aRight.w + aLeft.y * aRight.z - aLeft.z * aRight.y,
+            aLeft.w * aRight.y - aLeft.x * aRight.z + aLeft.y * aRight.w + aLeft.z * aRight.x,
+            aLeft.w * aRight.z + aLeft.x * aRight.y - aLeft.y * aRight.x + aLeft.z * aRight.w,
+            aLeft.w * aRight.w - aLeft.x * aRight.x - aLeft.y * aRight.y - aLeft.z * aRight.z,
+        };
+    }
+
+    inline Quat normalize(const Quat & aQuat)
+    {
+        const float scale =
+            1.f / std::sqrt(aQuat.x * aQuat.x + aQuat.y * aQuat.y + aQuat.z * aQuat.z + aQuat.w * aQuat.w);
+        return {aQuat.x * scale, aQuat.y * scale, aQuat.z * scale, aQuat.w * scale};
+    }
+
+    constexpr Vec3 rotate(const Quat & aQuat, const Vec3 & aVector)
+    {
+        // v + 2w (q x v) + 2 q x (q x v)
+        const Vec3 axis{aQuat.x, aQuat.y, aQuat.z};
+        const Vec3 t = cross(axis, aVector) * 2.f;
+        return aVector + t * aQuat.w + cross(axis, t);
+    }
+
+    /// @brief Normalized linear interpolation, along the shortest arc.
+    /// Close to slerp for the small angles between animation keys, at a fraction of the cost.
+    inline Quat nlerp(const Quat & aFrom, const Quat & aTo, float aRatio)
+    {
+        const float sign = (aFrom.x * aTo.x + aFrom.y * aTo.y + aFrom.z * aTo.z + aFrom.w * aTo.w) < 0.f ? -1.f : 1.f;
+        const float from = 1.f - aRatio;
+        const float to = aRatio * sign;
+        return normalize(Quat{
+            aFrom.x * from + aTo.x * to,
+            aFrom.y * from + aTo.y * to,
+            aFrom.z * from + aTo.z * to,
+            aFrom.w * from + aTo.w * to,
+        });
+    }
+
+
+    //
+    // Matrices construction
+    //
+    constexpr Mat4 gIdentity{{{
+        {1.f, 0.f, 0.f, 0.f},
+        {0.f, 1.f, 0.f, 0.f},
+        {0.f, 0.f, 1.f, 0.f},
+        {0.f, 0.f, 0.f, 1.f},
+    }}};
+
+    /// @brief translation * rotation * scale, the glTF node transform.
+    constexpr Mat4 composeTrs(const Vec3 & aTranslation, const Quat & aRotation, const Vec3 & aScale)
+    {
+        const auto [x, y, z, w] = aRotation;
+        return {{{
+            {(1.f - 2.f * (y * y + z * z)) * aScale.x, 2.f * (x * y + z * w) * aScale.x, 2.f * (x * z - y * w) * aScale.x, 0.f},
+            {2.f * (x * y - z * w) * aScale.y, (1.f - 2.f * (x * x + z * z)) * aScale.y, 2.f * (y * z + x * w) * aScale.y, 0.f},
+            {2.f * (x * z + y * w) * aScale.z, 2.f * (y * z - x * w) * aScale.z, (1.f - 2.f * (x * x + y * y)) * aScale.z, 0.f},
+            {aTranslation.x, aTranslation.y, aTranslation.z, 1.f},
+        }}};
+    }
+
+    constexpr Mat4 translation(const Vec3 & aOffset)
+    {
+        return composeTrs(aOffset, {0.f, 0.f, 0.f, 1.f}, {1.f, 1.f, 1.f});
+    }
+
+    constexpr Mat4 rotation(const Quat & aRotation)
+    {
+        return composeTrs({0.f, 0.f, 0.f}, aRotation, {1.f, 1.f, 1.f});
+    }
+
+    /// @brief View matrix, from the world to the space of a camera at aEye looking at aTarget.
+    inline Mat4 lookAt(const Vec3 & aEye, const Vec3 & aTarget, const Vec3 & aUp)
+    {
+        const Vec3 back = normalize(aEye - aTarget);
+        const Vec3 right = normalize(cross(aUp, back));
+        const Vec3 up = cross(back, right);
+        return {{{
+            {right.x, up.x, back.x, 0.f},
+            {right.y, up.y, back.y, 0.f},
+            {right.z, up.z, back.z, 0.f},
+            {-dot(right, aEye), -dot(up, aEye), -dot(back, aEye), 1.f},
+        }}};
+    }
+
+    /// @brief Perspective projection to the Vulkan clip volume (y down, depth in [0, 1]).
+    /// @param aVerticalFov In radians.
+    inline Mat4 perspective(float aVerticalFov, float aAspectRatio, float aNear, float aFar)
+    {
+        const float focal = 1.f / std::tan(0.5f * aVerticalFov);
+        const float depthScale = aFar / (aNear - aFar);
+        return {{{
+            {focal / aAspectRatio, 0.f, 0.f, 0.f},
+            {0.f, -focal, 0.f, 0.f},
+            {0.f, 0.f, depthScale, -1.f},
+            {0.f, 0.f, aNear * depthScale, 0.f},
+        }}};
+    }
+
+    /// @brief Orthographic projection of the view box to the Vulkan clip volume (y down, depth in [0, 1]).
+    constexpr Mat4 orthographic(float aLeft, float aRight, float aBottom, float aTop, float aNear, float aFar)
+    {
+        return {{{
+            {2.f / (aRight - aLeft), 0.f, 0.f, 0.f},
+            {0.f, -2.f / (aTop - aBottom), 0.f, 0.f},
+            {0.f, 0.f, 1.f / (aNear - aFar), 0.f},
+            {-(aRight + aLeft) / (aRight - aLeft), (aTop + aBottom) / (aTop - aBottom), aNear / (aNear - aFar), 1.f},
+        }}};
+    }
+
+    constexpr Mat4 transpose(const Mat4 & aMatrix)
+    {
+        const auto & c = aMatrix.mColumns;
+        return {{{
+            {c[0].x, c[1].x, c[2].x, c[3].x},
+            {c[0].y, c[1].y, c[2].y, c[3].y},
+            {c[0].z, c[1].z, c[2].z, c[3].z},
+            {c[0].w, c[1].w, c[2].w, c[3].w},
+        }}};
+    }
+
+    /// @brief Inverse of an affine transform made of a rotation, a uniform or non-uniform scale and a translation.
+    inline Mat4 inverseAffine(const Mat4 & aMatrix)
+    {
+        const auto & c = aMatrix.mColumns;
+        // Inverse of the upper 3x3 by the adjugate
+        const Vec3 x{c[0].x, c[0].y, c[0].z};
+        const Vec3 y{c[1].x, c[1].y, c[1].z};
+        const Vec3 z{c[2].x, c[2].y, c[2].z};
+        const Vec3 row0 = cross(y, z);
+        const Vec3 row1 = cross(z, x);
+        const Vec3 row2 = cross(x, y);
+        const float inverseDeterminant = 1.f / dot(x, row0);
+        const Vec3 r0 = row0 * inverseDeterminant;
+        const Vec3 r1 = row1 * inverseDeterminant;
+        const Vec3 r2 = row2 * inverseDeterminant;
+        const Vec3 t{c[3].x, c[3].y, c[3].z};
+        return {{{
+            {r0.x, r1.x, r2.x, 0.f},
+            {r0.y, r1.y, r2.y, 0.f},
+            {r0.z, r1.z, r2.z, 0.f},
+            {-dot(r0, t), -dot(r1, t), -dot(r2, t), 1.f},
+        }}};
+    }
+
+
+    //
+    // Reference implementations
+    //
+    namespace scalar {
+
+        inline Vec4 transform(const Mat4 & aMatrix, const Vec4 & aVector)
+        {
+            const auto & c = aMatrix.mColumns;
+            return {
+                c[0].x * aVector.x + c[1].x * aVector.y + c[2].x * aVector.z + c[3].x * aVector.w,
+                c[0].y * aVector.x + c[1].y * aVector.y + c[2].y * aVector.z + c[3].y * aVector.w,
+                c[0].z * aVector.x + c[1].z * aVector.y + c[2].z * aVector.z + c[3].z * aVector.w,
+                c[0].w * aVector.x + c[1].w * aVector.y + c[2].w * aVector.z + c[3].w * aVector.w,
+            };
+        }
+
+        inline Mat4 multiply(const Mat4 & aLeft, const Mat4 & aRight)
+        {
+            Mat4 result;
+            for(std::size_t columnIdx = 0; columnIdx != 4; ++columnIdx)
+            {
+                result.mColumns[columnIdx] = transform(aLeft, aRight.mColumns[columnIdx]);
+            }
+            return result;
+        }
+
+        inline void multiplyBatch(const Mat4 & aLeft, std::span<const Mat4> aRights, Mat4 * aOut)
+        {
+            for(std::size_t matrixIdx = 0; matrixIdx != aRights.size(); ++matrixIdx)
+            {
+                aOut[matrixIdx] = multiply(aLeft, aRights[matrixIdx]);
+            }
+        }
+
+        inline void multiplyToRowsBatch(const Mat4 & aLeft, std::span<const Mat4> aRights,
+                                        std::byte * aOut, std::size_t aOutStride)
+        {
+            for(const Mat4 & right : aRights)
+            {
+                const Mat4 rows = transpose(multiply(aLeft, right));
+                std::memcpy(aOut, rows.data(), sizeof(Mat4));
+                aOut += aOutStride;
+            }
+        }
+
+    } // namespace scalar
+
+
+    //
+    // Vectorized implementations
+    //
+    namespace detail {
+
+#if defined(SIMD_SSE2)
+        /// @brief aLeft * aColumn, the left matrix columns being loaded once by the caller.
+        inline __m128 transformColumn(const __m128 (&aLeft)[4], __m128 aColumn)
+        {
+            __m128 result = _mm_mul_ps(aLeft[0], _mm_shuffle_ps(aColumn, aColumn, _MM_SHUFFLE(0, 0, 0, 0)));
+            result = _mm_add_ps(result, _mm_mul_ps(aLeft[1], _mm_shuffle_ps(aColumn, aColumn, _MM_SHUFFLE(1, 1, 1, 1))));
+            result = _mm_add_ps(result, _mm_mul_ps(aLeft[2], _mm_shuffle_ps(aColumn, aColumn, _MM_SHUFFLE(2, 2, 2, 2))));
+            return _mm_add_ps(result, _mm_mul_ps(aLeft[3], _mm_shuffle_ps(aColumn, aColumn, _MM_SHUFFLE(3, 3, 3, 3))));
+        }
+
+        inline void loadColumns(const Mat4 & aMatrix, __m128 (&aOut)[4])
+        {
+            for(std::size_t columnIdx = 0; columnIdx != 4; ++columnIdx)
+            {
+                aOut[columnIdx] = _mm_load_ps(&aMatrix.mColumns[columnIdx].x);
+            }
+        }
+#endif
+
+#if defined(SIMD_AVX2)
+        /// @brief aLeft * [column j, column j + 1] of the right matrix, two columns per 256-bit register.
+        /// aLeft holds each column of the left matrix duplicated in both lanes.
+        inline __m256 transformColumnPair(const __m256 (&aLeft)[4], __m256 aColumns)
+        {
+            // The shuffles broadcast within each 128-bit lane, so each lane picks from its own column
+            __m256 result = _mm256_mul_ps(aLeft[0], _mm256_shuffle_ps(aColumns, aColumns, _MM_SHUFFLE(0, 0, 0, 0)));
+            result = _mm256_add_ps(result, _mm256_mul_ps(aLeft[1], _mm256_shuffle_ps(aColumns, aColumns, _MM_SHUFFLE(1, 1, 1, 1))));
+            result = _mm256_add_ps(result, _mm256_mul_ps(aLeft[2], _mm256_shuffle_ps(aColumns, aColumns, _MM_SHUFFLE(2, 2, 2, 2))));
+            return _mm256_add_ps(result, _mm256_mul_ps(aLeft[3], _mm256_shuffle_ps(aColumns, aColumns, _MM_SHUFFLE(3, 3, 3, 3))));
+        }
+
+        inline void loadDuplicatedColumns(const Mat4 & aMatrix, __m256 (&aOut)[4])
+        {
+            for(std::size_t columnIdx = 0; columnIdx != 4; ++columnIdx)
+            {
+                aOut[columnIdx] = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(&aMatrix.mColumns[columnIdx]));
+            }
+        }
+#endif
+
+#if defined(SIMD_NEON)
+        inline float32x4_t transformColumn(const float32x4_t (&aLeft)[4], float32x4_t aColumn)
+        {
+            float32x4_t result = vmulq_n_f32(aLeft[0], vgetq_lane_f32(aColumn, 0));
+            result = vmlaq_n_f32(result, aLeft[1], vgetq_lane_f32(aColumn, 1));
+            result = vmlaq_n_f32(result, aLeft[2], vgetq_lane_f32(aColumn, 2));
+            return vmlaq_n_f32(result, aLeft[3], vgetq_lane_f32(aColumn, 3));
+        }
+
+        inline void loadColumns(const Mat4 & aMatrix, float32x4_t (&aOut)[4])
+        {
+            for(std::size_t columnIdx = 0; columnIdx != 4; ++columnIdx)
+            {
+                aOut[columnIdx] = vld1q_f32(&aMatrix.mColumns[columnIdx].x);
+            }
+        }
+#endif
+
+    } // namespace detail
+
+
+    inline Vec4 transform(const Mat4 & aMatrix, const Vec4 & aVector)
+    {
+#if defined(SIMD_SSE2)
+        __m128 left[4];
+        detail::loadColumns(aMatrix, left);
+        Vec4 result;
+        _mm_store_ps(&result.x, detail::transformColumn(left, _mm_load_ps(&aVector.x)));
+        return result;
+#elif defined(SIMD_NEON)
+        float32x4_t left[4];
+        detail::loadColumns(aMatrix, left);
+        Vec4 result;
+        vst1q_f32(&result.x, detail::transformColumn(left, vld1q_f32(&aVector.x)));
+        return result;
+#else
+        return scalar::transform(aMatrix, aVector);
+#endif
+    }
+
+    /// @brief The transform aRight followed by aLeft.
+    inline Mat4 operator*(const Mat4 & aLeft, const Mat4 & aRight)
+    {
+#if defined(SIMD_SSE2) || defined(SIMD_NEON)
+        Mat4 result;
+        for(std::size_t columnIdx = 0; columnIdx != 4; ++columnIdx)
+        {
+            result.mColumns[columnIdx] = transform(aLeft, aRight.mColumns[columnIdx]);
+        }
+        return result;
+#else
+        return scalar::multiply(aLeft, aRight);
+#endif
+    }
+
+    /// @brief aOut[i] = aLeft * aRights[i], e.g. the model-view-projection of each object from the view-projection.
+    /// The left matrix is loaded in registers once for the whole batch.
+    inline void multiplyBatch(const Mat4 & aLeft, std::span<const Mat4> aRights, Mat4 * aOut)
+    {
+#if defined(SIMD_AVX2)
+        __m256 left[4];
+        detail::loadDuplicatedColumns(aLeft, left);
+        for(std::size_t matrixIdx = 0; matrixIdx != aRights.size(); ++matrixIdx)
+        {
+            float * out = aOut[matrixIdx].data();
+            const float * right = aRights[matrixIdx].data();
+            _mm256_storeu_ps(out, detail::transformColumnPair(left, _mm256_loadu_ps(right)));
+            _mm256_storeu_ps(out + 8, detail::transformColumnPair(left, _mm256_loadu_ps(right + 8)));
+        }
+#elif defined(SIMD_SSE2)
+        __m128 left[4];
+        detail::loadColumns(aLeft, left);
+        for(std::size_t matrixIdx = 0; matrixIdx != aRights.size(); ++matrixIdx)
+        {
+            for(std::size_t columnIdx = 0; columnIdx != 4; ++columnIdx)
+            {
+                _mm_store_ps(&aOut[matrixIdx].mColumns[columnIdx].x,
+                             detail::transformColumn(left, _mm_load_ps(&aRights[matrixIdx].mColumns[columnIdx].x)));
+            }
+        }
+#elif defined(SIMD_NEON)
+        float32x4_t left[4];
+        detail::loadColumns(aLeft, left);
+        for(std::size_t matrixIdx = 0; matrixIdx != aRights.size(); ++matrixIdx)
+        {
+            for(std::size_t columnIdx = 0; columnIdx != 4; ++columnIdx)
+            {
+                vst1q_f32(&aOut[matrixIdx].mColumns[columnIdx].x,
+                          detail::transformColumn(left, vld1q_f32(&aRights[matrixIdx].mColumns[columnIdx].x)));
+            }
+        }
+#else
+        scalar::multiplyBatch(aLeft, aRights, aOut);
+#endif
+    }
+
+    namespace detail {
+
+        /// @brief Writes the rows of aLeft * aGetRight(i) for i in [0, aCount), see multiplyToRowsBatch().
+        template <class T_getRight>
+        void multiplyToRows(const Mat4 & aLeft, std::size_t aCount, T_getRight && aGetRight,
+                            std::byte * aOut, std::size_t aOutStride)
+        {
+            // With AVX2, the 128-bit path is kept: the transpose works on 128-bit registers,
+            // and extracting the lanes of the paired columns costs more than the pairing saves (see tools/MathBenchmark.cpp).
+#if defined(SIMD_SSE2)
+            __m128 left[4];
+            loadColumns(aLeft, left);
+            for(std::size_t matrixIdx = 0; matrixIdx != aCount; ++matrixIdx)
+            {
+                const Mat4 & right = aGetRight(matrixIdx);
+                __m128 c0 = transformColumn(left, _mm_load_ps(&right.mColumns[0].x));
+                __m128 c1 = transformColumn(left, _mm_load_ps(&right.mColumns[1].x));
+                __m128 c2 = transformColumn(left, _mm_load_ps(&right.mColumns[2].x));
+                __m128 c3 = transformColumn(left, _mm_load_ps(&right.mColumns[3].x));
+                _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+                float * out = reinterpret_cast<float *>(aOut);
+                _mm_storeu_ps(out, c0);
+                _mm_storeu_ps(out + 4, c1);
+                _mm_storeu_ps(out + 8, c2);
+                _mm_storeu_ps(out + 12, c3);
+                aOut += aOutStride;
+            }
+#elif defined(SIMD_NEON)
+            float32x4_t left[4];
+            loadColumns(aLeft, left);
+            for(std::size_t matrixIdx = 0; matrixIdx != aCount; ++matrixIdx)
+            {
+                const Mat4 & right = aGetRight(matrixIdx);
+                float32x4x4_t columns;
+                columns.val[0] = transformColumn(left, vld1q_f32(&right.mColumns[0].x));
+                columns.val[1] = transformColumn(left, vld1q_f32(&right.mColumns[1].x));
+                columns.val[2] = transformColumn(left, vld1q_f32(&right.mColumns[2].x));
+                columns.val[3] = transformColumn(left, vld1q_f32(&right.mColumns[3].x));
+                // The interleaving store transposes
+                vst4q_f32(reinterpret_cast<float *>(aOut), columns);
+                aOut += aOutStride;
+            }
+#else
+            for(std::size_t matrixIdx = 0; matrixIdx != aCount; ++matrixIdx)
+            {
+                const Mat4 rows = transpose(scalar::multiply(aLeft, aGetRight(matrixIdx)));
+                std::memcpy(aOut, rows.data(), sizeof(Mat4));
+                aOut += aOutStride;
+            }
+#endif
+        }
+
+    } // namespace detail
+
+    /// @brief Writes the rows of aLeft * aRights[i] (16 floats, row after row) every aOutStride bytes of aOut.
+    /// Rows are what a vertex shader consumes as per-instance attributes, with one dot product per clip coordinate.
+    /// @param aOut Typically mapped GPU memory (write-combined): it is only written, sequentially, with full vectors.
+    inline void multiplyToRowsBatch(const Mat4 & aLeft, std::span<const Mat4> aRights,
+                                    std::byte * aOut, std::size_t aOutStride)
+    {
+        detail::multiplyToRows(aLeft, aRights.size(), [aRights](std::size_t aIdx) -> const Mat4 & { return aRights[aIdx]; },
+                               aOut, aOutStride);
+    }
+
+    /// @brief As multiplyToRowsBatch(), for the subset aRights[aIndices[i]] (e.g. the visible objects),
+    /// written contiguously.
+    inline void multiplyToRowsBatch(const Mat4 & aLeft, std::span<const Mat4> aRights, std::span<const uint32_t> aIndices,
+                                    std::byte * aOut, std::size_t aOutStride)
+    {
+        detail::multiplyToRows(aLeft, aIndices.size(),
+                               [aRights, aIndices](std::size_t aIdx) -> const Mat4 & { return aRights[aIndices[aIdx]]; },
+                               aOut, aOutStride);
+    }
+
+} // namespace math
@@ -0,0 +1,221 @@
+#pragma once
+
+
+#include "FileHelper.h"
+#include "VertexLayout.h"
+#include "VulkanLoading.h"
+
+#include <array>
+#include <filesystem>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+#include <cstdint>
+
+
+// Binary mesh file, produced offline by tools/ConvertMesh.cpp.
+// The chunks are stored in their GPU format (encoded vertex layout, index type), so the file is mapped
+// and its chunks are copied to the buffers as is, without parsing.
+//
+// Layout (native endianness), every part starting at a gChunkAlignment aligned offset:
+// * Header
+// * Attributes: Header::mAttributeCount entries, in the order of the interleaved vertex
+// * Lods: Header::mLodCount entries, from the most detailed
+// * Vertices: Header::mVertexCount interleaved vertices
+// * Indices: the index lists of all LODs, in Header::mIndexType
+namespace meshfile {
+
+    constexpr uint32_t gMagic = 0x4853454d; // "MESH"
+    // Bumped on any layout change, older files must be converted again
+    constexpr uint32_t gVersion = 1;
+    constexpr uint32_t gChunkAlignment = 16;
+
+    struct Chunk
+    {
+        uint64_t mOffset; // from the start of the file
+        uint64_t mSize;   // in bytes
+    };
+
+    struct Header
+    {
+        uint32_t mMagic;
+        uint32_t mVersion;
+        uint32_t mAttributeCount;
+        uint32_t mLodCount;
+        uint32_t mVertexCount;
+        uint32_t mVertexStride;
+        uint32_t mIndexType; // VkIndexType, VK_INDEX_TYPE_UINT16 or VK_INDEX_TYPE_UINT32
+        uint32_t mReserved0;
+        Chunk mVertices;
+        Chunk mIndices;
+        // Bounds of the positions, in the mesh space
+        std::array<float, 3> mBoundsMin;
+        std::array<float, 3> mBoundsMax;
+        std::array<float, 4> mBoundingSphere; // center, radius
+        uint32_t mReserved1;
+        uint32_t mReserved2;
+    };
+
+    struct Attribute
+    {
+        uint32_t mLocation;
+        uint32_t mFormat; // AttributeFormat
+        uint32_t mOffset; // in the vertex, in bytes
+        uint32_t mReserved;
+    };
+
+    struct Lod
+    {
+        uint32_t mFirstIndex;
+        uint32_t mIndexCount;
+        float mError; // Maximal distance of a vertex to its position in the full mesh
+        uint32_t mReserved;
+    };
+
+    static_assert(sizeof(Chunk) == 16);
+    static_assert(sizeof(Header) == 112 && sizeof(Header) % gChunkAlignment == 0);
+    static_assert(sizeof(Attribute) == 16);
+    static_assert(sizeof(Lod) == 16);
+
+    constexpr uint32_t getIndexSize(uint32_t aIndexType)
+    {
+        return aIndexType == VK_INDEX_TYPE_UINT16 ? 2 : 4;
+    }
+
+} // namespace meshfile
+
+
+/// @brief Read-only access to a mesh file, mapped for the lifetime of the object.
+/// The vertex and index data are paged in from disk when they are first read (typically, copied for upload).
+class MeshFile
+{
+public:
+    /// @throw std::runtime_error if the file cannot be mapped or is not a valid mesh file of the current version.
+    explicit MeshFile(const std::filesystem::path & aPath) :
+        mFile{aPath}
+    {
+        const std::span<const std::byte> bytes = mFile.getBytes();
+        auto fail = [&aPath](const char * aReason)
+        {
+            throw std::runtime_error{"Mesh file '" + aPath.string() + "' " + aReason + "."};
+        };
+
+        if(bytes.size() < sizeof(meshfile::Header))
+        {
+            fail("is truncated");
+        }
+        mHeader = reinterpret_cast<const meshfile::Header *>(bytes.data());
+        if(mHeader->mMagic != meshfile::gMagic)
+        {
+            fail("is not a mesh file");
+        }
+        if(mHeader->mVersion != meshfile::gVersion)
+        {
+            fail(("has version " + std::to_string(mHeader->mVersion) + ", expected "
+                  + std::to_string(meshfile::gVersion) + " (convert it again)").c_str());
+        }
+
+        const std::size_t tablesSize = (std::size_t)mHeader->mAttributeCount * sizeof(meshfile::Attribute)
+                                       + (std::size_t)mHeader->mLodCount * sizeof(meshfile::Lod);
+        if(bytes.size() < sizeof(meshfile::Header) + tablesSize)
+        {
+            fail("is truncated");
+        }
+        mAttributes = {reinterpret_cast<const meshfile::Attribute *>(bytes.data() + sizeof(meshfile::Header)),
+                       mHeader->mAttributeCount};
+        mLods = {reinterpret_cast<const meshfile::Lod *>(mAttributes.data() + mAttributes.size()), mHeader->mLodCount};
+
+        // Validate once, so the accessors can trust the header
+        auto isValid = [&bytes](const meshfile::Chunk & aChunk)
+        {
+            return aChunk.mOffset % meshfile::gChunkAlignment == 0
+                && aChunk.mOffset <= bytes.size()
+                && aChunk.mSize <= bytes.size() - aChunk.mOffset;
+        };
+        if(!isValid(mHeader->mVertices) || !isValid(mHeader->mIndices))
+        {
+            fail("has an invalid chunk");
+        }
+        if(mHeader->mVertices.mSize == 0 || mHeader->mIndices.mSize == 0)
+        {
+            fail("is empty");
+        }
+        // The full detail mesh is LOD 0
+        if(mHeader->mLodCount == 0)
+        {
+            fail("has no LOD");
+        }
+        if(mHeader->mIndexType != VK_INDEX_TYPE_UINT16 && mHeader->mIndexType != VK_INDEX_TYPE_UINT32)
+        {
+            fail("has an invalid index type");
+        }
+
+        for(const meshfile::Attribute & attribute : mAttributes)
+        {
+            if(attribute.mFormat > (uint32_t)AttributeFormat::Unorm10x3_2)
+            {
+                fail("has an invalid attribute format");
+            }
+            mLayout.mAttributes.push_back({.mLocation = attribute.mLocation, .mFormat = (AttributeFormat)attribute.mFormat});
+        }
+        for(std::size_t attributeIdx = 0; attributeIdx != mAttributes.size(); ++attributeIdx)
+        {
+            if(mAttributes[attributeIdx].mOffset != mLayout.getOffset(attributeIdx))
+            {
+                fail("has an invalid attribute offset");
+            }
+        }
+        if(mLayout.getStride() != mHeader->mVertexStride
+           || (uint64_t)mHeader->mVertexCount * mHeader->mVertexStride != mHeader->mVertices.mSize)
+        {
+            fail("has an invalid vertex chunk size");
+        }
+
+        const uint64_t indexCount = mHeader->mIndices.mSize / meshfile::getIndexSize(mHeader->mIndexType);
+        for(const meshfile::Lod & lod : mLods)
+        {
+            if(lod.mFirstIndex > indexCount || lod.mIndexCount > indexCount - lod.mFirstIndex)
+            {
+                fail("has an invalid LOD");
+            }
+        }
+    }
+
+    const meshfile::Header & getHeader() const
+    {
+        return *mHeader;
+    }
+
+    const VertexLayout & getVertexLayout() const
+    {
+        return mLayout;
+    }
+
+    VkIndexType getIndexType() const
+    {
+        return (VkIndexType)mHeader->mIndexType;
+    }
+
+    std::span<const meshfile::Lod> getLods() const
+    {
+        return mLods;
+    }
+
+    std::span<const std::byte> getVertexData() const
+    {
+        return mFile.getBytes().subspan(mHeader->mVertices.mOffset, mHeader->mVertices.mSize);
+    }
+
+    std::span<const std::byte> getIndexData() const
+    {
+        return mFile.getBytes().subspan(mHeader->mIndices.mOffset, mHeader->mIndices.mSize);
+    }
+
+private:
+    MappedFile mFile;
+    const meshfile::Header * mHeader{nullptr};
+    std::span<const meshfile::Attribute> mAttributes;
+    std::span<const meshfile::Lod> mLods;
+    VertexLayout mLayout;
+};
@@ -0,0 +1,115 @@
+#pragma once
+
+
+#include "MeshFile.h"
+#include "UploadService.h"
+#include "VulkanHelpers.h"
+#include "VulkanLoading.h"
+
+#include <algorithm>
+#include <chrono>
+#include <span>
+#include <tuple>
+
+
+/// @brief The device buffers of a mesh file, sized from its header.
+struct MeshBuffers
+{
+    void destroy()
+    {
+        vkDestroyBuffer(vkDevice, mVertexBuffer, pAllocator);
+        vkFreeMemory(vkDevice, mVertexMemory, pAllocator);
+        vkDestroyBuffer(vkDevice, mIndexBuffer, pAllocator);
+        vkFreeMemory(vkDevice, mIndexMemory, pAllocator);
+    }
+
+    VkDevice vkDevice;
+    VkBuffer mVertexBuffer;
+    VkDeviceMemory mVertexMemory;
+    VkBuffer mIndexBuffer;
+    VkDeviceMemory mIndexMemory;
+};
+
+
+inline MeshBuffers createMeshBuffers(VkDevice vkDevice,
+                                     VkDeviceSize aVertexSize,
+                                     VkDeviceSize aIndexSize,
+                                     uint32_t aMemoryTypeIndex)
+{
+    MeshBuffers result{.vkDevice = vkDevice};
+    std::tie(result.mVertexBuffer, result.mVertexMemory) = createBuffer(
+        vkDevice,
+        aVertexSize,
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        aMemoryTypeIndex);
+    std::tie(result.mIndexBuffer, result.mIndexMemory) = createBuffer(
+        vkDevice,
+        aIndexSize,
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        aMemoryTypeIndex);
+    nameObject(vkDevice, result.mVertexBuffer, "mesh_vertices");
+    nameObject(vkDevice, result.mIndexBuffer, "mesh_indices");
+    return result;
+}
+
+
+inline MeshBuffers createMeshBuffers(VkDevice vkDevice, const MeshFile & aMesh, uint32_t aMemoryTypeIndex)
+{
+    return createMeshBuffers(vkDevice, aMesh.getVertexData().size(), aMesh.getIndexData().size(), aMemoryTypeIndex);
+}
+
+
+struct MeshStreamReport
+{
+    using Duration = std::chrono::steady_clock::duration;
+
+    // The last upload request of the mesh, it is usable once this ticket is submitted
+    UploadService::Ticket mTicket;
+    std::size_t mBytes;
+    // From the first read to the last byte copied into the staging ring
+    Duration mDuration;
+
+    double getGigabytesPerSecond() const
+    {
+        return mBytes / std::max(std::chrono::duration<double>(mDuration).count(), 1e-9) / 1e9;
+    }
+};
+
+
+/// @brief Streams GPU-ready vertex and index data into aBuffers through the upload service.
+/// @note Blocks while the staging ring is full: call it from a worker thread, while the render thread submits.
+inline MeshStreamReport streamMeshData(std::span<const std::byte> aVertexData,
+                                       std::span<const std::byte> aIndexData,
+                                       const MeshBuffers & aBuffers,
+                                       UploadService & aUploadService)
+{
+    const auto start = std::chrono::steady_clock::now();
+    aUploadService.uploadBuffer(
+        aBuffers.mVertexBuffer,
+        0,
+        aVertexData,
+        VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT,
+        VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT);
+    // Requests are submitted in order: once the indices are submitted, so are the vertices.
+    const UploadService::Ticket ticket = aUploadService.uploadBuffer(
+        aBuffers.mIndexBuffer,
+        0,
+        aIndexData,
+        VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT,
+        VK_ACCESS_2_INDEX_READ_BIT);
+    return MeshStreamReport{
+        .mTicket = ticket,
+        .mBytes = aVertexData.size() + aIndexData.size(),
+        .mDuration = std::chrono::steady_clock::now() - start,
+    };
+}
+
+
+/// @brief Streams the chunks of aMesh into aBuffers through the upload service.
+/// The chunks are copied from the file mapping straight into the staging ring, so the file is read from disk
+/// by that copy, a ring chunk at a time, and never held in memory as a whole.
+/// @note Blocks while the staging ring is full: call it from a worker thread, while the render thread submits.
+inline MeshStreamReport streamMesh(const MeshFile & aMesh, const MeshBuffers & aBuffers, UploadService & aUploadService)
+{
+    return streamMeshData(aMesh.getVertexData(), aMesh.getIndexData(), aBuffers, aUploadService);
+}
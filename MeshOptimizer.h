@@ -0,0 +1,345 @@
+#pragma once
+
+
+#include "Hash.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <cstdint>
+#include <cstring>
+
+
+// Offline optimization of indexed triangle lists, ahead of upload:
+// * deduplication: a triangle soup becomes unique vertices plus indices,
+// * vertex cache: triangles are reordered so the vertices they share are still in the post-transform cache
+//   (each vertex shader invocation is then reused by more triangles),
+// * vertex fetch: vertices are reordered by first use, so the vertex fetches walk the buffer sequentially.
+//
+// The post-transform cache is modeled as a FIFO of gVertexCacheSize entries, the usual approximation of hardware
+// which batches vertices instead of caching them. The quality is measured by the ACMR (average cache miss ratio):
+// the number of vertex shader invocations per triangle, 3 without reuse, approaching 0.5 on large regular grids.
+
+
+constexpr uint32_t gVertexCacheSize = 16;
+
+
+template <class T_vertex>
+struct IndexedMesh
+{
+    std::vector<T_vertex> mVertices;
+    std::vector<uint32_t> mIndices; // Triangle list
+};
+
+
+/// @brief Merges the bitwise identical vertices of a triangle soup (3 consecutive vertices per triangle).
+/// Vertices are kept in order of first occurrence.
+/// @note T_vertex must not contain padding, as vertices are compared by their bytes.
+template <class T_vertex>
+IndexedMesh<T_vertex> deduplicateVertices(std::span<const T_vertex> aTriangleList)
+{
+    static_assert(std::is_trivially_copyable_v<T_vertex>, "Vertices are compared by their bytes.");
+
+    struct VertexHash
+    {
+        std::size_t operator()(const T_vertex & aVertex) const
+        {
+            return (std::size_t)hashBytes(std::as_bytes(std::span{&aVertex, 1}));
+        }
+    };
+    struct VertexEqual
+    {
+        bool operator()(const T_vertex & aLeft, const T_vertex & aRight) const
+        {
+            return std::memcmp(&aLeft, &aRight, sizeof(T_vertex)) == 0;
+        }
+    };
+
+    IndexedMesh<T_vertex> result;
+    result.mIndices.reserve(aTriangleList.size());
+    std::unordered_map<T_vertex, uint32_t, VertexHash, VertexEqual> indices;
+    indices.reserve(aTriangleList.size());
+    for(const T_vertex & vertex : aTriangleList)
+    {
+        auto [found, inserted] = indices.try_emplace(vertex, (uint32_t)result.mVertices.size());
+        if(inserted)
+        {
+            result.mVertices.push_back(vertex);
+        }
+        result.mIndices.push_back(found->second);
+    }
+    return result;
+}
+
+
+/// @brief Average cache miss ratio of aIndices: vertex shader invocations per triangle, with a FIFO cache.
+/// @throw std::out_of_range if an index is not below aVertexCount.
+inline float computeAcmr(std::span<const uint32_t> aIndices,
+                         std::size_t aVertexCount,
+                         uint32_t aCacheSize = gVertexCacheSize)
+{
+    if(aIndices.size() < 3)
+    {
+        return 0.f;
+    }
+
+    // A vertex is in the FIFO while fewer than aCacheSize misses happened since it was inserted
+    constexpr uint64_t gNever = std::numeric_limits<uint64_t>::max();
+    std::vector<uint64_t> insertedAt(aVertexCount, gNever);
+    uint64_t misses = 0;
+    for(uint32_t index : aIndices)
+    {
+        if(index >= aVertexCount)
+        {
+            throw std::out_of_range{"An index is out of the vertex range."};
+        }
+        if(insertedAt[index] == gNever || misses - insertedAt[index] >= aCacheSize)
+        {
+            insertedAt[index] = misses++;
+        }
+    }
+    return (float)misses / (aIndices.size() / 3);
+}
+
+
+/// @brief Reorders the triangles of aIndices for the post-transform vertex cache, with Tipsify.
+///
+/// Tipsify fans around a vertex, emitting all its remaining triangles, then moves to the next vertex among
+/// the ones just emitted, preferring the vertices that are still in the cache and will be after emitting their
+/// triangles. It runs in linear time, close to Forsyth's algorithm in quality at a fraction of the cost.
+/// see: Sander, Nehab, Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw", 2007
+inline std::vector<uint32_t> optimizeVertexCache(std::span<const uint32_t> aIndices,
+                                                 std::size_t aVertexCount,
+                                                 uint32_t aCacheSize = gVertexCacheSize)
+{
+    if(aIndices.size() % 3 != 0)
+    {
+        throw std::invalid_argument{"The index count of a triangle list must be a multiple of 3."};
+    }
+    const std::size_t triangleCount = aIndices.size() / 3;
+
+    // Triangles adjacent to each vertex, in compressed rows
+    // live: the number of adjacent triangles not emitted yet
+    std::vector<uint32_t> live(aVertexCount, 0);
+    for(uint32_t index : aIndices)
+    {
+        if(index >= aVertexCount)
+        {
+            throw std::out_of_range{"An index is out of the vertex range."};
+        }
+        ++live[index];
+    }
+    // Nothing to reorder, and fanning would start from a vertex that does not exist
+    if(aIndices.empty() || aVertexCount == 0)
+    {
+        return {aIndices.begin(), aIndices.end()};
+    }
+    std::vector<uint32_t> adjacencyOffsets(aVertexCount + 1, 0);
+    for(std::size_t vertexIdx = 0; vertexIdx != aVertexCount; ++vertexIdx)
+    {
+        adjacencyOffsets[vertexIdx + 1] = adjacencyOffsets[vertexIdx] + live[vertexIdx];
+    }
+    std::vector<uint32_t> adjacency(aIndices.size());
+    {
+        std::vector<uint32_t> cursors(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for(std::size_t indexIdx = 0; indexIdx != aIndices.size(); ++indexIdx)
+        {
+            adjacency[cursors[aIndices[indexIdx]]++] = (uint32_t)(indexIdx / 3);
+        }
+    }
+
+    std::vector<uint32_t> result;
+    result.reserve(aIndices.size());
+    std::vector<bool> emitted(triangleCount, false);
+    // Time at which each vertex entered the cache, it is still cached while time - cachedAt <= aCacheSize
+    std::vector<uint64_t> cachedAt(aVertexCount, 0);
+    uint64_t time = aCacheSize + 1;
+    // Recently emitted vertices, to restart from when fanning reaches a dead end
+    std::vector<uint32_t> deadEndStack;
+    std::vector<uint32_t> candidates;
+    uint32_t nextInputVertex = 0;
+
+    // Vertex 0 is the first fanning vertex, it has no triangles left if it is unused, then a new start is searched
+    int64_t fanning = 0;
+    while(fanning >= 0)
+    {
+        candidates.clear();
+        for(uint32_t adjacencyIdx = adjacencyOffsets[fanning]; adjacencyIdx != adjacencyOffsets[fanning + 1]; ++adjacencyIdx)
+        {
+            const uint32_t triangle = adjacency[adjacencyIdx];
+            if(emitted[triangle])
+            {
+                continue;
+            }
+            emitted[triangle] = true;
+            for(uint32_t cornerIdx = 0; cornerIdx != 3; ++cornerIdx)
+            {
+                const uint32_t vertex = aIndices[triangle * 3 + cornerIdx];
+                result.push_back(vertex);
+                deadEndStack.push_back(vertex);
+                candidates.push_back(vertex);
+                --live[vertex];
+                if(time - cachedAt[vertex] > aCacheSize)
+                {
+                    cachedAt[vertex] = time++;
+                }
+            }
+        }
+
+        // Next fanning vertex: the candidate with live triangles that stays cached the longest once they are emitted
+        fanning = -1;
+        uint64_t bestPriority = 0;
+        for(uint32_t candidate : candidates)
+        {
+            if(live[candidate] == 0)
+            {
+                continue;
+            }
+            uint64_t priority = 0;
+            if(time - cachedAt[candidate] + 2 * live[candidate] <= aCacheSize)
+            {
+                priority = time - cachedAt[candidate];
+            }
+            if(fanning == -1 || priority > bestPriority)
+            {
+                fanning = candidate;
+                bestPriority = priority;
+            }
+        }
+
+        // Dead end: the most recently emitted vertex with live triangles, otherwise the next one in input order
+        while(fanning == -1 && !deadEndStack.empty())
+        {
+            const uint32_t vertex = deadEndStack.back();
+            deadEndStack.pop_back();
+            if(live[vertex] != 0)
+            {
+                fanning = vertex;
+            }
+        }
+        while(fanning == -1 && nextInputVertex != aVertexCount)
+        {
+            if(live[nextInputVertex] != 0)
+            {
+                fanning = nextInputVertex;
+            }
+            ++nextInputVertex;
+        }
+    }
+    return result;
+}
+
+
+/// @brief Reorders the vertices by first use in the indices (remapping them), removing the unused vertices.
+template <class T_vertex>
+void optimizeVertexFetch(IndexedMesh<T_vertex> & aMesh)
+{
+    constexpr uint32_t gUnused = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> remap(aMesh.mVertices.size(), gUnused);
+    std::vector<T_vertex> vertices;
+    vertices.reserve(aMesh.mVertices.size());
+    for(uint32_t & index : aMesh.mIndices)
+    {
+        if(remap[index] == gUnused)
+        {
+            remap[index] = (uint32_t)vertices.size();
+            vertices.push_back(aMesh.mVertices[index]);
+        }
+        index = remap[index];
+    }
+    aMesh.mVertices = std::move(vertices);
+}
+
+
+/// @brief The indices of a coarser level of detail of aMesh, by vertex clustering: the vertices in the same cell
+/// of a grid over the mesh collapse to the first of them, and the triangles becoming degenerate are removed.
+/// The vertices are shared with the full mesh, only the indices differ.
+/// @param aCellSize Edge of the grid cells, in the units of T_vertex::mPosition. A vertex moves by less than a cell diagonal.
+template <class T_vertex>
+std::vector<uint32_t> simplifyByClustering(const IndexedMesh<T_vertex> & aMesh, float aCellSize)
+{
+    std::array<float, 3> boundsMin{std::numeric_limits<float>::max(),
+                                   std::numeric_limits<float>::max(),
+                                   std::numeric_limits<float>::max()};
+    for(const T_vertex & vertex : aMesh.mVertices)
+    {
+        for(std::size_t axis = 0; axis != 3; ++axis)
+        {
+            boundsMin[axis] = std::min(boundsMin[axis], vertex.mPosition[axis]);
+        }
+    }
+
+    // Cells are keyed by their 21-bit coordinates on each axis
+    std::unordered_map<uint64_t, uint32_t> representatives;
+    std::vector<uint32_t> remap(aMesh.mVertices.size());
+    for(uint32_t vertexIdx = 0; vertexIdx != aMesh.mVertices.size(); ++vertexIdx)
+    {
+        uint64_t cell = 0;
+        for(std::size_t axis = 0; axis != 3; ++axis)
+        {
+            const float coordinate = (aMesh.mVertices[vertexIdx].mPosition[axis] - boundsMin[axis]) / aCellSize;
+            cell = (cell << 21) | std::min<uint64_t>((uint64_t)coordinate, (1u << 21) - 1);
+        }
+        remap[vertexIdx] = representatives.try_emplace(cell, vertexIdx).first->second;
+    }
+
+    std::vector<uint32_t> result;
+    for(std::size_t indexIdx = 0; indexIdx + 2 < aMesh.mIndices.size(); indexIdx += 3)
+    {
+        const uint32_t a = remap[aMesh.mIndices[indexIdx]];
+        const uint32_t b = remap[aMesh.mIndices[indexIdx + 1]];
+        const uint32_t c = remap[aMesh.mIndices[indexIdx + 2]];
+        if(a != b && b != c && c != a)
+        {
+            result.insert(result.end(), {a, b, c});
+        }
+    }
+    return result;
+}
+
+
+struct MeshOptimizationReport
+{
+    using Duration = std::chrono::steady_clock::duration;
+
+    std::size_t mTriangleCount{0};
+    float mAcmrBefore{0.f};
+    float mAcmrAfter{0.f};
+    std::size_t mVertexCountBefore{0};
+    std::size_t mVertexCountAfter{0};
+    Duration mDuration{0};
+
+    double getTrianglesPerSecond() const
+    {
+        return mTriangleCount / std::max(std::chrono::duration<double>(mDuration).count(), 1e-9);
+    }
+};
+
+
+/// @brief Reorders aMesh triangles for the vertex cache, then its vertices for fetch locality.
+template <class T_vertex>
+MeshOptimizationReport optimizeMesh(IndexedMesh<T_vertex> & aMesh, uint32_t aCacheSize = gVertexCacheSize)
+{
+    MeshOptimizationReport report{
+        .mTriangleCount = aMesh.mIndices.size() / 3,
+        .mAcmrBefore = computeAcmr(aMesh.mIndices, aMesh.mVertices.size(), aCacheSize),
+        .mVertexCountBefore = aMesh.mVertices.size(),
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+    aMesh.mIndices = optimizeVertexCache(aMesh.mIndices, aMesh.mVertices.size(), aCacheSize);
+    optimizeVertexFetch(aMesh);
+    report.mDuration = std::chrono::steady_clock::now() - start;
+
+    // Fetch reordering renames the vertices, but keeps the cache behaviour
+    report.mAcmrAfter = computeAcmr(aMesh.mIndices, aMesh.mVertices.size(), aCacheSize);
+    report.mVertexCountAfter = aMesh.mVertices.size();
+    return report;
+}
@@ -0,0 +1,279 @@
+#pragma once
+
+
+#include "Hash.h"
+#include "VulkanLoading.h"
+
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+
+/// @brief Deduplicates immutable Vulkan objects by the content of their create infos:
+/// acquiring with identical create infos returns the same handle, with its reference count incremented.
+///
+/// Objects released down to zero references stay in the registry, so re-creating a pipeline
+/// (e.g. on resize) finds them again. They are destroyed by collectUnused(), or destroy().
+/// The create infos are serialized into the keys, and compared on hash hits: a hash collision cannot alias two objects.
+/// @note Thread safe.
+class ObjectRegistry
+{
+public:
+    explicit ObjectRegistry(VkDevice vkDevice) :
+        vkDevice{vkDevice}
+    {}
+
+    ObjectRegistry(const ObjectRegistry &) = delete;
+    ObjectRegistry & operator=(const ObjectRegistry &) = delete;
+
+    /// @brief Destroys all objects, which must not be in use anymore.
+    void destroy()
+    {
+        std::lock_guard lock{mMutex};
+        destroyEntries(mShaderModules, vkDestroyShaderModule, false);
+        destroyEntries(mPipelineLayouts, vkDestroyPipelineLayout, false);
+        destroyEntries(mDescriptorSetLayouts, vkDestroyDescriptorSetLayout, false);
+    }
+
+    /// @brief Destroys the objects without references.
+    void collectUnused()
+    {
+        std::lock_guard lock{mMutex};
+        // Pipeline layouts before set layouts, as they release their references to set layouts
+        destroyEntries(mShaderModules, vkDestroyShaderModule, true);
+        destroyEntries(mPipelineLayouts, vkDestroyPipelineLayout, true);
+        destroyEntries(mDescriptorSetLayouts, vkDestroyDescriptorSetLayout, true);
+    }
+
+    VkShaderModule acquireShaderModule(std::span<const char> aCode)
+    {
+        Key key;
+        key.appendAll(std::as_bytes(aCode));
+        return acquire(mShaderModules, std::move(key), [&](VkShaderModule & aModule)
+        {
+            VkShaderModuleCreateInfo shaderModuleCreateInfo{
+                .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+                .codeSize = aCode.size(),
+                .pCode = reinterpret_cast<const uint32_t *>(aCode.data()),
+            };
+            return vkCreateShaderModule(vkDevice, &shaderModuleCreateInfo, pAllocator, &aModule);
+        });
+    }
+
+    /// @note Only VkDescriptorSetLayoutBindingFlagsCreateInfo is supported in the pNext chain.
+    VkDescriptorSetLayout acquireDescriptorSetLayout(const VkDescriptorSetLayoutCreateInfo & aCreateInfo)
+    {
+        Key key;
+        key.append(aCreateInfo.flags);
+        key.append(aCreateInfo.bindingCount);
+        for(const VkDescriptorSetLayoutBinding & binding : std::span{aCreateInfo.pBindings, aCreateInfo.bindingCount})
+        {
+            key.append(binding.binding);
+            key.append(binding.descriptorType);
+            key.append(binding.descriptorCount);
+            key.append(binding.stageFlags);
+            key.append(binding.pImmutableSamplers != nullptr);
+            if(binding.pImmutableSamplers != nullptr)
+            {
+                key.appendAll(std::span{binding.pImmutableSamplers, binding.descriptorCount});
+            }
+        }
+        for(auto next = static_cast<const VkBaseInStructure *>(aCreateInfo.pNext); next != nullptr; next = next->pNext)
+        {
+            if(next->sType != VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO)
+            {
+                throw std::invalid_argument{"Unsupported structure in the descriptor set layout pNext chain."};
+            }
+            auto bindingFlags = reinterpret_cast<const VkDescriptorSetLayoutBindingFlagsCreateInfo *>(next);
+            key.append(bindingFlags->bindingCount);
+            key.appendAll(std::span{bindingFlags->pBindingFlags, bindingFlags->bindingCount});
+        }
+
+        return acquire(mDescriptorSetLayouts, std::move(key), [&](VkDescriptorSetLayout & aLayout)
+        {
+            return vkCreateDescriptorSetLayout(vkDevice, &aCreateInfo, pAllocator, &aLayout);
+        });
+    }
+
+    /// @note The set layouts are keyed by handle, which identifies their content when they come from the registry.
+    VkPipelineLayout acquirePipelineLayout(const VkPipelineLayoutCreateInfo & aCreateInfo)
+    {
+        Key key;
+        key.append(aCreateInfo.flags);
+        key.append(aCreateInfo.setLayoutCount);
+        key.appendAll(std::span{aCreateInfo.pSetLayouts, aCreateInfo.setLayoutCount});
+        key.append(aCreateInfo.pushConstantRangeCount);
+        key.appendAll(std::span{aCreateInfo.pPushConstantRanges, aCreateInfo.pushConstantRangeCount});
+
+        // The pipeline layout holds a reference to its set layouts, so their handles cannot be recycled
+        // (which would alias the key) while it is in the registry.
+        const std::span<const VkDescriptorSetLayout> setLayouts{aCreateInfo.pSetLayouts, aCreateInfo.setLayoutCount};
+        return acquire(mPipelineLayouts, std::move(key), [&](VkPipelineLayout & aLayout)
+        {
+            return vkCreatePipelineLayout(vkDevice, &aCreateInfo, pAllocator, &aLayout);
+        }, setLayouts);
+    }
+
+    /// @brief The hash of the create info content of aLayout: unlike the handle, it identifies the layout across runs.
+    /// @note Immutable samplers are keyed by handle, their layouts only hash the same within a run.
+    /// @throw std::invalid_argument if aLayout does not come from the registry.
+    Hash hashContent(VkDescriptorSetLayout aLayout)
+    {
+        std::lock_guard lock{mMutex};
+        for(const auto & [key, entry] : mDescriptorSetLayouts)
+        {
+            if(entry.mHandle == aLayout)
+            {
+                return hashBytes(key.mBytes);
+            }
+        }
+        throw std::invalid_argument{"The descriptor set layout does not come from the registry."};
+    }
+
+    void release(VkShaderModule aModule)
+    {
+        release(mShaderModules, aModule);
+    }
+
+    void release(VkDescriptorSetLayout aLayout)
+    {
+        release(mDescriptorSetLayouts, aLayout);
+    }
+
+    void release(VkPipelineLayout aLayout)
+    {
+        release(mPipelineLayouts, aLayout);
+    }
+
+private:
+    /// @brief The bytes of a create info content, field by field.
+    struct Key
+    {
+        template <class T_value>
+        void append(const T_value & aValue)
+        {
+            appendAll(std::span{&aValue, 1});
+        }
+
+        template <class T_value>
+        void appendAll(std::span<const T_value> aValues)
+        {
+            const std::span<const std::byte> bytes = std::as_bytes(aValues);
+            mBytes.insert(mBytes.end(), bytes.begin(), bytes.end());
+        }
+
+        bool operator==(const Key & aOther) const = default;
+
+        std::vector<std::byte> mBytes;
+    };
+
+    struct KeyHasher
+    {
+        std::size_t operator()(const Key & aKey) const
+        {
+            return (std::size_t)hashBytes(aKey.mBytes);
+        }
+    };
+
+    template <class T_handle>
+    struct Entry
+    {
+        T_handle mHandle;
+        uint32_t mReferences;
+        // Registry set layouts referenced by a pipeline layout
+        std::vector<VkDescriptorSetLayout> mSetLayouts;
+    };
+
+    template <class T_handle>
+    using Entries = std::unordered_map<Key, Entry<T_handle>, KeyHasher>;
+
+    template <class T_handle, class F_create>
+    T_handle acquire(Entries<T_handle> & aEntries, Key aKey, F_create aCreate,
+                     std::span<const VkDescriptorSetLayout> aSetLayouts = {})
+    {
+        std::lock_guard lock{mMutex};
+        if(auto found = aEntries.find(aKey); found != aEntries.end())
+        {
+            ++found->second.mReferences;
+            return found->second.mHandle;
+        }
+
+        T_handle handle;
+        if(aCreate(handle) != VK_SUCCESS)
+        {
+            throw std::runtime_error{"Vulkan object creation failed."};
+        }
+        Entry<T_handle> & entry =
+            aEntries.emplace(std::move(aKey), Entry<T_handle>{.mHandle = handle, .mReferences = 1}).first->second;
+        for(VkDescriptorSetLayout setLayout : aSetLayouts)
+        {
+            if(Entry<VkDescriptorSetLayout> * setLayoutEntry = find(mDescriptorSetLayouts, setLayout))
+            {
+                ++setLayoutEntry->mReferences;
+                entry.mSetLayouts.push_back(setLayout);
+            }
+        }
+        return handle;
+    }
+
+    /// @note Linear, but releasing is rare compared to acquiring.
+    template <class T_handle>
+    static Entry<T_handle> * find(Entries<T_handle> & aEntries, T_handle aHandle)
+    {
+        for(auto & [key, entry] : aEntries)
+        {
+            if(entry.mHandle == aHandle)
+            {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    template <class T_handle>
+    void release(Entries<T_handle> & aEntries, T_handle aHandle)
+    {
+        std::lock_guard lock{mMutex};
+        Entry<T_handle> * entry = find(aEntries, aHandle);
+        assert(entry != nullptr && "Released a handle that does not come from the registry.");
+        assert(entry->mReferences != 0);
+        --entry->mReferences;
+    }
+
+    template <class T_handle, class F_destroy>
+    void destroyEntries(Entries<T_handle> & aEntries, F_destroy aDestroy, bool aUnusedOnly)
+    {
+        for(auto it = aEntries.begin(); it != aEntries.end();)
+        {
+            if(!aUnusedOnly || it->second.mReferences == 0)
+            {
+                for(VkDescriptorSetLayout setLayout : it->second.mSetLayouts)
+                {
+                    if(Entry<VkDescriptorSetLayout> * setLayoutEntry = find(mDescriptorSetLayouts, setLayout))
+                    {
+                        --setLayoutEntry->mReferences;
+                    }
+                }
+                aDestroy(vkDevice, it->second.mHandle, pAllocator);
+                it = aEntries.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    VkDevice vkDevice;
+    std::mutex mMutex;
+    Entries<VkShaderModule> mShaderModules;
+    Entries<VkDescriptorSetLayout> mDescriptorSetLayouts;
+    Entries<VkPipelineLayout> mPipelineLayouts;
+};
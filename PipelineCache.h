@@ -0,0 +1,876 @@
+#pragma once
+
+
+#include "Hash.h"
+#include "ObjectRegistry.h"
+#include "ShaderVariant.h"
+#include "VulkanHelpers.h"
+#include "VulkanLoading.h"
+#include "WorkerPool.h"
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+/// @brief The complete state of a graphics pipeline, except for the viewport and scissor which are dynamic
+/// (so pipelines survive swapchain resizes).
+/// Defaults are the state of the forward triangle.
+struct GraphicsPipelineState
+{
+    // The code must outlive the compilation (typically, it is mapped from the shader pack).
+    std::span<const char> mVertexCode;
+    std::span<const char> mFragmentCode;
+    // The features specialized in both shaders
+    VariantKey mVariant{0};
+    VertexInputDescription mVertexInput;
+
+    VkPrimitiveTopology mTopology{VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP};
+
+    // Rasterization and multisample
+    VkPolygonMode mPolygonMode{VK_POLYGON_MODE_FILL};
+    VkCullModeFlags mCullMode{VK_CULL_MODE_BACK_BIT};
+    VkFrontFace mFrontFace{VK_FRONT_FACE_COUNTER_CLOCKWISE};
+    VkSampleCountFlagBits mSamples{VK_SAMPLE_COUNT_1_BIT};
+
+    // Depth
+    bool mDepthTest{true};
+    bool mDepthWrite{true};
+    VkCompareOp mDepthCompareOp{VK_COMPARE_OP_LESS};
+
+    // Blend, the same for all color attachments
+    VkPipelineColorBlendAttachmentState mBlend{
+        .blendEnable = VK_FALSE,
+        .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
+    };
+
+    // Attachments, either a render pass subpass, or the formats for dynamic rendering (when mRenderPass is null)
+    VkRenderPass mRenderPass{VK_NULL_HANDLE};
+    uint32_t mSubpass{0};
+    std::vector<VkFormat> mColorFormats;
+    VkFormat mDepthFormat{VK_FORMAT_UNDEFINED};
+
+    // The bindless heap backend, which selects the bindless set layout and the pipeline flags (all the parts must agree)
+    BindlessBackend mBindlessBackend{BindlessBackend::DescriptorSets};
+};
+
+
+/// @brief The creation flags required by aState, for all its parts and for the link.
+VkPipelineCreateFlags getRequiredCreateFlags(const GraphicsPipelineState & aState)
+{
+    return aState.mBindlessBackend == BindlessBackend::DescriptorBuffer
+        ? (VkPipelineCreateFlags)VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT
+        : 0;
+}
+
+
+// The four parts of a graphics pipeline, which VK_EXT_graphics_pipeline_library compiles as separate libraries.
+// see: https://docs.vulkan.org/spec/latest/chapters/pipelines.html#pipelines-graphics-subsets
+constexpr std::array<VkGraphicsPipelineLibraryFlagBitsEXT, 4> gPipelineLibraryParts{
+    VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT,
+    VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT,
+    VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT,
+    VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT,
+};
+
+constexpr VkGraphicsPipelineLibraryFlagsEXT gCompletePipeline =
+    gPipelineLibraryParts[0] | gPipelineLibraryParts[1] | gPipelineLibraryParts[2] | gPipelineLibraryParts[3];
+
+
+/// @brief Hashes the state member by member (never the padding), shaders by the content of their code.
+/// @param aParts Restricts the hash to the members the given pipeline parts depend on.
+/// @note The render pass is hashed by handle: a cache must not outlive the render passes it was used with.
+Hash getStructuralHash(const GraphicsPipelineState & aState, VkGraphicsPipelineLibraryFlagsEXT aParts = gCompletePipeline)
+{
+    // Both shader parts are created with the layout reflected from both shaders
+    const bool shaders = aParts & (VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT
+                                   | VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT);
+    const bool multisample = aParts & (VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT
+                                       | VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT);
+    const bool attachments = aParts & ~VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT;
+
+    Hash hash = hashCombine(0, aParts);
+    hash = hashCombine(hash, (uint64_t)aState.mBindlessBackend);
+
+    if(shaders)
+    {
+        hash = hashCombine(hash, hashBytes(std::as_bytes(aState.mVertexCode)));
+        hash = hashCombine(hash, hashBytes(std::as_bytes(aState.mFragmentCode)));
+        // Only the features used by a shader, the other bits select the same code
+        const VariantKey usedFeatures = getVariantMask(getReflection(aState.mVertexCode))
+                                        | getVariantMask(getReflection(aState.mFragmentCode));
+        hash = hashCombine(hash, aState.mVariant & usedFeatures);
+    }
+
+    if(aParts & VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT)
+    {
+        for(const VkVertexInputBindingDescription & binding : aState.mVertexInput.mBindings)
+        {
+            hash = hashCombine(hash, binding.binding);
+            hash = hashCombine(hash, binding.stride);
+            hash = hashCombine(hash, binding.inputRate);
+        }
+        for(const VkVertexInputAttributeDescription & attribute : aState.mVertexInput.mAttributes)
+        {
+            hash = hashCombine(hash, attribute.location);
+            hash = hashCombine(hash, attribute.binding);
+            hash = hashCombine(hash, attribute.format);
+            hash = hashCombine(hash, attribute.offset);
+        }
+        hash = hashCombine(hash, aState.mTopology);
+    }
+
+    if(aParts & VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT)
+    {
+        hash = hashCombine(hash, aState.mPolygonMode);
+        hash = hashCombine(hash, aState.mCullMode);
+        hash = hashCombine(hash, aState.mFrontFace);
+    }
+
+    if(multisample)
+    {
+        hash = hashCombine(hash, aState.mSamples);
+    }
+
+    if(aParts & VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT)
+    {
+        hash = hashCombine(hash, aState.mDepthTest);
+        hash = hashCombine(hash, aState.mDepthWrite);
+        hash = hashCombine(hash, aState.mDepthCompareOp);
+    }
+
+    if(aParts & VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT)
+    {
+        const VkPipelineColorBlendAttachmentState & blend = aState.mBlend;
+        hash = hashCombine(hash, blend.blendEnable);
+        hash = hashCombine(hash, blend.srcColorBlendFactor);
+        hash = hashCombine(hash, blend.dstColorBlendFactor);
+        hash = hashCombine(hash, blend.colorBlendOp);
+        hash = hashCombine(hash, blend.srcAlphaBlendFactor);
+        hash = hashCombine(hash, blend.dstAlphaBlendFactor);
+        hash = hashCombine(hash, blend.alphaBlendOp);
+        hash = hashCombine(hash, blend.colorWriteMask);
+    }
+
+    if(attachments)
+    {
+        hash = hashCombine(hash, (uint64_t)aState.mRenderPass);
+        hash = hashCombine(hash, aState.mSubpass);
+        for(VkFormat format : aState.mColorFormats)
+        {
+            hash = hashCombine(hash, format);
+        }
+        hash = hashCombine(hash, aState.mDepthFormat);
+    }
+
+    return hash;
+}
+
+
+/// @brief The fixed-function create infos of a GraphicsPipelineState, pointing into this object (thus not copyable).
+struct GraphicsPipelineCreateInfos
+{
+    explicit GraphicsPipelineCreateInfos(const GraphicsPipelineState & aState) :
+        mRenderPass{aState.mRenderPass},
+        mSubpass{aState.mSubpass},
+        // The render pass path has a single color attachment
+        mBlendAttachments((aState.mRenderPass != VK_NULL_HANDLE) ? 1 : aState.mColorFormats.size(), aState.mBlend)
+    {
+        //
+        // Vertex Input and Assembly (Vertex input state)
+        //
+        mVertexInput = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+            .vertexBindingDescriptionCount = (uint32_t)aState.mVertexInput.mBindings.size(),
+            .pVertexBindingDescriptions = aState.mVertexInput.mBindings.data(),
+            .vertexAttributeDescriptionCount = (uint32_t)aState.mVertexInput.mAttributes.size(),
+            .pVertexAttributeDescriptions = aState.mVertexInput.mAttributes.data(),
+        };
+
+        mInputAssembly = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+            .topology = aState.mTopology,
+            .primitiveRestartEnable = VK_FALSE,
+        };
+
+        //
+        // Viewport (dynamic, with count: see setViewportAndScissor())
+        //
+        mViewport = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+        };
+
+        mDynamic = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+            .dynamicStateCount = (uint32_t)mDynamicStates.size(),
+            .pDynamicStates = mDynamicStates.data(),
+        };
+
+        //
+        // Rasterization, multisample, depth-stencil
+        //
+        mRasterization = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+            .depthClampEnable = VK_FALSE,
+            .rasterizerDiscardEnable = VK_FALSE,
+            .polygonMode = aState.mPolygonMode,
+            .cullMode = aState.mCullMode,
+            .frontFace = aState.mFrontFace,
+            .depthBiasEnable = VK_FALSE,
+            .lineWidth = 1.0f,
+        };
+
+        mMultisample = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+            .rasterizationSamples = aState.mSamples,
+            .sampleShadingEnable = VK_FALSE,
+            .minSampleShading = 0, // Useless as we disabled sample shading altogether
+            .pSampleMask = &mSampleMask,
+            .alphaToCoverageEnable = VK_FALSE,
+            .alphaToOneEnable = VK_FALSE,
+        };
+
+        mDepthStencil = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+            .depthTestEnable = aState.mDepthTest,
+            .depthWriteEnable = aState.mDepthWrite,
+            .depthCompareOp = aState.mDepthCompareOp,
+            .depthBoundsTestEnable = VK_FALSE,
+            .stencilTestEnable = VK_FALSE,
+        };
+
+        //
+        // Color blend
+        //
+        mColorBlend = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+            .logicOpEnable = VK_FALSE,
+            .attachmentCount = (uint32_t)mBlendAttachments.size(),
+            .pAttachments = mBlendAttachments.data(),
+        };
+
+        //
+        // Attachments for dynamic rendering
+        //
+        mRendering = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
+            .colorAttachmentCount = (uint32_t)aState.mColorFormats.size(),
+            .pColorAttachmentFormats = aState.mColorFormats.data(),
+            .depthAttachmentFormat = aState.mDepthFormat,
+        };
+    }
+
+    GraphicsPipelineCreateInfos(const GraphicsPipelineCreateInfos &) = delete;
+    GraphicsPipelineCreateInfos & operator=(const GraphicsPipelineCreateInfos &) = delete;
+
+    /// @brief Returns the create info of a pipeline made of aParts, only pointing to the states of those parts.
+    /// @param aNext Chained after the dynamic rendering info, if any.
+    VkGraphicsPipelineCreateInfo get(VkGraphicsPipelineLibraryFlagsEXT aParts,
+                                     std::span<const VkPipelineShaderStageCreateInfo> aStages,
+                                     VkPipelineLayout aLayout,
+                                     void * aNext = nullptr)
+    {
+        const bool vertexInput = aParts & VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT;
+        const bool preRasterization = aParts & VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT;
+        const bool fragmentShader = aParts & VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT;
+        const bool fragmentOutput = aParts & VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT;
+        const bool attachments = aParts & ~VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT;
+
+        // Ignored when a render pass is provided
+        mRendering.pNext = aNext;
+        const bool dynamicRendering = attachments && mRenderPass == VK_NULL_HANDLE;
+
+        return VkGraphicsPipelineCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+            .pNext = dynamicRendering ? &mRendering : aNext,
+            .stageCount = (uint32_t)aStages.size(),
+            .pStages = aStages.data(),
+            .pVertexInputState = vertexInput ? &mVertexInput : nullptr,
+            .pInputAssemblyState = vertexInput ? &mInputAssembly : nullptr,
+            .pTessellationState = NULL,
+            .pViewportState = preRasterization ? &mViewport : nullptr,
+            .pRasterizationState = preRasterization ? &mRasterization : nullptr,
+            .pMultisampleState = (fragmentShader || fragmentOutput) ? &mMultisample : nullptr,
+            .pDepthStencilState = fragmentShader ? &mDepthStencil : nullptr,
+            .pColorBlendState = fragmentOutput ? &mColorBlend : nullptr,
+            .pDynamicState = preRasterization ? &mDynamic : nullptr,
+            .layout = aLayout,
+            .renderPass = attachments ? mRenderPass : VK_NULL_HANDLE,
+            .subpass = attachments ? mSubpass : 0,
+        };
+    }
+
+    VkRenderPass mRenderPass;
+    uint32_t mSubpass;
+    VkPipelineVertexInputStateCreateInfo mVertexInput;
+    VkPipelineInputAssemblyStateCreateInfo mInputAssembly;
+    VkPipelineViewportStateCreateInfo mViewport;
+    std::array<VkDynamicState, 2> mDynamicStates{
+        VK_DYNAMIC_STATE_VIEWPORT_WITH_COUNT,
+        VK_DYNAMIC_STATE_SCISSOR_WITH_COUNT,
+    };
+    VkPipelineDynamicStateCreateInfo mDynamic;
+    VkPipelineRasterizationStateCreateInfo mRasterization;
+    VkSampleMask mSampleMask = ~VkSampleMask{0};
+    VkPipelineMultisampleStateCreateInfo mMultisample;
+    VkPipelineDepthStencilStateCreateInfo mDepthStencil;
+    std::vector<VkPipelineColorBlendAttachmentState> mBlendAttachments;
+    VkPipelineColorBlendStateCreateInfo mColorBlend;
+    VkPipelineRenderingCreateInfo mRendering;
+};
+
+
+/// @brief Creates the pipeline made of aParts of aState, a complete pipeline by default, otherwise a library.
+/// Shader modules and layouts are acquired from aRegistry, so pipelines sharing shaders reuse them.
+/// @param aLayout Receives the layout of the shader parts, which libraries must keep until they are linked.
+/// Released right away when not provided.
+/// @note Thread safe, as long as aCache is not created with VK_PIPELINE_CACHE_CREATE_EXTERNALLY_SYNCHRONIZED_BIT.
+/// @throw std::logic_error if the vertex input does not match the vertex shader,
+/// std::runtime_error if the creation fails.
+VkPipeline createGraphicsPipeline(VkDevice vkDevice,
+                                  ObjectRegistry & aRegistry,
+                                  VkPipelineCache aCache,
+                                  const GraphicsPipelineState & aState,
+                                  VkGraphicsPipelineLibraryFlagsEXT aParts = gCompletePipeline,
+                                  std::optional<ReflectedLayout> * aLayout = nullptr)
+{
+    const bool library = aParts != gCompletePipeline;
+
+    //
+    // Pipeline layout
+    //
+    const ShaderReflection * shaders[]{&getReflection(aState.mVertexCode), &getReflection(aState.mFragmentCode)};
+    if(aParts & VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT)
+    {
+        assertVertexInputMatches(*shaders[0], aState.mVertexInput);
+    }
+    std::optional<ReflectedLayout> layout;
+    if(aParts & (VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT | VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT))
+    {
+        layout = createReflectedLayout(vkDevice, shaders, &aRegistry, aState.mBindlessBackend);
+    }
+
+    //
+    // Shaders
+    //
+    std::vector<VkShaderModule> shaderModules;
+    std::vector<VkPipelineShaderStageCreateInfo> stageCreateInfos;
+    const Specialization specializations[]{{*shaders[0], aState.mVariant}, {*shaders[1], aState.mVariant}};
+    auto addStage = [&](VkShaderStageFlagBits aStage, std::span<const char> aCode, const Specialization & aSpecialization)
+    {
+        shaderModules.push_back(aRegistry.acquireShaderModule(aCode));
+        stageCreateInfos.push_back({
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = aStage,
+            .module = shaderModules.back(),
+            .pName = "main",
+            .pSpecializationInfo = aSpecialization.get(),
+        });
+    };
+    if(aParts & VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT)
+    {
+        addStage(VK_SHADER_STAGE_VERTEX_BIT, aState.mVertexCode, specializations[0]);
+    }
+    if(aParts & VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT)
+    {
+        addStage(VK_SHADER_STAGE_FRAGMENT_BIT, aState.mFragmentCode, specializations[1]);
+    }
+
+    // Libraries retain the information required by an optimized link
+    VkGraphicsPipelineLibraryCreateInfoEXT graphicsPipelineLibraryCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT,
+        .flags = aParts,
+    };
+    GraphicsPipelineCreateInfos createInfos{aState};
+    VkGraphicsPipelineCreateInfo graphicsPipelineCreateInfo = createInfos.get(
+        aParts,
+        stageCreateInfos,
+        layout ? layout->mPipelineLayout : VK_NULL_HANDLE,
+        library ? &graphicsPipelineLibraryCreateInfo : nullptr);
+    graphicsPipelineCreateInfo.flags = getRequiredCreateFlags(aState);
+    if(library)
+    {
+        graphicsPipelineCreateInfo.flags |= VK_PIPELINE_CREATE_LIBRARY_BIT_KHR
+                                            | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+    }
+
+    VkPipeline vkPipeline = VK_NULL_HANDLE;
+    const VkResult result = vkCreateGraphicsPipelines(
+        vkDevice,
+        aCache,
+        1,
+        &graphicsPipelineCreateInfo,
+        pAllocator,
+        &vkPipeline);
+
+    // Above Vulkan 1.3, layout must not be accessed outside the creation command
+    // Released to the registry, which keeps the layouts and modules for the next creation
+    if(layout && (aLayout == nullptr || result != VK_SUCCESS))
+    {
+        layout->destroy();
+    }
+    else if(aLayout != nullptr)
+    {
+        *aLayout = std::move(layout);
+    }
+
+    // Note: shader modules can be destroyed while pipelines using its shaders are still in use.
+    for(VkShaderModule shaderModule : shaderModules)
+    {
+        aRegistry.release(shaderModule);
+    }
+
+    if(result != VK_SUCCESS)
+    {
+        throw std::runtime_error{"Graphics pipeline creation failed."};
+    }
+    return vkPipeline;
+}
+
+
+/// @brief Links the libraries of the four parts into a complete pipeline.
+/// @param aOptimize Without it, the link is fast (no further compilation) but the pipeline might run slower.
+/// @param aFlags The flags the libraries were created with (see getRequiredCreateFlags()).
+/// @throw std::runtime_error if the link fails.
+VkPipeline linkGraphicsPipeline(VkDevice vkDevice,
+                                VkPipelineCache aCache,
+                                std::span<const VkPipeline> aLibraries,
+                                VkPipelineLayout aLayout,
+                                bool aOptimize,
+                                VkPipelineCreateFlags aFlags = 0)
+{
+    VkPipelineLibraryCreateInfoKHR pipelineLibraryCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR,
+        .libraryCount = (uint32_t)aLibraries.size(),
+        .pLibraries = aLibraries.data(),
+    };
+    VkGraphicsPipelineCreateInfo graphicsPipelineCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .pNext = &pipelineLibraryCreateInfo,
+        .flags = aFlags | (aOptimize ? (VkPipelineCreateFlags)VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT : 0),
+        .layout = aLayout,
+    };
+
+    VkPipeline vkPipeline = VK_NULL_HANDLE;
+    if(vkCreateGraphicsPipelines(vkDevice, aCache, 1, &graphicsPipelineCreateInfo, pAllocator, &vkPipeline) != VK_SUCCESS)
+    {
+        throw std::runtime_error{"Graphics pipeline link failed."};
+    }
+    return vkPipeline;
+}
+
+
+/// @brief Average durations of the creation of a state, by each method (see measurePipelineCreation()).
+struct PipelineCreationTimings
+{
+    using Duration = std::chrono::duration<double, std::milli>;
+
+    Duration mComplete;
+    // The four libraries, compiled once
+    Duration mLibraries;
+    Duration mFastLink;
+    Duration mOptimizedLink;
+};
+
+
+/// @brief Creates aState aRepetitions times as a complete pipeline, then as fast and optimized links of its libraries,
+/// synchronously and without pipeline cache, so each creation compiles.
+/// @note Requires the graphicsPipelineLibrary feature.
+PipelineCreationTimings measurePipelineCreation(VkDevice vkDevice,
+                                                ObjectRegistry & aRegistry,
+                                                const GraphicsPipelineState & aState,
+                                                uint32_t aRepetitions)
+{
+    using Clock = std::chrono::steady_clock;
+    auto measure = [&](auto aCreate)
+    {
+        PipelineCreationTimings::Duration total{0};
+        for(uint32_t repetitionIdx = 0; repetitionIdx != aRepetitions; ++repetitionIdx)
+        {
+            const Clock::time_point start = Clock::now();
+            const VkPipeline vkPipeline = aCreate();
+            total += Clock::now() - start;
+            vkDestroyPipeline(vkDevice, vkPipeline, pAllocator);
+        }
+        return total / aRepetitions;
+    };
+
+    PipelineCreationTimings result{};
+    result.mComplete = measure([&]{ return createGraphicsPipeline(vkDevice, aRegistry, VK_NULL_HANDLE, aState); });
+
+    std::array<VkPipeline, gPipelineLibraryParts.size()> libraries{};
+    // Both shader parts have the same layout, acquired from the registry
+    std::vector<ReflectedLayout> layouts;
+    const Clock::time_point librariesStart = Clock::now();
+    for(std::size_t partIdx = 0; partIdx != gPipelineLibraryParts.size(); ++partIdx)
+    {
+        std::optional<ReflectedLayout> layout;
+        libraries[partIdx] =
+            createGraphicsPipeline(vkDevice, aRegistry, VK_NULL_HANDLE, aState, gPipelineLibraryParts[partIdx], &layout);
+        if(layout)
+        {
+            layouts.push_back(std::move(*layout));
+        }
+    }
+    result.mLibraries = Clock::now() - librariesStart;
+
+    const VkPipelineLayout layout = layouts.front().mPipelineLayout;
+    const VkPipelineCreateFlags flags = getRequiredCreateFlags(aState);
+    result.mFastLink = measure([&]{ return linkGraphicsPipeline(vkDevice, VK_NULL_HANDLE, libraries, layout, false, flags); });
+    result.mOptimizedLink = measure([&]{ return linkGraphicsPipeline(vkDevice, VK_NULL_HANDLE, libraries, layout, true, flags); });
+
+    for(VkPipeline library : libraries)
+    {
+        vkDestroyPipeline(vkDevice, library, pAllocator);
+    }
+    for(ReflectedLayout & reflectedLayout : layouts)
+    {
+        reflectedLayout.destroy();
+    }
+    return result;
+}
+
+
+/// @brief Graphics pipelines keyed by the structural hash of their state, compiled on a worker pool.
+///
+/// request() never blocks on a compilation: the first request of a state queues its compilation
+/// and returns the fallback (VK_NULL_HANDLE by default) until the pipeline is ready,
+/// so the renderer either skips the draw or draws it with the fallback pipeline.
+/// The compilations share a VkPipelineCache, so pipelines with common stages compile faster.
+///
+/// With VK_EXT_graphics_pipeline_library, the four parts of each state are compiled as libraries,
+/// keyed by the members of the state they depend on, so they are shared between states.
+/// A state whose libraries all exist is fast-linked directly in request() (no compilation, typically microseconds),
+/// then an optimized link is queued on the workers, which replaces the fast-linked pipeline once ready.
+/// @note request() is meant to be called from the render thread, but is thread safe.
+class PipelineCache
+{
+public:
+    struct Statistics
+    {
+        using Duration = std::chrono::steady_clock::duration;
+
+        // Complete pipelines (without libraries), or libraries
+        uint32_t mCompilations = 0;
+        Duration mCompilationTime{0};
+        uint32_t mFastLinks = 0;
+        Duration mFastLinkTime{0};
+        uint32_t mOptimizedLinks = 0;
+        Duration mOptimizedLinkTime{0};
+    };
+
+    /// @param aUseLibraries Requires the graphicsPipelineLibrary feature.
+    PipelineCache(VkDevice vkDevice, ObjectRegistry & aRegistry, WorkerPool & aWorkers, bool aUseLibraries = false) :
+        vkDevice{vkDevice},
+        mRegistry{aRegistry},
+        mWorkers{aWorkers},
+        mUseLibraries{aUseLibraries}
+    {
+        VkPipelineCacheCreateInfo pipelineCacheCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        };
+        assertVkSuccess(vkCreatePipelineCache(vkDevice, &pipelineCacheCreateInfo, pAllocator, &mPipelineCache));
+    }
+
+    PipelineCache(const PipelineCache &) = delete;
+    PipelineCache & operator=(const PipelineCache &) = delete;
+
+    /// @brief Waits for the queued compilations, then destroys all pipelines, which must not be in use anymore.
+    void destroy()
+    {
+        std::unique_lock lock{mMutex};
+        mCompiled.wait(lock, [this]{ return mPendingCount == 0; });
+        for(auto & [key, entry] : mEntries)
+        {
+            vkDestroyPipeline(vkDevice, entry.mPipeline, pAllocator);
+        }
+        mEntries.clear();
+        for(VkPipeline retired : mRetired)
+        {
+            vkDestroyPipeline(vkDevice, retired, pAllocator);
+        }
+        mRetired.clear();
+        for(auto & [key, library] : mLibraries)
+        {
+            vkDestroyPipeline(vkDevice, library.mPipeline, pAllocator);
+            if(library.mLayout)
+            {
+                library.mLayout->destroy();
+            }
+        }
+        mLibraries.clear();
+        vkDestroyPipelineCache(vkDevice, mPipelineCache, pAllocator);
+        mPipelineCache = VK_NULL_HANDLE;
+    }
+
+    /// @brief Returns the pipeline for aState, or aFallback while it compiles (or if its compilation failed).
+    /// @param aKey getStructuralHash(aState), which callers compute once for the states they request every frame.
+    VkPipeline request(Hash aKey, const GraphicsPipelineState & aState, VkPipeline aFallback = VK_NULL_HANDLE)
+    {
+        std::array<VkPipeline, gPipelineLibraryParts.size()> libraries{};
+        VkPipelineLayout layout = VK_NULL_HANDLE;
+        {
+            std::lock_guard lock{mMutex};
+            auto [entry, inserted] = mEntries.try_emplace(aKey);
+            if(!inserted)
+            {
+                return (entry->second.mStatus == Status::Ready) ? entry->second.mPipeline : aFallback;
+            }
+            ++mPendingCount;
+
+            if(mUseLibraries)
+            {
+                layout = findLibraries(aState, libraries);
+            }
+        }
+
+        if(layout == VK_NULL_HANDLE)
+        {
+            // The state is copied, the caller's instance can go away before the compilation starts
+            mWorkers.submit([this, aKey, state = aState]
+            {
+                if(mUseLibraries)
+                {
+                    compileLibraries(aKey, state);
+                }
+                else
+                {
+                    compile(aKey, state);
+                }
+            });
+            return aFallback;
+        }
+
+        // All the parts are already compiled
+        const VkPipelineCreateFlags flags = getRequiredCreateFlags(aState);
+        VkPipeline fastLinked = link(aKey, libraries, layout, false, flags);
+        if(fastLinked != VK_NULL_HANDLE)
+        {
+            {
+                std::lock_guard lock{mMutex};
+                ++mPendingCount;
+            }
+            mWorkers.submit([this, aKey, libraries, layout, flags]
+            {
+                link(aKey, libraries, layout, true, flags);
+            });
+            return fastLinked;
+        }
+        return aFallback;
+    }
+
+    VkPipeline request(const GraphicsPipelineState & aState, VkPipeline aFallback = VK_NULL_HANDLE)
+    {
+        return request(getStructuralHash(aState), aState, aFallback);
+    }
+
+    Statistics getStatistics()
+    {
+        std::lock_guard lock{mMutex};
+        return mStatistics;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    enum class Status
+    {
+        Compiling,
+        Ready,
+        Failed,
+    };
+
+    struct Entry
+    {
+        Status mStatus{Status::Compiling};
+        VkPipeline mPipeline{VK_NULL_HANDLE};
+    };
+
+    struct Library
+    {
+        Status mStatus{Status::Compiling};
+        VkPipeline mPipeline{VK_NULL_HANDLE};
+        // Only for the shader parts
+        std::optional<ReflectedLayout> mLayout;
+    };
+
+    /// @brief Completes the pending entry aKey, releasing a job.
+    /// @note When the entry already holds a pipeline (fast-linked), it is retired: it might be in use by the GPU.
+    void complete(Hash aKey, Entry aResult)
+    {
+        {
+            std::lock_guard lock{mMutex};
+            Entry & entry = mEntries[aKey];
+            if(aResult.mStatus == Status::Ready || entry.mStatus != Status::Ready)
+            {
+                if(entry.mPipeline != VK_NULL_HANDLE)
+                {
+                    mRetired.push_back(entry.mPipeline);
+                }
+                entry = aResult;
+            }
+            --mPendingCount;
+        }
+        mCompiled.notify_all();
+    }
+
+    void compile(Hash aKey, const GraphicsPipelineState & aState)
+    {
+        Entry result{.mStatus = Status::Failed};
+        try
+        {
+            const Clock::time_point start = Clock::now();
+            result = {
+                .mStatus = Status::Ready,
+                .mPipeline = createGraphicsPipeline(vkDevice, mRegistry, mPipelineCache, aState),
+            };
+            std::lock_guard lock{mMutex};
+            ++mStatistics.mCompilations;
+            mStatistics.mCompilationTime += Clock::now() - start;
+        }
+        catch(const std::exception & aException)
+        {
+            // Not fatal: the state keeps using its fallback
+            std::cerr << "Pipeline compilation failed: " << aException.what() << "\n";
+        }
+        complete(aKey, result);
+    }
+
+    /// @brief Finds the libraries of all parts of aState.
+    /// @return The layout of the shader parts, or VK_NULL_HANDLE if a library is missing.
+    /// @note Requires the mutex.
+    VkPipelineLayout findLibraries(const GraphicsPipelineState & aState,
+                                   std::span<VkPipeline, gPipelineLibraryParts.size()> aLibraries) const
+    {
+        VkPipelineLayout layout = VK_NULL_HANDLE;
+        for(std::size_t partIdx = 0; partIdx != gPipelineLibraryParts.size(); ++partIdx)
+        {
+            auto found = mLibraries.find(getStructuralHash(aState, gPipelineLibraryParts[partIdx]));
+            if(found == mLibraries.end() || found->second.mStatus != Status::Ready)
+            {
+                return VK_NULL_HANDLE;
+            }
+            aLibraries[partIdx] = found->second.mPipeline;
+            if(found->second.mLayout)
+            {
+                layout = found->second.mLayout->mPipelineLayout;
+            }
+        }
+        return layout;
+    }
+
+    /// @brief Returns the library for aPart of aState, compiling it unless another job already does,
+    /// in which case it waits for that job.
+    /// @note Only called from the workers, the job compiling a library is always running (never queued).
+    const Library & getLibrary(const GraphicsPipelineState & aState, VkGraphicsPipelineLibraryFlagBitsEXT aPart)
+    {
+        std::unique_lock lock{mMutex};
+        // References to elements of unordered_map stay valid when other elements are inserted.
+        auto [found, inserted] = mLibraries.try_emplace(getStructuralHash(aState, aPart));
+        Library & library = found->second;
+        if(!inserted)
+        {
+            mCompiled.wait(lock, [&library]{ return library.mStatus != Status::Compiling; });
+            return library;
+        }
+        lock.unlock();
+
+        Library result{.mStatus = Status::Failed};
+        const Clock::time_point start = Clock::now();
+        try
+        {
+            result.mPipeline = createGraphicsPipeline(vkDevice, mRegistry, mPipelineCache, aState, aPart, &result.mLayout);
+            result.mStatus = Status::Ready;
+        }
+        catch(const std::exception & aException)
+        {
+            std::cerr << "Pipeline library compilation failed: " << aException.what() << "\n";
+        }
+
+        lock.lock();
+        library = std::move(result);
+        ++mStatistics.mCompilations;
+        mStatistics.mCompilationTime += Clock::now() - start;
+        lock.unlock();
+        mCompiled.notify_all();
+        return library;
+    }
+
+    void compileLibraries(Hash aKey, const GraphicsPipelineState & aState)
+    {
+        std::array<VkPipeline, gPipelineLibraryParts.size()> libraries;
+        VkPipelineLayout layout = VK_NULL_HANDLE;
+        for(std::size_t partIdx = 0; partIdx != gPipelineLibraryParts.size(); ++partIdx)
+        {
+            const Library & library = getLibrary(aState, gPipelineLibraryParts[partIdx]);
+            if(library.mStatus != Status::Ready)
+            {
+                complete(aKey, {.mStatus = Status::Failed});
+                return;
+            }
+            libraries[partIdx] = library.mPipeline;
+            if(library.mLayout)
+            {
+                layout = library.mLayout->mPipelineLayout;
+            }
+        }
+
+        // The pending count covers both links, the optimized one running right after on this worker.
+        {
+            std::lock_guard lock{mMutex};
+            ++mPendingCount;
+        }
+        link(aKey, libraries, layout, false, getRequiredCreateFlags(aState));
+        link(aKey, libraries, layout, true, getRequiredCreateFlags(aState));
+    }
+
+    /// @brief Links aLibraries into the pipeline of aKey, completing its pending job.
+    /// @return The linked pipeline, or VK_NULL_HANDLE on failure.
+    VkPipeline link(Hash aKey, std::span<const VkPipeline> aLibraries, VkPipelineLayout aLayout, bool aOptimize,
+                    VkPipelineCreateFlags aFlags)
+    {
+        Entry result{.mStatus = Status::Failed};
+        try
+        {
+            const Clock::time_point start = Clock::now();
+            result = {
+                .mStatus = Status::Ready,
+                .mPipeline = linkGraphicsPipeline(vkDevice, mPipelineCache, aLibraries, aLayout, aOptimize, aFlags),
+            };
+            std::lock_guard lock{mMutex};
+            ++(aOptimize ? mStatistics.mOptimizedLinks : mStatistics.mFastLinks);
+            (aOptimize ? mStatistics.mOptimizedLinkTime : mStatistics.mFastLinkTime) += Clock::now() - start;
+        }
+        catch(const std::exception & aException)
+        {
+            // An optimized link failure keeps the fast-linked pipeline
+            std::cerr << "Pipeline link failed: " << aException.what() << "\n";
+        }
+        complete(aKey, result);
+        return result.mPipeline;
+    }
+
+    VkDevice vkDevice;
+    ObjectRegistry & mRegistry;
+    WorkerPool & mWorkers;
+    const bool mUseLibraries;
+    VkPipelineCache mPipelineCache{VK_NULL_HANDLE};
+
+    std::mutex mMutex;
+    std::condition_variable mCompiled;
+    std::unordered_map<Hash, Entry> mEntries;
+    std::unordered_map<Hash, Library> mLibraries;
+    // Fast-linked pipelines replaced by their optimized link, which might still be in use by the GPU
+    std::vector<VkPipeline> mRetired;
+    uint32_t mPendingCount{0};
+    Statistics mStatistics;
+};
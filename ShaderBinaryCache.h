@@ -0,0 +1,276 @@
+#pragma once
+
+
+#include "FileHelper.h"
+#include "Hash.h"
+#include "ObjectRegistry.h"
+#include "VulkanLoading.h"
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <optional>
+#include <span>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+#include <cstring>
+
+
+/// @brief On-disk cache of the implementation binaries of shader objects.
+///
+/// Shader objects created from SPIR-V are compiled by the driver, every run.
+/// Their binary is retrieved with `vkGetShaderBinaryDataEXT()` and stored, keyed by the content of the create infos,
+/// so the next run creates them from `VK_SHADER_CODE_TYPE_BINARY_EXT` code.
+/// Binaries are only compatible with the implementation identified by shaderBinaryUUID and shaderBinaryVersion,
+/// any mismatch (or a binary rejected by the driver) falls back to SPIR-V, then refreshes the cache entry.
+/// The descriptor set layouts of the shaders must come from the registry, which provides their content.
+/// see: https://docs.vulkan.org/spec/latest/chapters/shaders.html#shaders-objects-binary-code
+class ShaderBinaryCache
+{
+public:
+    struct Statistics
+    {
+        uint32_t mHits = 0;
+        uint32_t mMisses = 0;
+    };
+
+    ShaderBinaryCache(VkPhysicalDevice vkPhysicalDevice, ObjectRegistry & aRegistry, std::filesystem::path aDirectory) :
+        mRegistry{aRegistry},
+        mDirectory{std::move(aDirectory)}
+    {
+        VkPhysicalDeviceShaderObjectPropertiesEXT shaderObjectProperties{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_OBJECT_PROPERTIES_EXT,
+        };
+        VkPhysicalDeviceProperties2 properties{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+            .pNext = &shaderObjectProperties,
+        };
+        vkGetPhysicalDeviceProperties2(vkPhysicalDevice, &properties);
+        std::ranges::copy(shaderObjectProperties.shaderBinaryUUID, mShaderBinaryUUID.begin());
+        mShaderBinaryVersion = shaderObjectProperties.shaderBinaryVersion;
+    }
+
+    /// @brief Creates the shaders described by aCreateInfos (which must be SPIR-V), from their cached binaries
+    /// if available, caching the binaries otherwise.
+    /// @param aShaders Receives aCreateInfos.size() handles.
+    /// @throw std::invalid_argument if a descriptor set layout does not come from the registry.
+    VkResult createShaders(VkDevice vkDevice,
+                           std::span<const VkShaderCreateInfoEXT> aCreateInfos,
+                           VkShaderEXT * aShaders)
+    {
+        const Hash key = getKey(aCreateInfos);
+        const std::filesystem::path path = getPath(key);
+
+        // The mapping provides the binaries in place, it must outlive the creation call.
+        if(std::optional<MappedFile> file = open(path, key, aCreateInfos.size()))
+        {
+            std::vector<VkShaderCreateInfoEXT> binaryCreateInfos{aCreateInfos.begin(), aCreateInfos.end()};
+            const auto * blobs = reinterpret_cast<const Blob *>(file->getBytes().data() + sizeof(Header));
+            for(std::size_t shaderIdx = 0; shaderIdx != binaryCreateInfos.size(); ++shaderIdx)
+            {
+                binaryCreateInfos[shaderIdx].codeType = VK_SHADER_CODE_TYPE_BINARY_EXT;
+                binaryCreateInfos[shaderIdx].codeSize = blobs[shaderIdx].mSize;
+                binaryCreateInfos[shaderIdx].pCode = file->getBytes().data() + blobs[shaderIdx].mOffset;
+            }
+
+            const VkResult result = vkCreateShadersEXT(vkDevice, (uint32_t)binaryCreateInfos.size(),
+                                                       binaryCreateInfos.data(), pAllocator, aShaders);
+            if(result == VK_SUCCESS)
+            {
+                ++mStatistics.mHits;
+                return result;
+            }
+            // Notably VK_INCOMPATIBLE_SHADER_BINARY_EXT, which is not an error code:
+            // some shaders might have been created, linked shaders must all come from the same code type.
+            for(std::size_t shaderIdx = 0; shaderIdx != binaryCreateInfos.size(); ++shaderIdx)
+            {
+                vkDestroyShaderEXT(vkDevice, aShaders[shaderIdx], pAllocator);
+                aShaders[shaderIdx] = VK_NULL_HANDLE;
+            }
+        }
+
+        ++mStatistics.mMisses;
+        const VkResult result = vkCreateShadersEXT(vkDevice, (uint32_t)aCreateInfos.size(),
+                                                   aCreateInfos.data(), pAllocator, aShaders);
+        if(result == VK_SUCCESS)
+        {
+            store(vkDevice, path, key, std::span{aShaders, aCreateInfos.size()});
+        }
+        return result;
+    }
+
+    const Statistics & getStatistics() const
+    {
+        return mStatistics;
+    }
+
+private:
+    static constexpr uint32_t gMagic = 0x4e494253; // "SBIN"
+    static constexpr uint32_t gFormatVersion = 1;
+    // Required alignment of binary shader code
+    static constexpr uint64_t gBlobAlignment = 16;
+
+    struct Header
+    {
+        uint32_t mMagic;
+        uint32_t mFormatVersion;
+        std::array<uint8_t, VK_UUID_SIZE> mShaderBinaryUUID;
+        uint32_t mShaderBinaryVersion;
+        uint32_t mShaderCount;
+        Hash mKey;
+    };
+
+    // Followed by Header::mShaderCount blobs
+    struct Blob
+    {
+        uint64_t mOffset; // from the start of the file
+        uint64_t mSize;
+    };
+
+    /// @brief Hashes everything the binaries depend on.
+    /// @note Descriptor set layouts are opaque handles, the content behind them is hashed.
+    Hash getKey(std::span<const VkShaderCreateInfoEXT> aCreateInfos) const
+    {
+        Hash hash = hashBytes(std::as_bytes(std::span{mShaderBinaryUUID}));
+        hash = hashCombine(hash, mShaderBinaryVersion);
+        for(const VkShaderCreateInfoEXT & info : aCreateInfos)
+        {
+            hash = hashCombine(hash, info.flags);
+            hash = hashCombine(hash, info.stage);
+            hash = hashCombine(hash, info.nextStage);
+            hash = hashCombine(hash, hashBytes({static_cast<const std::byte *>(info.pCode), info.codeSize}));
+            hash = hashCombine(hash, hashBytes(std::as_bytes(std::span{info.pName, std::strlen(info.pName)})));
+            hash = hashCombine(hash, info.setLayoutCount);
+            for(VkDescriptorSetLayout setLayout : std::span{info.pSetLayouts, info.setLayoutCount})
+            {
+                hash = hashCombine(hash, mRegistry.hashContent(setLayout));
+            }
+            hash = hashCombine(hash, hashBytes(std::as_bytes(
+                std::span{info.pPushConstantRanges, info.pushConstantRangeCount})));
+            if(const VkSpecializationInfo * specialization = info.pSpecializationInfo)
+            {
+                hash = hashCombine(hash, hashBytes(std::as_bytes(
+                    std::span{specialization->pMapEntries, specialization->mapEntryCount})));
+                hash = hashCombine(hash, hashBytes(
+                    {static_cast<const std::byte *>(specialization->pData), specialization->dataSize}));
+            }
+        }
+        return hash;
+    }
+
+    std::filesystem::path getPath(Hash aKey) const
+    {
+        std::ostringstream oss;
+        oss << std::hex << std::setw(16) << std::setfill('0') << aKey << ".bin";
+        return mDirectory / oss.str();
+    }
+
+    /// @brief Maps the cache entry, if it exists and matches the key and the implementation.
+    std::optional<MappedFile> open(const std::filesystem::path & aPath, Hash aKey, std::size_t aShaderCount) const
+    {
+        std::error_code error;
+        if(!std::filesystem::exists(aPath, error))
+        {
+            return std::nullopt;
+        }
+
+        std::optional<MappedFile> file;
+        try
+        {
+            file.emplace(aPath);
+        }
+        catch(const std::runtime_error &)
+        {
+            return std::nullopt;
+        }
+
+        const std::span<const std::byte> bytes = file->getBytes();
+        if(bytes.size() < sizeof(Header) + aShaderCount * sizeof(Blob))
+        {
+            return std::nullopt;
+        }
+        const auto * header = reinterpret_cast<const Header *>(bytes.data());
+        if(header->mMagic != gMagic
+           || header->mFormatVersion != gFormatVersion
+           || header->mShaderBinaryUUID != mShaderBinaryUUID
+           || header->mShaderBinaryVersion != mShaderBinaryVersion
+           || header->mShaderCount != aShaderCount
+           || header->mKey != aKey)
+        {
+            return std::nullopt;
+        }
+        const auto * blobs = reinterpret_cast<const Blob *>(bytes.data() + sizeof(Header));
+        for(std::size_t shaderIdx = 0; shaderIdx != aShaderCount; ++shaderIdx)
+        {
+            if(blobs[shaderIdx].mOffset % gBlobAlignment != 0
+               || blobs[shaderIdx].mOffset > bytes.size()
+               || blobs[shaderIdx].mSize > bytes.size() - blobs[shaderIdx].mOffset)
+            {
+                return std::nullopt;
+            }
+        }
+        return file;
+    }
+
+    /// @brief Retrieves the binaries of aShaders, then writes them as the cache entry for aKey.
+    /// @note Failing to write the cache is not an error, it will be written on a later run.
+    void store(VkDevice vkDevice, const std::filesystem::path & aPath, Hash aKey, std::span<const VkShaderEXT> aShaders) const
+    {
+        Header header{
+            .mMagic = gMagic,
+            .mFormatVersion = gFormatVersion,
+            .mShaderBinaryUUID = mShaderBinaryUUID,
+            .mShaderBinaryVersion = mShaderBinaryVersion,
+            .mShaderCount = (uint32_t)aShaders.size(),
+            .mKey = aKey,
+        };
+        std::vector<Blob> blobs(aShaders.size());
+        std::vector<std::byte> data;
+        const uint64_t dataOffset = sizeof(Header) + blobs.size() * sizeof(Blob);
+        for(std::size_t shaderIdx = 0; shaderIdx != aShaders.size(); ++shaderIdx)
+        {
+            // Size query, then data
+            std::size_t size = 0;
+            if(vkGetShaderBinaryDataEXT(vkDevice, aShaders[shaderIdx], &size, nullptr) != VK_SUCCESS || size == 0)
+            {
+                return;
+            }
+            // Aligned in the file, so the mapping (page aligned) provides aligned code
+            data.resize((dataOffset + data.size() + gBlobAlignment - 1) / gBlobAlignment * gBlobAlignment - dataOffset);
+            blobs[shaderIdx] = {.mOffset = dataOffset + data.size(), .mSize = size};
+            data.resize(data.size() + size);
+            if(vkGetShaderBinaryDataEXT(vkDevice, aShaders[shaderIdx], &size, data.data() + data.size() - size) != VK_SUCCESS)
+            {
+                return;
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::create_directories(mDirectory, error);
+        // Written aside then renamed, so an interrupted write never leaves a truncated entry
+        std::filesystem::path temporaryPath = aPath;
+        temporaryPath += ".tmp";
+        {
+            std::ofstream output{temporaryPath, std::ios_base::binary | std::ios_base::trunc};
+            output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            output.write(reinterpret_cast<const char *>(blobs.data()), blobs.size() * sizeof(Blob));
+            output.write(reinterpret_cast<const char *>(data.data()), data.size());
+            if(!output)
+            {
+                return;
+            }
+        }
+        std::filesystem::rename(temporaryPath, aPath, error);
+    }
+
+    ObjectRegistry & mRegistry;
+    std::filesystem::path mDirectory;
+    std::array<uint8_t, VK_UUID_SIZE> mShaderBinaryUUID;
+    uint32_t mShaderBinaryVersion;
+    Statistics mStatistics;
+};
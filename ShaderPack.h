@@ -0,0 +1,141 @@
+#pragma once
+
+
+#include "FileHelper.h"
+#include "Hash.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include <cstdint>
+#include <cstring>
+
+
+// Single file archive of SPIR-V modules, produced at build time by tools/PackShaders.cpp,
+// so all shaders are obtained with a single file open and mapping at startup.
+//
+// Layout (native endianness):
+// * Header
+// * Index: Header::mEntryCount entries, sorted by name
+// * Blobs: the SPIR-V code, each at a 4-byte aligned offset
+namespace shaderpack {
+
+    constexpr uint32_t gMagic = 0x4b504853; // "SHPK"
+    constexpr uint32_t gVersion = 1;
+    constexpr uint32_t gBlobAlignment = 4;
+
+    struct Header
+    {
+        uint32_t mMagic;
+        uint32_t mVersion;
+        uint32_t mEntryCount;
+        uint32_t mReserved;
+    };
+
+    struct Entry
+    {
+        // Source file name without the .spv extension (e.g. "Forward.vert"), null terminated
+        char mName[56];
+        uint32_t mStage; // VkShaderStageFlagBits
+        uint32_t mSize;  // in bytes
+        Hash mHash;      // hashBytes() of the code
+        uint64_t mOffset; // from the start of the pack
+    };
+
+    static_assert(sizeof(Header) == 16);
+    static_assert(sizeof(Entry) == 80);
+
+} // namespace shaderpack
+
+
+/// @brief Read-only access to a shader pack, mapped for the lifetime of the object.
+class ShaderPack
+{
+public:
+    struct Shader
+    {
+        std::string_view mName;
+        uint32_t mStage; // VkShaderStageFlagBits
+        Hash mHash;
+        std::span<const char> mCode;
+    };
+
+    /// @throw std::runtime_error if the file cannot be mapped or is not a valid pack.
+    explicit ShaderPack(const std::filesystem::path & aPath) :
+        mFile{aPath}
+    {
+        const std::span<const std::byte> bytes = mFile.getBytes();
+        if(bytes.size() < sizeof(shaderpack::Header))
+        {
+            throw std::runtime_error{"Shader pack '" + aPath.string() + "' is truncated."};
+        }
+        const auto * header = reinterpret_cast<const shaderpack::Header *>(bytes.data());
+        if(header->mMagic != shaderpack::gMagic || header->mVersion != shaderpack::gVersion)
+        {
+            throw std::runtime_error{"Shader pack '" + aPath.string() + "' has an unsupported format."};
+        }
+
+        const std::size_t indexSize = (std::size_t)header->mEntryCount * sizeof(shaderpack::Entry);
+        if(bytes.size() < sizeof(shaderpack::Header) + indexSize)
+        {
+            throw std::runtime_error{"Shader pack '" + aPath.string() + "' is truncated."};
+        }
+        mIndex = {reinterpret_cast<const shaderpack::Entry *>(bytes.data() + sizeof(shaderpack::Header)),
+                  header->mEntryCount};
+
+        // Validate once, so lookups can trust the index
+        for(const shaderpack::Entry & entry : mIndex)
+        {
+            if(entry.mOffset % shaderpack::gBlobAlignment != 0
+               || entry.mOffset > bytes.size()
+               || entry.mSize > bytes.size() - entry.mOffset
+               || std::memchr(entry.mName, '\0', sizeof(entry.mName)) == nullptr)
+            {
+                throw std::runtime_error{"Shader pack '" + aPath.string() + "' has an invalid index."};
+            }
+        }
+        // get() binary searches the names, which must be strictly increasing (sorted, without duplicates)
+        auto notIncreasing = [](const shaderpack::Entry & aLeft, const shaderpack::Entry & aRight)
+        {
+            return std::string_view{aLeft.mName} >= std::string_view{aRight.mName};
+        };
+        if(std::ranges::adjacent_find(mIndex, notIncreasing) != mIndex.end())
+        {
+            throw std::runtime_error{"Shader pack '" + aPath.string() + "' has an unsorted index."};
+        }
+    }
+
+    std::span<const shaderpack::Entry> getIndex() const
+    {
+        return mIndex;
+    }
+
+    /// @brief Binary search of aName in the index.
+    /// @throw std::out_of_range if the pack does not contain aName.
+    Shader get(std::string_view aName) const
+    {
+        auto found = std::ranges::lower_bound(mIndex, aName, {},
+                                              [](const shaderpack::Entry & aEntry)
+                                              {
+                                                  return std::string_view{aEntry.mName};
+                                              });
+        if(found == mIndex.end() || std::string_view{found->mName} != aName)
+        {
+            throw std::out_of_range{"Shader '" + std::string{aName} + "' is not in the pack."};
+        }
+        return Shader{
+            .mName = found->mName,
+            .mStage = found->mStage,
+            .mHash = found->mHash,
+            .mCode = mFile.getChars().subspan(found->mOffset, found->mSize),
+        };
+    }
+
+private:
+    MappedFile mFile;
+    std::span<const shaderpack::Entry> mIndex;
+};
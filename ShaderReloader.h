@@ -0,0 +1,243 @@
+#pragma once
+
+
+#include "FileHelper.h"
+#include "SpirvReflection.h"
+#include "WorkerPool.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <cstdint>
+
+
+/// @brief Watches a directory of SPIR-V files (as produced by glslang, e.g. `Forward.vert.spv`) from a background thread,
+/// loading the code of the files modified or created while the application runs.
+///
+/// The directory is polled, which only costs a few file status queries per period, and is portable.
+/// The new code is validated by reflecting it, so a truncated file (caught mid-write) or an invalid module is
+/// reported then ignored, the previous version of the shader staying in use.
+class ShaderWatcher
+{
+public:
+    using Changes = std::map<std::string/*name, without .spv*/, std::span<const char>/*code*/>;
+
+    explicit ShaderWatcher(std::filesystem::path aDirectory,
+                           std::chrono::milliseconds aPollPeriod = std::chrono::milliseconds{250}) :
+        mDirectory{std::move(aDirectory)},
+        mPollPeriod{aPollPeriod}
+    {
+        // Only the files modified or created after startup are reported
+        scan(false);
+        mThread = std::thread{[this]{ run(); }};
+    }
+
+    ~ShaderWatcher()
+    {
+        {
+            std::lock_guard lock{mMutex};
+            mStopping = true;
+        }
+        mCondition.notify_one();
+        mThread.join();
+    }
+
+    ShaderWatcher(const ShaderWatcher &) = delete;
+    ShaderWatcher & operator=(const ShaderWatcher &) = delete;
+
+    /// @brief Returns the shaders modified since the previous call, never blocks on the file system.
+    /// @note The code stays valid for the lifetime of the watcher,
+    /// as pipelines and reflections might still refer to it after it is replaced.
+    Changes takeChanges()
+    {
+        std::lock_guard lock{mMutex};
+        return std::exchange(mChanges, {});
+    }
+
+private:
+    void run()
+    {
+        std::unique_lock lock{mMutex};
+        while(!mCondition.wait_for(lock, mPollPeriod, [this]{ return mStopping; }))
+        {
+            lock.unlock();
+            scan(true);
+            lock.lock();
+        }
+    }
+
+    /// @param aReport Loads the modified and new files into the changes, otherwise only records their write time.
+    void scan(bool aReport)
+    {
+        std::error_code error;
+        for(const std::filesystem::directory_entry & entry : std::filesystem::directory_iterator{mDirectory, error})
+        {
+            if(entry.path().extension() != ".spv")
+            {
+                continue;
+            }
+            const std::filesystem::file_time_type writeTime = entry.last_write_time(error);
+            if(error)
+            {
+                continue;
+            }
+            // Files created after the first scan are reported as well (e.g. a shader compiled for the first time)
+            auto [known, inserted] = mWriteTimes.try_emplace(entry.path().filename().string(), writeTime);
+            if(!inserted)
+            {
+                if(known->second == writeTime)
+                {
+                    continue;
+                }
+                known->second = writeTime;
+            }
+            if(aReport)
+            {
+                load(entry.path());
+            }
+        }
+    }
+
+    void load(const std::filesystem::path & aPath)
+    {
+        std::vector<char> code = readFile(aPath);
+        try
+        {
+            reflectSpirv({reinterpret_cast<const uint32_t *>(code.data()), code.size() / sizeof(uint32_t)});
+        }
+        catch(const std::exception & aException)
+        {
+            std::cerr << "Ignoring modified shader '" << aPath.string() << "': " << aException.what() << "\n";
+            return;
+        }
+
+        std::cout << "Reloading shader '" << aPath.string() << "'.\n";
+        std::lock_guard lock{mMutex};
+        const std::vector<char> & stored = mCodes.emplace_back(std::move(code));
+        // "Forward.vert.spv" is known as "Forward.vert", as in the shader pack
+        mChanges[aPath.stem().string()] = stored;
+    }
+
+    std::filesystem::path mDirectory;
+    std::chrono::milliseconds mPollPeriod;
+    // Only accessed by the watching thread (after construction)
+    std::map<std::string, std::filesystem::file_time_type> mWriteTimes;
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    bool mStopping{false};
+    // Every loaded version, the list never moves them
+    std::list<std::vector<char>> mCodes;
+    Changes mChanges;
+    std::thread mThread;
+};
+
+
+/// @brief A value rebuilt on the workers, taken by the render thread at a frame boundary.
+///
+/// Several rebuilds can be in flight, the most recently started one that succeeds wins:
+/// the values they supersede are discarded. A rebuild that throws leaves the previous value in place.
+template <class T_value>
+class PendingRebuild
+{
+public:
+    /// @param aDiscard Destroys the values that are superseded before being taken.
+    explicit PendingRebuild(std::function<void(T_value &)> aDiscard) :
+        mDiscard{std::move(aDiscard)}
+    {}
+
+    PendingRebuild(const PendingRebuild &) = delete;
+    PendingRebuild & operator=(const PendingRebuild &) = delete;
+
+    /// @param aBuild Runs on a worker, returns the new value or throws.
+    void start(WorkerPool & aWorkers, std::function<T_value()> aBuild)
+    {
+        uint64_t generation;
+        {
+            std::lock_guard lock{mMutex};
+            generation = ++mStartedGeneration;
+            ++mRunningCount;
+        }
+
+        aWorkers.submit([this, generation, build = std::move(aBuild)]
+        {
+            std::optional<T_value> value;
+            try
+            {
+                value = build();
+            }
+            catch(const std::exception & aException)
+            {
+                std::cerr << "Rebuild failed, keeping the previous version: " << aException.what() << "\n";
+            }
+
+            {
+                std::lock_guard lock{mMutex};
+                if(value && generation > mResultGeneration)
+                {
+                    if(mResult)
+                    {
+                        mDiscard(*mResult);
+                    }
+                    mResult = std::move(value);
+                    mResultGeneration = generation;
+                }
+                else if(value)
+                {
+                    mDiscard(*value);
+                }
+                --mRunningCount;
+            }
+            mFinished.notify_all();
+        });
+    }
+
+    /// @brief Returns the rebuilt value, once, if one finished since the previous call. Never blocks on a rebuild.
+    std::optional<T_value> take()
+    {
+        std::lock_guard lock{mMutex};
+        return std::exchange(mResult, std::nullopt);
+    }
+
+    /// @brief Some rebuilds are still in flight.
+    bool isRunning()
+    {
+        std::lock_guard lock{mMutex};
+        return mRunningCount != 0;
+    }
+
+    /// @brief Waits for the rebuilds in flight, discarding their values.
+    void cancel()
+    {
+        std::unique_lock lock{mMutex};
+        mFinished.wait(lock, [this]{ return mRunningCount == 0; });
+        if(mResult)
+        {
+            mDiscard(*mResult);
+            mResult.reset();
+        }
+    }
+
+private:
+    std::function<void(T_value &)> mDiscard;
+
+    std::mutex mMutex;
+    std::condition_variable mFinished;
+    uint64_t mStartedGeneration{0};
+    uint64_t mResultGeneration{0};
+    uint32_t mRunningCount{0};
+    std::optional<T_value> mResult;
+};
@@ -0,0 +1,157 @@
+#pragma once
+
+
+#include "SpirvReflection.h"
+#include "VulkanLoading.h"
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <cstdint>
+
+
+// Uber-shader variants: features are boolean specialization constants, selected when the shader is compiled,
+// so the driver's compiler removes the branches of disabled features (instead of branching on a uniform at runtime).
+// A variant is the bitset of its enabled features, bit N being `layout(constant_id = N) const bool`.
+// see: https://docs.vulkan.org/spec/latest/chapters/pipelines.html#pipelines-specialization-constants
+
+
+using VariantKey = uint32_t;
+
+/// @brief The features of the forward shaders, the value being the bit (thus the constant_id in the GLSL).
+/// All default to false in the shaders, so variant 0 is the unspecialized shader.
+enum class ShaderFeature : uint32_t
+{
+    Grayscale = 0,      // Color.frag: outputs the luminance of the color
+    UniformColor = 1,   // Forward.vert, ForwardInstanced.vert, ForwardDraw.vert: ignores the vertex color, for white (or the draw color)
+};
+
+constexpr std::array<std::pair<std::string_view, ShaderFeature>, 2> gShaderFeatureNames{{
+    {"Grayscale", ShaderFeature::Grayscale},
+    {"UniformColor", ShaderFeature::UniformColor},
+}};
+
+
+constexpr VariantKey operator|(ShaderFeature aLeft, ShaderFeature aRight)
+{
+    return (1u << (uint32_t)aLeft) | (1u << (uint32_t)aRight);
+}
+
+constexpr VariantKey operator|(VariantKey aVariant, ShaderFeature aFeature)
+{
+    return aVariant | (1u << (uint32_t)aFeature);
+}
+
+constexpr bool hasFeature(VariantKey aVariant, ShaderFeature aFeature)
+{
+    return (aVariant >> (uint32_t)aFeature) & 0b1;
+}
+
+
+/// @brief The bits of the variant key consumed by aShader: variants only differing by other bits are identical.
+inline VariantKey getVariantMask(const ShaderReflection & aShader)
+{
+    VariantKey mask = 0;
+    for(const ShaderReflection::SpecializationConstant & constant : aShader.mSpecializationConstants)
+    {
+        if(constant.mBoolean && constant.mConstantId < 32)
+        {
+            mask |= 1u << constant.mConstantId;
+        }
+    }
+    return mask;
+}
+
+
+/// @brief The specialization info of a variant of a shader, pointing into this object (thus not copyable).
+/// Only the feature constants declared by the shader are specialized, so the info (e.g. hashed by the
+/// shader binary cache) is the same for all the variants only differing by features the shader ignores.
+struct Specialization
+{
+    Specialization(const ShaderReflection & aShader, VariantKey aVariant)
+    {
+        for(const ShaderReflection::SpecializationConstant & constant : aShader.mSpecializationConstants)
+        {
+            if(constant.mBoolean && constant.mConstantId < 32)
+            {
+                mEntries.push_back({
+                    .constantID = constant.mConstantId,
+                    .offset = (uint32_t)(mData.size() * sizeof(VkBool32)),
+                    .size = sizeof(VkBool32),
+                });
+                mData.push_back((aVariant >> constant.mConstantId) & 0b1 ? VK_TRUE : VK_FALSE);
+            }
+        }
+        mInfo = {
+            .mapEntryCount = (uint32_t)mEntries.size(),
+            .pMapEntries = mEntries.data(),
+            .dataSize = mData.size() * sizeof(VkBool32),
+            .pData = mData.data(),
+        };
+    }
+
+    Specialization(const Specialization &) = delete;
+    Specialization & operator=(const Specialization &) = delete;
+
+    /// @return nullptr for a shader without feature constants.
+    const VkSpecializationInfo * get() const
+    {
+        return mEntries.empty() ? nullptr : &mInfo;
+    }
+
+    std::vector<VkSpecializationMapEntry> mEntries;
+    std::vector<VkBool32> mData;
+    VkSpecializationInfo mInfo;
+};
+
+
+/// @brief Reads the variants to create at load time, one per line, as the names of their enabled features
+/// separated by spaces (`none` for the variant without features). Text after '#' is a comment.
+/// @throw std::runtime_error if the file cannot be read, std::invalid_argument for an unknown feature.
+inline std::vector<VariantKey> readVariantManifest(const std::filesystem::path & aPath)
+{
+    std::ifstream manifest{aPath};
+    if(!manifest)
+    {
+        throw std::runtime_error{"Cannot open variant manifest '" + aPath.string() + "'."};
+    }
+
+    std::vector<VariantKey> result;
+    for(std::string line; std::getline(manifest, line);)
+    {
+        std::istringstream words{line.substr(0, line.find('#'))};
+        std::string word;
+        if(!(words >> word))
+        {
+            continue;
+        }
+
+        VariantKey variant = 0;
+        if(word != "none")
+        {
+            do
+            {
+                auto found = std::ranges::find(gShaderFeatureNames, word, &std::pair<std::string_view, ShaderFeature>::first);
+                if(found == gShaderFeatureNames.end())
+                {
+                    throw std::invalid_argument{"Unknown shader feature '" + word + "' in '" + aPath.string() + "'."};
+                }
+                variant = variant | found->second;
+            } while(words >> word);
+        }
+
+        if(std::ranges::find(result, variant) == result.end())
+        {
+            result.push_back(variant);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+
+// Instruction set selection, following the compiler target
+// (e.g. `/arch:AVX2` with cl.exe, `-mavx2 -mf16c -mfma` with gcc and clang).
+// Defining SIMD_FORCE_SCALAR disables all intrinsics paths, which notably provides the reference implementations.
+#if !defined(SIMD_FORCE_SCALAR)
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(__AVX2__)
+#define SIMD_AVX2
+#include <immintrin.h>
+#endif
+
+// Hardware float <-> half conversions. cl.exe does not define a macro for F16C, but it is implied by /arch:AVX2.
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+#define SIMD_F16C
+#include <immintrin.h>
+#endif
+
+#endif // SIMD_FORCE_SCALAR
+
+
+/// @brief Name of the instruction set in use, for reporting.
+constexpr const char * getSimdIsaName()
+{
+#if defined(SIMD_AVX2)
+    return "AVX2";
+#elif defined(SIMD_SSE2)
+    return "SSE2";
+#elif defined(SIMD_NEON)
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
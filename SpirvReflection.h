@@ -0,0 +1,756 @@
+#pragma once
+
+
+#include "Hash.h"
+#include "VulkanLoading.h"
+
+#include <algorithm>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <cstdint>
+
+
+// Minimal SPIR-V reflection: a single pass over the module, only recording the instructions
+// describing the interface of the (first) entry point with the pipeline.
+// see: https://registry.khronos.org/SPIR-V/specs/unified1/SPIRV.html#PhysicalLayout
+
+
+/// @brief The shader interface, as seen by the Vulkan API.
+struct ShaderReflection
+{
+    // Input or output variable, one entry per location (e.g. a mat4 input consumes 4 locations)
+    struct InterfaceVariable
+    {
+        uint32_t mLocation;
+        VkFormat mFormat; // The format matching the shader type, with 32-bit floats for float types
+        uint32_t mSize;   // Size of mFormat, in bytes
+        std::string mName;
+    };
+
+    struct DescriptorBinding
+    {
+        uint32_t mSet;
+        uint32_t mBinding;
+        VkDescriptorType mType;
+        uint32_t mCount; // 0 for runtime sized arrays
+        std::string mName;
+    };
+
+    struct SpecializationConstant
+    {
+        uint32_t mConstantId;
+        uint32_t mSize; // in bytes, VkBool32 for booleans
+        bool mBoolean;
+        std::string mName;
+    };
+
+    VkShaderStageFlagBits mStage;
+    // Sorted by location, builtins are not listed
+    std::vector<InterfaceVariable> mInputs;
+    std::vector<InterfaceVariable> mOutputs;
+    // Sorted by set then binding
+    std::vector<DescriptorBinding> mDescriptorBindings;
+    std::optional<VkPushConstantRange> mPushConstants;
+    // Sorted by constant id
+    std::vector<SpecializationConstant> mSpecializationConstants;
+};
+
+
+namespace spirv {
+
+    // Subset of the SPIR-V grammar used by the reflection
+    // see: https://registry.khronos.org/SPIR-V/specs/unified1/SPIRV.html#_binary_form
+    constexpr uint32_t gMagicNumber = 0x07230203;
+
+    enum Op : uint32_t
+    {
+        OpName = 5,
+        OpEntryPoint = 15,
+        OpTypeBool = 20,
+        OpTypeInt = 21,
+        OpTypeFloat = 22,
+        OpTypeVector = 23,
+        OpTypeMatrix = 24,
+        OpTypeImage = 25,
+        OpTypeSampler = 26,
+        OpTypeSampledImage = 27,
+        OpTypeArray = 28,
+        OpTypeRuntimeArray = 29,
+        OpTypeStruct = 30,
+        OpTypePointer = 32,
+        OpConstant = 43,
+        OpSpecConstantTrue = 48,
+        OpSpecConstantFalse = 49,
+        OpSpecConstant = 50,
+        OpVariable = 59,
+        OpDecorate = 71,
+        OpMemberDecorate = 72,
+        OpTypeAccelerationStructureKHR = 5341,
+    };
+
+    enum Decoration : uint32_t
+    {
+        DecorationSpecId = 1,
+        DecorationBufferBlock = 3,
+        DecorationArrayStride = 6,
+        DecorationMatrixStride = 7,
+        DecorationLocation = 30,
+        DecorationBinding = 33,
+        DecorationDescriptorSet = 34,
+        DecorationOffset = 35,
+    };
+
+    enum StorageClass : uint32_t
+    {
+        StorageClassUniformConstant = 0,
+        StorageClassInput = 1,
+        StorageClassUniform = 2,
+        StorageClassOutput = 3,
+        StorageClassPushConstant = 9,
+        StorageClassStorageBuffer = 12,
+    };
+
+    enum Dim : uint32_t
+    {
+        DimBuffer = 5,
+        DimSubpassData = 6,
+    };
+
+    constexpr uint32_t gNone = ~0u;
+
+    struct Type
+    {
+        uint32_t mOpcode = 0;
+        uint32_t mWidth = 0;           // OpTypeInt, OpTypeFloat
+        bool mSigned = false;          // OpTypeInt
+        uint32_t mElementType = 0;     // Component, column, element, or pointee type
+        uint32_t mCount = 0;           // Component count, column count, or array length (constant id until resolved)
+        uint32_t mStorageClass = 0;    // OpTypePointer
+        uint32_t mDim = 0;             // OpTypeImage
+        uint32_t mSampled = 0;         // OpTypeImage
+        std::vector<uint32_t> mMembers;
+    };
+
+    struct Decorations
+    {
+        uint32_t mSpecId = gNone;
+        uint32_t mLocation = gNone;
+        uint32_t mBinding = gNone;
+        uint32_t mSet = gNone;
+        uint32_t mOffset = gNone;      // Member decoration
+        uint32_t mArrayStride = 0;
+        uint32_t mMatrixStride = 0;    // Member decoration
+        bool mBufferBlock = false;
+    };
+
+    struct SpecConstant
+    {
+        uint32_t mId;
+        uint32_t mType;
+    };
+
+    struct Variable
+    {
+        uint32_t mId;
+        uint32_t mPointerType;
+        uint32_t mStorageClass;
+    };
+
+
+    inline std::string readString(std::span<const uint32_t> aWords)
+    {
+        std::string result;
+        for(uint32_t word : aWords)
+        {
+            for(int byteIdx = 0; byteIdx != 4; ++byteIdx)
+            {
+                const char character = (char)((word >> (8 * byteIdx)) & 0xff);
+                if(character == '\0')
+                {
+                    return result;
+                }
+                result.push_back(character);
+            }
+        }
+        return result;
+    }
+
+
+    inline VkShaderStageFlagBits getStage(uint32_t aExecutionModel)
+    {
+        switch(aExecutionModel)
+        {
+            case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+            case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+            case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+            case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+            case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+            case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+            case 5364: return VK_SHADER_STAGE_TASK_BIT_EXT;
+            case 5365: return VK_SHADER_STAGE_MESH_BIT_EXT;
+            default: throw std::invalid_argument{"Unsupported SPIR-V execution model."};
+        }
+    }
+
+
+    /// @brief Format of a scalar or vector interface variable.
+    inline VkFormat getFormat(const Type & aScalar, uint32_t aComponentCount)
+    {
+        static constexpr VkFormat float16[]{VK_FORMAT_R16_SFLOAT, VK_FORMAT_R16G16_SFLOAT,
+                                            VK_FORMAT_R16G16B16_SFLOAT, VK_FORMAT_R16G16B16A16_SFLOAT};
+        static constexpr VkFormat float32[]{VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT,
+                                            VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT};
+        static constexpr VkFormat float64[]{VK_FORMAT_R64_SFLOAT, VK_FORMAT_R64G64_SFLOAT,
+                                            VK_FORMAT_R64G64B64_SFLOAT, VK_FORMAT_R64G64B64A64_SFLOAT};
+        static constexpr VkFormat sint16[]{VK_FORMAT_R16_SINT, VK_FORMAT_R16G16_SINT,
+                                           VK_FORMAT_R16G16B16_SINT, VK_FORMAT_R16G16B16A16_SINT};
+        static constexpr VkFormat uint16[]{VK_FORMAT_R16_UINT, VK_FORMAT_R16G16_UINT,
+                                           VK_FORMAT_R16G16B16_UINT, VK_FORMAT_R16G16B16A16_UINT};
+        static constexpr VkFormat sint32[]{VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT,
+                                           VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT};
+        static constexpr VkFormat uint32[]{VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT,
+                                           VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT};
+        static constexpr VkFormat sint64[]{VK_FORMAT_R64_SINT, VK_FORMAT_R64G64_SINT,
+                                           VK_FORMAT_R64G64B64_SINT, VK_FORMAT_R64G64B64A64_SINT};
+        static constexpr VkFormat uint64[]{VK_FORMAT_R64_UINT, VK_FORMAT_R64G64_UINT,
+                                           VK_FORMAT_R64G64B64_UINT, VK_FORMAT_R64G64B64A64_UINT};
+
+        if(aComponentCount == 0 || aComponentCount > 4)
+        {
+            throw std::invalid_argument{"Invalid SPIR-V vector size."};
+        }
+        const uint32_t idx = aComponentCount - 1;
+        if(aScalar.mOpcode == OpTypeFloat)
+        {
+            switch(aScalar.mWidth)
+            {
+                case 16: return float16[idx];
+                case 32: return float32[idx];
+                case 64: return float64[idx];
+            }
+        }
+        else if(aScalar.mOpcode == OpTypeInt)
+        {
+            switch(aScalar.mWidth)
+            {
+                case 16: return aScalar.mSigned ? sint16[idx] : uint16[idx];
+                case 32: return aScalar.mSigned ? sint32[idx] : uint32[idx];
+                case 64: return aScalar.mSigned ? sint64[idx] : uint64[idx];
+            }
+        }
+        throw std::invalid_argument{"Unsupported SPIR-V interface variable type."};
+    }
+
+
+    class Module
+    {
+    public:
+        explicit Module(std::span<const uint32_t> aCode)
+        {
+            // Header: magic, version, generator, bound, schema
+            if(aCode.size() < 5 || aCode[0] != gMagicNumber)
+            {
+                throw std::invalid_argument{"Not a SPIR-V module (expecting native endianness)."};
+            }
+            const uint32_t bound = aCode[3];
+            mTypes.resize(bound);
+            mDecorations.resize(bound);
+            mMemberDecorations.resize(bound);
+            mNames.resize(bound);
+            mConstants.resize(bound, gNone);
+
+            for(std::size_t wordIdx = 5; wordIdx < aCode.size();)
+            {
+                const uint32_t wordCount = aCode[wordIdx] >> 16;
+                const uint32_t opcode = aCode[wordIdx] & 0xffff;
+                if(wordCount == 0 || wordIdx + wordCount > aCode.size())
+                {
+                    throw std::invalid_argument{"Truncated SPIR-V instruction."};
+                }
+                parseInstruction(opcode, aCode.subspan(wordIdx + 1, wordCount - 1));
+                wordIdx += wordCount;
+            }
+
+            if(!mStage)
+            {
+                throw std::invalid_argument{"SPIR-V module without entry point."};
+            }
+        }
+
+        ShaderReflection reflect() const
+        {
+            ShaderReflection result{.mStage = *mStage};
+
+            for(const Variable & variable : mVariables)
+            {
+                const Decorations & decorations = mDecorations[variable.mId];
+                const uint32_t pointee = type(variable.mPointerType).mElementType;
+                const std::string & name = mNames[variable.mId];
+
+                switch(variable.mStorageClass)
+                {
+                    case StorageClassInput:
+                    case StorageClassOutput:
+                    {
+                        // Builtins are not decorated with a location
+                        if(decorations.mLocation == gNone)
+                        {
+                            break;
+                        }
+                        uint32_t location = decorations.mLocation;
+                        appendInterfaceVariables(pointee, name, location,
+                                                 variable.mStorageClass == StorageClassInput ? result.mInputs
+                                                                                             : result.mOutputs);
+                        break;
+                    }
+                    case StorageClassUniformConstant:
+                    case StorageClassUniform:
+                    case StorageClassStorageBuffer:
+                    {
+                        // e.g. the ray tracing shader record buffer, which is not a descriptor.
+                        if(decorations.mBinding == gNone)
+                        {
+                            break;
+                        }
+                        result.mDescriptorBindings.push_back(
+                            getDescriptorBinding(pointee, variable.mStorageClass, decorations, name));
+                        break;
+                    }
+                    case StorageClassPushConstant:
+                    {
+                        const Type & block = type(pointee);
+                        uint32_t begin = ~0u;
+                        for(uint32_t memberIdx = 0; memberIdx != block.mMembers.size(); ++memberIdx)
+                        {
+                            begin = std::min(begin, memberDecorations(pointee, memberIdx).mOffset);
+                        }
+                        const uint32_t end = getSize(pointee);
+                        if(end > begin)
+                        {
+                            result.mPushConstants = VkPushConstantRange{
+                                .stageFlags = (VkShaderStageFlags)*mStage,
+                                .offset = begin,
+                                .size = end - begin,
+                            };
+                        }
+                        break;
+                    }
+                }
+            }
+
+            // Spec constants without SpecId are operations on other constants, which cannot be specialized
+            for(const SpecConstant & constant : mSpecConstants)
+            {
+                const uint32_t constantId = mDecorations[constant.mId].mSpecId;
+                if(constantId != gNone)
+                {
+                    const Type & constantType = type(constant.mType);
+                    result.mSpecializationConstants.push_back({
+                        .mConstantId = constantId,
+                        // Booleans have no width, they are specialized as VkBool32
+                        .mSize = (constantType.mWidth != 0) ? constantType.mWidth / 8 : (uint32_t)sizeof(VkBool32),
+                        .mBoolean = constantType.mOpcode == OpTypeBool,
+                        .mName = mNames[constant.mId],
+                    });
+                }
+            }
+            std::ranges::sort(result.mSpecializationConstants, {}, &ShaderReflection::SpecializationConstant::mConstantId);
+
+            auto byLocation = [](const auto & aLeft, const auto & aRight)
+            {
+                return aLeft.mLocation < aRight.mLocation;
+            };
+            std::ranges::sort(result.mInputs, byLocation);
+            std::ranges::sort(result.mOutputs, byLocation);
+            std::ranges::sort(result.mDescriptorBindings, [](const auto & aLeft, const auto & aRight)
+            {
+                return std::pair{aLeft.mSet, aLeft.mBinding} < std::pair{aRight.mSet, aRight.mBinding};
+            });
+            return result;
+        }
+
+    private:
+        void parseInstruction(uint32_t aOpcode, std::span<const uint32_t> aOperands)
+        {
+            auto requireOperands = [&](std::size_t aCount)
+            {
+                if(aOperands.size() < aCount)
+                {
+                    throw std::invalid_argument{"Malformed SPIR-V instruction."};
+                }
+            };
+
+            switch(aOpcode)
+            {
+                case OpName:
+                    requireOperands(2);
+                    at(mNames, aOperands[0]) = readString(aOperands.subspan(1));
+                    break;
+                case OpEntryPoint:
+                    requireOperands(3);
+                    // Only the first entry point is reflected
+                    if(!mStage)
+                    {
+                        mStage = getStage(aOperands[0]);
+                    }
+                    break;
+                case OpDecorate:
+                    requireOperands(2);
+                    decorate(at(mDecorations, aOperands[0]), aOperands.subspan(1));
+                    break;
+                case OpMemberDecorate:
+                {
+                    requireOperands(3);
+                    std::vector<Decorations> & members = at(mMemberDecorations, aOperands[0]);
+                    if(members.size() <= aOperands[1])
+                    {
+                        members.resize(aOperands[1] + 1);
+                    }
+                    decorate(members[aOperands[1]], aOperands.subspan(2));
+                    break;
+                }
+                case OpTypeInt:
+                    requireOperands(3);
+                    at(mTypes, aOperands[0]) = {.mOpcode = aOpcode, .mWidth = aOperands[1], .mSigned = aOperands[2] != 0};
+                    break;
+                case OpTypeFloat:
+                    requireOperands(2);
+                    at(mTypes, aOperands[0]) = {.mOpcode = aOpcode, .mWidth = aOperands[1]};
+                    break;
+                case OpTypeVector:
+                case OpTypeMatrix:
+                case OpTypeArray:
+                    requireOperands(3);
+                    at(mTypes, aOperands[0]) = {.mOpcode = aOpcode, .mElementType = aOperands[1], .mCount = aOperands[2]};
+                    break;
+                case OpTypeRuntimeArray:
+                case OpTypeSampledImage:
+                    requireOperands(2);
+                    at(mTypes, aOperands[0]) = {.mOpcode = aOpcode, .mElementType = aOperands[1]};
+                    break;
+                case OpTypeImage:
+                    requireOperands(8);
+                    at(mTypes, aOperands[0]) = {.mOpcode = aOpcode, .mDim = aOperands[2], .mSampled = aOperands[6]};
+                    break;
+                case OpTypeBool:
+                case OpTypeSampler:
+                case OpTypeAccelerationStructureKHR:
+                    requireOperands(1);
+                    at(mTypes, aOperands[0]) = {.mOpcode = aOpcode};
+                    break;
+                case OpTypeStruct:
+                    requireOperands(1);
+                    at(mTypes, aOperands[0]) = {
+                        .mOpcode = aOpcode,
+                        .mMembers{aOperands.begin() + 1, aOperands.end()},
+                    };
+                    break;
+                case OpTypePointer:
+                    requireOperands(3);
+                    at(mTypes, aOperands[0]) = {.mOpcode = aOpcode, .mElementType = aOperands[2], .mStorageClass = aOperands[1]};
+                    break;
+                case OpConstant:
+                case OpSpecConstant:
+                    // Only the low word is kept, it is enough for array lengths.
+                    // Specialization constants take their default value.
+                    requireOperands(3);
+                    at(mConstants, aOperands[1]) = aOperands[2];
+                    if(aOpcode == OpSpecConstant)
+                    {
+                        mSpecConstants.push_back({.mId = aOperands[1], .mType = aOperands[0]});
+                    }
+                    break;
+                case OpSpecConstantTrue:
+                case OpSpecConstantFalse:
+                    requireOperands(2);
+                    at(mConstants, aOperands[1]) = (aOpcode == OpSpecConstantTrue) ? 1 : 0;
+                    mSpecConstants.push_back({.mId = aOperands[1], .mType = aOperands[0]});
+                    break;
+                case OpVariable:
+                    requireOperands(3);
+                    mVariables.push_back({.mId = aOperands[1], .mPointerType = aOperands[0], .mStorageClass = aOperands[2]});
+                    at(mNames, aOperands[1]); // bound check
+                    break;
+            }
+        }
+
+        static void decorate(Decorations & aDecorations, std::span<const uint32_t> aDecoration)
+        {
+            const uint32_t literal = aDecoration.size() > 1 ? aDecoration[1] : 0;
+            switch(aDecoration[0])
+            {
+                case DecorationSpecId: aDecorations.mSpecId = literal; break;
+                case DecorationBufferBlock: aDecorations.mBufferBlock = true; break;
+                case DecorationArrayStride: aDecorations.mArrayStride = literal; break;
+                case DecorationMatrixStride: aDecorations.mMatrixStride = literal; break;
+                case DecorationLocation: aDecorations.mLocation = literal; break;
+                case DecorationBinding: aDecorations.mBinding = literal; break;
+                case DecorationDescriptorSet: aDecorations.mSet = literal; break;
+                case DecorationOffset: aDecorations.mOffset = literal; break;
+            }
+        }
+
+        template <class T_element>
+        static T_element & at(std::vector<T_element> & aVector, uint32_t aId)
+        {
+            if(aId >= aVector.size())
+            {
+                throw std::invalid_argument{"SPIR-V id out of bound."};
+            }
+            return aVector[aId];
+        }
+
+        const Type & type(uint32_t aId) const
+        {
+            if(aId >= mTypes.size() || mTypes[aId].mOpcode == 0)
+            {
+                throw std::invalid_argument{"Unknown SPIR-V type."};
+            }
+            return mTypes[aId];
+        }
+
+        Decorations memberDecorations(uint32_t aStructId, uint32_t aMemberIdx) const
+        {
+            const std::vector<Decorations> & members = mMemberDecorations[aStructId];
+            return aMemberIdx < members.size() ? members[aMemberIdx] : Decorations{};
+        }
+
+        uint32_t getArrayLength(const Type & aArray) const
+        {
+            if(aArray.mCount >= mConstants.size() || mConstants[aArray.mCount] == gNone)
+            {
+                throw std::invalid_argument{"Unknown SPIR-V array length."};
+            }
+            return mConstants[aArray.mCount];
+        }
+
+        /// @brief Size in bytes of aTypeId, following its explicit layout decorations.
+        uint32_t getSize(uint32_t aTypeId, uint32_t aMatrixStride = 0) const
+        {
+            const Type & t = type(aTypeId);
+            switch(t.mOpcode)
+            {
+                case OpTypeInt:
+                case OpTypeFloat:
+                    return t.mWidth / 8;
+                case OpTypeVector:
+                    return t.mCount * getSize(t.mElementType);
+                case OpTypeMatrix:
+                    return t.mCount * (aMatrixStride != 0 ? aMatrixStride : getSize(t.mElementType));
+                case OpTypeArray:
+                {
+                    const uint32_t stride = mDecorations[aTypeId].mArrayStride;
+                    return getArrayLength(t) * (stride != 0 ? stride : getSize(t.mElementType));
+                }
+                case OpTypeRuntimeArray:
+                    return 0;
+                case OpTypeStruct:
+                {
+                    uint32_t size = 0;
+                    for(uint32_t memberIdx = 0; memberIdx != t.mMembers.size(); ++memberIdx)
+                    {
+                        const Decorations member = memberDecorations(aTypeId, memberIdx);
+                        const uint32_t offset = member.mOffset != gNone ? member.mOffset : size;
+                        size = std::max(size, offset + getSize(t.mMembers[memberIdx], member.mMatrixStride));
+                    }
+                    return size;
+                }
+                case OpTypePointer:
+                    // Physical storage buffer pointers (buffer references) are 64-bit device addresses
+                    return 8;
+            }
+            throw std::invalid_argument{"SPIR-V type without explicit layout."};
+        }
+
+        void appendInterfaceVariables(uint32_t aTypeId,
+                                      const std::string & aName,
+                                      uint32_t & aLocation,
+                                      std::vector<ShaderReflection::InterfaceVariable> & aVariables) const
+        {
+            const Type & t = type(aTypeId);
+            switch(t.mOpcode)
+            {
+                case OpTypeInt:
+                case OpTypeFloat:
+                case OpTypeVector:
+                {
+                    const Type & scalar = t.mOpcode == OpTypeVector ? type(t.mElementType) : t;
+                    const uint32_t componentCount = t.mOpcode == OpTypeVector ? t.mCount : 1;
+                    const VkFormat format = getFormat(scalar, componentCount);
+                    aVariables.push_back({
+                        .mLocation = aLocation,
+                        .mFormat = format,
+                        .mSize = componentCount * scalar.mWidth / 8,
+                        .mName = aName,
+                    });
+                    // 64-bit 3 and 4 component vectors consume two locations
+                    aLocation += (scalar.mWidth == 64 && componentCount > 2) ? 2 : 1;
+                    break;
+                }
+                case OpTypeMatrix:
+                    // One location per column
+                    for(uint32_t columnIdx = 0; columnIdx != t.mCount; ++columnIdx)
+                    {
+                        appendInterfaceVariables(t.mElementType, aName, aLocation, aVariables);
+                    }
+                    break;
+                case OpTypeArray:
+                    for(uint32_t elementIdx = 0; elementIdx != getArrayLength(t); ++elementIdx)
+                    {
+                        appendInterfaceVariables(t.mElementType, aName, aLocation, aVariables);
+                    }
+                    break;
+                case OpTypeStruct:
+                    for(uint32_t member : t.mMembers)
+                    {
+                        appendInterfaceVariables(member, aName, aLocation, aVariables);
+                    }
+                    break;
+                default:
+                    throw std::invalid_argument{"Unsupported SPIR-V interface variable type."};
+            }
+        }
+
+        ShaderReflection::DescriptorBinding getDescriptorBinding(uint32_t aTypeId,
+                                                                 uint32_t aStorageClass,
+                                                                 const Decorations & aDecorations,
+                                                                 const std::string & aName) const
+        {
+            ShaderReflection::DescriptorBinding result{
+                .mSet = aDecorations.mSet != gNone ? aDecorations.mSet : 0,
+                .mBinding = aDecorations.mBinding,
+                .mCount = 1,
+                .mName = aName,
+            };
+
+            // Arrays of resources are a single binding
+            while(type(aTypeId).mOpcode == OpTypeArray || type(aTypeId).mOpcode == OpTypeRuntimeArray)
+            {
+                const Type & array = type(aTypeId);
+                result.mCount = (array.mOpcode == OpTypeArray) ? result.mCount * getArrayLength(array) : 0;
+                aTypeId = array.mElementType;
+            }
+
+            const Type & resource = type(aTypeId);
+            switch(resource.mOpcode)
+            {
+                case OpTypeStruct:
+                    // Before SPIR-V 1.3, storage buffers are Uniform blocks decorated BufferBlock
+                    result.mType = (aStorageClass == StorageClassStorageBuffer || mDecorations[aTypeId].mBufferBlock)
+                                   ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+                                   : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+                    break;
+                case OpTypeSampler:
+                    result.mType = VK_DESCRIPTOR_TYPE_SAMPLER;
+                    break;
+                case OpTypeSampledImage:
+                    result.mType = (type(resource.mElementType).mDim == DimBuffer)
+                                   ? VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER
+                                   : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                    break;
+                case OpTypeImage:
+                    if(resource.mDim == DimSubpassData)
+                    {
+                        result.mType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+                    }
+                    else if(resource.mDim == DimBuffer)
+                    {
+                        // Sampled: 1 means used with a sampler, 2 means storage
+                        result.mType = (resource.mSampled == 2) ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER
+                                                                : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+                    }
+                    else
+                    {
+                        result.mType = (resource.mSampled == 2) ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE
+                                                                : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+                    }
+                    break;
+                case OpTypeAccelerationStructureKHR:
+                    result.mType = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+                    break;
+                default:
+                    throw std::invalid_argument{"Unsupported SPIR-V descriptor type."};
+            }
+            return result;
+        }
+
+        std::optional<VkShaderStageFlagBits> mStage;
+        std::vector<Type> mTypes;
+        std::vector<Decorations> mDecorations;
+        std::vector<std::vector<Decorations>> mMemberDecorations;
+        std::vector<std::string> mNames;
+        std::vector<uint32_t> mConstants;
+        std::vector<Variable> mVariables;
+        std::vector<SpecConstant> mSpecConstants;
+    };
+
+} // namespace spirv
+
+
+/// @brief Reflects the interface of the first entry point in aCode.
+/// @throw std::invalid_argument if aCode is not a valid SPIR-V module.
+inline ShaderReflection reflectSpirv(std::span<const uint32_t> aCode)
+{
+    return spirv::Module{aCode}.reflect();
+}
+
+
+/// @brief Reflection of aCode, cached by content hash: reflecting the same code again is a lookup.
+/// @note Thread safe. The returned reference is valid for the duration of the program.
+inline const ShaderReflection & getReflection(std::span<const char> aCode)
+{
+    static std::mutex mutex;
+    static std::unordered_map<Hash, ShaderReflection> cache;
+
+    const Hash hash = hashBytes(std::as_bytes(aCode));
+    {
+        std::lock_guard lock{mutex};
+        if(auto found = cache.find(hash); found != cache.end())
+        {
+            return found->second;
+        }
+    }
+
+    // Parse outside of the lock, if another thread raced us its result is kept
+    ShaderReflection reflection = reflectSpirv(
+        std::span{reinterpret_cast<const uint32_t *>(aCode.data()), aCode.size() / sizeof(uint32_t)});
+    std::lock_guard lock{mutex};
+    return cache.try_emplace(hash, std::move(reflection)).first->second;
+}
+
+
+enum class NumericType
+{
+    Float,
+    Sint,
+    Uint,
+};
+
+/// @brief The numeric type a vertex attribute format is read as, which must match the shader input type.
+/// see: https://docs.vulkan.org/spec/latest/chapters/formats.html#formats-numericformat
+constexpr NumericType getNumericType(VkFormat aFormat)
+{
+    switch(aFormat)
+    {
+        case VK_FORMAT_R8_SINT: case VK_FORMAT_R8G8_SINT: case VK_FORMAT_R8G8B8_SINT: case VK_FORMAT_R8G8B8A8_SINT:
+        case VK_FORMAT_R16_SINT: case VK_FORMAT_R16G16_SINT: case VK_FORMAT_R16G16B16_SINT: case VK_FORMAT_R16G16B16A16_SINT:
+        case VK_FORMAT_R32_SINT: case VK_FORMAT_R32G32_SINT: case VK_FORMAT_R32G32B32_SINT: case VK_FORMAT_R32G32B32A32_SINT:
+        case VK_FORMAT_R64_SINT: case VK_FORMAT_R64G64_SINT: case VK_FORMAT_R64G64B64_SINT: case VK_FORMAT_R64G64B64A64_SINT:
+        case VK_FORMAT_A2B10G10R10_SINT_PACK32:
+            return NumericType::Sint;
+        case VK_FORMAT_R8_UINT: case VK_FORMAT_R8G8_UINT: case VK_FORMAT_R8G8B8_UINT: case VK_FORMAT_R8G8B8A8_UINT:
+        case VK_FORMAT_R16_UINT: case VK_FORMAT_R16G16_UINT: case VK_FORMAT_R16G16B16_UINT: case VK_FORMAT_R16G16B16A16_UINT:
+        case VK_FORMAT_R32_UINT: case VK_FORMAT_R32G32_UINT: case VK_FORMAT_R32G32B32_UINT: case VK_FORMAT_R32G32B32A32_UINT:
+        case VK_FORMAT_R64_UINT: case VK_FORMAT_R64G64_UINT: case VK_FORMAT_R64G64B64_UINT: case VK_FORMAT_R64G64B64A64_UINT:
+        case VK_FORMAT_A2B10G10R10_UINT_PACK32:
+            return NumericType::Uint;
+        default:
+            return NumericType::Float;
+    }
+}
@@ -0,0 +1,204 @@
+#pragma once
+
+
+#include "Math.h"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+
+/// @brief A hierarchy of nodes, each with a local transform relative to its parent, flattened into arrays.
+///
+/// The nodes are stored breadth first (sorted by depth, the children of a node being contiguous):
+/// a parent always precedes its children, so the world transforms are propagated by a single linear pass.
+/// Only the nodes whose local transform changed, and their descendants, are recomputed:
+/// the pass skips 64 unchanged nodes at a time, so static subtrees cost next to nothing.
+///
+/// Nodes are addressed by their slot in the flattened arrays (see getSlot()).
+class TransformHierarchy
+{
+public:
+    static constexpr uint32_t gNoParent = std::numeric_limits<uint32_t>::max();
+
+    /// @param aParents The parent of each node (gNoParent for the roots), nodes being in any order.
+    /// @param aLocals The local transform of each node.
+    /// @note All the world transforms are computed by the first update().
+    TransformHierarchy(std::span<const uint32_t> aParents, std::span<const math::Mat4> aLocals)
+    {
+        const std::size_t nodeCount = aParents.size();
+        if(aLocals.size() != nodeCount || nodeCount >= gNoParent)
+        {
+            throw std::invalid_argument{"Transform hierarchy: expects one local transform per node."};
+        }
+
+        // Children of each node, contiguous in input order
+        std::vector<uint32_t> childOffsets(nodeCount + 1, 0);
+        for(uint32_t parent : aParents)
+        {
+            if(parent != gNoParent)
+            {
+                if(parent >= nodeCount)
+                {
+                    throw std::invalid_argument{"Transform hierarchy: invalid parent index."};
+                }
+                ++childOffsets[parent + 1];
+            }
+        }
+        for(std::size_t nodeIdx = 0; nodeIdx != nodeCount; ++nodeIdx)
+        {
+            childOffsets[nodeIdx + 1] += childOffsets[nodeIdx];
+        }
+        std::vector<uint32_t> children(childOffsets.back());
+        {
+            std::vector<uint32_t> cursors(childOffsets.begin(), childOffsets.end() - 1);
+            for(uint32_t nodeIdx = 0; nodeIdx != nodeCount; ++nodeIdx)
+            {
+                if(aParents[nodeIdx] != gNoParent)
+                {
+                    children[cursors[aParents[nodeIdx]]++] = nodeIdx;
+                }
+            }
+        }
+
+        // Breadth first order: the roots, then the children of each node in turn
+        mNodes.reserve(nodeCount);
+        for(uint32_t nodeIdx = 0; nodeIdx != nodeCount; ++nodeIdx)
+        {
+            if(aParents[nodeIdx] == gNoParent)
+            {
+                mNodes.push_back(nodeIdx);
+            }
+        }
+        mFirstChild.reserve(nodeCount + 1);
+        for(std::size_t slot = 0; slot != mNodes.size(); ++slot)
+        {
+            const uint32_t nodeIdx = mNodes[slot];
+            mFirstChild.push_back((uint32_t)mNodes.size());
+            mNodes.insert(mNodes.end(), children.begin() + childOffsets[nodeIdx], children.begin() + childOffsets[nodeIdx + 1]);
+        }
+        if(mNodes.size() != nodeCount)
+        {
+            throw std::invalid_argument{"Transform hierarchy: the parents form a cycle."};
+        }
+        mFirstChild.push_back((uint32_t)nodeCount);
+
+        mSlots.resize(nodeCount);
+        for(uint32_t slot = 0; slot != nodeCount; ++slot)
+        {
+            mSlots[mNodes[slot]] = slot;
+        }
+        mParents.resize(nodeCount);
+        mLocals.resize(nodeCount);
+        for(uint32_t slot = 0; slot != nodeCount; ++slot)
+        {
+            const uint32_t parent = aParents[mNodes[slot]];
+            mParents[slot] = parent == gNoParent ? gNoParent : mSlots[parent];
+            mLocals[slot] = aLocals[mNodes[slot]];
+        }
+        mWorlds.resize(nodeCount);
+        // Everything is dirty: the roots propagate to all their descendants
+        mDirty.resize((nodeCount + 63) / 64, 0);
+        for(std::size_t slot = 0; slot != nodeCount && mParents[slot] == gNoParent; ++slot)
+        {
+            mDirty[slot / 64] |= uint64_t{1} << (slot % 64);
+        }
+    }
+
+    std::size_t size() const
+    {
+        return mNodes.size();
+    }
+
+    /// @brief The slot of the node at aNodeIdx in the constructor inputs.
+    uint32_t getSlot(uint32_t aNodeIdx) const
+    {
+        return mSlots[aNodeIdx];
+    }
+
+    /// @brief The slot of the parent of the node at aSlot, or gNoParent.
+    uint32_t getParent(uint32_t aSlot) const
+    {
+        return mParents[aSlot];
+    }
+
+    const math::Mat4 & getLocal(uint32_t aSlot) const
+    {
+        return mLocals[aSlot];
+    }
+
+    /// @brief The world transform of the node at aSlot, as of the last update().
+    const math::Mat4 & getWorld(uint32_t aSlot) const
+    {
+        return mWorlds[aSlot];
+    }
+
+    /// @brief Marks the subtree of the node at aSlot for the next update().
+    void setLocal(uint32_t aSlot, const math::Mat4 & aLocal)
+    {
+        mLocals[aSlot] = aLocal;
+        mDirty[aSlot / 64] |= uint64_t{1} << (aSlot % 64);
+    }
+
+    /// @brief Propagates the changed local transforms to the world transforms of the nodes and their descendants.
+    /// @param aOut When not null, the updated world transforms are also written there, at aSlot * aStride,
+    /// in increasing address order (e.g. to a persistently mapped GPU buffer). The nodes that did not change
+    /// are not written, so the output must still hold the previous results (a single buffer, not one per frame in flight).
+    /// @return The number of updated nodes.
+    std::size_t update(std::byte * aOut = nullptr, std::size_t aStride = sizeof(math::Mat4))
+    {
+        std::size_t result = 0;
+        for(std::size_t wordIdx = 0; wordIdx != mDirty.size(); ++wordIdx)
+        {
+            // Children come after their parent, possibly in the same word: it is re-read after each node
+            while(uint64_t bits = mDirty[wordIdx])
+            {
+                mDirty[wordIdx] = bits & (bits - 1);
+                const uint32_t slot = (uint32_t)(wordIdx * 64 + std::countr_zero(bits));
+                const uint32_t parent = mParents[slot];
+                mWorlds[slot] = parent == gNoParent ? mLocals[slot] : mWorlds[parent] * mLocals[slot];
+                if(aOut != nullptr)
+                {
+                    std::memcpy(aOut + slot * aStride, mWorlds[slot].data(), sizeof(math::Mat4));
+                }
+                markRange(mFirstChild[slot], mFirstChild[slot + 1]);
+                ++result;
+            }
+        }
+        return result;
+    }
+
+private:
+    void markRange(uint32_t aBegin, uint32_t aEnd)
+    {
+        while(aBegin != aEnd)
+        {
+            const uint32_t bit = aBegin % 64;
+            const uint32_t count = std::min<uint32_t>(64 - bit, aEnd - aBegin);
+            const uint64_t mask = count == 64 ? ~uint64_t{0} : ((uint64_t{1} << count) - 1) << bit;
+            mDirty[aBegin / 64] |= mask;
+            aBegin += count;
+        }
+    }
+
+    // Per slot
+    std::vector<uint32_t> mParents;
+    // The children of slot are [mFirstChild[slot], mFirstChild[slot + 1]) (one more element than the nodes)
+    std::vector<uint32_t> mFirstChild;
+    std::vector<math::Mat4> mLocals;
+    std::vector<math::Mat4> mWorlds;
+    // The node indices given at construction
+    std::vector<uint32_t> mNodes;
+    // One bit per slot, set for the nodes to recompute
+    std::vector<uint64_t> mDirty;
+
+    // Per node index
+    std::vector<uint32_t> mSlots;
+};
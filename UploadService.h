@@ -0,0 +1,628 @@
+#pragma once
+
+
+#include "VulkanHelpers.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <cassert>
+#include <cstring>
+
+
+/// @brief Streams buffer and image data to device local memory from the transfer queue.
+///
+/// Data is copied into a persistently mapped staging ring by the requesting thread, which might be any thread.
+/// The render thread calls submit() once per frame: it records the copies of the ready requests into a
+/// transfer command buffer, which signals a timeline semaphore. Graphics submissions wait on this semaphore,
+/// after recording the acquire half of the queue family ownership transfers (see recordAcquireBarriers()).
+///
+/// Large buffer uploads are split in chunks, so they never require more than a fraction of the ring.
+/// A requesting thread blocks while the ring is full, so large assets should be requested from worker threads.
+/// (The render thread cannot wait for itself to reclaim: it submits and waits for the copies in flight instead.)
+///
+/// When the transfer and graphics queue families differ, an uploaded buffer is released to the graphics family as a whole:
+/// it can only be the destination of a single request, until discardBuffer().
+///
+/// @note Only the render thread submits to the queues (transfer and graphics might be the same VkQueue),
+/// it is the thread constructing the service.
+struct UploadService
+{
+    /// @brief Identifies a request, tickets are increasing in request order.
+    using Ticket = uint64_t;
+
+    UploadService(const TransferContext & aContext, VkDeviceSize aStagingCapacity) :
+        mContext{aContext},
+        mCapacity{aStagingCapacity},
+        mMaxChunkSize{aStagingCapacity / 4}
+    {
+        const VkDevice vkDevice = mContext.vkDevice;
+
+        std::tie(mStagingBuffer, mStagingMemory) =
+            createBuffer(vkDevice, mCapacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, mContext.mStagingMemoryTypeIndex);
+        nameObject(vkDevice, mStagingBuffer, "upload_staging_ring");
+        // Persistently mapped, the memory is coherent so no flush is ever required.
+        void * mapping;
+        assertVkSuccess(vkMapMemory(vkDevice, mStagingMemory, 0, VK_WHOLE_SIZE, 0, &mapping));
+        mStagingMap = static_cast<std::byte *>(mapping);
+
+        VkSemaphoreTypeCreateInfo semaphoreTypeCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+            .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+            .initialValue = 0,
+        };
+        VkSemaphoreCreateInfo semaphoreCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+            .pNext = &semaphoreTypeCreateInfo,
+        };
+        assertVkSuccess(vkCreateSemaphore(vkDevice, &semaphoreCreateInfo, pAllocator, &mTimeline));
+        nameObject(vkDevice, mTimeline, "upload_timeline");
+
+        VkCommandPoolCreateInfo commandPoolCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+            .queueFamilyIndex = mContext.mQueueSelection.mTransfer.mFamilyIndex,
+        };
+        assertVkSuccess(vkCreateCommandPool(vkDevice, &commandPoolCreateInfo, pAllocator, &mCommandPool));
+    }
+
+    UploadService(const UploadService &) = delete;
+    UploadService & operator=(const UploadService &) = delete;
+
+    ~UploadService()
+    {
+        const VkDevice vkDevice = mContext.vkDevice;
+
+        waitSubmitted();
+
+        for(const Batch & batch : mInFlight)
+        {
+            mFreeCommandBuffers.push_back(batch.mCommandBuffer);
+        }
+        if(!mFreeCommandBuffers.empty())
+        {
+            vkFreeCommandBuffers(vkDevice, mCommandPool,
+                                 (uint32_t)mFreeCommandBuffers.size(), mFreeCommandBuffers.data());
+        }
+        vkDestroyCommandPool(vkDevice, mCommandPool, pAllocator);
+        vkDestroySemaphore(vkDevice, mTimeline, pAllocator);
+        vkUnmapMemory(vkDevice, mStagingMemory);
+        vkDestroyBuffer(vkDevice, mStagingBuffer, pAllocator);
+        vkFreeMemory(vkDevice, mStagingMemory, pAllocator);
+    }
+
+    /// @brief Request aData to be copied into aDestination at aDestinationOffset.
+    /// Once acquired by the graphics queue, aDestination is accessed by aDestinationStage with aDestinationAccess.
+    /// @throw std::invalid_argument if aDestination was already uploaded to, and released to the graphics family
+    /// (the transfer queue does not acquire it back).
+    /// @note Thread-safe. Blocks while the staging ring is full.
+    Ticket uploadBuffer(VkBuffer aDestination,
+                        VkDeviceSize aDestinationOffset,
+                        std::span<const std::byte> aData,
+                        VkPipelineStageFlags2 aDestinationStage,
+                        VkAccessFlags2 aDestinationAccess)
+    {
+        const QueueSelection & selection = mContext.mQueueSelection;
+        if(selection.requiresOwnershipTransfer(selection.mTransfer, selection.mGraphics))
+        {
+            std::lock_guard<std::mutex> lock{mMutex};
+            if(!mUploadedBuffers.insert(aDestination).second)
+            {
+                throw std::invalid_argument{"The upload destination buffer is owned by the graphics queue family."};
+            }
+        }
+
+        const Ticket ticket = createTicket();
+
+        for(VkDeviceSize copied = 0; copied < aData.size(); /*in body*/)
+        {
+            const VkDeviceSize chunkSize = std::min<VkDeviceSize>(aData.size() - copied, mMaxChunkSize);
+            const bool last = (copied + chunkSize == aData.size());
+            Chunk & chunk = reserve(chunkSize, Chunk{
+                .mTicket = ticket,
+                .mLast = last,
+                .mBuffer = aDestination,
+                .mDestinationOffset = aDestinationOffset + copied,
+                .mSize = chunkSize,
+                .mDestinationStage = aDestinationStage,
+                .mDestinationAccess = aDestinationAccess,
+            });
+            std::memcpy(mStagingMap + chunk.mStagingOffset, aData.data() + copied, chunkSize);
+            markReady(chunk);
+            copied += chunkSize;
+        }
+        return ticket;
+    }
+
+    /// @brief Request aData to be copied into the aRegion subresource of aDestination,
+    /// which is then transitioned to aFinalLayout, to be accessed by aDestinationStage with aDestinationAccess.
+    /// @note aRegion buffer offset, row length and image height are ignored (data must be tightly packed).
+    /// @note Thread-safe. Blocks while the staging ring is full.
+    Ticket uploadImage(VkImage aDestination,
+                       VkBufferImageCopy aRegion,
+                       std::span<const std::byte> aData,
+                       VkImageLayout aFinalLayout,
+                       VkPipelineStageFlags2 aDestinationStage,
+                       VkAccessFlags2 aDestinationAccess)
+    {
+        // Images are not chunked, they must fit in the ring
+        assert(aData.size() <= mCapacity);
+
+        const Ticket ticket = createTicket();
+
+        aRegion.bufferRowLength = 0;
+        aRegion.bufferImageHeight = 0;
+        Chunk & chunk = reserve(aData.size(), Chunk{
+            .mTicket = ticket,
+            .mLast = true,
+            .mImage = aDestination,
+            .mImageRegion = aRegion,
+            .mFinalLayout = aFinalLayout,
+            .mSize = aData.size(),
+            .mDestinationStage = aDestinationStage,
+            .mDestinationAccess = aDestinationAccess,
+        });
+        std::memcpy(mStagingMap + chunk.mStagingOffset, aData.data(), aData.size());
+        markReady(chunk);
+        return ticket;
+    }
+
+    /// @brief The previous content of aBuffer is not used anymore: it can be the destination of a new request,
+    /// the transfer queue overwriting it without acquiring it from the graphics family.
+    /// @note Thread-safe. Also required before destroying an uploaded buffer, whose handle can be reused.
+    void discardBuffer(VkBuffer aBuffer)
+    {
+        std::lock_guard<std::mutex> lock{mMutex};
+        mUploadedBuffers.erase(aBuffer);
+    }
+
+    /// @brief Render thread, once per frame: reclaims the staging space of completed copies,
+    /// then records and submits the copies of ready requests to the transfer queue.
+    void submit()
+    {
+        reclaim();
+
+        std::vector<Chunk> chunks;
+        {
+            std::lock_guard<std::mutex> lock{mMutex};
+            // Requests are submitted in reservation order, stopping at the first one still being written.
+            VkDeviceSize bytes = 0;
+            while(!mPending.empty() && mPending.front().mReady && bytes < mMaxBytesPerSubmit)
+            {
+                bytes += mPending.front().mSize;
+                chunks.push_back(mPending.front());
+                mPending.pop_front();
+            }
+        }
+        if(chunks.empty())
+        {
+            return;
+        }
+
+        const QueueSelection & selection = mContext.mQueueSelection;
+        const bool ownershipTransfer = selection.requiresOwnershipTransfer(selection.mTransfer, selection.mGraphics);
+
+        VkCommandBuffer vkCommandBuffer = takeCommandBuffer();
+        VkCommandBufferBeginInfo commandBufferBeginInfo{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        };
+        assertVkSuccess(vkBeginCommandBuffer(vkCommandBuffer, &commandBufferBeginInfo));
+
+        // Images have to be transitioned to a layout allowing the copy
+        std::vector<VkImageMemoryBarrier2> toTransferDst;
+        for(const Chunk & chunk : chunks)
+        {
+            if(chunk.mImage != VK_NULL_HANDLE)
+            {
+                toTransferDst.push_back(VkImageMemoryBarrier2{
+                    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+                    .srcStageMask = VK_PIPELINE_STAGE_2_NONE,
+                    .srcAccessMask = VK_ACCESS_2_NONE,
+                    .dstStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+                    .dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                    .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                    .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    .image = chunk.mImage,
+                    .subresourceRange = getSubresourceRange(chunk.mImageRegion.imageSubresource),
+                });
+            }
+        }
+        recordBarriers(vkCommandBuffer, {}, toTransferDst);
+
+        for(const Chunk & chunk : chunks)
+        {
+            if(chunk.mImage != VK_NULL_HANDLE)
+            {
+                VkBufferImageCopy region = chunk.mImageRegion;
+                region.bufferOffset = chunk.mStagingOffset;
+                vkCmdCopyBufferToImage(vkCommandBuffer, mStagingBuffer, chunk.mImage,
+                                       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+            }
+            else
+            {
+                VkBufferCopy region{
+                    .srcOffset = chunk.mStagingOffset,
+                    .dstOffset = chunk.mDestinationOffset,
+                    .size = chunk.mSize,
+                };
+                vkCmdCopyBuffer(vkCommandBuffer, mStagingBuffer, chunk.mBuffer, 1, &region);
+            }
+        }
+
+        // Release the completed requests to the graphics queue family (and transition images to their final layout).
+        // The matching acquire barriers are recorded by recordAcquireBarriers() on the graphics queue.
+        std::vector<VkBufferMemoryBarrier2> bufferReleases;
+        std::vector<VkImageMemoryBarrier2> imageReleases;
+        std::vector<Ticket> completedTickets;
+        for(const Chunk & chunk : chunks)
+        {
+            if(chunk.mLast)
+            {
+                completedTickets.push_back(chunk.mTicket);
+            }
+
+            if(chunk.mImage != VK_NULL_HANDLE)
+            {
+                VkImageMemoryBarrier2 release{
+                    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+                    .srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+                    .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                    .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    .newLayout = chunk.mFinalLayout,
+                    .srcQueueFamilyIndex = ownershipTransfer ? selection.mTransfer.mFamilyIndex : VK_QUEUE_FAMILY_IGNORED,
+                    .dstQueueFamilyIndex = ownershipTransfer ? selection.mGraphics.mFamilyIndex : VK_QUEUE_FAMILY_IGNORED,
+                    .image = chunk.mImage,
+                    .subresourceRange = getSubresourceRange(chunk.mImageRegion.imageSubresource),
+                };
+                imageReleases.push_back(release);
+                if(ownershipTransfer)
+                {
+                    // The acquire has to repeat the layout transition of the release
+                    mPendingImageAcquires.push_back(asAcquire(release, chunk));
+                }
+            }
+            // Buffers are released with the last chunk of their request, which covers the whole buffer.
+            // (Without ownership transfer, the timeline semaphore wait is enough of a memory dependency.)
+            else if(ownershipTransfer && chunk.mLast)
+            {
+                VkBufferMemoryBarrier2 release{
+                    .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+                    .srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+                    .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                    .srcQueueFamilyIndex = selection.mTransfer.mFamilyIndex,
+                    .dstQueueFamilyIndex = selection.mGraphics.mFamilyIndex,
+                    .buffer = chunk.mBuffer,
+                    .offset = 0,
+                    .size = VK_WHOLE_SIZE,
+                };
+                bufferReleases.push_back(release);
+                mPendingBufferAcquires.push_back(asAcquire(release, chunk));
+            }
+        }
+        recordBarriers(vkCommandBuffer, bufferReleases, imageReleases);
+
+        assertVkSuccess(vkEndCommandBuffer(vkCommandBuffer));
+
+        const uint64_t signalValue = ++mLastSubmittedValue;
+        VkCommandBufferSubmitInfo commandBufferSubmitInfo{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+            .commandBuffer = vkCommandBuffer,
+        };
+        VkSemaphoreSubmitInfo signalSemaphoreSubmitInfo{
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+            .semaphore = mTimeline,
+            .value = signalValue,
+            .stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+        };
+        VkSubmitInfo2 submitInfo2{
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+            .commandBufferInfoCount = 1,
+            .pCommandBufferInfos = &commandBufferSubmitInfo,
+            .signalSemaphoreInfoCount = 1,
+            .pSignalSemaphoreInfos = &signalSemaphoreSubmitInfo,
+        };
+        assertVkSuccess(vkQueueSubmit2(mContext.mQueues.mTransfer, 1, &submitInfo2, VK_NULL_HANDLE));
+
+        {
+            std::lock_guard<std::mutex> lock{mMutex};
+            for(Ticket ticket : completedTickets)
+            {
+                mUnsubmittedTickets.erase(ticket);
+            }
+        }
+        mInFlight.push_back(Batch{
+            .mValue = signalValue,
+            .mCommandBuffer = vkCommandBuffer,
+            .mRingEnd = chunks.back().mRingEnd,
+            .mTickets = std::move(completedTickets),
+        });
+        mGraphicsWaitValue = signalValue;
+    }
+
+    /// @brief Render thread: records the acquire half of the ownership transfers of the submitted requests
+    /// into a graphics queue command buffer.
+    /// @return The value of getTimelineSemaphore() that the submission of vkCommandBuffer must wait on
+    /// (before any command accessing uploaded resources), or 0 when no wait is required.
+    uint64_t recordAcquireBarriers(VkCommandBuffer vkCommandBuffer)
+    {
+        recordBarriers(vkCommandBuffer, mPendingBufferAcquires, mPendingImageAcquires);
+        mPendingBufferAcquires.clear();
+        mPendingImageAcquires.clear();
+        return std::exchange(mGraphicsWaitValue, 0);
+    }
+
+    /// @brief The copies of aTicket have been submitted, so graphics commands recorded
+    /// after the next recordAcquireBarriers() can use the resource.
+    bool isSubmitted(Ticket aTicket)
+    {
+        std::lock_guard<std::mutex> lock{mMutex};
+        return aTicket <= mLastTicket && !mUnsubmittedTickets.contains(aTicket);
+    }
+
+    /// @brief Render thread: the copies of aTicket have completed on the device.
+    bool isComplete(Ticket aTicket)
+    {
+        reclaim();
+        return isSubmitted(aTicket)
+            && std::none_of(mInFlight.begin(), mInFlight.end(), [aTicket](const Batch & aBatch)
+                {
+                    return std::find(aBatch.mTickets.begin(), aBatch.mTickets.end(), aTicket) != aBatch.mTickets.end();
+                });
+    }
+
+    /// @brief Render thread: blocks until all submitted copies have completed.
+    void waitSubmitted()
+    {
+        waitTimeline(mLastSubmittedValue);
+        reclaim();
+    }
+
+    VkSemaphore getTimelineSemaphore() const
+    {
+        return mTimeline;
+    }
+
+private:
+    struct Chunk
+    {
+        Ticket mTicket;
+        // The chunk completes its request
+        bool mLast;
+
+        // Either a buffer or an image
+        VkBuffer mBuffer{VK_NULL_HANDLE};
+        VkDeviceSize mDestinationOffset{0};
+        VkImage mImage{VK_NULL_HANDLE};
+        VkBufferImageCopy mImageRegion{};
+        VkImageLayout mFinalLayout{VK_IMAGE_LAYOUT_UNDEFINED};
+
+        VkDeviceSize mSize;
+        VkPipelineStageFlags2 mDestinationStage;
+        VkAccessFlags2 mDestinationAccess;
+
+        // Assigned by reserve()
+        VkDeviceSize mStagingOffset{0};
+        // Monotonic ring position after this chunk (including the padding to wrap around)
+        uint64_t mRingEnd{0};
+        bool mReady{false};
+    };
+
+    struct Batch
+    {
+        uint64_t mValue;
+        VkCommandBuffer mCommandBuffer;
+        uint64_t mRingEnd;
+        // Tickets completed by this batch
+        std::vector<Ticket> mTickets;
+    };
+
+    static VkImageSubresourceRange getSubresourceRange(const VkImageSubresourceLayers & aLayers)
+    {
+        return VkImageSubresourceRange{
+            .aspectMask = aLayers.aspectMask,
+            .baseMipLevel = aLayers.mipLevel,
+            .levelCount = 1,
+            .baseArrayLayer = aLayers.baseArrayLayer,
+            .layerCount = aLayers.layerCount,
+        };
+    }
+
+    /// @brief The acquire operation matching aRelease, with the destination scope of aChunk
+    template <class T_barrier>
+    static T_barrier asAcquire(T_barrier aRelease, const Chunk & aChunk)
+    {
+        aRelease.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+        aRelease.srcAccessMask = VK_ACCESS_2_NONE;
+        aRelease.dstStageMask = aChunk.mDestinationStage;
+        aRelease.dstAccessMask = aChunk.mDestinationAccess;
+        return aRelease;
+    }
+
+    static void recordBarriers(VkCommandBuffer vkCommandBuffer,
+                               std::span<const VkBufferMemoryBarrier2> aBufferBarriers,
+                               std::span<const VkImageMemoryBarrier2> aImageBarriers)
+    {
+        if(aBufferBarriers.empty() && aImageBarriers.empty())
+        {
+            return;
+        }
+        VkDependencyInfo dependencyInfo{
+            .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .bufferMemoryBarrierCount = (uint32_t)aBufferBarriers.size(),
+            .pBufferMemoryBarriers = aBufferBarriers.data(),
+            .imageMemoryBarrierCount = (uint32_t)aImageBarriers.size(),
+            .pImageMemoryBarriers = aImageBarriers.data(),
+        };
+        vkCmdPipelineBarrier2(vkCommandBuffer, &dependencyInfo);
+    }
+
+    Ticket createTicket()
+    {
+        std::lock_guard<std::mutex> lock{mMutex};
+        mUnsubmittedTickets.insert(++mLastTicket);
+        return mLastTicket;
+    }
+
+    /// @brief Reserve aSize bytes of staging memory for aChunk, blocking until they are available.
+    /// @return A reference to the pending chunk, stable until it is marked ready.
+    Chunk & reserve(VkDeviceSize aSize, Chunk aChunk)
+    {
+        // Satisfies VkBufferImageCopy::bufferOffset requirements for all texel block sizes up to 16 bytes
+        constexpr VkDeviceSize gAlignment = 16;
+        const VkDeviceSize alignedSize = (aSize + gAlignment - 1) / gAlignment * gAlignment;
+        assert(alignedSize <= mCapacity);
+
+        std::unique_lock<std::mutex> lock{mMutex};
+        VkDeviceSize padding;
+        auto fits = [&]()
+        {
+            // Allocations never wrap around the end of the ring, the remaining space is skipped instead.
+            const VkDeviceSize offset = mRingHead % mCapacity;
+            padding = (offset + alignedSize > mCapacity) ? mCapacity - offset : 0;
+            return mRingHead + padding + alignedSize - mRingTail <= mCapacity;
+        };
+        if(std::this_thread::get_id() != mRenderThread)
+        {
+            mSpaceAvailable.wait(lock, fits);
+        }
+        else
+        {
+            // Nobody else reclaims: the render thread submits the ready copies, then waits for the oldest batch.
+            while(!fits())
+            {
+                const bool submittable = !mPending.empty() && mPending.front().mReady;
+                lock.unlock();
+                if(submittable)
+                {
+                    submit();
+                }
+                else if(!mInFlight.empty())
+                {
+                    waitTimeline(mInFlight.front().mValue);
+                    reclaim();
+                }
+                else
+                {
+                    // Another thread is writing the oldest pending chunk
+                    std::this_thread::yield();
+                }
+                lock.lock();
+            }
+        }
+
+        mRingHead += padding;
+        aChunk.mStagingOffset = mRingHead % mCapacity;
+        mRingHead += alignedSize;
+        aChunk.mRingEnd = mRingHead;
+        // std::deque::push_back() does not invalidate references to the other elements
+        return mPending.emplace_back(aChunk);
+    }
+
+    void waitTimeline(uint64_t aValue)
+    {
+        VkSemaphoreWaitInfo semaphoreWaitInfo{
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+            .semaphoreCount = 1,
+            .pSemaphores = &mTimeline,
+            .pValues = &aValue,
+        };
+        assertVkSuccess(vkWaitSemaphores(mContext.vkDevice, &semaphoreWaitInfo, UINT64_MAX));
+    }
+
+    void markReady(Chunk & aChunk)
+    {
+        std::lock_guard<std::mutex> lock{mMutex};
+        aChunk.mReady = true;
+    }
+
+    /// @brief Release the staging space and command buffers of the completed batches.
+    void reclaim()
+    {
+        uint64_t completedValue;
+        assertVkSuccess(vkGetSemaphoreCounterValue(mContext.vkDevice, mTimeline, &completedValue));
+
+        bool released = false;
+        while(!mInFlight.empty() && mInFlight.front().mValue <= completedValue)
+        {
+            const Batch & batch = mInFlight.front();
+            assertVkSuccess(vkResetCommandBuffer(batch.mCommandBuffer, 0));
+            mFreeCommandBuffers.push_back(batch.mCommandBuffer);
+            {
+                std::lock_guard<std::mutex> lock{mMutex};
+                mRingTail = batch.mRingEnd;
+            }
+            mInFlight.pop_front();
+            released = true;
+        }
+        if(released)
+        {
+            mSpaceAvailable.notify_all();
+        }
+    }
+
+    VkCommandBuffer takeCommandBuffer()
+    {
+        if(mFreeCommandBuffers.empty())
+        {
+            VkCommandBufferAllocateInfo commandBufferAllocateInfo{
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                .commandPool = mCommandPool,
+                .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                .commandBufferCount = 1,
+            };
+            VkCommandBuffer vkCommandBuffer;
+            assertVkSuccess(vkAllocateCommandBuffers(mContext.vkDevice, &commandBufferAllocateInfo, &vkCommandBuffer));
+            return vkCommandBuffer;
+        }
+        VkCommandBuffer vkCommandBuffer = mFreeCommandBuffers.back();
+        mFreeCommandBuffers.pop_back();
+        return vkCommandBuffer;
+    }
+
+    const TransferContext & mContext;
+    const std::thread::id mRenderThread{std::this_thread::get_id()};
+
+    //
+    // Staging ring, shared with requesting threads (guarded by mMutex)
+    //
+    VkBuffer mStagingBuffer;
+    VkDeviceMemory mStagingMemory;
+    std::byte * mStagingMap;
+    const VkDeviceSize mCapacity;
+    const VkDeviceSize mMaxChunkSize;
+    // Bounds the copies recorded by a single submit(), to spread large streams over several frames.
+    const VkDeviceSize mMaxBytesPerSubmit{32 * 1024 * 1024};
+
+    std::mutex mMutex;
+    std::condition_variable mSpaceAvailable;
+    // Monotonic positions, the offset in the ring is the position modulo mCapacity
+    uint64_t mRingHead{0};
+    uint64_t mRingTail{0};
+    std::deque<Chunk> mPending;
+    Ticket mLastTicket{0};
+    // Requests with chunks remaining to be submitted (they can be submitted out of order when chunked)
+    std::set<Ticket> mUnsubmittedTickets;
+    // Destinations of a request, when it releases them to the graphics family
+    std::set<VkBuffer> mUploadedBuffers;
+
+    //
+    // Render thread only
+    //
+    VkSemaphore mTimeline;
+    VkCommandPool mCommandPool;
+    std::vector<VkCommandBuffer> mFreeCommandBuffers;
+    std::deque<Batch> mInFlight;
+    uint64_t mLastSubmittedValue{0};
+    uint64_t mGraphicsWaitValue{0};
+    std::vector<VkBufferMemoryBarrier2> mPendingBufferAcquires;
+    std::vector<VkImageMemoryBarrier2> mPendingImageAcquires;
+};
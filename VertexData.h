@@ -1,4 +1,11 @@
+#pragma once
+
+
 #include <array>
+#include <vector>
+
+#include <cmath>
+#include <cstdint>
 
 struct Vertex
 {
@@ -6,10 +13,52 @@ struct Vertex
     std::array<float, 3> mColor;
 };
 
-const float f = 0.75f;
+constexpr float f = 0.75f;
 
 constexpr std::array<Vertex, 3> gTriangle{{
     {.mPosition = {-0.866f * f, -0.5f * f, 0.0f}, .mColor = {0.0f, 1.0f, 0.0f}},
     {.mPosition = { 0.866f * f, -0.5f * f, 0.0f}, .mColor = {0.0f, 0.0f, 1.0f}},
     {.mPosition = { 0.0f,        1.0f * f, 0.0f}, .mColor = {1.0f, 0.0f, 0.0f}},
-}};
\ No newline at end of file
+}};
+
+constexpr std::array<uint16_t, 3> gTriangleIndices{0, 1, 2};
+
+// Radius of the bounding sphere of gTriangle, centered on the origin
+constexpr float gTriangleRadius = f;
+
+
+// Per-instance attributes
+struct InstanceData
+{
+    // Rows of the transform to clip space
+    std::array<std::array<float, 4>, 4> mTransformRows;
+    std::array<float, 4> mColor;
+};
+
+/// @brief Places aInstanceCount instances on a square grid covering [-1, 1] in x and y,
+/// with a hue varying along the grid. The transforms are the model transforms of the instances.
+std::vector<InstanceData> generateInstanceGrid(uint32_t aInstanceCount)
+{
+    const uint32_t side = (uint32_t)std::ceil(std::sqrt((float)aInstanceCount));
+    const float cell = 2.f / side;
+    // Scales the mesh to fit in its cell
+    const float scale = 0.5f * cell / f;
+
+    std::vector<InstanceData> instances(aInstanceCount);
+    for(uint32_t instanceIdx = 0; instanceIdx != aInstanceCount; ++instanceIdx)
+    {
+        const uint32_t column = instanceIdx % side;
+        const uint32_t row = instanceIdx / side;
+        const float ratio = (float)instanceIdx / aInstanceCount;
+        instances[instanceIdx] = InstanceData{
+            .mTransformRows = {{
+                {scale, 0.f,   0.f, -1.f + (column + 0.5f) * cell},
+                {0.f,   scale, 0.f, -1.f + (row + 0.5f) * cell},
+                {0.f,   0.f,   1.f, 0.f},
+                {0.f,   0.f,   0.f, 1.f},
+            }},
+            .mColor = {1.f - ratio, 0.5f + 0.5f * ratio, ratio, 1.f},
+        };
+    }
+    return instances;
+}
@@ -0,0 +1,492 @@
+#pragma once
+
+
+#include "Simd.h"
+#include "VertexData.h"
+#include "VulkanLoading.h"
+
+#include <algorithm>
+#include <bit>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+
+// Storage formats of vertex attributes.
+// All of them are read as floating point vectors by the shaders, so changing the storage format
+// of an attribute does not require to change the shader declaring it.
+// see: https://docs.vulkan.org/spec/latest/chapters/fxvertex.html#fxvertex-input-extraction
+enum class AttributeFormat
+{
+    Float32x3,      // Full precision, 12 bytes
+    Float16x4,      // Half precision, 8 bytes (3-component 16-bit formats are not widely supported for vertex buffers)
+    Snorm16x4,      // [-1, 1] in 65535 steps, 8 bytes. Positions must be normalized by the mesh bounds.
+    Unorm8x4,       // [0, 1] in 255 steps, 4 bytes. Colors.
+    Snorm10x3_2,    // xyz in [-1, 1] in 1023 steps, w in {-1, 0, 1}, 4 bytes. Normals and tangents.
+    Unorm10x3_2,    // xyz in [0, 1] in 1023 steps, w in [0, 1] in 3 steps, 4 bytes. HDR-ish colors.
+};
+
+
+constexpr VkFormat getVkFormat(AttributeFormat aFormat)
+{
+    switch(aFormat)
+    {
+        case AttributeFormat::Float32x3:
+            return VK_FORMAT_R32G32B32_SFLOAT;
+        case AttributeFormat::Float16x4:
+            return VK_FORMAT_R16G16B16A16_SFLOAT;
+        case AttributeFormat::Snorm16x4:
+            return VK_FORMAT_R16G16B16A16_SNORM;
+        case AttributeFormat::Unorm8x4:
+            return VK_FORMAT_R8G8B8A8_UNORM;
+        // Packed formats list components from the most significant bits: x is in the low bits.
+        case AttributeFormat::Snorm10x3_2:
+            return VK_FORMAT_A2B10G10R10_SNORM_PACK32;
+        case AttributeFormat::Unorm10x3_2:
+            return VK_FORMAT_A2B10G10R10_UNORM_PACK32;
+    }
+    return VK_FORMAT_UNDEFINED;
+}
+
+
+/// @brief Size in bytes of one attribute in aFormat.
+constexpr uint32_t getSize(AttributeFormat aFormat)
+{
+    switch(aFormat)
+    {
+        case AttributeFormat::Float32x3:
+            return 12;
+        case AttributeFormat::Float16x4:
+        case AttributeFormat::Snorm16x4:
+            return 8;
+        case AttributeFormat::Unorm8x4:
+        case AttributeFormat::Snorm10x3_2:
+        case AttributeFormat::Unorm10x3_2:
+            return 4;
+    }
+    return 0;
+}
+
+
+struct VertexAttribute
+{
+    uint32_t mLocation;
+    AttributeFormat mFormat;
+};
+
+
+/// @brief Interleaved attributes of a single vertex buffer binding, tightly packed in declaration order.
+struct VertexLayout
+{
+    std::vector<VertexAttribute> mAttributes;
+
+    uint32_t getOffset(std::size_t aAttributeIdx) const
+    {
+        uint32_t offset = 0;
+        for(std::size_t attributeIdx = 0; attributeIdx != aAttributeIdx; ++attributeIdx)
+        {
+            offset += getSize(mAttributes[attributeIdx].mFormat);
+        }
+        return offset;
+    }
+
+    uint32_t getStride() const
+    {
+        return getOffset(mAttributes.size());
+    }
+
+    /// @brief Vulkan description of the attributes sourced from aBinding.
+    /// @note The 2EXT versions used by `vkCmdSetVertexInputEXT()` are derived from those,
+    /// see VertexInputDescription.
+    std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions(uint32_t aBinding) const
+    {
+        std::vector<VkVertexInputAttributeDescription> result;
+        for(std::size_t attributeIdx = 0; attributeIdx != mAttributes.size(); ++attributeIdx)
+        {
+            result.push_back({
+                .location = mAttributes[attributeIdx].mLocation,
+                .binding = aBinding,
+                .format = getVkFormat(mAttributes[attributeIdx].mFormat),
+                .offset = getOffset(attributeIdx),
+            });
+        }
+        return result;
+    }
+};
+
+
+// The layout matching the `Vertex` struct
+const VertexLayout gFullVertexLayout{
+    .mAttributes{
+        {.mLocation = 1, .mFormat = AttributeFormat::Float32x3},
+        {.mLocation = 2, .mFormat = AttributeFormat::Float32x3},
+    },
+};
+
+// Half the size of gFullVertexLayout: half precision positions (keeping the mesh untransformed),
+// and 8-bit colors.
+const VertexLayout gCompactVertexLayout{
+    .mAttributes{
+        {.mLocation = 1, .mFormat = AttributeFormat::Float16x4},
+        {.mLocation = 2, .mFormat = AttributeFormat::Unorm8x4},
+    },
+};
+
+
+//
+// Encoders
+//
+// Each kernel quantizes a single 4-component vector, which makes them independent of the source layout
+// (the source components are loaded into a 4-lane register, the missing ones defaulting to 0, 0, 0, 1).
+// Rounding is to nearest, out of range values are clamped (and overflow to infinity for half floats).
+
+namespace encode {
+
+    /// @brief Reference float to half conversion, rounding to nearest even.
+    /// Denormals, infinities and NaNs are preserved.
+    inline uint16_t floatToHalf(float aValue)
+    {
+        constexpr uint32_t f32Infinity = 255u << 23;
+        // All single precision values greater or equal round to half infinity
+        constexpr uint32_t f16Max = (127u + 16u) << 23;
+        // Values below produce half denormals
+        constexpr uint32_t f16MinNormal = (127u - 14u) << 23;
+        constexpr uint32_t denormalMagic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+        uint32_t bits = std::bit_cast<uint32_t>(aValue);
+        const uint32_t sign = bits & 0x80000000u;
+        bits ^= sign;
+
+        uint32_t result;
+        if(bits >= f16Max)
+        {
+            result = (bits > f32Infinity) ? 0x7e00 : 0x7c00;
+        }
+        else if(bits < f16MinNormal)
+        {
+            // The float addition aligns the mantissa and performs the rounding
+            result = std::bit_cast<uint32_t>(std::bit_cast<float>(bits) + std::bit_cast<float>(denormalMagic))
+                     - denormalMagic;
+        }
+        else
+        {
+            const uint32_t mantissaOdd = (bits >> 13) & 1;
+            // Rebias the exponent, and round
+            bits += ((uint32_t)(15 - 127) << 23) + 0xfff + mantissaOdd;
+            result = bits >> 13;
+        }
+        return (uint16_t)(result | (sign >> 16));
+    }
+
+    inline float clamp(float aValue, float aLow, float aHigh)
+    {
+        // Written so NaN maps to aLow, as the SIMD paths do.
+        return aValue > aLow ? (aValue < aHigh ? aValue : aHigh) : aLow;
+    }
+
+    inline int32_t quantize(float aValue, float aLow, float aHigh, float aScale)
+    {
+        return (int32_t)std::nearbyint(clamp(aValue, aLow, aHigh) * aScale);
+    }
+
+    // The 10/10/10/2 formats are quantized 4-wide, then packed with scalar shifts
+    // (SSE2 has no per-lane variable shift).
+    inline uint32_t pack10x3_2(const int32_t (&aValues)[4])
+    {
+        return ((uint32_t)aValues[0] & 0x3ff)
+               | (((uint32_t)aValues[1] & 0x3ff) << 10)
+               | (((uint32_t)aValues[2] & 0x3ff) << 20)
+               | (((uint32_t)aValues[3] & 0x3) << 30);
+    }
+
+
+    // Reference implementations of the kernels, always available to check and measure the vectorized ones.
+    namespace scalar {
+
+        inline void toFloat16x4(const float (&aIn)[4], std::byte * aOut)
+        {
+            uint16_t halves[4];
+            for(int componentIdx = 0; componentIdx != 4; ++componentIdx)
+            {
+                halves[componentIdx] = floatToHalf(aIn[componentIdx]);
+            }
+            std::memcpy(aOut, halves, sizeof(halves));
+        }
+
+        inline void toSnorm16x4(const float (&aIn)[4], std::byte * aOut)
+        {
+            int16_t values[4];
+            for(int componentIdx = 0; componentIdx != 4; ++componentIdx)
+            {
+                values[componentIdx] = (int16_t)quantize(aIn[componentIdx], -1.f, 1.f, 32767.f);
+            }
+            std::memcpy(aOut, values, sizeof(values));
+        }
+
+        inline void toUnorm8x4(const float (&aIn)[4], std::byte * aOut)
+        {
+            for(int componentIdx = 0; componentIdx != 4; ++componentIdx)
+            {
+                aOut[componentIdx] = (std::byte)quantize(aIn[componentIdx], 0.f, 1.f, 255.f);
+            }
+        }
+
+        inline void toPacked10x3_2(const float (&aIn)[4], std::byte * aOut,
+                                   float aLow, float aScaleXyz, float aScaleW)
+        {
+            int32_t values[4];
+            for(int componentIdx = 0; componentIdx != 4; ++componentIdx)
+            {
+                values[componentIdx] = quantize(aIn[componentIdx], aLow, 1.f, componentIdx == 3 ? aScaleW : aScaleXyz);
+            }
+            const uint32_t packed = pack10x3_2(values);
+            std::memcpy(aOut, &packed, sizeof(packed));
+        }
+
+        inline void toSnorm10x3_2(const float (&aIn)[4], std::byte * aOut)
+        {
+            toPacked10x3_2(aIn, aOut, -1.f, 511.f, 1.f);
+        }
+
+        inline void toUnorm10x3_2(const float (&aIn)[4], std::byte * aOut)
+        {
+            toPacked10x3_2(aIn, aOut, 0.f, 1023.f, 3.f);
+        }
+
+    } // namespace scalar
+
+
+#if defined(SIMD_SSE2)
+
+    // Port of the scalar floatToHalf() to 4 lanes.
+    // The result is sign extended to 32 bits, so it can be narrowed with the saturating _mm_packs_epi32().
+    inline __m128i floatToHalf(__m128 aValues)
+    {
+        const __m128 signMask = _mm_set1_ps(-0.f);
+        const __m128i f16Max = _mm_set1_epi32((127 + 16) << 23);
+        const __m128i f16MinNormal = _mm_set1_epi32((127 - 14) << 23);
+        const __m128i denormalMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+        const __m128i normalBias = _mm_set1_epi32(0xfff - ((127 - 15) << 23));
+
+        const __m128 sign = _mm_and_ps(aValues, signMask);
+        const __m128 absolute = _mm_xor_ps(aValues, sign);
+        const __m128i absoluteBits = _mm_castps_si128(absolute);
+
+        // Specials
+        const __m128i isNan = _mm_castps_si128(_mm_cmpunord_ps(absolute, absolute));
+        const __m128i isFinite = _mm_cmpgt_epi32(f16Max, absoluteBits);
+        const __m128i infinityOrNan = _mm_or_si128(_mm_and_si128(isNan, _mm_set1_epi32(0x200)),
+                                                   _mm_set1_epi32(0x7c00));
+
+        // Denormals
+        const __m128i isDenormal = _mm_cmpgt_epi32(f16MinNormal, absoluteBits);
+        const __m128i denormal =
+            _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(absolute, _mm_castsi128_ps(denormalMagic))), denormalMagic);
+
+        // Normals: -1 when the half mantissa is odd, to round to even
+        const __m128i mantissaOdd = _mm_srai_epi32(_mm_slli_epi32(absoluteBits, 31 - 13), 31);
+        const __m128i normal =
+            _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(absoluteBits, normalBias), mantissaOdd), 13);
+
+        const __m128i finite = _mm_or_si128(_mm_and_si128(isDenormal, denormal), _mm_andnot_si128(isDenormal, normal));
+        const __m128i joined = _mm_or_si128(_mm_and_si128(isFinite, finite), _mm_andnot_si128(isFinite, infinityOrNan));
+        return _mm_or_si128(joined, _mm_srai_epi32(_mm_castps_si128(sign), 16));
+    }
+
+    // Clamps, scales, and rounds to nearest (under the default MXCSR rounding mode).
+    // Note: _mm_max_ps() returns its second operand when the first is NaN, so NaN maps to aLow.
+    inline __m128i quantize(__m128 aValues, __m128 aLow, __m128 aHigh, __m128 aScale)
+    {
+        return _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(aValues, aLow), aHigh), aScale));
+    }
+
+#elif defined(SIMD_NEON)
+
+    inline int32x4_t quantize(float32x4_t aValues, float32x4_t aLow, float32x4_t aHigh, float32x4_t aScale)
+    {
+        // vmaxnmq returns the number when the other operand is NaN
+        return vcvtnq_s32_f32(vmulq_f32(vminq_f32(vmaxnmq_f32(aValues, aLow), aHigh), aScale));
+    }
+
+#endif
+
+
+    inline void toFloat32x3(const float (&aIn)[4], std::byte * aOut)
+    {
+        std::memcpy(aOut, aIn, 3 * sizeof(float));
+    }
+
+    inline void toFloat16x4(const float (&aIn)[4], std::byte * aOut)
+    {
+#if defined(SIMD_F16C)
+        _mm_storel_epi64((__m128i *)aOut, _mm_cvtps_ph(_mm_loadu_ps(aIn), _MM_FROUND_TO_NEAREST_INT));
+#elif defined(SIMD_SSE2)
+        const __m128i halves = floatToHalf(_mm_loadu_ps(aIn));
+        _mm_storel_epi64((__m128i *)aOut, _mm_packs_epi32(halves, halves));
+#elif defined(SIMD_NEON)
+        vst1_u16((uint16_t *)aOut, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(aIn))));
+#else
+        scalar::toFloat16x4(aIn, aOut);
+#endif
+    }
+
+    inline void toSnorm16x4(const float (&aIn)[4], std::byte * aOut)
+    {
+#if defined(SIMD_SSE2)
+        const __m128i values = quantize(_mm_loadu_ps(aIn), _mm_set1_ps(-1.f), _mm_set1_ps(1.f), _mm_set1_ps(32767.f));
+        _mm_storel_epi64((__m128i *)aOut, _mm_packs_epi32(values, values));
+#elif defined(SIMD_NEON)
+        const int32x4_t values = quantize(vld1q_f32(aIn), vdupq_n_f32(-1.f), vdupq_n_f32(1.f), vdupq_n_f32(32767.f));
+        vst1_s16((int16_t *)aOut, vmovn_s32(values));
+#else
+        scalar::toSnorm16x4(aIn, aOut);
+#endif
+    }
+
+    inline void toUnorm8x4(const float (&aIn)[4], std::byte * aOut)
+    {
+#if defined(SIMD_SSE2)
+        const __m128i values = quantize(_mm_loadu_ps(aIn), _mm_setzero_ps(), _mm_set1_ps(1.f), _mm_set1_ps(255.f));
+        const __m128i words = _mm_packs_epi32(values, values);
+        const int packed = _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+        std::memcpy(aOut, &packed, sizeof(packed));
+#elif defined(SIMD_NEON)
+        const int32x4_t values = quantize(vld1q_f32(aIn), vdupq_n_f32(0.f), vdupq_n_f32(1.f), vdupq_n_f32(255.f));
+        const uint8x8_t bytes = vmovn_u16(vcombine_u16(vmovn_u32(vreinterpretq_u32_s32(values)), vdup_n_u16(0)));
+        vst1_lane_u32((uint32_t *)aOut, vreinterpret_u32_u8(bytes), 0);
+#else
+        scalar::toUnorm8x4(aIn, aOut);
+#endif
+    }
+
+    inline void toPacked10x3_2(const float (&aIn)[4], std::byte * aOut,
+                               float aLow, float aScaleXyz, float aScaleW)
+    {
+#if defined(SIMD_SSE2) || defined(SIMD_NEON)
+        int32_t values[4];
+#if defined(SIMD_SSE2)
+        _mm_storeu_si128((__m128i *)values,
+                         quantize(_mm_loadu_ps(aIn), _mm_set1_ps(aLow), _mm_set1_ps(1.f),
+                                  _mm_setr_ps(aScaleXyz, aScaleXyz, aScaleXyz, aScaleW)));
+#else
+        const float scales[4] = {aScaleXyz, aScaleXyz, aScaleXyz, aScaleW};
+        vst1q_s32(values, quantize(vld1q_f32(aIn), vdupq_n_f32(aLow), vdupq_n_f32(1.f), vld1q_f32(scales)));
+#endif
+        const uint32_t packed = pack10x3_2(values);
+        std::memcpy(aOut, &packed, sizeof(packed));
+#else
+        scalar::toPacked10x3_2(aIn, aOut, aLow, aScaleXyz, aScaleW);
+#endif
+    }
+
+    inline void toSnorm10x3_2(const float (&aIn)[4], std::byte * aOut)
+    {
+        toPacked10x3_2(aIn, aOut, -1.f, 511.f, 1.f);
+    }
+
+    inline void toUnorm10x3_2(const float (&aIn)[4], std::byte * aOut)
+    {
+        toPacked10x3_2(aIn, aOut, 0.f, 1023.f, 3.f);
+    }
+
+    /// @brief Encodes aVertexCount vectors, read from strided aIn, to strided aOut.
+    template <class T_kernel>
+    void encodeStream(T_kernel aKernel,
+                      const std::byte * aIn, std::size_t aInStride, std::size_t aComponentCount,
+                      std::byte * aOut, std::size_t aOutStride,
+                      std::size_t aVertexCount)
+    {
+        for(std::size_t vertexIdx = 0; vertexIdx != aVertexCount; ++vertexIdx)
+        {
+            float components[4] = {0.f, 0.f, 0.f, 1.f};
+            std::memcpy(components, aIn, aComponentCount * sizeof(float));
+            aKernel(components, aOut);
+            aIn += aInStride;
+            aOut += aOutStride;
+        }
+    }
+
+} // namespace encode
+
+
+/// @brief Strided view over the float components of one attribute in the source data.
+struct AttributeSource
+{
+    const float * mData;
+    uint32_t mComponentCount; // in [1, 4]
+    std::size_t mStride;      // in bytes
+};
+
+
+/// @brief Encodes aVertexCount vertices into the interleaved aLayout.
+/// @param aSources One source per attribute of aLayout, in the same order.
+/// @param aOut Must be able to hold aVertexCount * aLayout.getStride() bytes.
+inline void encodeVertices(const VertexLayout & aLayout,
+                           std::span<const AttributeSource> aSources,
+                           std::size_t aVertexCount,
+                           std::byte * aOut)
+{
+    if(aSources.size() != aLayout.mAttributes.size())
+    {
+        throw std::invalid_argument{"There must be one source per attribute in the layout."};
+    }
+
+    const uint32_t stride = aLayout.getStride();
+    for(std::size_t attributeIdx = 0; attributeIdx != aSources.size(); ++attributeIdx)
+    {
+        const AttributeSource & source = aSources[attributeIdx];
+        const AttributeFormat format = aLayout.mAttributes[attributeIdx].mFormat;
+        const std::size_t componentCount = std::min<std::size_t>(source.mComponentCount, 4);
+        std::byte * out = aOut + aLayout.getOffset(attributeIdx);
+        const std::byte * in = reinterpret_cast<const std::byte *>(source.mData);
+
+        // Dispatch once per attribute, outside of the vertex loop
+        auto encodeWith = [&](auto aKernel)
+        {
+            encode::encodeStream(aKernel, in, source.mStride, componentCount, out, stride, aVertexCount);
+        };
+        switch(format)
+        {
+            case AttributeFormat::Float32x3:
+                encodeWith(encode::toFloat32x3);
+                break;
+            case AttributeFormat::Float16x4:
+                encodeWith(encode::toFloat16x4);
+                break;
+            case AttributeFormat::Snorm16x4:
+                encodeWith(encode::toSnorm16x4);
+                break;
+            case AttributeFormat::Unorm8x4:
+                encodeWith(encode::toUnorm8x4);
+                break;
+            case AttributeFormat::Snorm10x3_2:
+                encodeWith(encode::toSnorm10x3_2);
+                break;
+            case AttributeFormat::Unorm10x3_2:
+                encodeWith(encode::toUnorm10x3_2);
+                break;
+        }
+    }
+}
+
+
+/// @brief Encodes `Vertex` data into aLayout, which must declare the position then the color.
+inline std::vector<std::byte> encodeVertices(const VertexLayout & aLayout, std::span<const Vertex> aVertices)
+{
+    if(aVertices.empty())
+    {
+        return {};
+    }
+    const AttributeSource sources[] = {
+        {.mData = aVertices.front().mPosition.data(), .mComponentCount = 3, .mStride = sizeof(Vertex)},
+        {.mData = aVertices.front().mColor.data(), .mComponentCount = 3, .mStride = sizeof(Vertex)},
+    };
+    std::vector<std::byte> result(aVertices.size() * aLayout.getStride());
+    encodeVertices(aLayout, sources, aVertices.size(), result.data());
+    return result;
+}
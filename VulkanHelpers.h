@@ -1,24 +1,33 @@
 #pragma once
 
 
+#include "VertexData.h"
+#include "ObjectRegistry.h"
+#include "ShaderBinaryCache.h"
+#include "ShaderVariant.h"
+#include "SpirvReflection.h"
+#include "VertexLayout.h"
 #include "VulkanLoading.h"
 
 // Included to get the to_string() functions
 // Note: cannot include vulkan_to_string directly, there is a circular dependency issue
 #include <vulkan/vulkan.hpp>
 
+#include <array>
 #include <format>
 #include <sstream>
 #include <iomanip>
 #include <iostream>
+#include <map>
+#include <optional>
 #include <span>
+#include <string_view>
 #include <vector>
 
 #include <cassert>
+#include <cstring>
 
 
-VkAllocationCallbacks * const pAllocator = nullptr;
-
 const VkImageSubresourceRange gSwapchainImageFullRange{
     // When aspectMask is not included, there is a bug/typo in the validation layer
     // (the path is missing the subresourceRange stage)
@@ -446,55 +455,257 @@ void printEnumeratedLayers()
 
 struct QueueSelection
 {
-    uint32_t mQueueFamilyIndex;
+    struct Queue
+    {
+        uint32_t mFamilyIndex;
+        // Index of the queue within its family
+        uint32_t mQueueIndex;
+        float mPriority;
+    };
+
+    // Graphics queue, which is also able to present to Win32 surfaces.
+    Queue mGraphics;
+    // Preferably from a transfer-only family (usually backed by DMA engines), used for uploads and readbacks.
+    Queue mTransfer;
+    // Preferably from a family without graphics support, for async compute.
+    Queue mCompute;
+
+    /// @brief Ownership transfers are required between queues of distinct families
+    /// (resources are created with VK_SHARING_MODE_EXCLUSIVE).
+    bool requiresOwnershipTransfer(const Queue & aSource, const Queue & aDestination) const
+    {
+        return aSource.mFamilyIndex != aDestination.mFamilyIndex;
+    }
 };
 
+
+std::vector<VkQueueFamilyProperties2> getQueueFamilyProperties(VkPhysicalDevice vkPhysicalDevice)
+{
+    uint32_t queueFamilyPropertyCount;
+    vkGetPhysicalDeviceQueueFamilyProperties2(vkPhysicalDevice, &queueFamilyPropertyCount, nullptr);
+    std::vector<VkQueueFamilyProperties2> queueFamilyPropertiesVector(
+        queueFamilyPropertyCount,
+        VkQueueFamilyProperties2{
+            .sType = VK_STRUCTURE_TYPE_QUEUE_FAMILY_PROPERTIES_2,
+        }
+    );
+    vkGetPhysicalDeviceQueueFamilyProperties2(vkPhysicalDevice, &queueFamilyPropertyCount, queueFamilyPropertiesVector.data());
+    return queueFamilyPropertiesVector;
+}
+
+
+bool isDeviceExtensionSupported(VkPhysicalDevice vkPhysicalDevice, std::string_view aExtensionName)
+{
+    uint32_t extensionCount;
+    assertVkSuccess(vkEnumerateDeviceExtensionProperties(vkPhysicalDevice, nullptr, &extensionCount, nullptr));
+    std::vector<VkExtensionProperties> extensions(extensionCount);
+    assertVkSuccess(vkEnumerateDeviceExtensionProperties(vkPhysicalDevice, nullptr, &extensionCount, extensions.data()));
+    return std::ranges::any_of(extensions, [aExtensionName](const VkExtensionProperties & aExtension)
+    {
+        return aExtensionName == aExtension.extensionName;
+    });
+}
+
+
 QueueSelection pickQueueFamily(VkInstance vkInstance, VkPhysicalDevice vkPhysicalDevice)
 {
-    // TODO: compute the queue family index from a list of required queues.
-    return QueueSelection{
-        .mQueueFamilyIndex = 0,
+    const std::vector<VkQueueFamilyProperties2> families = getQueueFamilyProperties(vkPhysicalDevice);
+    const uint32_t familyCount = (uint32_t)families.size();
+    // Count of queues already handed out in each family
+    std::vector<uint32_t> usedQueues(familyCount, 0);
+
+    auto flagsOf = [&](uint32_t aFamilyIdx)
+    {
+        return families[aFamilyIdx].queueFamilyProperties.queueFlags;
     };
+
+    // Returns the first family exposing all aRequired flags and none of aExcluded flags
+    auto findFamily = [&](VkQueueFlags aRequired, VkQueueFlags aExcluded, auto aPredicate) -> std::optional<uint32_t>
+    {
+        for(uint32_t familyIdx = 0; familyIdx != familyCount; ++familyIdx)
+        {
+            if((flagsOf(familyIdx) & aRequired) == aRequired
+               && (flagsOf(familyIdx) & aExcluded) == 0
+               && aPredicate(familyIdx))
+            {
+                return familyIdx;
+            }
+        }
+        return std::nullopt;
+    };
+    auto anyFamily = [](uint32_t){ return true; };
+
+    // Hands out the next queue in the family, or shares the last one when the family is exhausted
+    auto takeQueue = [&](uint32_t aFamilyIdx, float aPriority) -> QueueSelection::Queue
+    {
+        const uint32_t queueCount = families[aFamilyIdx].queueFamilyProperties.queueCount;
+        const uint32_t queueIdx = std::min(usedQueues[aFamilyIdx], queueCount - 1);
+        usedQueues[aFamilyIdx] = queueIdx + 1;
+        return QueueSelection::Queue{
+            .mFamilyIndex = aFamilyIdx,
+            .mQueueIndex = queueIdx,
+            .mPriority = aPriority,
+        };
+    };
+
+    // Note: since Vulkan 1.0, if a family supports graphics, then at least one family supports graphics and compute.
+    std::optional<uint32_t> graphicsFamily = findFamily(
+        VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT, 0,
+        [&](uint32_t aFamilyIdx)
+        {
+            return vkGetPhysicalDeviceWin32PresentationSupportKHR(vkPhysicalDevice, aFamilyIdx) == VK_TRUE;
+        });
+    assert(graphicsFamily);
+
+    // Transfer: prefer a transfer-only family, then a compute family without graphics, then fallback on graphics.
+    // (All graphics and compute queues implicitly support transfer operations).
+    std::optional<uint32_t> transferFamily = findFamily(
+        VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT, anyFamily);
+    if(!transferFamily)
+    {
+        transferFamily = findFamily(VK_QUEUE_COMPUTE_BIT, VK_QUEUE_GRAPHICS_BIT, anyFamily);
+    }
+
+    // Compute: prefer a family without graphics (async compute)
+    std::optional<uint32_t> computeFamily = findFamily(VK_QUEUE_COMPUTE_BIT, VK_QUEUE_GRAPHICS_BIT, anyFamily);
+
+    // The graphics queue is taken first, so it always gets the index 0 in its family.
+    QueueSelection result{
+        .mGraphics = takeQueue(*graphicsFamily, 1.0f),
+    };
+    result.mCompute = takeQueue(computeFamily.value_or(*graphicsFamily), 0.5f);
+    result.mTransfer = takeQueue(transferFamily.value_or(*graphicsFamily), 0.5f);
+
+    std::cout << "Queue selection (family:index):"
+        << "\n\t- graphics: " << result.mGraphics.mFamilyIndex << ":" << result.mGraphics.mQueueIndex
+        << "\n\t- compute: " << result.mCompute.mFamilyIndex << ":" << result.mCompute.mQueueIndex
+        << "\n\t- transfer: " << result.mTransfer.mFamilyIndex << ":" << result.mTransfer.mQueueIndex
+        << "\n\n"
+        ;
+
+    return result;
 }
 
+
+/// @param aGraphicsPipelineLibrary Enables VK_EXT_graphics_pipeline_library, which must be supported.
+/// @param aDescriptorIndexing Enables the descriptor indexing features of bindless descriptors.
+/// @param aDescriptorBuffer Enables VK_EXT_descriptor_buffer, which must be supported.
+/// @param aDrawIndirectFirstInstance Enables non-zero firstInstance in indirect draws, which must be supported.
 VkDevice createDevice(VkInstance vkInstance,
                       VkPhysicalDevice vkPhysicalDevice,
-                      const QueueSelection & aQueueSelection
+                      const QueueSelection & aQueueSelection,
+                      bool aGraphicsPipelineLibrary = false,
+                      bool aDescriptorIndexing = false,
+                      bool aDescriptorBuffer = false,
+                      bool aDrawIndirectFirstInstance = false
                       )
 {
-    const uint32_t queueCount = 1;
-    // TODO: assign priorities
-    std::vector<float> queuePriorities(queueCount);
+    // Group the selected queues per family, the priorities being indexed by queue index.
+    std::map<uint32_t/*family*/, std::vector<float>/*priorities*/> familyPriorities;
+    for(const QueueSelection::Queue & queue : {aQueueSelection.mGraphics,
+                                               aQueueSelection.mCompute,
+                                               aQueueSelection.mTransfer})
+    {
+        std::vector<float> & priorities = familyPriorities[queue.mFamilyIndex];
+        if(priorities.size() <= queue.mQueueIndex)
+        {
+            priorities.resize(queue.mQueueIndex + 1, 0.f);
+        }
+        // When a queue is shared between roles, it keeps the highest requested priority
+        priorities[queue.mQueueIndex] = std::max(priorities[queue.mQueueIndex], queue.mPriority);
+    }
+
+    std::vector<VkDeviceQueueCreateInfo> deviceQueueCreateInfos;
+    for(const auto & [familyIndex, priorities] : familyPriorities)
+    {
+        deviceQueueCreateInfos.push_back(VkDeviceQueueCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+            .queueFamilyIndex = familyIndex,
+            .queueCount = (uint32_t)priorities.size(),
+            .pQueuePriorities = priorities.data(),
+        });
+    }
+
+    // Optional: pipelines compiled as libraries, then linked
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT physicalDeviceGraphicsPipelineLibraryFeaturesEXT{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT,
+        .graphicsPipelineLibrary = VK_TRUE,
+    };
+
+    // Optional: descriptors written to buffer memory, see BindlessBackend
+    VkPhysicalDeviceDescriptorBufferFeaturesEXT physicalDeviceDescriptorBufferFeaturesEXT{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT,
+        .pNext = aGraphicsPipelineLibrary ? &physicalDeviceGraphicsPipelineLibraryFeaturesEXT : nullptr,
+        .descriptorBuffer = VK_TRUE,
+    };
 
     VkPhysicalDeviceShaderObjectFeaturesEXT physicalDeviceShaderObjectFeaturesEXT{
         .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_OBJECT_FEATURES_EXT,
+        .pNext = aDescriptorBuffer ? &physicalDeviceDescriptorBufferFeaturesEXT : physicalDeviceDescriptorBufferFeaturesEXT.pNext,
         .shaderObject = VK_TRUE,
     };
 
+    VkPhysicalDeviceVulkan12Features physicalDeviceVulkan12Features{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+        .pNext = &physicalDeviceShaderObjectFeaturesEXT,
+        // GPU-driven draws, with the draw count sourced from a buffer
+        .drawIndirectCount = VK_TRUE,
+        // Used to track completion of uploads on the transfer queue
+        .timelineSemaphore = VK_TRUE,
+        // Shaders access per-object data via buffer references
+        .bufferDeviceAddress = VK_TRUE,
+    };
+    // Optional: bindless descriptors, see gBindlessSetLayoutCreateInfo
+    if(aDescriptorIndexing)
+    {
+        physicalDeviceVulkan12Features.descriptorIndexing = VK_TRUE;
+        physicalDeviceVulkan12Features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+        physicalDeviceVulkan12Features.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+        physicalDeviceVulkan12Features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        physicalDeviceVulkan12Features.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+        physicalDeviceVulkan12Features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+        physicalDeviceVulkan12Features.descriptorBindingPartiallyBound = VK_TRUE;
+        physicalDeviceVulkan12Features.runtimeDescriptorArray = VK_TRUE;
+    }
+
+    VkPhysicalDeviceFeatures2 physicalDeviceFeatures2{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &physicalDeviceVulkan12Features,
+        .features = {
+            // Indirect draws with a draw count greater than 1
+            .multiDrawIndirect = VK_TRUE,
+            // Optional: indirect draws addressing per-object data through firstInstance, see generateDrawRecords()
+            .drawIndirectFirstInstance = aDrawIndirectFirstInstance,
+        },
+    };
+
     VkPhysicalDeviceVulkan13Features physicalDeviceVulkan13Features{
         .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
-        .pNext = &physicalDeviceShaderObjectFeaturesEXT,
+        .pNext = &physicalDeviceFeatures2,
         .synchronization2 = VK_TRUE,
         .dynamicRendering = VK_TRUE,
     };
 
-    VkDeviceQueueCreateInfo deviceQueueCreateInfo{
-        .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
-        .queueFamilyIndex = aQueueSelection.mQueueFamilyIndex,
-        .queueCount = queueCount,
-        .pQueuePriorities = queuePriorities.data(),
-    };
-
     std::vector<const char *>enabledDeviceExtensionNames{
         "VK_EXT_shader_object",
         "VK_KHR_swapchain",
     };
+    if(aGraphicsPipelineLibrary)
+    {
+        enabledDeviceExtensionNames.push_back("VK_EXT_graphics_pipeline_library");
+        // Dependency of the above
+        enabledDeviceExtensionNames.push_back("VK_KHR_pipeline_library");
+    }
+    if(aDescriptorBuffer)
+    {
+        enabledDeviceExtensionNames.push_back("VK_EXT_descriptor_buffer");
+    }
 
     VkDeviceCreateInfo deviceCreateInfo{
         .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
         .pNext = &physicalDeviceVulkan13Features,
-        .queueCreateInfoCount = 1,
-        .pQueueCreateInfos = &deviceQueueCreateInfo,
+        .queueCreateInfoCount = (uint32_t)deviceQueueCreateInfos.size(),
+        .pQueueCreateInfos = deviceQueueCreateInfos.data(),
         .enabledExtensionCount = (uint32_t)enabledDeviceExtensionNames.size(),
         .ppEnabledExtensionNames = enabledDeviceExtensionNames.data(),
     };
@@ -505,6 +716,61 @@ VkDevice createDevice(VkInstance vkInstance,
 }
 
 
+struct Queues
+{
+    VkQueue mGraphics;
+    VkQueue mTransfer;
+    VkQueue mCompute;
+};
+
+VkQueue getQueue(VkDevice vkDevice, const QueueSelection::Queue & aQueue)
+{
+    VkDeviceQueueInfo2 deviceQueueInfo2{
+        .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_INFO_2,
+        .queueFamilyIndex = aQueue.mFamilyIndex,
+        .queueIndex = aQueue.mQueueIndex,
+    };
+    VkQueue vkQueue;
+    vkGetDeviceQueue2(vkDevice, &deviceQueueInfo2, &vkQueue);
+    return vkQueue;
+}
+
+/// @note Several roles might share the same VkQueue, in which case they also share
+/// the external synchronization requirement on queue submission.
+Queues getQueues(VkDevice vkDevice, const QueueSelection & aQueueSelection)
+{
+    Queues result{
+        .mGraphics = getQueue(vkDevice, aQueueSelection.mGraphics),
+        .mTransfer = getQueue(vkDevice, aQueueSelection.mTransfer),
+        .mCompute = getQueue(vkDevice, aQueueSelection.mCompute),
+    };
+    // Names are assigned in reverse priority order, so a shared queue ends up with the most significant name.
+    nameObject(vkDevice, result.mTransfer, "main_transfer");
+    nameObject(vkDevice, result.mCompute, "main_compute");
+    nameObject(vkDevice, result.mGraphics, "main_graphics");
+    return result;
+}
+
+
+uint32_t findMemoryTypeIndex(const VkPhysicalDeviceMemoryProperties & aMemoryProperties,
+                             VkMemoryPropertyFlags aRequiredProperties,
+                             uint32_t aMemoryTypeBits = ~0u)
+{
+    uint32_t memoryTypeIndex = 0;
+    for(; memoryTypeIndex != aMemoryProperties.memoryTypeCount; ++memoryTypeIndex)
+    {
+        if((aMemoryTypeBits & (0b1 << memoryTypeIndex))
+           && (aMemoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & aRequiredProperties)
+               == aRequiredProperties)
+        {
+            break; // Found a suitable memory type
+        }
+    }
+    assert(memoryTypeIndex < aMemoryProperties.memoryTypeCount);
+    return memoryTypeIndex;
+}
+
+
 VkFence createFence(VkDevice vkDevice)
 {
     VkFence fence;
@@ -548,8 +814,295 @@ void printSupportedSurfaceFormat(VkPhysicalDevice vkPhysicalDevice, VkSurfaceKHR
 }
 
     
-std::vector<VkShaderEXT> createShaderObjects(VkDevice vkDevice, std::span<char> vertexCode, std::span<char> fragmentCode)
+/// @brief Merges the push constant ranges of aShaders into a single range, visible to all stages using it.
+/// @note Shader objects linked together must be created with identical ranges.
+std::vector<VkPushConstantRange> getPushConstantRanges(std::span<const ShaderReflection * const> aShaders)
+{
+    std::optional<VkPushConstantRange> merged;
+    for(const ShaderReflection * shader : aShaders)
+    {
+        if(const std::optional<VkPushConstantRange> & range = shader->mPushConstants)
+        {
+            if(!merged)
+            {
+                merged = range;
+            }
+            else
+            {
+                const uint32_t end = std::max(merged->offset + merged->size, range->offset + range->size);
+                merged->stageFlags |= range->stageFlags;
+                merged->offset = std::min(merged->offset, range->offset);
+                merged->size = end - merged->offset;
+            }
+        }
+    }
+    return merged ? std::vector<VkPushConstantRange>{*merged} : std::vector<VkPushConstantRange>{};
+}
+
+
+//
+// Bindless descriptors (see BindlessDescriptors.h)
+//
+// Shaders declaring set gBindlessSet see all the resources registered in the bindless heap, as runtime sized arrays
+// indexed by values from the push constants. The layout is fixed, whatever the shaders actually declare,
+// so that the set is bound once per command buffer, whichever bindless pipeline or shader objects are bound.
+constexpr uint32_t gBindlessSet = 0;
+
+/// @brief Where the descriptors of the bindless set live.
+enum class BindlessBackend
+{
+    // A descriptor set from a pool, written with vkUpdateDescriptorSets()
+    DescriptorSets,
+    // Host visible buffer memory, written with vkGetDescriptorEXT() (VK_EXT_descriptor_buffer).
+    // Pipelines using the set must be created with VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT.
+    DescriptorBuffer,
+};
+
+constexpr uint32_t gBindlessSampledImageBinding = 0;
+constexpr uint32_t gBindlessStorageBufferBinding = 1;
+constexpr uint32_t gBindlessSamplerBinding = 2;
+
+constexpr std::array<VkDescriptorSetLayoutBinding, 3> gBindlessBindings{{
+    {
+        .binding = gBindlessSampledImageBinding,
+        .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+        .descriptorCount = 1 << 17,
+        .stageFlags = VK_SHADER_STAGE_ALL,
+    },
+    {
+        .binding = gBindlessStorageBufferBinding,
+        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .descriptorCount = 1 << 16,
+        .stageFlags = VK_SHADER_STAGE_ALL,
+    },
+    {
+        .binding = gBindlessSamplerBinding,
+        .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER,
+        .descriptorCount = 1 << 10,
+        .stageFlags = VK_SHADER_STAGE_ALL,
+    },
+}};
+
+// Slots are written while the set is bound (as long as pending commands do not use them), most are never written.
+constexpr VkDescriptorBindingFlags gBindlessBindingFlags = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT
+                                                           | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT
+                                                           | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+constexpr std::array<VkDescriptorBindingFlags, 3> gBindlessBindingFlagsArray{
+    gBindlessBindingFlags, gBindlessBindingFlags, gBindlessBindingFlags,
+};
+constexpr VkDescriptorSetLayoutBindingFlagsCreateInfo gBindlessBindingFlagsCreateInfo{
+    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+    .bindingCount = (uint32_t)gBindlessBindingFlagsArray.size(),
+    .pBindingFlags = gBindlessBindingFlagsArray.data(),
+};
+constexpr VkDescriptorSetLayoutCreateInfo gBindlessSetLayoutCreateInfo{
+    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+    .pNext = &gBindlessBindingFlagsCreateInfo,
+    .flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+    .bindingCount = (uint32_t)gBindlessBindings.size(),
+    .pBindings = gBindlessBindings.data(),
+};
+
+// Descriptor buffers are plain memory: slots are written whenever they are not in use, without update after bind flags.
+constexpr std::array<VkDescriptorBindingFlags, 3> gBindlessBufferBindingFlagsArray{
+    VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT, VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT, VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT,
+};
+constexpr VkDescriptorSetLayoutBindingFlagsCreateInfo gBindlessBufferBindingFlagsCreateInfo{
+    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+    .bindingCount = (uint32_t)gBindlessBufferBindingFlagsArray.size(),
+    .pBindingFlags = gBindlessBufferBindingFlagsArray.data(),
+};
+constexpr VkDescriptorSetLayoutCreateInfo gBindlessBufferSetLayoutCreateInfo{
+    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+    .pNext = &gBindlessBufferBindingFlagsCreateInfo,
+    .flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT,
+    .bindingCount = (uint32_t)gBindlessBindings.size(),
+    .pBindings = gBindlessBindings.data(),
+};
+
+constexpr const VkDescriptorSetLayoutCreateInfo & getBindlessSetLayoutCreateInfo(BindlessBackend aBackend)
+{
+    return aBackend == BindlessBackend::DescriptorBuffer ? gBindlessBufferSetLayoutCreateInfo : gBindlessSetLayoutCreateInfo;
+}
+
+// The push constants of the bindless layouts: the guaranteed size for all stages, for the same reason.
+constexpr VkPushConstantRange gBindlessPushConstantRange{
+    .stageFlags = VK_SHADER_STAGE_ALL,
+    .offset = 0,
+    .size = 128,
+};
+
+
+/// @brief Descriptor set layouts and pipeline layout matching the interface of a set of shaders.
+struct ReflectedLayout
+{
+    /// @brief Destroys the layouts, or releases them if they were acquired from a registry.
+    void destroy()
+    {
+        if(mRegistry != nullptr)
+        {
+            mRegistry->release(mPipelineLayout);
+            for(VkDescriptorSetLayout setLayout : mSetLayouts)
+            {
+                mRegistry->release(setLayout);
+            }
+            return;
+        }
+
+        vkDestroyPipelineLayout(vkDevice, mPipelineLayout, pAllocator);
+        for(VkDescriptorSetLayout setLayout : mSetLayouts)
+        {
+            vkDestroyDescriptorSetLayout(vkDevice, setLayout, pAllocator);
+        }
+    }
+
+    VkDevice vkDevice; // required for Dtor
+    ObjectRegistry * mRegistry{nullptr};
+
+    // Indexed by set number, sets not used by the shaders have an empty layout
+    std::vector<VkDescriptorSetLayout> mSetLayouts;
+    std::vector<VkPushConstantRange> mPushConstantRanges;
+    VkPipelineLayout mPipelineLayout;
+};
+
+
+/// @param aRegistry Optional, the layouts are then acquired from it instead of created.
+/// @param aBindlessBackend The layout of the bindless set, when the shaders declare it.
+ReflectedLayout createReflectedLayout(VkDevice vkDevice,
+                                      std::span<const ShaderReflection * const> aShaders,
+                                      ObjectRegistry * aRegistry = nullptr,
+                                      BindlessBackend aBindlessBackend = BindlessBackend::DescriptorSets)
+{
+    ReflectedLayout result{
+        .vkDevice = vkDevice,
+        .mRegistry = aRegistry,
+        .mPushConstantRanges = getPushConstantRanges(aShaders),
+    };
+
+    // Gather the bindings of each set, merging the stages of bindings shared by several shaders
+    std::map<uint32_t, std::vector<VkDescriptorSetLayoutBinding>> setBindings;
+    bool bindless = false;
+    for(const ShaderReflection * shader : aShaders)
+    {
+        for(const ShaderReflection::DescriptorBinding & descriptor : shader->mDescriptorBindings)
+        {
+            if(descriptor.mSet == gBindlessSet)
+            {
+                auto found = std::ranges::find(gBindlessBindings, descriptor.mBinding, &VkDescriptorSetLayoutBinding::binding);
+                if(found == gBindlessBindings.end() || found->descriptorType != descriptor.mType)
+                {
+                    throw std::invalid_argument{"A descriptor of the bindless set does not match its layout."};
+                }
+                // The set is created with the full bindless layout below
+                setBindings[descriptor.mSet];
+                bindless = true;
+                continue;
+            }
+            if(descriptor.mCount == 0)
+            {
+                throw std::invalid_argument{"Runtime sized descriptor arrays require an explicit layout."};
+            }
+
+            std::vector<VkDescriptorSetLayoutBinding> & bindings = setBindings[descriptor.mSet];
+            auto found = std::ranges::find(bindings, descriptor.mBinding, &VkDescriptorSetLayoutBinding::binding);
+            if(found != bindings.end())
+            {
+                if(found->descriptorType != descriptor.mType || found->descriptorCount != descriptor.mCount)
+                {
+                    throw std::invalid_argument{"Stages disagree on the declaration of a descriptor binding."};
+                }
+                found->stageFlags |= shader->mStage;
+            }
+            else
+            {
+                bindings.push_back({
+                    .binding = descriptor.mBinding,
+                    .descriptorType = descriptor.mType,
+                    .descriptorCount = descriptor.mCount,
+                    .stageFlags = (VkShaderStageFlags)shader->mStage,
+                });
+            }
+        }
+    }
+
+    if(bindless)
+    {
+        if(!result.mPushConstantRanges.empty()
+           && result.mPushConstantRanges[0].offset + result.mPushConstantRanges[0].size > gBindlessPushConstantRange.size)
+        {
+            throw std::invalid_argument{"The push constants of bindless shaders exceed the bindless range."};
+        }
+        result.mPushConstantRanges = {gBindlessPushConstantRange};
+    }
+
+    const uint32_t setCount = setBindings.empty() ? 0 : setBindings.rbegin()->first + 1;
+    for(uint32_t setIdx = 0; setIdx != setCount; ++setIdx)
+    {
+        // Creates an empty entry for unused sets
+        const std::vector<VkDescriptorSetLayoutBinding> & bindings = setBindings[setIdx];
+        VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+            .bindingCount = (uint32_t)bindings.size(),
+            .pBindings = bindings.data(),
+        };
+        if(bindless && setIdx == gBindlessSet)
+        {
+            descriptorSetLayoutCreateInfo = getBindlessSetLayoutCreateInfo(aBindlessBackend);
+        }
+        result.mSetLayouts.emplace_back();
+        if(aRegistry != nullptr)
+        {
+            result.mSetLayouts.back() = aRegistry->acquireDescriptorSetLayout(descriptorSetLayoutCreateInfo);
+        }
+        else
+        {
+            assertVkSuccess(vkCreateDescriptorSetLayout(vkDevice, &descriptorSetLayoutCreateInfo, pAllocator, &result.mSetLayouts.back()));
+        }
+    }
+
+    VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = (uint32_t)result.mSetLayouts.size(),
+        .pSetLayouts = result.mSetLayouts.data(),
+        .pushConstantRangeCount = (uint32_t)result.mPushConstantRanges.size(),
+        .pPushConstantRanges = result.mPushConstantRanges.data(),
+    };
+    if(aRegistry != nullptr)
+    {
+        result.mPipelineLayout = aRegistry->acquirePipelineLayout(pipelineLayoutCreateInfo);
+    }
+    else
+    {
+        assertVkSuccess(vkCreatePipelineLayout(vkDevice, &pipelineLayoutCreateInfo, pAllocator, &result.mPipelineLayout));
+    }
+    return result;
+}
+
+
+/// @brief Creates the linked vertex and fragment shader objects.
+/// @param aPushConstantRanges When empty, the ranges are reflected from the shaders code.
+/// @param aBinaryCache Optional, reuses the implementation binaries from a previous run when available.
+/// @param aVariant The features specialized in the shaders, see ShaderVariant.h.
+/// @param aSetLayouts The descriptor set layouts of the shaders, e.g. from createReflectedLayout().
+std::vector<VkShaderEXT> createShaderObjects(VkDevice vkDevice,
+                                             std::span<const char> vertexCode,
+                                             std::span<const char> fragmentCode,
+                                             std::span<const VkPushConstantRange> aPushConstantRanges = {},
+                                             ShaderBinaryCache * aBinaryCache = nullptr,
+                                             VariantKey aVariant = 0,
+                                             std::span<const VkDescriptorSetLayout> aSetLayouts = {})
 {
+    const Specialization vertexSpecialization{getReflection(vertexCode), aVariant};
+    const Specialization fragmentSpecialization{getReflection(fragmentCode), aVariant};
+
+    std::vector<VkPushConstantRange> reflectedRanges;
+    if(aPushConstantRanges.empty())
+    {
+        const ShaderReflection * shaders[]{&getReflection(vertexCode), &getReflection(fragmentCode)};
+        reflectedRanges = getPushConstantRanges(shaders);
+        aPushConstantRanges = reflectedRanges;
+    }
+
     VkShaderCreateInfoEXT shaderCreateInfoEXTs[]{
         VkShaderCreateInfoEXT{
             .sType = VK_STRUCTURE_TYPE_SHADER_CREATE_INFO_EXT,
@@ -560,6 +1113,11 @@ std::vector<VkShaderEXT> createShaderObjects(VkDevice vkDevice, std::span<char>
             .codeSize = vertexCode.size(),
             .pCode = vertexCode.data(),
             .pName = "main",
+            .setLayoutCount = (uint32_t)aSetLayouts.size(),
+            .pSetLayouts = aSetLayouts.data(),
+            .pushConstantRangeCount = (uint32_t)aPushConstantRanges.size(),
+            .pPushConstantRanges = aPushConstantRanges.data(),
+            .pSpecializationInfo = vertexSpecialization.get(),
         },
         VkShaderCreateInfoEXT{
             .sType = VK_STRUCTURE_TYPE_SHADER_CREATE_INFO_EXT,
@@ -569,20 +1127,95 @@ std::vector<VkShaderEXT> createShaderObjects(VkDevice vkDevice, std::span<char>
             .codeSize = fragmentCode.size(),
             .pCode = fragmentCode.data(),
             .pName = "main",
+            .setLayoutCount = (uint32_t)aSetLayouts.size(),
+            .pSetLayouts = aSetLayouts.data(),
+            .pushConstantRangeCount = (uint32_t)aPushConstantRanges.size(),
+            .pPushConstantRanges = aPushConstantRanges.data(),
+            .pSpecializationInfo = fragmentSpecialization.get(),
         }
     };
     const uint32_t shaderCount = std::size(shaderCreateInfoEXTs);
     std::vector<VkShaderEXT> vkShaderEXTs(shaderCount);
-    assertVkSuccess(
-        vkCreateShadersEXT(vkDevice,
-                           shaderCount,
-                           shaderCreateInfoEXTs,
-                           pAllocator,
-                           vkShaderEXTs.data()));
+    if(aBinaryCache != nullptr)
+    {
+        assertVkSuccess(aBinaryCache->createShaders(vkDevice, shaderCreateInfoEXTs, vkShaderEXTs.data()));
+    }
+    else
+    {
+        assertVkSuccess(
+            vkCreateShadersEXT(vkDevice,
+                               shaderCount,
+                               shaderCreateInfoEXTs,
+                               pAllocator,
+                               vkShaderEXTs.data()));
+    }
     return vkShaderEXTs;
 }
 
 
+/// @param aPushConstantRanges When empty, the ranges are reflected from the shader code.
+/// @param aBinaryCache Optional, reuses the implementation binary from a previous run when available.
+VkShaderEXT createComputeShaderObject(VkDevice vkDevice,
+                                      std::span<const char> computeCode,
+                                      std::span<const VkPushConstantRange> aPushConstantRanges = {},
+                                      ShaderBinaryCache * aBinaryCache = nullptr)
+{
+    std::vector<VkPushConstantRange> reflectedRanges;
+    if(aPushConstantRanges.empty())
+    {
+        const ShaderReflection * shaders[]{&getReflection(computeCode)};
+        reflectedRanges = getPushConstantRanges(shaders);
+        aPushConstantRanges = reflectedRanges;
+    }
+
+    VkShaderCreateInfoEXT shaderCreateInfoEXT{
+        .sType = VK_STRUCTURE_TYPE_SHADER_CREATE_INFO_EXT,
+        .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+        .codeType = VK_SHADER_CODE_TYPE_SPIRV_EXT,
+        .codeSize = computeCode.size(),
+        .pCode = computeCode.data(),
+        .pName = "main",
+        .pushConstantRangeCount = (uint32_t)aPushConstantRanges.size(),
+        .pPushConstantRanges = aPushConstantRanges.data(),
+    };
+    VkShaderEXT vkShaderEXT;
+    if(aBinaryCache != nullptr)
+    {
+        assertVkSuccess(aBinaryCache->createShaders(vkDevice, {&shaderCreateInfoEXT, 1}, &vkShaderEXT));
+    }
+    else
+    {
+        assertVkSuccess(vkCreateShadersEXT(vkDevice, 1, &shaderCreateInfoEXT, pAllocator, &vkShaderEXT));
+    }
+    return vkShaderEXT;
+}
+
+
+/// @brief Pipeline layout with push constants only, notably used by vkCmdPushConstants() with shader objects.
+VkPipelineLayout createPushConstantLayout(VkDevice vkDevice, std::span<const VkPushConstantRange> aPushConstantRanges)
+{
+    VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = 0,
+        .pushConstantRangeCount = (uint32_t)aPushConstantRanges.size(),
+        .pPushConstantRanges = aPushConstantRanges.data(),
+    };
+    VkPipelineLayout vkPipelineLayout;
+    assertVkSuccess(vkCreatePipelineLayout(vkDevice, &pipelineLayoutCreateInfo, pAllocator, &vkPipelineLayout));
+    return vkPipelineLayout;
+}
+
+
+VkDeviceAddress getBufferDeviceAddress(VkDevice vkDevice, VkBuffer aBuffer)
+{
+    VkBufferDeviceAddressInfo bufferDeviceAddressInfo{
+        .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+        .buffer = aBuffer,
+    };
+    return vkGetBufferDeviceAddress(vkDevice, &bufferDeviceAddressInfo);
+}
+
+
 Swapchain prepareSwapchain(VkPhysicalDevice vkPhysicalDevice,
                            VkDevice vkDevice,
                            VkSurfaceKHR vkSurface,
@@ -649,42 +1282,101 @@ Swapchain prepareSwapchain(VkPhysicalDevice vkPhysicalDevice,
 };
 
 
-std::pair<VkBuffer, VkDeviceMemory> prepareVertexBuffer(VkDevice vkDevice, std::size_t vertexDataSize, uint32_t deviceLocalMemoryTypeIndex)
+std::pair<VkBuffer, VkDeviceMemory> createBuffer(VkDevice vkDevice,
+                                                 std::size_t aSize,
+                                                 VkBufferUsageFlags aUsage,
+                                                 uint32_t aMemoryTypeIndex,
+                                                 VkMemoryAllocateFlags aAllocateFlags = 0)
 {
-    VkBufferCreateInfo vertexBufferCreateInfo{
+    VkBufferCreateInfo bufferCreateInfo{
         .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-        .size = vertexDataSize,
-        .usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT
-                 // TODO: confirm that memory mapped write are not considered transfer_dst operations
-                 //| VK_BUFFER_USAGE_TRANSFER_DST_BIT 
+        .size = aSize,
+        .usage = aUsage,
+        // Queue family ownership is explicitly transferred when the buffer is used by several families
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
     };
-    VkBuffer vkVertexBuffer;
-    vkCreateBuffer(vkDevice, &vertexBufferCreateInfo, pAllocator, &vkVertexBuffer);
+    VkBuffer vkBuffer;
+    assertVkSuccess(vkCreateBuffer(vkDevice, &bufferCreateInfo, pAllocator, &vkBuffer));
 
-    VkMemoryRequirements vkVertexMemoryRequirements;
-    vkGetBufferMemoryRequirements(vkDevice, vkVertexBuffer, &vkVertexMemoryRequirements);
+    VkMemoryRequirements vkMemoryRequirements;
+    vkGetBufferMemoryRequirements(vkDevice, vkBuffer, &vkMemoryRequirements);
 
     {
-        // TODO: confirm this understanding of vkVertexMemoryRequirements.memoryTypeBits
-        uint32_t selectedMemoryTypeBit = 0b1 << deviceLocalMemoryTypeIndex;
-        assert((vkVertexMemoryRequirements.memoryTypeBits & selectedMemoryTypeBit)
+        // memoryTypeBits has a bit set for each memory type index supported for the resource
+        uint32_t selectedMemoryTypeBit = 0b1 << aMemoryTypeIndex;
+        assert((vkMemoryRequirements.memoryTypeBits & selectedMemoryTypeBit)
                == selectedMemoryTypeBit);
     }
 
+    // Notably required for VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+    VkMemoryAllocateFlagsInfo memoryAllocateFlagsInfo{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO,
+        .flags = aAllocateFlags,
+    };
+
     VkMemoryAllocateInfo memoryAllocateInfo{
         .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .allocationSize = vkVertexMemoryRequirements.size,
-        .memoryTypeIndex = deviceLocalMemoryTypeIndex,
+        .pNext = &memoryAllocateFlagsInfo,
+        .allocationSize = vkMemoryRequirements.size,
+        .memoryTypeIndex = aMemoryTypeIndex,
     };
-    VkDeviceMemory vkVertexDeviceMemory;
-    vkAllocateMemory(vkDevice, &memoryAllocateInfo, pAllocator, &vkVertexDeviceMemory);
+    VkDeviceMemory vkDeviceMemory;
+    assertVkSuccess(vkAllocateMemory(vkDevice, &memoryAllocateInfo, pAllocator, &vkDeviceMemory));
+
+    assertVkSuccess(vkBindBufferMemory(vkDevice, vkBuffer, vkDeviceMemory, 0));
+
+    return {vkBuffer, vkDeviceMemory};
+}
+
+
+/// @brief Creates the image with its own dedicated allocation.
+std::pair<VkImage, VkDeviceMemory> createImage(VkDevice vkDevice,
+                                               const VkImageCreateInfo & aCreateInfo,
+                                               uint32_t aMemoryTypeIndex)
+{
+    VkImage vkImage;
+    assertVkSuccess(vkCreateImage(vkDevice, &aCreateInfo, pAllocator, &vkImage));
 
-    vkBindBufferMemory(vkDevice, vkVertexBuffer, vkVertexDeviceMemory, 0);
+    VkMemoryRequirements vkMemoryRequirements;
+    vkGetImageMemoryRequirements(vkDevice, vkImage, &vkMemoryRequirements);
+    assert((vkMemoryRequirements.memoryTypeBits & (0b1 << aMemoryTypeIndex)) != 0);
 
-    return {vkVertexBuffer, vkVertexDeviceMemory};
+    VkMemoryAllocateInfo memoryAllocateInfo{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .allocationSize = vkMemoryRequirements.size,
+        .memoryTypeIndex = aMemoryTypeIndex,
+    };
+    VkDeviceMemory vkDeviceMemory;
+    assertVkSuccess(vkAllocateMemory(vkDevice, &memoryAllocateInfo, pAllocator, &vkDeviceMemory));
+
+    assertVkSuccess(vkBindImageMemory(vkDevice, vkImage, vkDeviceMemory, 0));
+
+    return {vkImage, vkDeviceMemory};
+}
+
+
+std::pair<VkBuffer, VkDeviceMemory> prepareVertexBuffer(VkDevice vkDevice, std::size_t vertexDataSize, uint32_t deviceLocalMemoryTypeIndex)
+{
+    return createBuffer(vkDevice,
+                        vertexDataSize,
+                        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT
+                        // Destination of the copy from the staging buffer
+                        | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                        deviceLocalMemoryTypeIndex);
 }
 
 
+/// @brief Queues, and the memory types, required to move data between host and device local memory.
+struct TransferContext
+{
+    VkDevice vkDevice;
+    const QueueSelection & mQueueSelection;
+    Queues mQueues;
+    // Host visible and coherent memory, for staging buffers
+    uint32_t mStagingMemoryTypeIndex;
+};
+
+
 VkViewport getViewport(VkExtent2D aSurfaceExtent)
 {
     // Note: the viewport coordinate system is top-left origin (Y going down),
@@ -713,7 +1405,8 @@ VkViewport getViewport(VkExtent2D aSurfaceExtent)
 }
 
 
-void setDynamicPipelineState(VkCommandBuffer vkCommandBuffer, VkExtent2D aSurfaceExtent)
+/// @brief Covers the whole surface, for both the shader objects and the pipelines (which make it dynamic).
+void setViewportAndScissor(VkCommandBuffer vkCommandBuffer, VkExtent2D aSurfaceExtent)
 {
     VkViewport vkViewport = getViewport(aSurfaceExtent);
     vkCmdSetViewportWithCount(vkCommandBuffer, 1, &vkViewport);
@@ -722,6 +1415,12 @@ void setDynamicPipelineState(VkCommandBuffer vkCommandBuffer, VkExtent2D aSurfac
         .extent = aSurfaceExtent,
     };
     vkCmdSetScissorWithCount(vkCommandBuffer, 1, &scissor);
+}
+
+
+void setDynamicPipelineState(VkCommandBuffer vkCommandBuffer, VkExtent2D aSurfaceExtent)
+{
+    setViewportAndScissor(vkCommandBuffer, aSurfaceExtent);
 
     vkCmdSetRasterizerDiscardEnable(vkCommandBuffer, VK_FALSE);
 
@@ -805,213 +1504,146 @@ std::vector<VkFramebuffer> createFramebuffers(VkDevice vkDevice, VkRenderPass vk
 }
 
 
-VkPipeline createStaticPipeline(VkDevice vkDevice,
-                                const Swapchain & swapchain,
-                                VkRenderPass vkRenderPass,
-                                std::span<char> vertexCode,
-                                std::span<char> fragmentCode)
+/// @brief Vertex input bindings and attributes, usable by both the static pipeline and `vkCmdSetVertexInputEXT()`.
+struct VertexInputDescription
 {
-    //
-    // Shaders
-    //
-    std::array<VkShaderModuleCreateInfo, 2> shaderModuleCreateInfoArray{{
-        {
-            .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-            .codeSize = vertexCode.size(),
-            .pCode = reinterpret_cast<const uint32_t *>(vertexCode.data()),
-        },
-        {
-            .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-            .codeSize = fragmentCode.size(),
-            .pCode = reinterpret_cast<const uint32_t *>(fragmentCode.data()),
-        },
-    }};
-    
-    std::array<VkShaderModule, 2> shaderModuleArray;
-    vkCreateShaderModule(vkDevice, &shaderModuleCreateInfoArray[0], pAllocator, &shaderModuleArray[0]);
-    vkCreateShaderModule(vkDevice, &shaderModuleCreateInfoArray[1], pAllocator, &shaderModuleArray[1]);
+    std::vector<VkVertexInputBindingDescription> mBindings;
+    std::vector<VkVertexInputAttributeDescription> mAttributes;
 
-    std::array<VkPipelineShaderStageCreateInfo, 2> stageCreateInfoArray{{
+    // Extremely similar to the static pipeline descriptions, but dynamic state uses the 2EXT versions.
+    std::vector<VkVertexInputBindingDescription2EXT> getBindings2EXT() const
+    {
+        std::vector<VkVertexInputBindingDescription2EXT> result;
+        for(const VkVertexInputBindingDescription & binding : mBindings)
         {
-            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-            .stage = VK_SHADER_STAGE_VERTEX_BIT,
-            .module = shaderModuleArray[0],
-            .pName = "main",
-        },
+            result.push_back({
+                .sType = VK_STRUCTURE_TYPE_VERTEX_INPUT_BINDING_DESCRIPTION_2_EXT,
+                .binding = binding.binding,
+                .stride = binding.stride,
+                .inputRate = binding.inputRate,
+                // Must be 1 without the vertexAttributeInstanceRateDivisor feature
+                .divisor = 1,
+            });
+        }
+        return result;
+    }
+
+    std::vector<VkVertexInputAttributeDescription2EXT> getAttributes2EXT() const
+    {
+        std::vector<VkVertexInputAttributeDescription2EXT> result;
+        for(const VkVertexInputAttributeDescription & attribute : mAttributes)
         {
-            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-            .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
-            .module = shaderModuleArray[1],
-            .pName = "main",
-        },
-    }};
+            result.push_back({
+                .sType = VK_STRUCTURE_TYPE_VERTEX_INPUT_ATTRIBUTE_DESCRIPTION_2_EXT,
+                .location = attribute.location,
+                .binding = attribute.binding,
+                .format = attribute.format,
+                .offset = attribute.offset,
+            });
+        }
+        return result;
+    }
+};
 
-    // 
-    // Vertex Input and Assembly (Vertex input state)
-    //
+// Binding numbers of the vertex input streams
+constexpr uint32_t gVertexBinding = 1;
+constexpr uint32_t gInstanceBinding = 2;
 
-    // Extremely similar to the equivalent dynamic rendering descriptions
-    // but they use the 2EXT version.
-    VkVertexInputBindingDescription vertexInputBindingDescriptions[]{
-        {
-            .binding = 1,
-            .stride = sizeof(Vertex),
-            .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
+/// @brief Describes the per-vertex attributes for Forward.vert, stored according to aVertexLayout,
+/// and optionally the per-instance `InstanceData` attributes for ForwardInstanced.vert
+VertexInputDescription getVertexInputDescription(const VertexLayout & aVertexLayout, bool aInstanced)
+{
+    // Describe the single per-vertex binding, used by all interleaved attributes
+    VertexInputDescription result{
+        .mBindings{
+            {
+                .binding = gVertexBinding,
+                .stride = aVertexLayout.getStride(),
+                .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
+            },
         },
+        .mAttributes = aVertexLayout.getAttributeDescriptions(gVertexBinding),
     };
 
-    VkVertexInputAttributeDescription vertexInputAttributeDescription[]{
-        {
-            .location = 1,
-            .binding = 1,
-            .format = VK_FORMAT_R32G32B32_SFLOAT,
-            .offset = 0,
-        },
+    if(aInstanced)
+    {
+        // The per-instance binding advances once per instance, instead of once per vertex.
+        result.mBindings.push_back({
+            .binding = gInstanceBinding,
+            .stride = sizeof(InstanceData),
+            .inputRate = VK_VERTEX_INPUT_RATE_INSTANCE,
+        });
+        // The transform rows each consume a location
+        for(uint32_t rowIdx = 0; rowIdx != 4; ++rowIdx)
         {
-            .location = 2,
-            .binding = 1,
-            .format = VK_FORMAT_R32G32B32_SFLOAT,
-            .offset = offsetof(Vertex, mColor),
-        },
-    };
-
-    VkPipelineVertexInputStateCreateInfo pipelineVertexInputStateCreateInfo{
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
-        .vertexBindingDescriptionCount = std::size(vertexInputBindingDescriptions),
-        .pVertexBindingDescriptions = vertexInputBindingDescriptions,
-        .vertexAttributeDescriptionCount = std::size(vertexInputAttributeDescription),
-        .pVertexAttributeDescriptions = vertexInputAttributeDescription,
-    };
-
-    VkPipelineInputAssemblyStateCreateInfo pipelineInputAssemblyStateCreateInfo{
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
-        .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP,
-        .primitiveRestartEnable = VK_FALSE,
-    };
-    
-    //
-    // Viewport
-    //
-    VkViewport vkViewport = getViewport(swapchain.imageExtent);
-
-    VkRect2D scissor{
-        .extent = swapchain.imageExtent,
-    };
-
-    VkPipelineViewportStateCreateInfo pipelineViewportStateCreateInfo{
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
-        .viewportCount = 1,
-        .pViewports = &vkViewport,
-        .scissorCount = 1,
-        .pScissors = &scissor,
-    };
-
-
-    //
-    // Rasterization, multisample, depth-stencil
-    //
-    VkPipelineRasterizationStateCreateInfo pipelineRasterizationStateCreateInfo{
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
-        .depthClampEnable = VK_FALSE,
-        .rasterizerDiscardEnable = VK_FALSE,
-        .polygonMode = VK_POLYGON_MODE_FILL,
-        .cullMode = VK_CULL_MODE_BACK_BIT,
-        .frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE,
-        .depthBiasEnable = VK_FALSE,
-        .lineWidth = 1.0f,
-    };
+            result.mAttributes.push_back({
+                .location = 3 + rowIdx,
+                .binding = gInstanceBinding,
+                .format = VK_FORMAT_R32G32B32A32_SFLOAT,
+                .offset = (uint32_t)(offsetof(InstanceData, mTransformRows) + rowIdx * sizeof(InstanceData::mTransformRows[0])),
+            });
+        }
+        result.mAttributes.push_back({
+            .location = 7,
+            .binding = gInstanceBinding,
+            .format = VK_FORMAT_R32G32B32A32_SFLOAT,
+            .offset = offsetof(InstanceData, mColor),
+        });
+    }
 
-    VkSampleMask sampleMask = VK_SAMPLE_COUNT_1_BIT;
-    VkPipelineMultisampleStateCreateInfo pipelineMultisampleStateCreateInfo{
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
-        .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
-        .sampleShadingEnable = VK_FALSE,
-        .minSampleShading = 0, // Useless as we disabled sample shading altogether
-        .pSampleMask = &sampleMask,
-        .alphaToCoverageEnable = VK_FALSE,
-        .alphaToOneEnable = VK_FALSE,
-    };
-
-    VkPipelineDepthStencilStateCreateInfo pipelineDepthStencilStateCreateInfo{
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,    
-        .depthTestEnable = VK_TRUE,
-        .depthWriteEnable = VK_TRUE,
-        .depthCompareOp = VK_COMPARE_OP_LESS,
-        .depthBoundsTestEnable = VK_FALSE,
-        .stencilTestEnable = VK_FALSE,
-    };
-
-    //
-    // Color blend
-    //
-    VkPipelineColorBlendAttachmentState pipelineColorBlendAttachmentState{
-        .blendEnable = VK_FALSE,
-        .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
-    };
-    VkPipelineColorBlendStateCreateInfo pipelineColorBlendStateCreateInfo{
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
-        .logicOpEnable = VK_FALSE,
-        .attachmentCount = 1,
-        .pAttachments = &pipelineColorBlendAttachmentState,
-    };
+    return result;
+}
 
-    //
-    // Pipeline layout
-    //
-    VkPipelineLayout vkPipelineLayout;
-    VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-        .setLayoutCount = 0, 
-        .pushConstantRangeCount = 0,
-    };
-    vkCreatePipelineLayout(vkDevice, &pipelineLayoutCreateInfo, pAllocator, &vkPipelineLayout);
-
-    VkGraphicsPipelineCreateInfo graphicsPipelineCreateInfo{
-        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
-        .stageCount = stageCreateInfoArray.size(),
-        .pStages = stageCreateInfoArray.data(),
-        .pVertexInputState = &pipelineVertexInputStateCreateInfo,
-        .pInputAssemblyState = &pipelineInputAssemblyStateCreateInfo,
-        .pTessellationState = NULL,
-        .pViewportState = &pipelineViewportStateCreateInfo,
-        .pRasterizationState = &pipelineRasterizationStateCreateInfo,
-        .pMultisampleState = &pipelineMultisampleStateCreateInfo,
-        .pDepthStencilState = &pipelineDepthStencilStateCreateInfo,
-        .pColorBlendState = &pipelineColorBlendStateCreateInfo,
-        .pDynamicState = NULL, // We could actually set dynamic state here, to reuse the setDynamicPipelineState() helper
-        .layout = vkPipelineLayout,
-        .renderPass = vkRenderPass,
-        .subpass = 0, // subpass index
-    };
 
-    VkPipeline vkPipeline;
-    vkCreateGraphicsPipelines(
-        vkDevice,
-        VK_NULL_HANDLE,
-        1,
-        &graphicsPipelineCreateInfo,
-        pAllocator,
-        &vkPipeline);
+/// @brief Throws if aVertexInput does not provide every input location consumed by aVertexShader,
+/// with a compatible numeric type.
+void assertVertexInputMatches(const ShaderReflection & aVertexShader, const VertexInputDescription & aVertexInput)
+{
+    for(const ShaderReflection::InterfaceVariable & input : aVertexShader.mInputs)
+    {
+        auto found = std::ranges::find(aVertexInput.mAttributes, input.mLocation,
+                                       &VkVertexInputAttributeDescription::location);
+        if(found == aVertexInput.mAttributes.end())
+        {
+            throw std::logic_error{"Vertex input location " + std::to_string(input.mLocation)
+                                   + " (" + input.mName + ") is not provided."};
+        }
+        if(getNumericType(found->format) != getNumericType(input.mFormat))
+        {
+            throw std::logic_error{"Vertex input location " + std::to_string(input.mLocation)
+                                   + " (" + input.mName + ") has a mismatched numeric type."};
+        }
+    }
+}
 
-    // Above Vulkan 1.3, layout must not be accessed outside the creation command
-    vkDestroyPipelineLayout(vkDevice, vkPipelineLayout, pAllocator);
 
-    // Note: shader modules can be destroyed while pipelines using its shaders are still in use.
-    for(VkShaderModule shaderModule : shaderModuleArray)
+/// @brief Throws if aShaders do not declare the same descriptor set bindings and push constant ranges as aLayout,
+/// e.g. hot-reloaded shaders which must keep the layout their draws are recorded with.
+/// @param aLayout Acquired from a registry: the layouts of aShaders are acquired from it too,
+/// so that identical layouts are the same handles.
+/// @throw std::logic_error if the layouts differ, std::invalid_argument if aShaders have no valid layout.
+void assertLayoutMatches(VkDevice vkDevice,
+                         std::span<const ShaderReflection * const> aShaders,
+                         const ReflectedLayout & aLayout,
+                         BindlessBackend aBindlessBackend = BindlessBackend::DescriptorSets)
+{
+    if(aLayout.mRegistry == nullptr)
     {
-        vkDestroyShaderModule(vkDevice, shaderModule, pAllocator);
+        throw std::invalid_argument{"The reference layout must be acquired from a registry."};
+    }
+    ReflectedLayout layout = createReflectedLayout(vkDevice, aShaders, aLayout.mRegistry, aBindlessBackend);
+    // The pipeline layout is keyed by its set layouts and push constant ranges
+    const bool matches = layout.mPipelineLayout == aLayout.mPipelineLayout;
+    layout.destroy();
+    if(!matches)
+    {
+        throw std::logic_error{"The descriptor bindings or push constants of the shaders do not match their layout."};
     }
-
-    return vkPipeline;
 }
 
 
-void destroyPipelineAndFramebuffers(VkDevice vkDevice, VkPipeline vkPipeline, std::span<VkFramebuffer> framebuffers)
+void destroyFramebuffers(VkDevice vkDevice, std::span<VkFramebuffer> framebuffers)
 {
-    // Pipeline
-    vkDestroyPipeline(vkDevice, vkPipeline, pAllocator);
-
-    // Render pass and framebuffers
     for(VkFramebuffer framebuffer : framebuffers)
     {
         vkDestroyFramebuffer(vkDevice, framebuffer, pAllocator);
@@ -16,6 +16,10 @@
 #include <windows.h>
 
 
+// Host memory allocator, passed to all creation and destruction functions
+VkAllocationCallbacks * const pAllocator = nullptr;
+
+
 // Functions prototypes, as function pointers
 PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr;
 #define D(functionName) PFN_ ## functionName functionName
@@ -30,6 +34,7 @@ PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr;
     D(vkGetPhysicalDeviceFeatures2);
     D(vkGetPhysicalDeviceMemoryProperties2);
     D(vkGetPhysicalDeviceQueueFamilyProperties2);
+    D(vkEnumerateDeviceExtensionProperties);
     D(vkCreateDevice);
     D(vkGetPhysicalDeviceSurfaceCapabilitiesKHR);
     // VK_KHR_surface
@@ -37,6 +42,7 @@ PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr;
     D(vkGetPhysicalDeviceSurfaceFormatsKHR);
     // VK_KHR_win32_surface
     D(vkCreateWin32SurfaceKHR);
+    D(vkGetPhysicalDeviceWin32PresentationSupportKHR);
     // VK_EXT_debug_utils
     D(vkCreateDebugUtilsMessengerEXT);
     D(vkDestroyDebugUtilsMessengerEXT);
@@ -66,6 +72,12 @@ PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr;
     D(vkCreateImageView);
     D(vkDestroyImageView);
     D(vkCmdDraw);
+    D(vkCmdDrawIndexed);
+    D(vkCmdDrawIndexedIndirectCount);
+    D(vkCmdBindIndexBuffer);
+    D(vkCmdDispatch);
+    D(vkCmdPushConstants);
+    D(vkCmdFillBuffer);
     D(vkCmdSetViewportWithCount);
     D(vkCmdSetScissorWithCount);
     D(vkCmdSetRasterizerDiscardEnable);
@@ -104,8 +116,14 @@ PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr;
     D(vkFreeMemory);
     D(vkGetBufferMemoryRequirements);
     D(vkBindBufferMemory);
+    D(vkGetBufferDeviceAddress);
     D(vkMapMemory);
     D(vkUnmapMemory);
+    D(vkCmdCopyBuffer);
+    D(vkCmdCopyBufferToImage);
+    D(vkResetCommandBuffer);
+    D(vkWaitSemaphores);
+    D(vkGetSemaphoreCounterValue);
     D(vkCreateRenderPass);
     D(vkDestroyRenderPass);
     D(vkCreateFramebuffer);
@@ -114,11 +132,26 @@ PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr;
     D(vkCmdEndRenderPass);
     D(vkCreateGraphicsPipelines);
     D(vkDestroyPipeline);
+    D(vkCreatePipelineCache);
+    D(vkDestroyPipelineCache);
     D(vkCreateShaderModule);
     D(vkDestroyShaderModule);
     D(vkCreatePipelineLayout);
     D(vkDestroyPipelineLayout);
+    D(vkCreateDescriptorSetLayout);
+    D(vkDestroyDescriptorSetLayout);
     D(vkCmdBindPipeline);
+    D(vkCreateDescriptorPool);
+    D(vkDestroyDescriptorPool);
+    D(vkAllocateDescriptorSets);
+    D(vkUpdateDescriptorSets);
+    D(vkCmdBindDescriptorSets);
+    D(vkCreateImage);
+    D(vkDestroyImage);
+    D(vkGetImageMemoryRequirements);
+    D(vkBindImageMemory);
+    D(vkCreateSampler);
+    D(vkDestroySampler);
 
     // VK_KHR_swapchain
     D(vkCreateSwapchainKHR);
@@ -132,9 +165,16 @@ PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr;
     // VK_EXT_shader_object
     D(vkCreateShadersEXT);
     D(vkDestroyShaderEXT);
+    D(vkGetShaderBinaryDataEXT);
     D(vkCmdBindShadersEXT);
     D(vkCmdSetVertexInputEXT);
     D(vkCmdBindVertexBuffers);
+    // VK_EXT_descriptor_buffer
+    D(vkGetDescriptorSetLayoutSizeEXT);
+    D(vkGetDescriptorSetLayoutBindingOffsetEXT);
+    D(vkGetDescriptorEXT);
+    D(vkCmdBindDescriptorBuffersEXT);
+    D(vkCmdSetDescriptorBufferOffsetsEXT);
 #undef D
 
 
@@ -180,6 +220,7 @@ void initializeForInstance(VkInstance aInstance)
     D(vkGetPhysicalDeviceFeatures2);
     D(vkGetPhysicalDeviceMemoryProperties2);
     D(vkGetPhysicalDeviceQueueFamilyProperties2);
+    D(vkEnumerateDeviceExtensionProperties);
     D(vkCreateDevice);
     D(vkGetPhysicalDeviceSurfaceCapabilitiesKHR);
 
@@ -187,6 +228,7 @@ void initializeForInstance(VkInstance aInstance)
     D(vkGetPhysicalDeviceSurfaceFormatsKHR);
 
     D(vkCreateWin32SurfaceKHR);
+    D(vkGetPhysicalDeviceWin32PresentationSupportKHR);
 
     D(vkCreateDebugUtilsMessengerEXT);
     D(vkDestroyDebugUtilsMessengerEXT);
@@ -224,6 +266,12 @@ void initializeForDevice(VkDevice aDevice)
     D(vkCreateImageView);
     D(vkDestroyImageView);
     D(vkCmdDraw);
+    D(vkCmdDrawIndexed);
+    D(vkCmdDrawIndexedIndirectCount);
+    D(vkCmdBindIndexBuffer);
+    D(vkCmdDispatch);
+    D(vkCmdPushConstants);
+    D(vkCmdFillBuffer);
     D(vkCmdSetViewportWithCount);
     D(vkCmdSetScissorWithCount);
     D(vkCmdSetRasterizerDiscardEnable);
@@ -262,8 +310,14 @@ void initializeForDevice(VkDevice aDevice)
     D(vkFreeMemory);
     D(vkGetBufferMemoryRequirements);
     D(vkBindBufferMemory);
+    D(vkGetBufferDeviceAddress);
     D(vkMapMemory);
     D(vkUnmapMemory);
+    D(vkCmdCopyBuffer);
+    D(vkCmdCopyBufferToImage);
+    D(vkResetCommandBuffer);
+    D(vkWaitSemaphores);
+    D(vkGetSemaphoreCounterValue);
     D(vkCreateRenderPass);
     D(vkDestroyRenderPass);
     D(vkCreateFramebuffer);
@@ -272,11 +326,26 @@ void initializeForDevice(VkDevice aDevice)
     D(vkCmdEndRenderPass);
     D(vkCreateGraphicsPipelines);
     D(vkDestroyPipeline);
+    D(vkCreatePipelineCache);
+    D(vkDestroyPipelineCache);
     D(vkCreateShaderModule);
     D(vkDestroyShaderModule);
     D(vkCreatePipelineLayout);
     D(vkDestroyPipelineLayout);
+    D(vkCreateDescriptorSetLayout);
+    D(vkDestroyDescriptorSetLayout);
     D(vkCmdBindPipeline);
+    D(vkCreateDescriptorPool);
+    D(vkDestroyDescriptorPool);
+    D(vkAllocateDescriptorSets);
+    D(vkUpdateDescriptorSets);
+    D(vkCmdBindDescriptorSets);
+    D(vkCreateImage);
+    D(vkDestroyImage);
+    D(vkGetImageMemoryRequirements);
+    D(vkBindImageMemory);
+    D(vkCreateSampler);
+    D(vkDestroySampler);
 
     D(vkCreateSwapchainKHR);
     D(vkDestroySwapchainKHR);
@@ -289,8 +358,15 @@ void initializeForDevice(VkDevice aDevice)
 
     D(vkCreateShadersEXT);
     D(vkDestroyShaderEXT);
+    D(vkGetShaderBinaryDataEXT);
     D(vkCmdBindShadersEXT);
     D(vkCmdSetVertexInputEXT);
     D(vkCmdBindVertexBuffers);
+    // VK_EXT_descriptor_buffer
+    D(vkGetDescriptorSetLayoutSizeEXT);
+    D(vkGetDescriptorSetLayoutBindingOffsetEXT);
+    D(vkGetDescriptorEXT);
+    D(vkCmdBindDescriptorBuffersEXT);
+    D(vkCmdSetDescriptorBufferOffsetsEXT);
 #undef D
 }
\ No newline at end of file
@@ -0,0 +1,150 @@
+#pragma once
+
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <latch>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/// @brief Fixed set of threads executing the submitted jobs, in submission order.
+/// Jobs still queued on destruction are executed before the threads are joined.
+class WorkerPool
+{
+public:
+    /// @param aThreadCount Defaults to the hardware threads, minus the one running the render loop.
+    explicit WorkerPool(unsigned int aThreadCount = std::max(2u, std::thread::hardware_concurrency()) - 1)
+    {
+        for(unsigned int threadIdx = 0; threadIdx != aThreadCount; ++threadIdx)
+        {
+            mThreads.emplace_back([this]{ run(); });
+        }
+    }
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard lock{mMutex};
+            mStopping = true;
+        }
+        mCondition.notify_all();
+        for(std::thread & thread : mThreads)
+        {
+            thread.join();
+        }
+    }
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool & operator=(const WorkerPool &) = delete;
+
+    /// @note Jobs must not throw, they are responsible for reporting their own errors.
+    void submit(std::function<void()> aJob)
+    {
+        {
+            std::lock_guard lock{mMutex};
+            mJobs.push_back(std::move(aJob));
+        }
+        mCondition.notify_one();
+    }
+
+    std::size_t getThreadCount() const
+    {
+        return mThreads.size();
+    }
+
+private:
+    void run()
+    {
+        for(;;)
+        {
+            std::function<void()> job;
+            {
+                std::unique_lock lock{mMutex};
+                mCondition.wait(lock, [this]{ return mStopping || !mJobs.empty(); });
+                // Only exits once the queue is drained
+                if(mJobs.empty())
+                {
+                    return;
+                }
+                job = std::move(mJobs.front());
+                mJobs.pop_front();
+            }
+            job();
+        }
+    }
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::deque<std::function<void()>> mJobs;
+    bool mStopping{false};
+    std::vector<std::thread> mThreads;
+};
+
+
+/// @brief Runs aJob(index) for each index in [0, aCount) on the workers and the calling thread, and waits for all of them.
+/// The calling thread claims indices like the workers do, so the loop completes even when the workers are busy
+/// with other jobs (or blocked), and it can be called from a job of aPool.
+/// The first exception thrown by a job is rethrown once all the jobs are finished.
+inline void parallelFor(WorkerPool & aPool, std::size_t aCount, const std::function<void(std::size_t)> & aJob)
+{
+    if(aCount == 0)
+    {
+        return;
+    }
+
+    // Shared with the helper jobs, which might only start after the loop is over, queued behind other jobs
+    struct Loop
+    {
+        explicit Loop(std::size_t aCount) :
+            mCount{aCount},
+            mFinished{(std::ptrdiff_t)aCount}
+        {}
+
+        const std::size_t mCount;
+        std::atomic<std::size_t> mNextIndex{0};
+        std::latch mFinished;
+        std::mutex mMutex;
+        std::exception_ptr mFirstException;
+    };
+    auto loop = std::make_shared<Loop>(aCount);
+
+    // aJob is only called for a claimed index, which is finished before parallelFor returns
+    auto claimIndices = [loop, &aJob]
+    {
+        for(std::size_t index = loop->mNextIndex++; index < loop->mCount; index = loop->mNextIndex++)
+        {
+            try
+            {
+                aJob(index);
+            }
+            catch(...)
+            {
+                std::lock_guard lock{loop->mMutex};
+                if(!loop->mFirstException)
+                {
+                    loop->mFirstException = std::current_exception();
+                }
+            }
+            loop->mFinished.count_down();
+        }
+    };
+
+    const std::size_t helperCount = std::min(aCount - 1, aPool.getThreadCount());
+    for(std::size_t helperIdx = 0; helperIdx != helperCount; ++helperIdx)
+    {
+        aPool.submit(claimIndices);
+    }
+    claimIndices();
+    loop->mFinished.wait();
+    if(loop->mFirstException)
+    {
+        std::rethrow_exception(loop->mFirstException);
+    }
+}
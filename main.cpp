@@ -2,24 +2,168 @@
 #define UNICODE
 #endif 
 
+// Prevents windows.h from defining min and max macros, which break std::min() and std::max()
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#include "BindlessDescriptors.h"
+#include "DrawParameters.h"
+#include "EmbeddedShader.h"
 #include "FileHelper.h"
+#include "FrustumCulling.h"
+#include "IndirectDraw.h"
+#include "Math.h"
+#include "MeshFile.h"
+#include "MeshLoader.h"
+#include "ObjectRegistry.h"
+#include "PipelineCache.h"
+#include "ShaderBinaryCache.h"
+#include "ShaderPack.h"
+#include "ShaderReloader.h"
+#include "ShaderVariant.h"
+#include "UploadService.h"
 #include "VertexData.h"
+#include "VertexLayout.h"
 #include "VulkanLoading.h"
 #include "VulkanHelpers.h"
 #include "WindowsHelpers.h"
+#include "WorkerPool.h"
+
+// Generated by the "embed shaders" build task (a dependency of "build project"), only required by gEmbeddedShaders
+#if __has_include("shaders/spirv/EmbeddedShaders.h")
+#include "shaders/spirv/EmbeddedShaders.h"
+#define HAS_EMBEDDED_SHADERS
+#endif
 
 #include <windows.h>
 
+#include <chrono>
+#include <algorithm>
+#include <array>
 #include <iostream>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
 #include <vector>
 
 #include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
 
 // Toggle between:
 // * false: Vulkan 1.0 style rendering, with Render Pass and Framebuffer objects, and a fully static graphics pipeline
 // * true: dynamic rendering (`vkCmdBeginRendering()`) with shader objects (no pipeline object).
 constexpr bool gDynamicRendering = false;
 
+// Objects scene (requires gDynamicRendering):
+// * 0: draws the single triangle
+// * otherwise: draws that many triangles, each with its own draw record, issued following gDrawPath
+//   (the indirect paths fall back to DrawPath::PerDrawCpuCulled without the drawIndirectFirstInstance feature)
+constexpr uint32_t gObjectCount = 0;
+constexpr DrawPath gDrawPath = DrawPath::IndirectCountCulled;
+static_assert(gObjectCount == 0 || gDynamicRendering, "The objects scene is implemented with shader objects.");
+
+// Instanced stress scene:
+// * 0: draws the single triangle
+// * otherwise: draws that many instances of the triangle in a single draw, with per-instance transform and color.
+//   The grid is seen by an orbiting camera: the instances are culled on the CPU each frame (see FrustumCulling.h),
+//   and the model-view-projection matrices of the visible ones are computed straight into the mapped instance buffer (see Math.h).
+constexpr uint32_t gInstanceCount = 0;
+static_assert(gInstanceCount == 0 || gObjectCount == 0, "Scenes are exclusive.");
+
+// Mesh drawn instead of the triangle, by the single draw and instanced scenes (see MeshFile.h):
+// * nullptr: the triangle
+// * otherwise: the path of a mesh file (produced by tools/ConvertMesh.cpp), streamed to the GPU in the background
+constexpr const char * gMeshFile = nullptr;
+static_assert(gMeshFile == nullptr || gObjectCount == 0, "The objects scene draws the triangle.");
+
+// Graphics pipeline creation (see PipelineCache.h):
+// * false: each state is compiled as a complete pipeline
+// * true: when VK_EXT_graphics_pipeline_library is supported, states are fast-linked from libraries,
+//   then replaced by an optimized link
+constexpr bool gPipelineLibraries = true;
+// Pipeline creation benchmark, when pipeline libraries are in use:
+// * 0: none
+// * otherwise: at startup, the forward state is created that many times as a complete pipeline,
+//   then as fast and optimized links of its libraries, and the average durations are printed (see measurePipelineCreation()).
+constexpr uint32_t gPipelineCreationRepetitions = 0;
+static_assert(gPipelineCreationRepetitions == 0 || gPipelineLibraries, "The benchmark links pipeline libraries.");
+
+// Shader hot-reload (see ShaderReloader.h):
+// * false: shaders are only loaded from the shader pack, at startup
+// * true: shaders/spirv is watched, the forward shaders modified while running (e.g. recompiled with glslang)
+//   are rebuilt in the background, then swapped in between two frames
+constexpr bool gShaderHotReload = false;
+
+// Shaders source (see EmbeddedShader.h):
+// * false: loaded from the shader pack, shaders/spirv/shaders.pack
+// * true: compiled into the executable by the "embed shaders" build task, startup does no shader file I/O
+//   (falls back to the pack when shaders/spirv/EmbeddedShaders.h was not generated)
+#if defined(HAS_EMBEDDED_SHADERS)
+constexpr bool gEmbeddedShaders = true;
+#else
+#pragma message("shaders/spirv/EmbeddedShaders.h is missing (see the \"embed shaders\" build task): the shaders are loaded from the pack.")
+constexpr bool gEmbeddedShaders = false;
+namespace embedded {
+    // Without the generated header, the shaders only come from the pack
+    constexpr std::array<EmbeddedShader, 0> gShaders{};
+} // namespace embedded
+#endif
+
+// Forward shaders variant (see ShaderVariant.h):
+// the features specialized in the shaders that are drawn with, e.g. ShaderFeature::Grayscale | ShaderFeature::UniformColor.
+// The variants listed in shaders/variants.txt are created at load time, so switching between them never compiles.
+constexpr VariantKey gShaderVariant = 0;
+
+// Vertex attributes storage (see VertexLayout.h):
+// * false: full precision, as declared by the `Vertex` struct
+// * true: quantized on load to gCompactVertexLayout, half the memory and fetch bandwidth
+constexpr bool gCompactVertices = true;
+
+// Bindless textures (see BindlessDescriptors.h):
+// * 0: the forward shaders use no descriptor
+// * otherwise: that many textures (views of the layers of a small array image) are registered in the bindless heap at startup,
+//   the forward fragment shader (Bindless.frag) samples the one whose slot is pushed as a constant, cycling through all of them.
+//   The descriptor set is bound once per command buffer, whatever the texture count.
+constexpr uint32_t gBindlessTextureCount = 0;
+static_assert(gBindlessTextureCount == 0 || gObjectCount == 0, "The objects scene shaders are not bindless.");
+// Where the bindless descriptors live:
+// * BindlessBackend::DescriptorSets: an update after bind descriptor set, written with vkUpdateDescriptorSets()
+// * BindlessBackend::DescriptorBuffer: a mapped buffer, written with vkGetDescriptorEXT(), when VK_EXT_descriptor_buffer is supported
+constexpr BindlessBackend gBindlessBackend = BindlessBackend::DescriptorSets;
+// Bindless textures re-registered each frame (e.g. streamed in), the average update time is printed to compare the backends.
+constexpr uint32_t gBindlessUpdatesPerFrame = 0;
+static_assert(gBindlessUpdatesPerFrame == 0 || gBindlessTextureCount != 0, "Updates require bindless textures.");
+
+// Per-draw parameters (see DrawParameters.h):
+// * 0: the single triangle
+// * otherwise: draws the triangle that many times, its vertex and index buffers bound once, each draw setting its own
+//   transform and color (ForwardDraw.vert). They do not fit in the push constants: they are written into the frame's
+//   parameter ring, and only their address is pushed.
+constexpr uint32_t gParameterDrawCount = 0;
+static_assert(gParameterDrawCount == 0 || (gObjectCount == 0 && gInstanceCount == 0 && gBindlessTextureCount == 0),
+              "Scenes are exclusive.");
+static_assert(gParameterDrawCount == 0 || gMeshFile == nullptr, "The parameter draws draw the triangle.");
+
+/// @note Must match the parameters in ForwardDraw.vert
+struct ForwardDrawParameters
+{
+    math::Mat4 mModel;
+    math::Mat4 mViewProjection;
+    std::array<float, 4> mColor;
+};
+static_assert(!isPushedParameter<ForwardDrawParameters>(), "The shader reads the parameters through their address.");
+
+/// @note Must match the push constants in Bindless.frag
+struct BindlessParameters
+{
+    uint32_t mTexture;
+    uint32_t mSampler;
+};
+
 VkInstance vkInstance;
 VkDevice vkDevice;
 
@@ -86,7 +230,23 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE, PWSTR pCmdLine, int nCmdShow
     VkPhysicalDevice vkPhysicalDevice = physicalDevices.front();
     assertPhysicalDeviceSupport(vkPhysicalDevice, gRequestedVulkanVersion); 
     QueueSelection queueSelection = pickQueueFamily(vkInstance, vkPhysicalDevice);
-    vkDevice = createDevice(vkInstance, vkPhysicalDevice, queueSelection);
+    const bool pipelineLibraries =
+        gPipelineLibraries && isDeviceExtensionSupported(vkPhysicalDevice, "VK_EXT_graphics_pipeline_library");
+    // Indirect draws address the object records through firstInstance, otherwise the objects are drawn by the CPU
+    VkPhysicalDeviceFeatures2 supportedFeatures2{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+    };
+    vkGetPhysicalDeviceFeatures2(vkPhysicalDevice, &supportedFeatures2);
+    const bool indirectDrawPath = gDrawPath == DrawPath::IndirectCount || gDrawPath == DrawPath::IndirectCountCulled;
+    const bool drawIndirectFirstInstance = supportedFeatures2.features.drawIndirectFirstInstance == VK_TRUE;
+    const DrawPath drawPath = indirectDrawPath && !drawIndirectFirstInstance ? DrawPath::PerDrawCpuCulled : gDrawPath;
+    const BindlessBackend bindlessBackend =
+        gBindlessBackend == BindlessBackend::DescriptorBuffer && !isDeviceExtensionSupported(vkPhysicalDevice, "VK_EXT_descriptor_buffer")
+            ? BindlessBackend::DescriptorSets
+            : gBindlessBackend;
+    vkDevice = createDevice(vkInstance, vkPhysicalDevice, queueSelection, pipelineLibraries,
+                            gBindlessTextureCount != 0, bindlessBackend == BindlessBackend::DescriptorBuffer,
+                            gObjectCount != 0 && indirectDrawPath && drawIndirectFirstInstance);
     initializeForDevice(vkDevice);
 
     // Get physical device properties
@@ -101,34 +261,23 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE, PWSTR pCmdLine, int nCmdShow
     vkGetPhysicalDeviceMemoryProperties2(vkPhysicalDevice, &vkPhysicalDeviceMemoryProperties2);
 
     // Get the first memory type index for device local memory
-    const VkMemoryPropertyFlags requiredMemoryTypeProperties = 
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-        | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT 
-        | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
-        ;
     const VkPhysicalDeviceMemoryProperties & memoryProperties = vkPhysicalDeviceMemoryProperties2.memoryProperties;
-    uint32_t deviceLocalMemoryTypeIndex = 0;
-    for(; deviceLocalMemoryTypeIndex != memoryProperties.memoryTypeCount; ++deviceLocalMemoryTypeIndex)
-    {
-        if((memoryProperties.memoryTypes[deviceLocalMemoryTypeIndex].propertyFlags & requiredMemoryTypeProperties)
-            == requiredMemoryTypeProperties )
-        {
-            break; // Found a suitable memory type
-        }
-    }
-    assert(deviceLocalMemoryTypeIndex < memoryProperties.memoryTypeCount);
-
-    // Retrieve the handle to a graphics queue
-    VkDeviceQueueInfo2 deviceQueueInfo2{
-        .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_INFO_2,
-        // TODO: handle that family index cleanly
-        .queueFamilyIndex = queueSelection.mQueueFamilyIndex,
-        // Only 1 queue requested at device creation
-        .queueIndex = 0,
+    const uint32_t deviceLocalMemoryTypeIndex =
+        findMemoryTypeIndex(memoryProperties, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    // Staging memory, written by the host and read by transfer commands
+    const uint32_t stagingMemoryTypeIndex =
+        findMemoryTypeIndex(memoryProperties, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    // Retrieve the handles to the selected queues
+    Queues queues = getQueues(vkDevice, queueSelection);
+    VkQueue vkQueue = queues.mGraphics;
+
+    const TransferContext transferContext{
+        .vkDevice = vkDevice,
+        .mQueueSelection = queueSelection,
+        .mQueues = queues,
+        .mStagingMemoryTypeIndex = stagingMemoryTypeIndex,
     };
-    VkQueue vkQueue;
-    vkGetDeviceQueue2(vkDevice, &deviceQueueInfo2, &vkQueue);
-    nameObject(vkDevice, vkQueue, "main_graphics");
 
     // Enumerate layers
     printEnumeratedLayers();
@@ -196,7 +345,7 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE, PWSTR pCmdLine, int nCmdShow
     VkCommandPoolCreateInfo commandPoolCreateInfo{
         .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
         .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
-        .queueFamilyIndex = queueSelection.mQueueFamilyIndex,
+        .queueFamilyIndex = queueSelection.mGraphics.mFamilyIndex,
     };
     vkCreateCommandPool(vkDevice, &commandPoolCreateInfo, pAllocator, &vkCommandPool);
 
@@ -223,29 +372,407 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE, PWSTR pCmdLine, int nCmdShow
                    ("signal_QueueSubmit_" + std::to_string(semaphoreIdx)).c_str());
     }
 
+    // Shader modules and layouts, shared through the registry by the pipelines and the bindless heap
+    ObjectRegistry objectRegistry{vkDevice};
+
+    // Bindless descriptors
+    // The forward shaders are then reflected with the bindless layout, which the heap's pipeline layout is compatible with.
+    std::optional<BindlessHeap> bindlessHeap;
+    if constexpr(gBindlessTextureCount != 0)
+    {
+        bindlessHeap.emplace(vkDevice, vkPhysicalDevice, objectRegistry, bindlessBackend, stagingMemoryTypeIndex);
+    }
+
     // Create shader objects
-    std::vector<char> vertexCode = readFile("shaders/spirv/Forward.vert.spv");
-    std::vector<char> fragmentCode = readFile("shaders/spirv/Color.frag.spv");
-    std::vector<VkShaderEXT> vkShaderEXTs = createShaderObjects(vkDevice, vertexCode, fragmentCode);
+    // The instanced stress scene uses the variant of Forward.vert consuming the per-instance attributes
+    // The code is consumed directly from the executable, or the shader pack mapping, which is kept for pipeline re-creation.
+    // (The pack is produced by the "pack shaders" build task, see tools/PackShaders.cpp)
+    std::optional<ShaderPack> shaderPack;
+    if(!gEmbeddedShaders)
+    {
+        shaderPack.emplace("shaders/spirv/shaders.pack");
+    }
+    auto getShaderCode = [&shaderPack](std::string_view aName) -> std::span<const char>
+    {
+        return shaderPack ? shaderPack->get(aName).mCode : getEmbeddedShader(embedded::gShaders, aName).getChars();
+    };
+    const std::string vertexShaderName = gInstanceCount != 0 ? "ForwardInstanced.vert"
+                                         : gParameterDrawCount != 0 ? "ForwardDraw.vert" : "Forward.vert";
+    const std::string fragmentShaderName = gBindlessTextureCount == 0 ? "Color.frag" : "Bindless.frag";
+    // Replaced by the hot-reloaded versions
+    std::span<const char> vertexCode = getShaderCode(vertexShaderName);
+    std::span<const char> fragmentCode = getShaderCode(fragmentShaderName);
+    // Layout of the forward shaders, from the registry: the shader objects are created with it,
+    // and the pipeline cache acquires the same one for the pipelines, so the draw parameters are set alike on both paths.
+    // (Hot-reloaded shaders must keep their descriptors and push constants, otherwise they are rejected.)
+    const ShaderReflection * forwardShaders[]{&getReflection(vertexCode), &getReflection(fragmentCode)};
+    ReflectedLayout forwardLayout = createReflectedLayout(vkDevice, forwardShaders, &objectRegistry, bindlessBackend);
+    // Implementation binaries are cached on disk: the first run compiles the SPIR-V (cold), later runs do not (warm).
+    ShaderBinaryCache shaderBinaryCache{vkPhysicalDevice, objectRegistry, "shader_cache"};
+    const auto shaderCreationStart = std::chrono::steady_clock::now();
+    std::vector<VkShaderEXT> vkShaderEXTs =
+        createShaderObjects(vkDevice, vertexCode, fragmentCode, forwardLayout.mPushConstantRanges, &shaderBinaryCache,
+                            gShaderVariant, forwardLayout.mSetLayouts);
+    // Pre-warms the other variants of the manifest (which also populates the binary cache)
+    const std::vector<VariantKey> shaderVariants = readVariantManifest("shaders/variants.txt");
+    std::map<VariantKey, std::vector<VkShaderEXT>> shaderObjectVariants;
+    if(gDynamicRendering)
+    {
+        for(VariantKey variant : shaderVariants)
+        {
+            if(variant != gShaderVariant)
+            {
+                shaderObjectVariants[variant] =
+                    createShaderObjects(vkDevice, vertexCode, fragmentCode, forwardLayout.mPushConstantRanges, &shaderBinaryCache,
+                                        variant, forwardLayout.mSetLayouts);
+            }
+        }
+    }
+    std::cout << "Shader objects created in "
+              << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - shaderCreationStart).count()
+              << " ms (" << (shaderBinaryCache.getStatistics().mHits != 0 ? "warm, from cached binaries" : "cold, from SPIR-V")
+              << ").\n";
+
+    // Worker threads, for the background loads and compilations
+    WorkerPool workerPool;
+
+    // Mesh file, mapped: its header and layout are available immediately, its chunks are read as they are uploaded.
+    std::optional<MeshFile> meshFile;
+    if constexpr(gMeshFile != nullptr)
+    {
+        meshFile.emplace(gMeshFile);
+    }
 
     // Vertex Attribute Data
-    const std::size_t vertexDataSize = sizeof(gTriangle);
+    const VertexLayout & vertexLayout =
+        meshFile ? meshFile->getVertexLayout() : (gCompactVertices ? gCompactVertexLayout : gFullVertexLayout);
+    const std::vector<std::byte> vertexData = encodeVertices(vertexLayout, gTriangle);
+    const std::size_t vertexDataSize = vertexData.size();
     auto [vkVertexBuffer, vkVertexDeviceMemory] = prepareVertexBuffer(vkDevice, vertexDataSize, deviceLocalMemoryTypeIndex);
 
     // Load the vertex attribute data
-    // see: https://docs.vulkan.org/spec/latest/chapters/memory.html#memory-device-hostaccess
+    // The copy runs on the transfer queue, which then releases the buffer to the graphics queue family.
+    // Optional, so it can be destroyed with the other Vulkan objects
+    std::optional<UploadService> uploadService;
+    uploadService.emplace(transferContext, 64 * 1024 * 1024);
+    const UploadService::Ticket vertexUpload = uploadService->uploadBuffer(
+        vkVertexBuffer,
+        0,
+        vertexData,
+        VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT,
+        VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT);
+
+    // Vertex input, shared by the static pipeline and the shader objects
+    const VertexInputDescription vertexInputDescription = getVertexInputDescription(vertexLayout, gInstanceCount != 0);
+    // The locations must match the inputs declared by the vertex shader
+    assertVertexInputMatches(getReflection(vertexCode), vertexInputDescription);
+    const std::vector<VkVertexInputBindingDescription2EXT> vertexInputBindings2EXT =
+        vertexInputDescription.getBindings2EXT();
+    const std::vector<VkVertexInputAttributeDescription2EXT> vertexInputAttributes2EXT =
+        vertexInputDescription.getAttributes2EXT();
+
+    // Bounding box of the triangle, for the CPU culling
+    Aabb triangleBounds{.mMin = {INFINITY, INFINITY, INFINITY}, .mMax = {-INFINITY, -INFINITY, -INFINITY}};
+    for(const Vertex & vertex : gTriangle)
+    {
+        const auto [x, y, z] = vertex.mPosition;
+        triangleBounds.mMin = {std::min(triangleBounds.mMin.x, x), std::min(triangleBounds.mMin.y, y), std::min(triangleBounds.mMin.z, z)};
+        triangleBounds.mMax = {std::max(triangleBounds.mMax.x, x), std::max(triangleBounds.mMax.y, y), std::max(triangleBounds.mMax.z, z)};
+    }
+
+    // Per-instance attribute data
+    // Rewritten by the CPU each frame, so it stays in host visible memory, mapped for the lifetime of the buffer.
+    // Frames do not overlap (each waits for the previous submission), so a single copy of the data is enough.
+    std::pair<VkBuffer, VkDeviceMemory> instanceBuffer{VK_NULL_HANDLE, VK_NULL_HANDLE};
+    std::byte * instanceMapping = nullptr;
+    std::vector<math::Mat4> instanceModels;
+    std::vector<std::array<float, 4>> instanceColors;
+    BoundingVolumes instanceVolumes;
+    // Indices of the visible instances, whose data is compacted at the start of the buffer
+    std::vector<uint32_t> instanceVisible(gInstanceCount);
+    uint32_t instanceVisibleCount = 0;
+    if constexpr(gInstanceCount != 0)
+    {
+        std::vector<InstanceData> instances = generateInstanceGrid(gInstanceCount);
+        instanceBuffer = createBuffer(vkDevice,
+                                      std::span{instances}.size_bytes(),
+                                      VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                                      stagingMemoryTypeIndex);
+        void * mapping;
+        assertVkSuccess(vkMapMemory(vkDevice, instanceBuffer.second, 0, VK_WHOLE_SIZE, 0, &mapping));
+        instanceMapping = static_cast<std::byte *>(mapping);
+        // The instances are written every frame, from their models and colors
+        instanceVolumes.resize(gInstanceCount);
+        for(const InstanceData & instance : instances)
+        {
+            const math::Mat4 model = math::transpose(math::Mat4::fromColumnMajor(instance.mTransformRows[0].data()));
+            instanceVolumes.set(instanceModels.size(),
+                                transformSphere(model, {.mCenter = {0.f, 0.f, 0.f}, .mRadius = gTriangleRadius}),
+                                transformAabb(model, triangleBounds));
+            instanceModels.push_back(model);
+            instanceColors.push_back(instance.mColor);
+        }
+    }
+    // The camera orbits the instance grid, which spans [-1, 1] in x and y
+    const auto instanceAnimationStart = std::chrono::steady_clock::now();
+    auto writeInstanceTransforms = [&](VkExtent2D aExtent)
+    {
+        const float time = std::chrono::duration<float>(std::chrono::steady_clock::now() - instanceAnimationStart).count();
+        const float angle = 0.5f * std::sin(0.5f * time);
+        constexpr float gDistance = 2.5f;
+        const math::Mat4 viewProjection =
+            math::perspective(2.f * std::atan(1.1f / gDistance), (float)aExtent.width / aExtent.height, 0.1f, 10.f)
+            * math::lookAt({gDistance * std::sin(angle), 0.f, gDistance * std::cos(angle)}, {0.f, 0.f, 0.f}, {0.f, 1.f, 0.f});
+        // The visible instances are compacted: the draw only covers them
+        instanceVisibleCount = culling::cull(instanceVolumes, extractFrustum(viewProjection), instanceVisible, workerPool);
+        const std::span<const uint32_t> visible = std::span{instanceVisible}.first(instanceVisibleCount);
+        math::multiplyToRowsBatch(viewProjection, instanceModels, visible,
+                                  instanceMapping + offsetof(InstanceData, mTransformRows), sizeof(InstanceData));
+        for(std::size_t slot = 0; slot != visible.size(); ++slot)
+        {
+            std::memcpy(instanceMapping + slot * sizeof(InstanceData) + offsetof(InstanceData, mColor),
+                        instanceColors[visible[slot]].data(), sizeof(InstanceData::mColor));
+        }
+    };
+
+    // Index data
+    // (Meshes are optimized offline for the vertex cache and fetch, see MeshOptimizer.h and tools/OptimizeMesh.cpp)
+    const std::size_t indexDataSize = sizeof(gTriangleIndices);
+    auto [vkIndexBuffer, vkIndexDeviceMemory] = createBuffer(
+        vkDevice,
+        indexDataSize,
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        deviceLocalMemoryTypeIndex);
+    const UploadService::Ticket indexUpload = uploadService->uploadBuffer(
+        vkIndexBuffer,
+        0,
+        std::as_bytes(std::span{gTriangleIndices}),
+        VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT,
+        VK_ACCESS_2_INDEX_READ_BIT);
+
+    // Bindless textures: views of the layers of a single array image, each layer a solid color
+    constexpr uint32_t gBindlessLayerCount = 256;
+    std::pair<VkImage, VkDeviceMemory> bindlessImage{VK_NULL_HANDLE, VK_NULL_HANDLE};
+    std::optional<UploadService::Ticket> bindlessUpload;
+    VkSampler bindlessSampler = VK_NULL_HANDLE;
+    uint32_t bindlessSamplerSlot = 0;
+    std::vector<VkImageView> bindlessViews(gBindlessTextureCount);
+    std::vector<uint32_t> bindlessTextureSlots(gBindlessTextureCount);
+    if constexpr(gBindlessTextureCount != 0)
+    {
+        bindlessImage = createImage(
+            vkDevice,
+            VkImageCreateInfo{
+                .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+                .imageType = VK_IMAGE_TYPE_2D,
+                .format = VK_FORMAT_R8G8B8A8_UNORM,
+                .extent = {1, 1, 1},
+                .mipLevels = 1,
+                .arrayLayers = gBindlessLayerCount,
+                .samples = VK_SAMPLE_COUNT_1_BIT,
+                .tiling = VK_IMAGE_TILING_OPTIMAL,
+                .usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+                .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            },
+            deviceLocalMemoryTypeIndex);
+        std::vector<std::array<uint8_t, 4>> texels(gBindlessLayerCount);
+        for(uint32_t layer = 0; layer != gBindlessLayerCount; ++layer)
+        {
+            texels[layer] = {(uint8_t)(layer * 7), (uint8_t)(255 - layer), (uint8_t)(layer * 61), 255};
+        }
+        bindlessUpload = uploadService->uploadImage(
+            bindlessImage.first,
+            VkBufferImageCopy{
+                .imageSubresource = {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .layerCount = gBindlessLayerCount,
+                },
+                .imageExtent = {1, 1, 1},
+            },
+            std::as_bytes(std::span{texels}),
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+            VK_ACCESS_2_SHADER_SAMPLED_READ_BIT);
+
+        VkSamplerCreateInfo samplerCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+            .magFilter = VK_FILTER_NEAREST,
+            .minFilter = VK_FILTER_NEAREST,
+            .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+            .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+            .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        };
+        assertVkSuccess(vkCreateSampler(vkDevice, &samplerCreateInfo, pAllocator, &bindlessSampler));
+        bindlessSamplerSlot = bindlessHeap->addSampler(bindlessSampler);
+
+        // The views are created and registered by the workers concurrently, each taking its slots from the free-list
+        constexpr std::size_t gJobTextureCount = 4096;
+        const auto registrationStart = std::chrono::steady_clock::now();
+        parallelFor(workerPool, (gBindlessTextureCount + gJobTextureCount - 1) / gJobTextureCount, [&](std::size_t aJobIdx)
+        {
+            const std::size_t end = std::min<std::size_t>(gBindlessTextureCount, (aJobIdx + 1) * gJobTextureCount);
+            for(std::size_t textureIdx = aJobIdx * gJobTextureCount; textureIdx != end; ++textureIdx)
+            {
+                VkImageViewCreateInfo imageViewCreateInfo{
+                    .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+                    .image = bindlessImage.first,
+                    .viewType = VK_IMAGE_VIEW_TYPE_2D,
+                    .format = VK_FORMAT_R8G8B8A8_UNORM,
+                    .subresourceRange = {
+                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                        .levelCount = 1,
+                        .baseArrayLayer = (uint32_t)(textureIdx % gBindlessLayerCount),
+                        .layerCount = 1,
+                    },
+                };
+                assertVkSuccess(vkCreateImageView(vkDevice, &imageViewCreateInfo, pAllocator, &bindlessViews[textureIdx]));
+                bindlessTextureSlots[textureIdx] = bindlessHeap->addSampledImage(bindlessViews[textureIdx]);
+            }
+        });
+        std::cout << gBindlessTextureCount << " bindless textures registered in "
+                  << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - registrationStart).count()
+                  << " ms.\n";
+    }
+
+    // Per-draw parameters of the forward shaders, in the forward layout: pushed, or written in the frame ring.
+    // Frames do not overlap (each waits for the previous submission), a single segment is enough.
+    std::optional<FrameParameterRing> parameterRing;
+    if constexpr(gParameterDrawCount != 0)
+    {
+        parameterRing.emplace(vkDevice, vkPhysicalDevice,
+                              gParameterDrawCount * FrameParameterRing::getCapacityFor(sizeof(ForwardDrawParameters)),
+                              1, stagingMemoryTypeIndex);
+    }
+    const DrawParameterBinder forwardParameters{forwardLayout, parameterRing ? &*parameterRing : nullptr};
+
+    // Binds the bindless set and pushes the slots of the texture to sample, a different one each frame.
+    // The set stays bound for all the draws of the command buffer, with any bindless pipeline or shader objects.
+    uint32_t bindlessFrame = 0;
+    auto bindBindlessTexture = [&](VkCommandBuffer vkCommandBuffer)
+    {
+        bindlessHeap->bind(vkCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS);
+        forwardParameters.set(vkCommandBuffer, BindlessParameters{
+            .mTexture = bindlessTextureSlots[bindlessFrame++ % bindlessTextureSlots.size()],
+            .mSampler = bindlessSamplerSlot,
+        });
+    };
+
+    // Parameter draws: a grid of triangles, spanning [-1, 1] in x and y, each with its own color
+    std::vector<math::Mat4> parameterDrawModels;
+    std::vector<std::array<float, 4>> parameterDrawColors;
+    if constexpr(gParameterDrawCount != 0)
+    {
+        const uint32_t side = (uint32_t)std::ceil(std::sqrt((float)gParameterDrawCount));
+        const float cellSize = 2.f / side;
+        for(uint32_t drawIdx = 0; drawIdx != gParameterDrawCount; ++drawIdx)
+        {
+            const uint32_t column = drawIdx % side;
+            const uint32_t row = drawIdx / side;
+            parameterDrawModels.push_back(math::composeTrs(
+                {-1.f + (column + 0.5f) * cellSize, -1.f + (row + 0.5f) * cellSize, 0.f},
+                {0.f, 0.f, 0.f, 1.f},
+                {0.5f * cellSize, 0.5f * cellSize, 1.f}));
+            parameterDrawColors.push_back({(float)column / side, (float)row / side, 1.f - (float)column / side, 1.f});
+        }
+    }
+    // Binds the triangle once, then sets the parameters of each draw.
+    // Their view-projection keeps the grid square whatever the aspect ratio of the window.
+    auto recordParameterDraws = [&](VkCommandBuffer vkCommandBuffer, VkExtent2D aExtent)
+    {
+        const float aspectRatio = (float)aExtent.width / aExtent.height;
+        const math::Mat4 viewProjection = aspectRatio > 1.f
+            ? math::orthographic(-aspectRatio, aspectRatio, -1.f, 1.f, -1.f, 1.f)
+            : math::orthographic(-1.f, 1.f, -1.f / aspectRatio, 1.f / aspectRatio, -1.f, 1.f);
+
+        vkCmdBindIndexBuffer(vkCommandBuffer, vkIndexBuffer, 0, VK_INDEX_TYPE_UINT16);
+        for(uint32_t drawIdx = 0; drawIdx != gParameterDrawCount; ++drawIdx)
+        {
+            forwardParameters.set(vkCommandBuffer, ForwardDrawParameters{
+                .mModel = parameterDrawModels[drawIdx],
+                .mViewProjection = viewProjection,
+                .mColor = parameterDrawColors[drawIdx],
+            });
+            vkCmdDrawIndexed(vkCommandBuffer, (uint32_t)gTriangleIndices.size(), 1, 0, 0, 0);
+        }
+    };
+
+    // Mesh data, streamed from the file by a worker (which blocks while the staging ring is full)
+    std::optional<MeshBuffers> meshBuffers;
+    PendingRebuild<MeshStreamReport> meshStream{[](MeshStreamReport &){}};
+    // Set once the stream requested all the uploads
+    std::optional<UploadService::Ticket> meshUpload;
+    if(meshFile)
+    {
+        meshBuffers = createMeshBuffers(vkDevice, *meshFile, deviceLocalMemoryTypeIndex);
+        meshStream.start(workerPool, [&]
+        {
+            return streamMesh(*meshFile, *meshBuffers, *uploadService);
+        });
+    }
+
+    // Draws the indexed triangle (or the full detail of the mesh),
+    // or all its instances in a single draw for the instanced stress scene.
+    auto recordTriangleDraw = [&](VkCommandBuffer vkCommandBuffer)
     {
-        void * vertexDataMap;
-        vkMapMemory(vkDevice, vkVertexDeviceMemory, 0, vertexDataSize, 0, &vertexDataMap);
-        std::memcpy(vertexDataMap, gTriangle.data(), vertexDataSize);
-        vkUnmapMemory(vkDevice, vkVertexDeviceMemory);
-        // No need to call vkFlushMappedMemoryRanges() since we picked coherent memory
+        uint32_t indexCount = (uint32_t)gTriangleIndices.size();
+        uint32_t firstIndex = 0;
+        if(meshFile)
+        {
+            if(!meshUpload || !uploadService->isSubmitted(*meshUpload))
+            {
+                return;
+            }
+            const meshfile::Lod & lod = meshFile->getLods().front();
+            indexCount = lod.mIndexCount;
+            firstIndex = lod.mFirstIndex;
+            VkDeviceSize vertexBufferOffset = 0;
+            vkCmdBindVertexBuffers(vkCommandBuffer, gVertexBinding, 1, &meshBuffers->mVertexBuffer, &vertexBufferOffset);
+            vkCmdBindIndexBuffer(vkCommandBuffer, meshBuffers->mIndexBuffer, 0, meshFile->getIndexType());
+        }
+        else
+        {
+            vkCmdBindIndexBuffer(vkCommandBuffer, vkIndexBuffer, 0, VK_INDEX_TYPE_UINT16);
+        }
 
-        // Note: afaiu, host writes to mappable device memory are made available to all memory accesses performed by the device
-        // in commands from a subsequent queue submission.
-        // see access scope in: https://docs.vulkan.org/spec/latest/chapters/synchronization.html#synchronization-submission-host-writes
+        if constexpr(gInstanceCount != 0)
+        {
+            VkDeviceSize instanceBufferOffset = 0;
+            vkCmdBindVertexBuffers(vkCommandBuffer, gInstanceBinding, 1, &instanceBuffer.first, &instanceBufferOffset);
+            vkCmdDrawIndexed(vkCommandBuffer, indexCount, instanceVisibleCount, firstIndex, 0, 0);
+        }
+        else
+        {
+            vkCmdDrawIndexed(vkCommandBuffer, indexCount, 1, firstIndex, 0, 0);
+        }
+    };
+
+    // Objects scene, each object being an instance of the indexed triangle
+    std::optional<ObjectScene> objectScene;
+    if constexpr(gObjectCount != 0)
+    {
+        std::span<const char> cullCode;
+        if(drawPath == DrawPath::IndirectCountCulled)
+        {
+            cullCode = getShaderCode("Cull.comp");
+        }
+        std::vector<DrawRecord> records = generateDrawRecords(gObjectCount, (uint32_t)gTriangleIndices.size());
+        objectScene = createObjectScene(vkDevice, *uploadService, deviceLocalMemoryTypeIndex,
+                                        records, gTriangleRadius, triangleBounds,
+                                        getShaderCode("Indirect.vert"), fragmentCode, cullCode);
     }
 
+    // Average CPU time to record the scene draws, binds and draw calls, and frame time, over gTimingFrameCount frames.
+    // Or the time to update the bindless textures.
+    using Clock = std::chrono::steady_clock;
+    constexpr uint32_t gTimingFrameCount = 256;
+    Clock::duration drawRecordingDuration{0};
+    Clock::duration bindlessUpdateDuration{0};
+    std::size_t bindlessUpdateCursor = 0;
+    drawsort::BindCounts recordedBinds;
+    Clock::time_point timingStart = Clock::now();
+    uint32_t timingFrame = 0;
+
     //
     // Render Pass Object (used when not going through dynamic rendering)
     //
@@ -295,7 +822,57 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE, PWSTR pCmdLine, int nCmdShow
     std::vector<VkFramebuffer> framebuffers = createFramebuffers(vkDevice, vkRenderPass, swapchain);
 
     // Graphics Pipeline
-    VkPipeline vkPipeline = createStaticPipeline(vkDevice, swapchain, vkRenderPass, vertexCode, fragmentCode);
+    // Compiled in the background by the cache, shader modules and layouts are shared through the registry.
+    // The viewport is dynamic, so the pipeline is not re-created on resize.
+    PipelineCache pipelineCache{vkDevice, objectRegistry, workerPool, pipelineLibraries};
+    GraphicsPipelineState pipelineState{
+        .mVertexCode = vertexCode,
+        .mFragmentCode = fragmentCode,
+        .mVariant = gShaderVariant,
+        .mVertexInput = vertexInputDescription,
+        .mRenderPass = vkRenderPass,
+        .mBindlessBackend = bindlessBackend,
+    };
+    // Measured before the cache starts compiling on the workers
+    if(gPipelineCreationRepetitions != 0 && pipelineLibraries)
+    {
+        const PipelineCreationTimings timings =
+            measurePipelineCreation(vkDevice, objectRegistry, pipelineState, gPipelineCreationRepetitions);
+        std::cout << "Pipeline creation (average ms over " << gPipelineCreationRepetitions << "): complete "
+                  << timings.mComplete.count() << ", fast link " << timings.mFastLink.count()
+                  << ", optimized link " << timings.mOptimizedLink.count()
+                  << " (the four libraries compiled once in " << timings.mLibraries.count() << ")\n";
+    }
+    Hash pipelineKey = getStructuralHash(pipelineState);
+    // Requested ahead of the first frame, to start its compilation
+    pipelineCache.request(pipelineKey, pipelineState);
+    // As well as the other variants of the manifest, compiled in the background
+    if(!gDynamicRendering)
+    {
+        for(VariantKey variant : shaderVariants)
+        {
+            GraphicsPipelineState variantState = pipelineState;
+            variantState.mVariant = variant;
+            pipelineCache.request(variantState);
+        }
+    }
+
+    // Shader hot-reload
+    // Only the objects of the active path are rebuilt: the shader objects, or the pipeline (by the cache).
+    std::optional<ShaderWatcher> shaderWatcher;
+    if constexpr(gShaderHotReload)
+    {
+        shaderWatcher.emplace("shaders/spirv");
+    }
+    PendingRebuild<std::vector<VkShaderEXT>> shaderObjectsRebuild{[](std::vector<VkShaderEXT> & aShaders)
+    {
+        for(VkShaderEXT shader : aShaders)
+        {
+            vkDestroyShaderEXT(vkDevice, shader, pAllocator);
+        }
+    }};
+    // The state with reloaded shaders, replacing pipelineState once its pipeline is compiled
+    std::optional<std::pair<Hash, GraphicsPipelineState>> reloadedPipeline;
     
 
     //
@@ -329,9 +906,76 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE, PWSTR pCmdLine, int nCmdShow
 
                     if(!gDynamicRendering)
                     {
-                        destroyPipelineAndFramebuffers(vkDevice, vkPipeline, framebuffers);
+                        destroyFramebuffers(vkDevice, framebuffers);
                         framebuffers = createFramebuffers(vkDevice, vkRenderPass, swapchain);
-                        vkPipeline = createStaticPipeline(vkDevice, swapchain, vkRenderPass, vertexCode, fragmentCode);
+                    }
+                }
+
+                // Shader hot-reload, at the frame boundary:
+                // the previous frame was waited for, so the replaced shaders are not in use anymore.
+                if(shaderWatcher)
+                {
+                    bool reloaded = false;
+                    for(const auto & [name, code] : shaderWatcher->takeChanges())
+                    {
+                        if(name == vertexShaderName)
+                        {
+                            vertexCode = code;
+                            reloaded = true;
+                        }
+                        else if(name == fragmentShaderName)
+                        {
+                            fragmentCode = code;
+                            reloaded = true;
+                        }
+                    }
+
+                    if(reloaded && gDynamicRendering)
+                    {
+                        shaderObjectsRebuild.start(workerPool, [vertexCode, fragmentCode, &vertexInputDescription,
+                                                                &forwardLayout, bindlessBackend]
+                        {
+                            const ShaderReflection * shaders[]{&getReflection(vertexCode), &getReflection(fragmentCode)};
+                            assertVertexInputMatches(*shaders[0], vertexInputDescription);
+                            assertLayoutMatches(vkDevice, shaders, forwardLayout, bindlessBackend);
+                            return createShaderObjects(vkDevice, vertexCode, fragmentCode, forwardLayout.mPushConstantRanges, nullptr,
+                                                       gShaderVariant, forwardLayout.mSetLayouts);
+                        });
+                    }
+                    else if(reloaded)
+                    {
+                        // The cache would compile the pipeline with the reloaded layout, while the draws are recorded with forwardLayout
+                        try
+                        {
+                            const ShaderReflection * shaders[]{&getReflection(vertexCode), &getReflection(fragmentCode)};
+                            assertLayoutMatches(vkDevice, shaders, forwardLayout, bindlessBackend);
+                            GraphicsPipelineState state = pipelineState;
+                            state.mVertexCode = vertexCode;
+                            state.mFragmentCode = fragmentCode;
+                            const Hash key = getStructuralHash(state);
+                            reloadedPipeline.emplace(key, std::move(state));
+                        }
+                        catch(const std::exception & aException)
+                        {
+                            std::cerr << "Rebuild failed, keeping the previous version: " << aException.what() << "\n";
+                        }
+                    }
+
+                    if(std::optional<std::vector<VkShaderEXT>> rebuilt = shaderObjectsRebuild.take())
+                    {
+                        for(VkShaderEXT shader : vkShaderEXTs)
+                        {
+                            vkDestroyShaderEXT(vkDevice, shader, pAllocator);
+                        }
+                        vkShaderEXTs = std::move(*rebuilt);
+                    }
+                    // Compiled by the cache meanwhile, a failed compilation keeps the previous pipeline.
+                    if(reloadedPipeline
+                       && pipelineCache.request(reloadedPipeline->first, reloadedPipeline->second) != VK_NULL_HANDLE)
+                    {
+                        pipelineKey = reloadedPipeline->first;
+                        pipelineState = std::move(reloadedPipeline->second);
+                        reloadedPipeline.reset();
                     }
                 }
 
@@ -363,12 +1007,56 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE, PWSTR pCmdLine, int nCmdShow
                     vkDestroyFence(vkDevice, acquireFence, pAllocator);
                 }
 
+                // The mesh stream requested its last upload
+                if(std::optional<MeshStreamReport> streamed = meshStream.take())
+                {
+                    meshUpload = streamed->mTicket;
+                    std::cout << "Mesh '" << gMeshFile << "' streamed: " << streamed->mBytes << " bytes in "
+                              << std::chrono::duration<double, std::milli>(streamed->mDuration).count() << " ms ("
+                              << streamed->getGigabytesPerSecond() << " GB/s).\n";
+                }
+
+                // The previous frame completed, its instance data can be overwritten
+                // (host writes are made visible to the device by the submission)
+                if constexpr(gInstanceCount != 0)
+                {
+                    writeInstanceTransforms(swapchain.imageExtent);
+                }
+                // As well as its draw parameters
+                if(parameterRing)
+                {
+                    parameterRing->beginFrame();
+                }
+
+                // Re-register some bindless textures: the previous frame completed, their slots are not in use anymore.
+                // (The freed slot is reused right away, the descriptor is rewritten in place.)
+                if(gBindlessUpdatesPerFrame != 0)
+                {
+                    const Clock::time_point updateStart = Clock::now();
+                    for(uint32_t updateIdx = 0; updateIdx != gBindlessUpdatesPerFrame; ++updateIdx)
+                    {
+                        const std::size_t textureIdx = bindlessUpdateCursor++ % bindlessTextureSlots.size();
+                        bindlessHeap->removeSampledImage(bindlessTextureSlots[textureIdx]);
+                        bindlessTextureSlots[textureIdx] = bindlessHeap->addSampledImage(bindlessViews[textureIdx]);
+                    }
+                    bindlessUpdateDuration += Clock::now() - updateStart;
+                }
+
+                // Submit the pending uploads to the transfer queue
+                uploadService->submit();
+                // Draws are skipped until their data is in flight
+                const bool vertexDataReady = uploadService->isSubmitted(vertexUpload) && uploadService->isSubmitted(indexUpload)
+                                             && (!bindlessUpload || uploadService->isSubmitted(*bindlessUpload));
+
                 // Move CB to recording state
                 VkCommandBufferBeginInfo commandBufferBeginInfo{
                     .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
                 };
                 assertVkSuccess(vkBeginCommandBuffer(vkCommandBuffer, &commandBufferBeginInfo));
 
+                // Acquire the ownership of uploaded resources, the submission will wait on the copies.
+                const uint64_t uploadWaitValue = uploadService->recordAcquireBarriers(vkCommandBuffer);
+
                 // Transition to general layout (initializing from undefined layout)
                 // > All presentable images are initially in the VK_IMAGE_LAYOUT_UNDEFINED layout, thus before using presentable images, 
                 // > the application must transition them to a valid layout for the intended use.
@@ -393,6 +1081,13 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE, PWSTR pCmdLine, int nCmdShow
                 };
                 vkCmdPipelineBarrier2(vkCommandBuffer, &dependencyInfo);
 
+                // Cull the objects on the GPU, before any rendering
+                const bool objectsReady = objectScene && uploadService->isSubmitted(objectScene->mUpload);
+                if(objectsReady && drawPath == DrawPath::IndirectCountCulled)
+                {
+                    recordCulling(vkCommandBuffer, *objectScene, gClipVolumeFrustum);
+                }
+
                 // Clear color image
                 VkClearColorValue clearColor{
                     .float32{0.1f, 0.1f, 0.1f, 1.0f},
@@ -431,6 +1126,10 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE, PWSTR pCmdLine, int nCmdShow
                         VK_SHADER_STAGE_FRAGMENT_BIT,
                     };
                     vkCmdBindShadersEXT(vkCommandBuffer, vkShaderEXTs.size(), stageBits, vkShaderEXTs.data());
+                    if(bindlessHeap)
+                    {
+                        bindBindlessTexture(vkCommandBuffer);
+                    }
 
                     // Very explicit required state
                     setDynamicPipelineState(vkCommandBuffer, swapchain.imageExtent);
@@ -455,44 +1154,43 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE, PWSTR pCmdLine, int nCmdShow
                     // *vertex input bindings* are associated with specific *buffers* (per-draw)
                     //  - vkCmdBindVertexBuffers()
 
-                    // Vertex shader input from buffers
-                    // Describe the single binding, used by both interleaved attributes
-                    VkVertexInputBindingDescription2EXT vertexInputBindingDescriptions[]{
-                        {
-                            .sType = VK_STRUCTURE_TYPE_VERTEX_INPUT_BINDING_DESCRIPTION_2_EXT,
-                            .binding = 1,
-                            .stride = sizeof(Vertex),
-                            .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
-                            .divisor = 1,
-                        },
-                    };
-                    // Describes both attributes that will be pulled from the single binding
-                    VkVertexInputAttributeDescription2EXT vertexInputAttributeDescription[]{
-                        {
-                            .sType = VK_STRUCTURE_TYPE_VERTEX_INPUT_ATTRIBUTE_DESCRIPTION_2_EXT,
-                            .location = 1,
-                            .binding = 1,
-                            .format = VK_FORMAT_R32G32B32_SFLOAT,
-                            .offset = 0,
-                        },
-                        {
-                            .sType = VK_STRUCTURE_TYPE_VERTEX_INPUT_ATTRIBUTE_DESCRIPTION_2_EXT,
-                            .location = 2,
-                            .binding = 1,
-                            .format = VK_FORMAT_R32G32B32_SFLOAT,
-                            .offset = offsetof(Vertex, mColor),
-                        },
-                    };
+                    // Vertex shader input from buffers (see getVertexInputDescription())
                     vkCmdSetVertexInputEXT(vkCommandBuffer,
-                                           std::size(vertexInputBindingDescriptions), vertexInputBindingDescriptions,
-                                           std::size(vertexInputAttributeDescription), vertexInputAttributeDescription);
+                                           (uint32_t)vertexInputBindings2EXT.size(), vertexInputBindings2EXT.data(),
+                                           (uint32_t)vertexInputAttributes2EXT.size(), vertexInputAttributes2EXT.data());
 
                     // Associate the vertex input bindings to buffers (per-draw)
                     VkDeviceSize vertexBufferOffset = 0;
-                    vkCmdBindVertexBuffers(vkCommandBuffer, 1, 1, &vkVertexBuffer, &vertexBufferOffset);
+                    vkCmdBindVertexBuffers(vkCommandBuffer, gVertexBinding, 1, &vkVertexBuffer, &vertexBufferOffset);
 
-                    // Non-indexed draw
-                    vkCmdDraw(vkCommandBuffer, 3, 1, 0, 0);
+                    if(objectScene)
+                    {
+                        if(objectsReady)
+                        {
+                            vkCmdBindIndexBuffer(vkCommandBuffer, vkIndexBuffer, 0, VK_INDEX_TYPE_UINT16);
+
+                            // The CPU culling and sorting are accounted for in the draw recording
+                            Clock::time_point recordingStart = Clock::now();
+                            if(drawPath == DrawPath::PerDrawCpuCulled)
+                            {
+                                cullObjects(*objectScene, gClipVolumeFrustum, workerPool);
+                            }
+                            const drawsort::BindCounts binds = recordObjectDraws(vkCommandBuffer, *objectScene, drawPath);
+                            drawRecordingDuration += Clock::now() - recordingStart;
+                            recordedBinds.mPipelines += binds.mPipelines;
+                            recordedBinds.mDraws += binds.mDraws;
+                        }
+                    }
+                    else if(vertexDataReady && gParameterDrawCount != 0)
+                    {
+                        Clock::time_point recordingStart = Clock::now();
+                        recordParameterDraws(vkCommandBuffer, swapchain.imageExtent);
+                        drawRecordingDuration += Clock::now() - recordingStart;
+                    }
+                    else if(vertexDataReady)
+                    {
+                        recordTriangleDraw(vkCommandBuffer);
+                    }
 
                     vkCmdEndRendering(vkCommandBuffer);
                 }
@@ -510,14 +1208,32 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE, PWSTR pCmdLine, int nCmdShow
                                          // The content of the first subpass will be recorded inline in the primary command buffer
                                          VK_SUBPASS_CONTENTS_INLINE);
 
-                    vkCmdBindPipeline(vkCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vkPipeline);
+                    // Never waits for the compilation: the draw is skipped until the pipeline is ready
+                    VkPipeline vkPipeline = pipelineCache.request(pipelineKey, pipelineState);
+                    if(vkPipeline != VK_NULL_HANDLE)
+                    {
+                        vkCmdBindPipeline(vkCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vkPipeline);
+                        setViewportAndScissor(vkCommandBuffer, swapchain.imageExtent);
+                        if(bindlessHeap)
+                        {
+                            bindBindlessTexture(vkCommandBuffer);
+                        }
 
-                    // Associate the vertex input bindings to buffers (per-draw)
-                    VkDeviceSize vertexBufferOffset = 0;
-                    vkCmdBindVertexBuffers(vkCommandBuffer, 1, 1, &vkVertexBuffer, &vertexBufferOffset);
+                        // Associate the vertex input bindings to buffers (per-draw)
+                        VkDeviceSize vertexBufferOffset = 0;
+                        vkCmdBindVertexBuffers(vkCommandBuffer, gVertexBinding, 1, &vkVertexBuffer, &vertexBufferOffset);
 
-                    // Non-indexed draw
-                    vkCmdDraw(vkCommandBuffer, 3, 1, 0, 0);
+                        if(vertexDataReady && gParameterDrawCount != 0)
+                        {
+                            Clock::time_point recordingStart = Clock::now();
+                            recordParameterDraws(vkCommandBuffer, swapchain.imageExtent);
+                            drawRecordingDuration += Clock::now() - recordingStart;
+                        }
+                        else if(vertexDataReady)
+                        {
+                            recordTriangleDraw(vkCommandBuffer);
+                        }
+                    }
 
                     vkCmdEndRenderPass(vkCommandBuffer);
                 }
@@ -532,10 +1248,19 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE, PWSTR pCmdLine, int nCmdShow
                 assertVkSuccess(vkEndCommandBuffer(vkCommandBuffer));
 
                 //submit queue
-                VkSemaphoreSubmitInfo waitSemaphoreSubmitInfo{
-                    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
-                    .semaphore = acquireSemaphore,
-                    .stageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                VkSemaphoreSubmitInfo waitSemaphoreSubmitInfos[]{
+                    {
+                        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+                        .semaphore = acquireSemaphore,
+                        .stageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                    },
+                    // Uploads on the transfer queue (only waited when there were new submissions)
+                    {
+                        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+                        .semaphore = uploadService->getTimelineSemaphore(),
+                        .value = uploadWaitValue,
+                        .stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                    },
                 };
 
                 VkCommandBufferSubmitInfo commandBufferSubmitInfo{
@@ -553,8 +1278,8 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE, PWSTR pCmdLine, int nCmdShow
 
                 VkSubmitInfo2 submitInfo2{
                     .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
-                    .waitSemaphoreInfoCount = 1,
-                    .pWaitSemaphoreInfos = &waitSemaphoreSubmitInfo,
+                    .waitSemaphoreInfoCount = uploadWaitValue != 0 ? 2u : 1u,
+                    .pWaitSemaphoreInfos = waitSemaphoreSubmitInfos,
                     .commandBufferInfoCount = 1,
                     .pCommandBufferInfos = &commandBufferSubmitInfo,
                     .signalSemaphoreInfoCount = 1,
@@ -591,6 +1316,35 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE, PWSTR pCmdLine, int nCmdShow
                 vkDestroyFence(vkDevice, submitFence, pAllocator);
 
                 vkDestroySemaphore(vkDevice, acquireSemaphore, pAllocator);
+
+                if((objectScene || gParameterDrawCount != 0 || gBindlessUpdatesPerFrame != 0) && ++timingFrame == gTimingFrameCount)
+                {
+                    using Microseconds = std::chrono::duration<double, std::micro>;
+                    if(objectScene)
+                    {
+                        std::cout << gObjectCount << " objects"
+                            << ", draw recording: " << Microseconds{drawRecordingDuration}.count() / timingFrame << " us"
+                            << " (" << recordedBinds.mPipelines / timingFrame << " shader binds, "
+                            << recordedBinds.mDraws / timingFrame << " draw calls)";
+                    }
+                    else if(gParameterDrawCount != 0)
+                    {
+                        std::cout << gParameterDrawCount << " parameter draws"
+                            << ", draw recording: " << Microseconds{drawRecordingDuration}.count() / timingFrame << " us";
+                    }
+                    else
+                    {
+                        std::cout << gBindlessUpdatesPerFrame << " bindless texture updates ("
+                            << (bindlessBackend == BindlessBackend::DescriptorBuffer ? "descriptor buffer" : "descriptor set")
+                            << "): " << Microseconds{bindlessUpdateDuration}.count() / timingFrame << " us";
+                    }
+                    std::cout << ", frame: " << Microseconds{Clock::now() - timingStart}.count() / timingFrame << " us\n";
+                    drawRecordingDuration = Clock::duration{0};
+                    bindlessUpdateDuration = Clock::duration{0};
+                    recordedBinds = {};
+                    timingStart = Clock::now();
+                    timingFrame = 0;
+                }
             }
 
         }
@@ -601,13 +1355,79 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE, PWSTR pCmdLine, int nCmdShow
     // Vulkan clean-up
     //
 
-    // Pipeline and framebuffers
-    destroyPipelineAndFramebuffers(vkDevice, vkPipeline, framebuffers);
+    // Shader rebuilds
+    shaderObjectsRebuild.cancel();
+
+    // Pipelines (waits for the pending compilations) and framebuffers
+    pipelineCache.destroy();
+    {
+        const PipelineCache::Statistics statistics = pipelineCache.getStatistics();
+        auto average = [](PipelineCache::Statistics::Duration aTotal, uint32_t aCount)
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds>(aTotal).count() / std::max(aCount, 1u);
+        };
+        std::cout << "Pipelines (average us): "
+            << statistics.mCompilations << " compilations: " << average(statistics.mCompilationTime, statistics.mCompilations)
+            << ", " << statistics.mFastLinks << " fast links: " << average(statistics.mFastLinkTime, statistics.mFastLinks)
+            << ", " << statistics.mOptimizedLinks << " optimized links: " << average(statistics.mOptimizedLinkTime, statistics.mOptimizedLinks)
+            << "\n";
+    }
+    destroyFramebuffers(vkDevice, framebuffers);
     
     // Render pass 
     vkDestroyRenderPass(vkDevice, vkRenderPass, pAllocator);
 
-    // Buffers
+    // Bindless textures, and the heap releasing its layouts
+    if(bindlessHeap)
+    {
+        bindlessHeap->destroy();
+        for(VkImageView view : bindlessViews)
+        {
+            vkDestroyImageView(vkDevice, view, pAllocator);
+        }
+        vkDestroySampler(vkDevice, bindlessSampler, pAllocator);
+    }
+
+    // Draw parameters
+    if(parameterRing)
+    {
+        parameterRing->destroy();
+    }
+
+    // Shader modules and layouts
+    forwardLayout.destroy();
+    objectRegistry.destroy();
+
+    // Mesh stream, which might be waiting for space in the staging ring
+    while(meshStream.isRunning())
+    {
+        uploadService->submit();
+        uploadService->waitSubmitted();
+    }
+    meshStream.cancel();
+
+    // Uploads (waits for the pending copies)
+    uploadService.reset();
+
+    // Mesh
+    if(meshBuffers)
+    {
+        meshBuffers->destroy();
+    }
+
+    // Objects scene
+    if(objectScene)
+    {
+        objectScene->destroy();
+    }
+
+    // Buffers and images
+    vkFreeMemory(vkDevice, bindlessImage.second, pAllocator);
+    vkDestroyImage(vkDevice, bindlessImage.first, pAllocator);
+    vkFreeMemory(vkDevice, instanceBuffer.second, pAllocator);
+    vkDestroyBuffer(vkDevice, instanceBuffer.first, pAllocator);
+    vkFreeMemory(vkDevice, vkIndexDeviceMemory, pAllocator);
+    vkDestroyBuffer(vkDevice, vkIndexBuffer, pAllocator);
     vkFreeMemory(vkDevice, vkVertexDeviceMemory, pAllocator);
     vkDestroyBuffer(vkDevice, vkVertexBuffer, pAllocator);
 
@@ -616,6 +1436,13 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE, PWSTR pCmdLine, int nCmdShow
     {
         vkDestroyShaderEXT(vkDevice, shader, pAllocator);
     }
+    for(const auto & [variant, shaders] : shaderObjectVariants)
+    {
+        for(VkShaderEXT shader : shaders)
+        {
+            vkDestroyShaderEXT(vkDevice, shader, pAllocator);
+        }
+    }
 
     // Semaphores
     assertVkSuccess(vkQueueWaitIdle(vkQueue));
@@ -0,0 +1,34 @@
+#version 460
+
+#extension GL_EXT_nonuniform_qualifier : require
+
+
+// Variant features, the constant_id is the bit of the feature in ShaderVariant.h
+layout(constant_id = 0) const bool kGrayscale = false;
+
+// The bindless set (see gBindlessBindings in VulkanHelpers.h), only the arrays used are declared
+layout(set = 0, binding = 0) uniform texture2D gTextures[];
+layout(set = 0, binding = 2) uniform sampler gSamplers[];
+
+// Slots in the bindless arrays, the same for the whole draw
+// (an index varying within the draw, e.g. read from a buffer, must be qualified nonuniformEXT)
+layout(push_constant) uniform DrawParameters
+{
+    uint mTexture;
+    uint mSampler;
+} pc;
+
+layout(location = 1) in vec3 ex_Color;
+
+layout(location = 0) out vec4 out_Color;
+
+void main() 
+{
+    vec3 color = ex_Color * texture(sampler2D(gTextures[pc.mTexture], gSamplers[pc.mSampler]), vec2(0.5)).rgb;
+    if(kGrayscale)
+    {
+        // Rec. 709 luma
+        color = vec3(dot(color, vec3(0.2126, 0.7152, 0.0722)));
+    }
+    out_Color = vec4(color, 1);
+}
\ No newline at end of file
@@ -1,11 +1,20 @@
 #version 460
 
 
+// Variant features, the constant_id is the bit of the feature in ShaderVariant.h
+layout(constant_id = 0) const bool kGrayscale = false;
+
 layout(location = 1) in vec3 ex_Color;
 
 layout(location = 0) out vec4 out_Color;
 
 void main() 
 {
-    out_Color = vec4(ex_Color, 1);
+    vec3 color = ex_Color;
+    if(kGrayscale)
+    {
+        // Rec. 709 luma
+        color = vec3(dot(color, vec3(0.2126, 0.7152, 0.0722)));
+    }
+    out_Color = vec4(color, 1);
 }
\ No newline at end of file
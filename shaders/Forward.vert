@@ -1,6 +1,9 @@
 #version 460
 
 
+// Variant features, the constant_id is the bit of the feature in ShaderVariant.h
+layout(constant_id = 1) const bool kUniformColor = false;
+
 layout(location = 1) in vec3 ve_Position;
 layout(location = 2) in vec3 ve_Color;
 
@@ -8,6 +11,6 @@ layout(location = 1) out vec3 ex_Color;
 
 void main() 
 {
-    ex_Color = ve_Color;
+    ex_Color = kUniformColor ? vec3(1.0) : ve_Color;
     gl_Position = vec4(ve_Position, 1.0);
 }
\ No newline at end of file
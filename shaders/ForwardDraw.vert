@@ -0,0 +1,32 @@
+#version 460
+
+#extension GL_EXT_buffer_reference : require
+
+
+// Variant features, the constant_id is the bit of the feature in ShaderVariant.h
+layout(constant_id = 1) const bool kUniformColor = false;
+
+// Must match ForwardDrawParameters in main.cpp
+// Larger than the push constants: written in the frame parameter ring, the draw pushes their address (see DrawParameters.h)
+layout(buffer_reference, std430, buffer_reference_align = 16) readonly buffer DrawParameters
+{
+    mat4 model;
+    mat4 viewProjection;
+    vec4 color;
+};
+
+layout(push_constant) uniform PushConstants
+{
+    DrawParameters pc_Draw;
+};
+
+layout(location = 1) in vec3 ve_Position;
+layout(location = 2) in vec3 ve_Color;
+
+layout(location = 1) out vec3 ex_Color;
+
+void main() 
+{
+    ex_Color = kUniformColor ? pc_Draw.color.rgb : ve_Color * pc_Draw.color.rgb;
+    gl_Position = pc_Draw.viewProjection * (pc_Draw.model * vec4(ve_Position, 1.0));
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#version 460
+
+
+// Variant features, as in Forward.vert
+layout(constant_id = 1) const bool kUniformColor = false;
+
+// Per-vertex attributes, as in Forward.vert
+layout(location = 1) in vec3 ve_Position;
+layout(location = 2) in vec3 ve_Color;
+
+// Per-instance attributes, must match InstanceData in VertexData.h
+// Rows of the model-view-projection transform
+layout(location = 3) in vec4 in_TransformRow0;
+layout(location = 4) in vec4 in_TransformRow1;
+layout(location = 5) in vec4 in_TransformRow2;
+layout(location = 6) in vec4 in_TransformRow3;
+layout(location = 7) in vec4 in_Color;
+
+layout(location = 1) out vec3 ex_Color;
+
+void main() 
+{
+    vec4 position = vec4(ve_Position, 1.0);
+
+    ex_Color = (kUniformColor ? vec3(1.0) : ve_Color) * in_Color.rgb;
+    gl_Position = vec4(dot(in_TransformRow0, position),
+                       dot(in_TransformRow1, position),
+                       dot(in_TransformRow2, position),
+                       dot(in_TransformRow3, position));
+}
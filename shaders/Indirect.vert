@@ -0,0 +1,41 @@
+#version 460
+
+#extension GL_EXT_buffer_reference : require
+
+
+// Must match DrawRecord in IndirectDraw.h
+struct DrawRecord
+{
+    uint indexCount;
+    uint instanceCount;
+    uint firstIndex;
+    int vertexOffset;
+    uint firstInstance;
+    // xyz: translation, w: uniform scale
+    float translationScale[4];
+};
+
+layout(buffer_reference, std430, buffer_reference_align = 4) readonly buffer DrawRecords
+{
+    DrawRecord records[];
+};
+
+layout(push_constant) uniform PushConstants
+{
+    DrawRecords pc_Objects;
+};
+
+layout(location = 1) in vec3 ve_Position;
+layout(location = 2) in vec3 ve_Color;
+
+layout(location = 1) out vec3 ex_Color;
+
+void main() 
+{
+    // firstInstance is the object index, even after culling compacted the draw commands
+    DrawRecord object = pc_Objects.records[gl_InstanceIndex];
+    vec3 translation = vec3(object.translationScale[0], object.translationScale[1], object.translationScale[2]);
+
+    ex_Color = ve_Color;
+    gl_Position = vec4(translation + ve_Position * object.translationScale[3], 1.0);
+}
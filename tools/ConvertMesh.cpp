@@ -0,0 +1,374 @@
+// Offline tool, converting a Wavefront OBJ or glTF 2.0 mesh into the binary mesh format (see MeshFile.h).
+//
+// Usage: ConvertMesh <input.obj|input.gltf|input.glb> <output.mesh> [--full] [--lods <count>] [--no-fit]
+//
+// * --full: stores full precision vertices (gFullVertexLayout), instead of gCompactVertexLayout.
+// * --lods: the number of coarser levels of detail generated after the full mesh (default 3).
+// * --no-fit: keeps the positions, instead of fitting the mesh in the view volume (the forward shader has no camera).
+//
+// Polygons are triangulated as fans. Vertex colors are read from the `v x y z r g b` extension when present,
+// otherwise they are derived from the position in the bounds. Texture coordinates and normals are ignored.
+// glTF scenes are imported by Gltf.h, and flattened: the node transforms are applied to the vertices of their meshes.
+
+#include "../Gltf.h"
+#include "../MeshFile.h"
+#include "../MeshOptimizer.h"
+#include "../VertexData.h"
+#include "../VertexLayout.h"
+#include "../WorkerPool.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <span>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+
+namespace {
+
+    struct ObjVertex
+    {
+        std::array<float, 3> mPosition;
+        std::array<float, 3> mColor;
+        bool mHasColor;
+    };
+
+    /// @return The triangle soup, or an empty vector if the file cannot be read.
+    std::vector<Vertex> readObj(const std::string & aPath)
+    {
+        std::ifstream input{aPath};
+        std::vector<ObjVertex> positions;
+        std::vector<ObjVertex> soup;
+        std::vector<ObjVertex> polygon;
+        for(std::string line; std::getline(input, line);)
+        {
+            std::istringstream words{line};
+            std::string keyword;
+            words >> keyword;
+            if(keyword == "v")
+            {
+                ObjVertex & vertex = positions.emplace_back();
+                words >> vertex.mPosition[0] >> vertex.mPosition[1] >> vertex.mPosition[2];
+                vertex.mHasColor = (bool)(words >> vertex.mColor[0] >> vertex.mColor[1] >> vertex.mColor[2]);
+            }
+            else if(keyword == "f")
+            {
+                polygon.clear();
+                // Each corner is `position[/texcoord[/normal]]`, negative indices are relative to the end
+                for(std::string corner; words >> corner;)
+                {
+                    const long index = std::stol(corner.substr(0, corner.find('/')));
+                    const long position = index < 0 ? (long)positions.size() + index : index - 1;
+                    if(position < 0 || position >= (long)positions.size())
+                    {
+                        throw std::out_of_range{"Face index " + std::to_string(index) + " is out of range."};
+                    }
+                    polygon.push_back(positions[position]);
+                }
+                for(std::size_t cornerIdx = 2; cornerIdx < polygon.size(); ++cornerIdx)
+                {
+                    soup.insert(soup.end(), {polygon[0], polygon[cornerIdx - 1], polygon[cornerIdx]});
+                }
+            }
+        }
+
+        std::array<float, 3> boundsMin{INFINITY, INFINITY, INFINITY};
+        std::array<float, 3> boundsMax{-INFINITY, -INFINITY, -INFINITY};
+        for(const ObjVertex & vertex : soup)
+        {
+            for(std::size_t axis = 0; axis != 3; ++axis)
+            {
+                boundsMin[axis] = std::min(boundsMin[axis], vertex.mPosition[axis]);
+                boundsMax[axis] = std::max(boundsMax[axis], vertex.mPosition[axis]);
+            }
+        }
+
+        std::vector<Vertex> result;
+        result.reserve(soup.size());
+        for(const ObjVertex & vertex : soup)
+        {
+            Vertex & converted = result.emplace_back(Vertex{.mPosition = vertex.mPosition, .mColor = vertex.mColor});
+            if(!vertex.mHasColor)
+            {
+                for(std::size_t axis = 0; axis != 3; ++axis)
+                {
+                    const float extent = boundsMax[axis] - boundsMin[axis];
+                    converted.mColor[axis] = extent > 0.f ? (vertex.mPosition[axis] - boundsMin[axis]) / extent : 1.f;
+                }
+            }
+        }
+        return result;
+    }
+
+    /// @return The triangle soup of the default scene, in world space.
+    std::vector<Vertex> readGltf(const std::string & aPath)
+    {
+        WorkerPool workers;
+        // The full layout is byte-identical to Vertex
+        const gltf::Scene scene = gltf::importScene(aPath, workers, gFullVertexLayout);
+        static_assert(sizeof(Vertex) == 6 * sizeof(float));
+        const std::span<const Vertex> vertices{reinterpret_cast<const Vertex *>(scene.mVertexData.data()),
+                                               scene.mVertexData.size() / sizeof(Vertex)};
+
+        const std::vector<std::array<float, 16>> worldMatrices = gltf::computeWorldMatrices(scene);
+        std::vector<Vertex> result;
+        for(std::size_t nodeIdx = 0; nodeIdx != scene.mNodes.size(); ++nodeIdx)
+        {
+            const int32_t meshIdx = scene.mNodes[nodeIdx].mMesh;
+            if(meshIdx < 0)
+            {
+                continue;
+            }
+            const std::array<float, 16> & matrix = worldMatrices[nodeIdx];
+            for(const gltf::Primitive & primitive : scene.mMeshes.at(meshIdx).mPrimitives)
+            {
+                for(uint32_t indexIdx = 0; indexIdx != primitive.mIndexCount; ++indexIdx)
+                {
+                    Vertex vertex = vertices[primitive.mVertexOffset + scene.mIndices[primitive.mFirstIndex + indexIdx]];
+                    const std::array<float, 3> position = vertex.mPosition;
+                    for(std::size_t row = 0; row != 3; ++row)
+                    {
+                        vertex.mPosition[row] = matrix[row] * position[0] + matrix[4 + row] * position[1]
+                                                + matrix[8 + row] * position[2] + matrix[12 + row];
+                    }
+                    result.push_back(vertex);
+                }
+            }
+        }
+        return result;
+    }
+
+    /// @brief Uniformly scales and translates the positions into x, y in [-0.9, 0.9] and z in [0.1, 0.9].
+    void fitInViewVolume(std::vector<Vertex> & aVertices)
+    {
+        std::array<float, 3> boundsMin{INFINITY, INFINITY, INFINITY};
+        std::array<float, 3> boundsMax{-INFINITY, -INFINITY, -INFINITY};
+        for(const Vertex & vertex : aVertices)
+        {
+            for(std::size_t axis = 0; axis != 3; ++axis)
+            {
+                boundsMin[axis] = std::min(boundsMin[axis], vertex.mPosition[axis]);
+                boundsMax[axis] = std::max(boundsMax[axis], vertex.mPosition[axis]);
+            }
+        }
+        const float extent = std::max({boundsMax[0] - boundsMin[0], boundsMax[1] - boundsMin[1], boundsMax[2] - boundsMin[2]});
+        const float scale = extent > 0.f ? 1.8f / extent : 1.f;
+        const std::array<float, 3> target{0.f, 0.f, 0.5f};
+        for(Vertex & vertex : aVertices)
+        {
+            for(std::size_t axis = 0; axis != 3; ++axis)
+            {
+                const float center = 0.5f * (boundsMin[axis] + boundsMax[axis]);
+                vertex.mPosition[axis] = (vertex.mPosition[axis] - center) * scale + target[axis];
+            }
+        }
+    }
+
+    uint64_t alignUp(uint64_t aValue, uint64_t aAlignment)
+    {
+        return (aValue + aAlignment - 1) / aAlignment * aAlignment;
+    }
+
+} // anonymous namespace
+
+
+int main(int argc, char ** argv)
+{
+    std::vector<std::string> positional;
+    bool full = false;
+    bool fit = true;
+    uint32_t coarseLodCount = 3;
+    for(int argIdx = 1; argIdx < argc; ++argIdx)
+    {
+        const std::string argument = argv[argIdx];
+        if(argument == "--full")
+        {
+            full = true;
+        }
+        else if(argument == "--no-fit")
+        {
+            fit = false;
+        }
+        else if(argument == "--lods" && argIdx + 1 < argc)
+        {
+            coarseLodCount = (uint32_t)std::stoul(argv[++argIdx]);
+        }
+        else
+        {
+            positional.push_back(argument);
+        }
+    }
+    if(positional.size() != 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <input.obj|input.gltf|input.glb> <output.mesh> [--full] [--lods <count>] [--no-fit]\n";
+        return 1;
+    }
+
+    std::vector<Vertex> soup;
+    try
+    {
+        const std::string extension = std::filesystem::path{positional[0]}.extension().string();
+        soup = (extension == ".gltf" || extension == ".glb") ? readGltf(positional[0]) : readObj(positional[0]);
+    }
+    catch(const std::exception & aException)
+    {
+        std::cerr << "Invalid mesh " << positional[0] << ": " << aException.what() << "\n";
+        return 1;
+    }
+    if(soup.empty())
+    {
+        std::cerr << "No triangles read from " << positional[0] << ".\n";
+        return 1;
+    }
+    if(fit)
+    {
+        fitInViewVolume(soup);
+    }
+
+    //
+    // Optimization and levels of detail
+    //
+    IndexedMesh<Vertex> mesh = deduplicateVertices<Vertex>(soup);
+    const MeshOptimizationReport report = optimizeMesh(mesh);
+    std::cout << report.mTriangleCount << " triangles, " << report.mVertexCountAfter << " vertices ("
+              << soup.size() << " before deduplication).\n"
+              << "ACMR (FIFO " << gVertexCacheSize << "): " << report.mAcmrBefore << " -> " << report.mAcmrAfter
+              << ", optimized at " << report.getTrianglesPerSecond() / 1e6 << " M triangles/s.\n";
+
+    std::array<float, 3> boundsMin{INFINITY, INFINITY, INFINITY};
+    std::array<float, 3> boundsMax{-INFINITY, -INFINITY, -INFINITY};
+    for(const Vertex & vertex : mesh.mVertices)
+    {
+        for(std::size_t axis = 0; axis != 3; ++axis)
+        {
+            boundsMin[axis] = std::min(boundsMin[axis], vertex.mPosition[axis]);
+            boundsMax[axis] = std::max(boundsMax[axis], vertex.mPosition[axis]);
+        }
+    }
+    const float extent = std::max({boundsMax[0] - boundsMin[0], boundsMax[1] - boundsMin[1], boundsMax[2] - boundsMin[2]});
+
+    // Each coarser LOD halves the resolution of the clustering grid, starting from 64 cells along the extent
+    std::vector<meshfile::Lod> lods{{.mFirstIndex = 0, .mIndexCount = (uint32_t)mesh.mIndices.size(), .mError = 0.f}};
+    std::vector<uint32_t> indices = mesh.mIndices;
+    for(uint32_t lodIdx = 0; lodIdx != coarseLodCount; ++lodIdx)
+    {
+        // Stop before the grid is a single cell (or has no cell left), or if the mesh is a single point
+        const uint32_t cellCount = 64u >> lodIdx;
+        if(cellCount < 2 || !(extent > 0.f))
+        {
+            break;
+        }
+        const float cellSize = extent / cellCount;
+        std::vector<uint32_t> lodIndices = optimizeVertexCache(simplifyByClustering(mesh, cellSize), mesh.mVertices.size());
+        // A LOD must be coarser than the previous one
+        if(lodIndices.empty() || lodIndices.size() >= lods.back().mIndexCount)
+        {
+            break;
+        }
+        lods.push_back({
+            .mFirstIndex = (uint32_t)indices.size(),
+            .mIndexCount = (uint32_t)lodIndices.size(),
+            .mError = cellSize * std::sqrt(3.f),
+        });
+        std::cout << "LOD " << lods.size() - 1 << ": " << lodIndices.size() / 3 << " triangles.\n";
+        indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+    }
+    // The coarser LODs reference a subset of the vertices, first used by the full mesh: its fetch order is kept
+    mesh.mIndices = std::move(indices);
+    optimizeVertexFetch(mesh);
+
+    //
+    // Encoding
+    //
+    const VertexLayout & layout = full ? gFullVertexLayout : gCompactVertexLayout;
+    const std::vector<std::byte> vertexData = encodeVertices(layout, mesh.mVertices);
+
+    const bool shortIndices = mesh.mVertices.size() <= 0x10000;
+    std::vector<std::byte> indexData(mesh.mIndices.size() * (shortIndices ? sizeof(uint16_t) : sizeof(uint32_t)));
+    for(std::size_t indexIdx = 0; indexIdx != mesh.mIndices.size(); ++indexIdx)
+    {
+        if(shortIndices)
+        {
+            reinterpret_cast<uint16_t *>(indexData.data())[indexIdx] = (uint16_t)mesh.mIndices[indexIdx];
+        }
+        else
+        {
+            reinterpret_cast<uint32_t *>(indexData.data())[indexIdx] = mesh.mIndices[indexIdx];
+        }
+    }
+
+    std::vector<meshfile::Attribute> attributes;
+    for(std::size_t attributeIdx = 0; attributeIdx != layout.mAttributes.size(); ++attributeIdx)
+    {
+        attributes.push_back({
+            .mLocation = layout.mAttributes[attributeIdx].mLocation,
+            .mFormat = (uint32_t)layout.mAttributes[attributeIdx].mFormat,
+            .mOffset = layout.getOffset(attributeIdx),
+            .mReserved = 0,
+        });
+    }
+
+    std::array<float, 3> center;
+    float radius = 0.f;
+    for(std::size_t axis = 0; axis != 3; ++axis)
+    {
+        center[axis] = 0.5f * (boundsMin[axis] + boundsMax[axis]);
+    }
+    for(const Vertex & vertex : mesh.mVertices)
+    {
+        const float dx = vertex.mPosition[0] - center[0];
+        const float dy = vertex.mPosition[1] - center[1];
+        const float dz = vertex.mPosition[2] - center[2];
+        radius = std::max(radius, std::sqrt(dx * dx + dy * dy + dz * dz));
+    }
+
+    const uint64_t tablesEnd = sizeof(meshfile::Header)
+                               + attributes.size() * sizeof(meshfile::Attribute)
+                               + lods.size() * sizeof(meshfile::Lod);
+    const uint64_t vertexOffset = alignUp(tablesEnd, meshfile::gChunkAlignment);
+    const uint64_t indexOffset = alignUp(vertexOffset + vertexData.size(), meshfile::gChunkAlignment);
+    const meshfile::Header header{
+        .mMagic = meshfile::gMagic,
+        .mVersion = meshfile::gVersion,
+        .mAttributeCount = (uint32_t)attributes.size(),
+        .mLodCount = (uint32_t)lods.size(),
+        .mVertexCount = (uint32_t)mesh.mVertices.size(),
+        .mVertexStride = layout.getStride(),
+        .mIndexType = shortIndices ? (uint32_t)VK_INDEX_TYPE_UINT16 : (uint32_t)VK_INDEX_TYPE_UINT32,
+        .mReserved0 = 0,
+        .mVertices = {.mOffset = vertexOffset, .mSize = vertexData.size()},
+        .mIndices = {.mOffset = indexOffset, .mSize = indexData.size()},
+        .mBoundsMin = boundsMin,
+        .mBoundsMax = boundsMax,
+        .mBoundingSphere = {center[0], center[1], center[2], radius},
+        .mReserved1 = 0,
+        .mReserved2 = 0,
+    };
+
+    std::ofstream output{positional[1], std::ios_base::binary | std::ios_base::trunc};
+    const char padding[meshfile::gChunkAlignment]{};
+    output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    output.write(reinterpret_cast<const char *>(attributes.data()), attributes.size() * sizeof(meshfile::Attribute));
+    output.write(reinterpret_cast<const char *>(lods.data()), lods.size() * sizeof(meshfile::Lod));
+    output.write(padding, vertexOffset - tablesEnd);
+    output.write(reinterpret_cast<const char *>(vertexData.data()), vertexData.size());
+    output.write(padding, indexOffset - (vertexOffset + vertexData.size()));
+    output.write(reinterpret_cast<const char *>(indexData.data()), indexData.size());
+    if(!output)
+    {
+        std::cerr << "Failed to write " << positional[1] << ".\n";
+        return 1;
+    }
+
+    std::cout << "Converted " << positional[0] << " into " << positional[1]
+              << " (" << indexOffset + indexData.size() << " bytes, " << lods.size() << " LODs).\n";
+    return 0;
+}
@@ -0,0 +1,96 @@
+// Offline tool, measuring the CPU frustum culling (see FrustumCulling.h) against the number of worker threads.
+//
+// Usage: CullBenchmark [object count] [max threads] [repetitions]
+//
+// The objects are randomly placed and oriented boxes around a perspective camera, about a sixth of them in view.
+// Each thread count culls `repetitions` times, the best time is reported, and the visible list is checked
+// against the scalar reference.
+
+#include "../FrustumCulling.h"
+#include "../Math.h"
+#include "../WorkerPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cstdint>
+
+
+namespace {
+
+    BoundingVolumes generateVolumes(uint32_t aCount)
+    {
+        std::mt19937 generator{0};
+        std::uniform_real_distribution<float> position{-100.f, 100.f};
+        std::uniform_real_distribution<float> unit{-1.f, 1.f};
+        std::uniform_real_distribution<float> scale{0.2f, 2.f};
+
+        const Aabb unitCube{.mMin = {-1.f, -1.f, -1.f}, .mMax = {1.f, 1.f, 1.f}};
+        const Sphere unitSphere{.mCenter = {0.f, 0.f, 0.f}, .mRadius = std::sqrt(3.f)};
+        BoundingVolumes result;
+        result.resize(aCount);
+        for(uint32_t objectIdx = 0; objectIdx != aCount; ++objectIdx)
+        {
+            const math::Mat4 model = math::composeTrs(
+                {position(generator), position(generator), position(generator)},
+                math::fromAxisAngle({unit(generator), unit(generator), 1.f}, 3.f * unit(generator)),
+                {scale(generator), scale(generator), scale(generator)});
+            result.set(objectIdx, transformSphere(model, unitSphere), transformAabb(model, unitCube));
+        }
+        return result;
+    }
+
+} // anonymous namespace
+
+
+int main(int argc, char ** argv)
+{
+    const uint32_t objectCount = argc > 1 ? (uint32_t)std::stoul(argv[1]) : 1'000'000;
+    const unsigned int maxThreads = argc > 2
+        ? (unsigned int)std::stoul(argv[2])
+        : std::max(1u, std::thread::hardware_concurrency());
+    const unsigned int repetitions = argc > 3 ? (unsigned int)std::stoul(argv[3]) : 20;
+
+    const BoundingVolumes volumes = generateVolumes(objectCount);
+    const Frustum frustum = extractFrustum(math::perspective(1.f, 16.f / 9.f, 0.1f, 150.f)
+                                           * math::lookAt({0.f, 0.f, 0.f}, {1.f, 0.f, -1.f}, {0.f, 1.f, 0.f}));
+
+    std::vector<uint32_t> reference(objectCount);
+    const auto referenceStart = std::chrono::steady_clock::now();
+    reference.resize(culling::scalar::cullRange(volumes, frustum, 0, objectCount, reference.data()));
+    const double referenceMs =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - referenceStart).count();
+    std::cout << "ISA: " << getSimdIsaName() << ", " << objectCount << " objects, " << reference.size() << " visible.\n"
+              << "Scalar reference: " << objectCount / referenceMs << " objects/ms.\n";
+
+    std::vector<uint32_t> visible(objectCount);
+    double singleThreadMs = 0.;
+    for(unsigned int threadCount = 1; threadCount <= maxThreads; ++threadCount)
+    {
+        // The calling thread runs jobs too
+        WorkerPool workers{threadCount - 1};
+        double bestMs = INFINITY;
+        uint32_t visibleCount = 0;
+        for(unsigned int repetitionIdx = 0; repetitionIdx != repetitions; ++repetitionIdx)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            visibleCount = culling::cull(volumes, frustum, visible, workers);
+            bestMs = std::min(bestMs, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        if(!std::equal(reference.begin(), reference.end(), visible.begin(), visible.begin() + visibleCount))
+        {
+            std::cerr << "The visible list differs from the scalar reference with " << threadCount << " thread(s).\n";
+            return 1;
+        }
+        singleThreadMs = threadCount == 1 ? bestMs : singleThreadMs;
+        std::cout << threadCount << " thread(s): " << objectCount / bestMs << " objects/ms (x"
+                  << singleThreadMs / bestMs << ").\n";
+    }
+    return 0;
+}
@@ -0,0 +1,128 @@
+// Build-time tool, generating a header embedding the SPIR-V modules of a directory (see EmbeddedShader.h).
+//
+// Usage: EmbedShaders <spirv directory> <output header>
+//
+// Each `<Name>.<stage>.spv` file (glslang naming, e.g. Forward.vert.spv) becomes a `constexpr std::array<uint32_t, N>`,
+// listed under `<Name>.<stage>` in `embedded::gShaders`. Each module is reflected, so that an invalid one fails the build.
+
+#include "../FileHelper.h"
+#include "../SpirvReflection.h"
+
+#include <algorithm>
+#include <cctype>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+
+namespace {
+
+    struct Input
+    {
+        std::string mName;
+        std::filesystem::path mPath;
+    };
+
+    /// @brief C++ identifier of the code array, e.g. "gForward_vertCode" for "Forward.vert".
+    std::string getIdentifier(const std::string & aName)
+    {
+        std::string result = "g";
+        for(char character : aName)
+        {
+            result.push_back(std::isalnum((unsigned char)character) ? character : '_');
+        }
+        return result + "Code";
+    }
+
+} // anonymous namespace
+
+
+int main(int argc, char ** argv)
+{
+    if(argc != 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <spirv directory> <output header>\n";
+        return 1;
+    }
+    const std::filesystem::path inputDirectory{argv[1]};
+    const std::filesystem::path outputPath{argv[2]};
+
+    std::vector<Input> inputs;
+    for(const std::filesystem::directory_entry & file : std::filesystem::directory_iterator{inputDirectory})
+    {
+        if(file.is_regular_file() && file.path().extension() == ".spv")
+        {
+            inputs.push_back({.mName = file.path().stem().string(), .mPath = file.path()});
+        }
+    }
+    // The runtime binary searches the list
+    std::ranges::sort(inputs, {}, &Input::mName);
+
+    std::ostringstream arrays;
+    std::ostringstream list;
+    arrays << std::hex << std::setfill('0');
+    for(const Input & input : inputs)
+    {
+        const MappedFile file{input.mPath};
+        const std::span<const std::byte> bytes = file.getBytes();
+        if(bytes.size() % sizeof(uint32_t) != 0)
+        {
+            std::cerr << input.mPath << " is not a SPIR-V module.\n";
+            return 1;
+        }
+        const std::span<const uint32_t> code{reinterpret_cast<const uint32_t *>(bytes.data()), bytes.size() / sizeof(uint32_t)};
+
+        try
+        {
+            reflectSpirv(code);
+        }
+        catch(const std::exception & aException)
+        {
+            std::cerr << input.mPath << ": " << aException.what() << "\n";
+            return 1;
+        }
+
+        const std::string identifier = getIdentifier(input.mName);
+        arrays << "    inline constexpr std::array<uint32_t, " << std::dec << code.size() << std::hex << "> "
+               << identifier << "{";
+        for(std::size_t wordIdx = 0; wordIdx != code.size(); ++wordIdx)
+        {
+            arrays << (wordIdx % 8 == 0 ? "\n        " : " ") << "0x" << std::setw(8) << code[wordIdx] << ",";
+        }
+        arrays << "\n    };\n\n";
+
+        list << "        {\n"
+             << "            .mName = \"" << input.mName << "\",\n"
+             << "            .mCode = " << identifier << ",\n"
+             << "        },\n";
+    }
+
+    std::ofstream output{outputPath, std::ios_base::trunc};
+    output << "// Generated by tools/EmbedShaders.cpp from " << inputDirectory.generic_string() << ", do not edit.\n"
+           << "#pragma once\n\n\n"
+           << "#include \"../../EmbeddedShader.h\"\n\n"
+           << "#include <array>\n\n"
+           << "#include <cstdint>\n\n\n"
+           << "namespace embedded {\n\n"
+           << arrays.str()
+           << "    // Sorted by name, see getEmbeddedShader()\n"
+           << "    inline constexpr std::array<EmbeddedShader, " << inputs.size() << "> gShaders{{\n"
+           << list.str()
+           << "    }};\n\n"
+           << "} // namespace embedded\n";
+    if(!output)
+    {
+        std::cerr << "Failed to write " << outputPath << ".\n";
+        return 1;
+    }
+
+    std::cout << "Embedded " << inputs.size() << " shaders into " << outputPath << ".\n";
+    return 0;
+}
@@ -0,0 +1,237 @@
+// Offline tool, measuring the vertex attribute encoders of VertexLayout.h against their scalar reference, and checking their results.
+//
+// Usage: EncodeBenchmark [vertex count] [repetitions]
+//
+// The instruction set is selected at compile time (see Simd.h): build once per ISA to compare them,
+// e.g. with the "build encode benchmark" and "build encode benchmark (AVX2)" tasks (the latter using F16C for half floats).
+// The sources are 4 floats per vertex, partly out of the range of each format to exercise the clamping,
+// and the outputs are interleaved in a compact vertex, as they are in vertex buffers.
+
+#include "../VertexLayout.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+
+namespace {
+
+    using Kernel = void(*)(const float (&)[4], std::byte *);
+
+    struct Encoder
+    {
+        const char * mName;
+        AttributeFormat mFormat;
+        Kernel mScalar;
+        Kernel mVectorized;
+    };
+
+    const Encoder gEncoders[] = {
+        {"Float16x4", AttributeFormat::Float16x4, encode::scalar::toFloat16x4, encode::toFloat16x4},
+        {"Snorm16x4", AttributeFormat::Snorm16x4, encode::scalar::toSnorm16x4, encode::toSnorm16x4},
+        {"Unorm8x4", AttributeFormat::Unorm8x4, encode::scalar::toUnorm8x4, encode::toUnorm8x4},
+        {"Snorm10x3_2", AttributeFormat::Snorm10x3_2, encode::scalar::toSnorm10x3_2, encode::toSnorm10x3_2},
+        {"Unorm10x3_2", AttributeFormat::Unorm10x3_2, encode::scalar::toUnorm10x3_2, encode::toUnorm10x3_2},
+    };
+
+    // Stride of the encoded vertices: position, normal and color in the compact formats.
+    constexpr std::size_t gOutStride = 16;
+
+    std::vector<float> generateComponents(AttributeFormat aFormat, std::size_t aVertexCount)
+    {
+        std::mt19937 generator{0};
+        std::vector<float> result(4 * aVertexCount);
+        if(aFormat == AttributeFormat::Float16x4)
+        {
+            // Magnitudes from half denormals to beyond the largest half, with both signs
+            std::uniform_real_distribution<float> exponent{-26.f, 17.f};
+            std::bernoulli_distribution negative{0.5};
+            for(float & component : result)
+            {
+                component = std::exp2(exponent(generator)) * (negative(generator) ? -1.f : 1.f);
+            }
+        }
+        else
+        {
+            std::uniform_real_distribution<float> value{-1.25f, 1.25f};
+            for(float & component : result)
+            {
+                component = value(generator);
+            }
+        }
+        return result;
+    }
+
+    float halfToFloat(uint16_t aHalf)
+    {
+        const uint32_t sign = (uint32_t)(aHalf & 0x8000) << 16;
+        const uint32_t exponent = (aHalf >> 10) & 0x1f;
+        const uint32_t mantissa = aHalf & 0x3ff;
+        float magnitude;
+        if(exponent == 0)
+        {
+            magnitude = std::ldexp((float)mantissa, -24);
+        }
+        else if(exponent == 0x1f)
+        {
+            magnitude = mantissa == 0 ? INFINITY : NAN;
+        }
+        else
+        {
+            magnitude = std::ldexp((float)(mantissa | 0x400), (int)exponent - 25);
+        }
+        return std::bit_cast<float>(std::bit_cast<uint32_t>(magnitude) | sign);
+    }
+
+    /// @brief Reads back the 4 components of an attribute in aFormat, as the vertex input stage would.
+    void decode(AttributeFormat aFormat, const std::byte * aIn, float (&aOut)[4])
+    {
+        switch(aFormat)
+        {
+            case AttributeFormat::Float16x4:
+            {
+                uint16_t halves[4];
+                std::memcpy(halves, aIn, sizeof(halves));
+                for(int componentIdx = 0; componentIdx != 4; ++componentIdx)
+                {
+                    aOut[componentIdx] = halfToFloat(halves[componentIdx]);
+                }
+                break;
+            }
+            case AttributeFormat::Snorm16x4:
+            {
+                int16_t values[4];
+                std::memcpy(values, aIn, sizeof(values));
+                for(int componentIdx = 0; componentIdx != 4; ++componentIdx)
+                {
+                    aOut[componentIdx] = std::max(values[componentIdx] / 32767.f, -1.f);
+                }
+                break;
+            }
+            case AttributeFormat::Unorm8x4:
+                for(int componentIdx = 0; componentIdx != 4; ++componentIdx)
+                {
+                    aOut[componentIdx] = std::to_integer<int>(aIn[componentIdx]) / 255.f;
+                }
+                break;
+            case AttributeFormat::Snorm10x3_2:
+            case AttributeFormat::Unorm10x3_2:
+            {
+                uint32_t packed;
+                std::memcpy(&packed, aIn, sizeof(packed));
+                const bool isSigned = aFormat == AttributeFormat::Snorm10x3_2;
+                for(int componentIdx = 0; componentIdx != 4; ++componentIdx)
+                {
+                    const int bits = componentIdx == 3 ? 2 : 10;
+                    const uint32_t field = (packed >> (10 * componentIdx)) & ((1u << bits) - 1);
+                    if(isSigned)
+                    {
+                        // Sign extend the field
+                        const int32_t value = (int32_t)(field << (32 - bits)) >> (32 - bits);
+                        aOut[componentIdx] = std::max(value / (float)((1 << (bits - 1)) - 1), -1.f);
+                    }
+                    else
+                    {
+                        aOut[componentIdx] = field / (float)((1u << bits) - 1);
+                    }
+                }
+                break;
+            }
+            case AttributeFormat::Float32x3:
+                std::memcpy(aOut, aIn, 3 * sizeof(float));
+                aOut[3] = 1.f;
+                break;
+        }
+    }
+
+    /// @return The largest difference between the decoded components of aLeft and aRight.
+    float getMaxError(AttributeFormat aFormat, const std::vector<std::byte> & aLeft, const std::vector<std::byte> & aRight)
+    {
+        float result = 0.f;
+        for(std::size_t offset = 0; offset != aLeft.size(); offset += gOutStride)
+        {
+            float left[4];
+            float right[4];
+            decode(aFormat, aLeft.data() + offset, left);
+            decode(aFormat, aRight.data() + offset, right);
+            for(int componentIdx = 0; componentIdx != 4; ++componentIdx)
+            {
+                // Also equal when both are the same infinity
+                if(left[componentIdx] != right[componentIdx])
+                {
+                    result = std::max(result, std::abs(left[componentIdx] - right[componentIdx]));
+                }
+            }
+        }
+        return result;
+    }
+
+    /// @return The best time of aRepetitions calls to aFunction, in milliseconds.
+    template <class T_function>
+    double measure(unsigned int aRepetitions, T_function && aFunction)
+    {
+        double result = INFINITY;
+        for(unsigned int repetitionIdx = 0; repetitionIdx != aRepetitions; ++repetitionIdx)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            aFunction();
+            result = std::min(result, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        return result;
+    }
+
+} // anonymous namespace
+
+
+int main(int argc, char ** argv)
+{
+    const std::size_t count = argc > 1 ? std::stoul(argv[1]) : 1'000'000;
+    const unsigned int repetitions = argc > 2 ? (unsigned int)std::stoul(argv[2]) : 20;
+
+    std::vector<std::byte> reference(count * gOutStride);
+    std::vector<std::byte> vectorized(count * gOutStride);
+
+    std::cout << "ISA: " << getSimdIsaName()
+#if defined(SIMD_F16C)
+              << " (F16C)"
+#endif
+              << ", " << count << " vertices.\n";
+
+    bool valid = true;
+    for(const Encoder & encoder : gEncoders)
+    {
+        const std::vector<float> components = generateComponents(encoder.mFormat, count);
+        const std::byte * in = reinterpret_cast<const std::byte *>(components.data());
+        auto encodeWith = [&](Kernel aKernel, std::vector<std::byte> & aOut)
+        {
+            encode::encodeStream(aKernel, in, 4 * sizeof(float), 4, aOut.data(), gOutStride, count);
+        };
+
+        const double scalarMs = measure(repetitions, [&]{ encodeWith(encoder.mScalar, reference); });
+        const double vectorizedMs = measure(repetitions, [&]{ encodeWith(encoder.mVectorized, vectorized); });
+        // Both round to nearest even and clamp the same way: the results are expected to be identical
+        const float error = getMaxError(encoder.mFormat, reference, vectorized);
+        valid = valid && error == 0.f;
+
+        std::cout << encoder.mName << ": scalar " << count / scalarMs / 1e3 << " M/s, "
+                  << getSimdIsaName() << " " << count / vectorizedMs / 1e3 << " M/s (x" << scalarMs / vectorizedMs
+                  << "), " << count * getSize(encoder.mFormat) / vectorizedMs / 1e6 << " GB/s written, max error "
+                  << error << "\n";
+    }
+
+    if(!valid)
+    {
+        std::cerr << "The " << getSimdIsaName() << " results differ from the scalar reference.\n";
+        return 1;
+    }
+    return 0;
+}
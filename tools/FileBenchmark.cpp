@@ -0,0 +1,139 @@
+// Offline tool, measuring the load time of files through MappedFile against readFile() (see FileHelper.h).
+//
+// Usage: FileBenchmark [directory] [repetitions]
+//
+// Loads all the regular files of the directory (shaders/spirv by default), `repetitions` times per method,
+// and reports the best time of a pass. Each pass reads every byte, as creating the shader modules does,
+// so the mapped pages are all touched. The files are in the OS cache after the first pass:
+// this measures the per-file overhead and the copy, not the disk.
+// The former readFile(), copying through std::istreambuf_iterator, is measured as a baseline.
+
+#include "../FileHelper.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <numeric>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace {
+
+    /// @brief readFile() as it was before the single read.
+    std::vector<char> readFileByChar(const std::filesystem::path & aPath)
+    {
+        std::ifstream ifs{aPath, std::ios_base::binary};
+        return std::vector<char>{
+            std::istreambuf_iterator<char>{ifs},
+            std::istreambuf_iterator<char>{},
+        };
+    }
+
+    /// @brief Reads all the bytes, standing for the consumer of the file content.
+    uint64_t sumBytes(std::span<const char> aContent)
+    {
+        return std::accumulate(aContent.begin(), aContent.end(), uint64_t{0},
+                               [](uint64_t aSum, char aByte){ return aSum + (unsigned char)aByte; });
+    }
+
+    /// @return The best time of aRepetitions calls to aFunction, in milliseconds.
+    template <class T_function>
+    double measure(unsigned int aRepetitions, T_function && aFunction)
+    {
+        double result = INFINITY;
+        for(unsigned int repetitionIdx = 0; repetitionIdx != aRepetitions; ++repetitionIdx)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            aFunction();
+            result = std::min(result, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        return result;
+    }
+
+} // anonymous namespace
+
+
+int main(int argc, char ** argv)
+{
+    const std::filesystem::path directory = argc > 1 ? argv[1] : "shaders/spirv";
+    const unsigned int repetitions = argc > 2 ? (unsigned int)std::stoul(argv[2]) : 1000;
+
+    std::vector<std::filesystem::path> paths;
+    std::uintmax_t totalSize = 0;
+    for(const std::filesystem::directory_entry & entry : std::filesystem::directory_iterator{directory})
+    {
+        if(entry.is_regular_file())
+        {
+            paths.push_back(entry.path());
+            totalSize += entry.file_size();
+        }
+    }
+    if(paths.empty())
+    {
+        std::cerr << "No file in '" << directory.string() << "'.\n";
+        return 1;
+    }
+    std::cout << paths.size() << " files, " << totalSize << " bytes, in '" << directory.string() << "'.\n";
+
+    auto report = [&](const char * aName, double aMs)
+    {
+        std::cout << aName << ": " << aMs * 1e3 << " us per pass, " << aMs * 1e3 / paths.size() << " us per file, "
+                  << totalSize / aMs / 1e6 << " GB/s\n";
+    };
+
+    // Each method sums the bytes of its last pass, to check they all read the same content
+    uint64_t byCharSum = 0;
+    const double byCharMs = measure(repetitions, [&]
+    {
+        byCharSum = 0;
+        for(const std::filesystem::path & path : paths)
+        {
+            const std::vector<char> content = readFileByChar(path);
+            byCharSum += sumBytes(content);
+        }
+    });
+
+    uint64_t readSum = 0;
+    const double readMs = measure(repetitions, [&]
+    {
+        readSum = 0;
+        for(const std::filesystem::path & path : paths)
+        {
+            const std::vector<char> content = readFile(path);
+            readSum += sumBytes(content);
+        }
+    });
+
+    uint64_t mappedSum = 0;
+    const double mappedMs = measure(repetitions, [&]
+    {
+        mappedSum = 0;
+        for(const std::filesystem::path & path : paths)
+        {
+            const MappedFile file{path};
+            mappedSum += sumBytes(file.getChars());
+        }
+    });
+
+    report("readFile (istreambuf_iterator)", byCharMs);
+    report("readFile", readMs);
+    report("MappedFile", mappedMs);
+    std::cout << "MappedFile speedup: x" << readMs / mappedMs << " over readFile, x" << byCharMs / mappedMs
+              << " over the istreambuf_iterator copy.\n";
+
+    if(byCharSum != readSum || readSum != mappedSum)
+    {
+        std::cerr << "The methods read different contents.\n";
+        return 1;
+    }
+    return 0;
+}
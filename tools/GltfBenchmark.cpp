@@ -0,0 +1,179 @@
+// Offline tool, measuring the glTF import time (see Gltf.h) against the number of worker threads.
+//
+// Usage: GltfBenchmark <scene.gltf|scene.glb> [max threads] [repetitions]
+//        GltfBenchmark --synthetic <mesh count> [max threads] [repetitions]
+//
+// The synthetic scene is a .glb of grid meshes (16-bit indices, normalized byte colors, one node each),
+// written to the working directory, so the benchmark runs without assets.
+// Each thread count imports the scene `repetitions` times, the best time is reported (the first import warms the file cache).
+
+#include "../Gltf.h"
+#include "../VertexLayout.h"
+#include "../WorkerPool.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cstdint>
+#include <cstring>
+
+
+namespace {
+
+    template <class T_value>
+    void append(std::vector<std::byte> & aOut, const T_value & aValue)
+    {
+        const std::size_t offset = aOut.size();
+        aOut.resize(offset + sizeof(T_value));
+        std::memcpy(aOut.data() + offset, &aValue, sizeof(T_value));
+    }
+
+    void pad(std::vector<std::byte> & aOut)
+    {
+        aOut.resize((aOut.size() + 3) / 4 * 4);
+    }
+
+    /// @brief Writes a .glb of aMeshCount grids of aSide x aSide quads.
+    void writeSyntheticScene(const std::string & aPath, uint32_t aMeshCount, uint32_t aSide)
+    {
+        const uint32_t vertexCount = (aSide + 1) * (aSide + 1);
+        const uint32_t indexCount = 6 * aSide * aSide;
+
+        // The grids are identical, but each mesh has its own accessors so that each is converted
+        std::vector<std::byte> binary;
+        std::string bufferViews;
+        std::string accessors;
+        std::string meshes;
+        std::string nodes;
+        std::string rootNodes;
+        for(uint32_t meshIdx = 0; meshIdx != aMeshCount; ++meshIdx)
+        {
+            const std::size_t positionOffset = binary.size();
+            for(uint32_t row = 0; row <= aSide; ++row)
+            {
+                for(uint32_t column = 0; column <= aSide; ++column)
+                {
+                    append(binary, std::array<float, 3>{(float)column / aSide, (float)row / aSide, 0.f});
+                }
+            }
+            const std::size_t colorOffset = binary.size();
+            for(uint32_t vertexIdx = 0; vertexIdx != vertexCount; ++vertexIdx)
+            {
+                append(binary, std::array<uint8_t, 4>{(uint8_t)vertexIdx, (uint8_t)(vertexIdx >> 8), (uint8_t)meshIdx, 255});
+            }
+            const std::size_t indexOffset = binary.size();
+            for(uint32_t row = 0; row != aSide; ++row)
+            {
+                for(uint32_t column = 0; column != aSide; ++column)
+                {
+                    const uint16_t corner = (uint16_t)(row * (aSide + 1) + column);
+                    const uint16_t above = (uint16_t)(corner + aSide + 1);
+                    append(binary, std::array<uint16_t, 6>{corner, (uint16_t)(corner + 1), (uint16_t)(above + 1),
+                                                           corner, (uint16_t)(above + 1), above});
+                }
+            }
+            pad(binary);
+
+            const std::string separator = meshIdx == 0 ? "" : ",";
+            const std::string first = std::to_string(3 * meshIdx);
+            bufferViews += separator
+                + "{\"buffer\":0,\"byteOffset\":" + std::to_string(positionOffset) + ",\"byteLength\":" + std::to_string(colorOffset - positionOffset) + "},"
+                + "{\"buffer\":0,\"byteOffset\":" + std::to_string(colorOffset) + ",\"byteLength\":" + std::to_string(indexOffset - colorOffset) + "},"
+                + "{\"buffer\":0,\"byteOffset\":" + std::to_string(indexOffset) + ",\"byteLength\":" + std::to_string(2 * indexCount) + "}";
+            accessors += separator
+                + "{\"bufferView\":" + first + ",\"componentType\":5126,\"count\":" + std::to_string(vertexCount) + ",\"type\":\"VEC3\"},"
+                + "{\"bufferView\":" + std::to_string(3 * meshIdx + 1) + ",\"componentType\":5121,\"normalized\":true,\"count\":" + std::to_string(vertexCount) + ",\"type\":\"VEC4\"},"
+                + "{\"bufferView\":" + std::to_string(3 * meshIdx + 2) + ",\"componentType\":5123,\"count\":" + std::to_string(indexCount) + ",\"type\":\"SCALAR\"}";
+            meshes += separator
+                + "{\"name\":\"grid" + std::to_string(meshIdx) + "\",\"primitives\":[{\"attributes\":{\"POSITION\":" + first
+                + ",\"COLOR_0\":" + std::to_string(3 * meshIdx + 1) + "},\"indices\":" + std::to_string(3 * meshIdx + 2) + ",\"material\":0}]}";
+            nodes += separator
+                + "{\"mesh\":" + std::to_string(meshIdx) + ",\"translation\":[" + std::to_string(meshIdx) + ",0,0]}";
+            rootNodes += separator + std::to_string(meshIdx);
+        }
+
+        std::string json = "{\"asset\":{\"version\":\"2.0\"},\"scene\":0,\"scenes\":[{\"nodes\":[" + rootNodes + "]}],"
+            + "\"nodes\":[" + nodes + "],\"meshes\":[" + meshes + "],"
+            + "\"materials\":[{\"name\":\"grid\",\"pbrMetallicRoughness\":{\"baseColorFactor\":[1,1,1,1]}}],"
+            + "\"accessors\":[" + accessors + "],\"bufferViews\":[" + bufferViews + "],"
+            + "\"buffers\":[{\"byteLength\":" + std::to_string(binary.size()) + "}]}";
+        // The JSON chunk is padded with spaces
+        json.resize((json.size() + 3) / 4 * 4, ' ');
+
+        std::vector<std::byte> glb;
+        append(glb, gltf::detail::gGlbMagic);
+        append(glb, uint32_t{2});
+        append(glb, (uint32_t)(12 + 8 + json.size() + 8 + binary.size()));
+        append(glb, (uint32_t)json.size());
+        append(glb, gltf::detail::gGlbJsonChunk);
+        glb.insert(glb.end(), reinterpret_cast<const std::byte *>(json.data()), reinterpret_cast<const std::byte *>(json.data() + json.size()));
+        append(glb, (uint32_t)binary.size());
+        append(glb, gltf::detail::gGlbBinChunk);
+        glb.insert(glb.end(), binary.begin(), binary.end());
+
+        std::ofstream{aPath, std::ios::binary}.write(reinterpret_cast<const char *>(glb.data()), (std::streamsize)glb.size());
+    }
+
+} // anonymous namespace
+
+
+int main(int argc, char ** argv)
+{
+    if(argc < 2 || (std::string{argv[1]} == "--synthetic" && argc < 3))
+    {
+        std::cerr << "Usage: " << argv[0] << " <scene.gltf|scene.glb> [max threads] [repetitions]\n"
+                  << "       " << argv[0] << " --synthetic <mesh count> [max threads] [repetitions]\n";
+        return 1;
+    }
+
+    std::string path = argv[1];
+    int argIdx = 2;
+    if(path == "--synthetic")
+    {
+        path = "synthetic.glb";
+        writeSyntheticScene(path, (uint32_t)std::stoul(argv[argIdx++]), 255);
+    }
+    const unsigned int maxThreads = argc > argIdx
+        ? (unsigned int)std::stoul(argv[argIdx])
+        : std::max(1u, std::thread::hardware_concurrency());
+    const unsigned int repetitions = argc > argIdx + 1 ? (unsigned int)std::stoul(argv[argIdx + 1]) : 5;
+
+    std::cout << "SIMD: " << getSimdIsaName() << "\n";
+    double singleThreadMs = 0.;
+    for(unsigned int threadCount = 1; threadCount <= maxThreads; ++threadCount)
+    {
+        // The calling thread runs jobs too
+        WorkerPool workers{threadCount - 1};
+        double bestMs = INFINITY;
+        gltf::Scene scene;
+        try
+        {
+            for(unsigned int repetitionIdx = 0; repetitionIdx != repetitions; ++repetitionIdx)
+            {
+                const auto start = std::chrono::steady_clock::now();
+                scene = gltf::importScene(path, workers, gCompactVertexLayout);
+                bestMs = std::min(bestMs, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            }
+        }
+        catch(const std::exception & aException)
+        {
+            std::cerr << "Cannot import " << path << ": " << aException.what() << "\n";
+            return 1;
+        }
+        if(threadCount == 1)
+        {
+            singleThreadMs = bestMs;
+            std::cout << scene.mMeshes.size() << " meshes, " << scene.mIndices.size() / 3 << " triangles, "
+                      << (scene.mVertexData.size() + scene.mIndices.size() * sizeof(uint32_t)) / (1 << 20) << " MiB of GPU data.\n";
+        }
+        std::cout << threadCount << " thread(s): " << bestMs << " ms (x" << singleThreadMs / bestMs << ").\n";
+    }
+    return 0;
+}
@@ -0,0 +1,103 @@
+// Offline tool, measuring the world transform propagation of TransformHierarchy.h against the ratio of changed nodes.
+//
+// Usage: HierarchyBenchmark [node count] [repetitions]
+//
+// The hierarchy is a tree where each node has 8 children (7 levels for 1M nodes), given to the hierarchy in a shuffled order.
+// For each ratio, that many random nodes get a new local transform before each update, the best time is reported.
+// The world transforms are written to a write-only buffer, as they would be to mapped GPU memory,
+// and checked against a hierarchy updated from scratch.
+
+#include "../Math.h"
+#include "../TransformHierarchy.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+
+namespace {
+
+    constexpr uint32_t gChildCount = 8;
+
+    math::Mat4 generateLocal(std::mt19937 & aGenerator)
+    {
+        std::uniform_real_distribution<float> unit{-1.f, 1.f};
+        return math::composeTrs({unit(aGenerator), unit(aGenerator), unit(aGenerator)},
+                                math::fromAxisAngle({unit(aGenerator), unit(aGenerator), 1.f}, 3.f * unit(aGenerator)),
+                                {1.f, 1.f, 1.f});
+    }
+
+} // anonymous namespace
+
+
+int main(int argc, char ** argv)
+{
+    const uint32_t nodeCount = argc > 1 ? (uint32_t)std::stoul(argv[1]) : 1'000'000;
+    const unsigned int repetitions = argc > 2 ? (unsigned int)std::stoul(argv[2]) : 10;
+
+    // Node i of the tree is the input node order[i]
+    std::mt19937 generator{0};
+    std::vector<uint32_t> order(nodeCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), generator);
+    std::vector<uint32_t> parents(nodeCount);
+    std::vector<math::Mat4> locals(nodeCount);
+    for(uint32_t treeIdx = 0; treeIdx != nodeCount; ++treeIdx)
+    {
+        parents[order[treeIdx]] = treeIdx == 0 ? TransformHierarchy::gNoParent : order[(treeIdx - 1) / gChildCount];
+        locals[order[treeIdx]] = generateLocal(generator);
+    }
+
+    TransformHierarchy hierarchy{parents, locals};
+    std::vector<std::byte> output(nodeCount * sizeof(math::Mat4));
+    const auto fullStart = std::chrono::steady_clock::now();
+    hierarchy.update(output.data());
+    const double fullMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - fullStart).count();
+    std::cout << "ISA: " << getSimdIsaName() << ", " << nodeCount << " nodes, first update: " << fullMs << " ms.\n";
+
+    std::uniform_int_distribution<uint32_t> nodeDistribution{0, nodeCount - 1};
+    for(double ratio : {0., 0.0001, 0.001, 0.01, 0.1, 1.})
+    {
+        const uint32_t changedCount = (uint32_t)std::round(ratio * nodeCount);
+        double bestMs = INFINITY;
+        std::size_t updatedCount = 0;
+        for(unsigned int repetitionIdx = 0; repetitionIdx != repetitions; ++repetitionIdx)
+        {
+            for(uint32_t changeIdx = 0; changeIdx != changedCount; ++changeIdx)
+            {
+                const uint32_t nodeIdx = nodeDistribution(generator);
+                locals[nodeIdx] = generateLocal(generator);
+                hierarchy.setLocal(hierarchy.getSlot(nodeIdx), locals[nodeIdx]);
+            }
+            const auto start = std::chrono::steady_clock::now();
+            updatedCount = hierarchy.update(output.data());
+            bestMs = std::min(bestMs, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        std::cout << ratio * 100. << "% changed: " << updatedCount << " nodes updated in " << bestMs << " ms ("
+                  << updatedCount / bestMs / 1e3 << " M nodes/s).\n";
+    }
+
+    // The same operations are applied in the same order: the results are identical
+    TransformHierarchy reference{parents, locals};
+    reference.update();
+    for(uint32_t nodeIdx = 0; nodeIdx != nodeCount; ++nodeIdx)
+    {
+        const uint32_t slot = hierarchy.getSlot(nodeIdx);
+        if(std::memcmp(reference.getWorld(reference.getSlot(nodeIdx)).data(), output.data() + slot * sizeof(math::Mat4),
+                       sizeof(math::Mat4)) != 0)
+        {
+            std::cerr << "The world transform of node " << nodeIdx << " differs from the reference.\n";
+            return 1;
+        }
+    }
+    return 0;
+}
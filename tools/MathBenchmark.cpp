@@ -0,0 +1,113 @@
+// Offline tool, measuring the batch transforms of Math.h against their scalar reference, and checking their results.
+//
+// Usage: MathBenchmark [matrix count] [repetitions]
+//
+// The instruction set is selected at compile time (see Simd.h): build once per ISA to compare them,
+// e.g. with the "build math benchmark" and "build math benchmark (AVX2)" tasks, or with SIMD_FORCE_SCALAR defined.
+// The outputs are written to a write-only buffer, as they would be to mapped GPU memory.
+
+#include "../Math.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+
+
+namespace {
+
+    std::vector<math::Mat4> generateModels(std::size_t aCount)
+    {
+        std::mt19937 generator{0};
+        std::uniform_real_distribution<float> position{-100.f, 100.f};
+        std::uniform_real_distribution<float> unit{-1.f, 1.f};
+        std::uniform_real_distribution<float> scale{0.5f, 2.f};
+
+        std::vector<math::Mat4> result(aCount);
+        for(math::Mat4 & model : result)
+        {
+            model = math::composeTrs({position(generator), position(generator), position(generator)},
+                                     math::fromAxisAngle({unit(generator), unit(generator), 1.f}, 3.f * unit(generator)),
+                                     {scale(generator), scale(generator), scale(generator)});
+        }
+        return result;
+    }
+
+    /// @return The largest difference between aLeft and aRight, relative to the magnitude of the values.
+    float getMaxRelativeError(std::span<const float> aLeft, std::span<const float> aRight)
+    {
+        float result = 0.f;
+        for(std::size_t valueIdx = 0; valueIdx != aLeft.size(); ++valueIdx)
+        {
+            const float magnitude = std::max({std::abs(aLeft[valueIdx]), std::abs(aRight[valueIdx]), 1.f});
+            result = std::max(result, std::abs(aLeft[valueIdx] - aRight[valueIdx]) / magnitude);
+        }
+        return result;
+    }
+
+    /// @return The best time of aRepetitions calls to aFunction, in milliseconds.
+    template <class T_function>
+    double measure(unsigned int aRepetitions, T_function && aFunction)
+    {
+        double result = INFINITY;
+        for(unsigned int repetitionIdx = 0; repetitionIdx != aRepetitions; ++repetitionIdx)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            aFunction();
+            result = std::min(result, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        return result;
+    }
+
+} // anonymous namespace
+
+
+int main(int argc, char ** argv)
+{
+    const std::size_t count = argc > 1 ? std::stoul(argv[1]) : 100'000;
+    const unsigned int repetitions = argc > 2 ? (unsigned int)std::stoul(argv[2]) : 20;
+
+    const std::vector<math::Mat4> models = generateModels(count);
+    const math::Mat4 viewProjection = math::perspective(1.f, 16.f / 9.f, 0.1f, 1000.f)
+                                      * math::lookAt({0.f, 50.f, 200.f}, {0.f, 0.f, 0.f}, {0.f, 1.f, 0.f});
+
+    std::vector<math::Mat4> reference(count);
+    std::vector<math::Mat4> vectorized(count);
+    // Rows are written with a stride, as into per-instance data
+    constexpr std::size_t gRowsStride = sizeof(math::Mat4) + 4 * sizeof(float);
+    std::vector<std::byte> referenceRows(count * gRowsStride);
+    std::vector<std::byte> vectorizedRows(count * gRowsStride);
+
+    std::cout << "ISA: " << getSimdIsaName() << ", " << count << " matrices.\n";
+    auto report = [count](const char * aName, double aScalarMs, double aVectorizedMs, float aError)
+    {
+        std::cout << aName << ": scalar " << count / aScalarMs / 1e3 << " M/s, "
+                  << getSimdIsaName() << " " << count / aVectorizedMs / 1e3 << " M/s (x" << aScalarMs / aVectorizedMs
+                  << "), max relative error " << aError << "\n";
+        // Same operations in a different order: only rounding differences are expected
+        return aError < 1e-5f;
+    };
+
+    const double scalarMultiplyMs = measure(repetitions, [&]{ math::scalar::multiplyBatch(viewProjection, models, reference.data()); });
+    const double multiplyMs = measure(repetitions, [&]{ math::multiplyBatch(viewProjection, models, vectorized.data()); });
+    const bool multiplyValid = report("multiplyBatch", scalarMultiplyMs, multiplyMs,
+        getMaxRelativeError({reference.front().data(), 16 * count}, {vectorized.front().data(), 16 * count}));
+
+    const double scalarRowsMs = measure(repetitions, [&]{ math::scalar::multiplyToRowsBatch(viewProjection, models, referenceRows.data(), gRowsStride); });
+    const double rowsMs = measure(repetitions, [&]{ math::multiplyToRowsBatch(viewProjection, models, vectorizedRows.data(), gRowsStride); });
+    const bool rowsValid = report("multiplyToRowsBatch", scalarRowsMs, rowsMs,
+        getMaxRelativeError({reinterpret_cast<const float *>(referenceRows.data()), referenceRows.size() / sizeof(float)},
+                            {reinterpret_cast<const float *>(vectorizedRows.data()), vectorizedRows.size() / sizeof(float)}));
+
+    if(!multiplyValid || !rowsValid)
+    {
+        std::cerr << "The " << getSimdIsaName() << " results differ from the scalar reference.\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,72 @@
+// Offline tool, reporting the effect and the cost of the mesh optimizations (see MeshOptimizer.h).
+//
+// Usage: OptimizeMesh [grid side] [seed]
+//
+// The input is a regular grid of side x side quads, as a triangle soup in random triangle order:
+// the worst case for the vertex cache, as exported by tools that do not care about it.
+
+#include "../MeshOptimizer.h"
+#include "../VertexData.h"
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+
+namespace {
+
+    std::vector<Vertex> generateShuffledGrid(uint32_t aSide, uint32_t aSeed)
+    {
+        auto vertex = [aSide](uint32_t aColumn, uint32_t aRow)
+        {
+            const float u = (float)aColumn / aSide;
+            const float v = (float)aRow / aSide;
+            return Vertex{.mPosition = {2.f * u - 1.f, 2.f * v - 1.f, 0.f}, .mColor = {u, v, 1.f - u}};
+        };
+
+        using Triangle = std::array<Vertex, 3>;
+        std::vector<Triangle> triangles;
+        triangles.reserve(2 * aSide * aSide);
+        for(uint32_t row = 0; row != aSide; ++row)
+        {
+            for(uint32_t column = 0; column != aSide; ++column)
+            {
+                triangles.push_back({vertex(column, row), vertex(column + 1, row), vertex(column + 1, row + 1)});
+                triangles.push_back({vertex(column, row), vertex(column + 1, row + 1), vertex(column, row + 1)});
+            }
+        }
+        std::ranges::shuffle(triangles, std::mt19937{aSeed});
+
+        std::vector<Vertex> result;
+        result.reserve(3 * triangles.size());
+        for(const Triangle & triangle : triangles)
+        {
+            result.insert(result.end(), triangle.begin(), triangle.end());
+        }
+        return result;
+    }
+
+} // anonymous namespace
+
+
+int main(int argc, char ** argv)
+{
+    const uint32_t side = argc > 1 ? (uint32_t)std::stoul(argv[1]) : 256;
+    const uint32_t seed = argc > 2 ? (uint32_t)std::stoul(argv[2]) : 0;
+
+    const std::vector<Vertex> soup = generateShuffledGrid(side, seed);
+    IndexedMesh<Vertex> mesh = deduplicateVertices<Vertex>(soup);
+    std::cout << "Grid " << side << "x" << side << ": " << soup.size() << " soup vertices, "
+              << mesh.mVertices.size() << " unique.\n";
+
+    const MeshOptimizationReport report = optimizeMesh(mesh);
+    std::cout << "ACMR (FIFO " << gVertexCacheSize << "): " << report.mAcmrBefore << " -> " << report.mAcmrAfter << "\n"
+              << "Optimized " << report.mTriangleCount << " triangles in "
+              << std::chrono::duration<double, std::milli>(report.mDuration).count() << " ms ("
+              << report.getTrianglesPerSecond() / 1e6 << " M triangles/s).\n";
+    return 0;
+}
@@ -0,0 +1,143 @@
+// Build-time tool, packing the SPIR-V modules of a directory into a single shader pack (see ShaderPack.h).
+//
+// Usage: PackShaders <spirv directory> <output pack>
+//
+// Each `<Name>.<stage>.spv` file (glslang naming, e.g. Forward.vert.spv) is stored under `<Name>.<stage>`.
+
+#include "../FileHelper.h"
+#include "../Hash.h"
+#include "../ShaderPack.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+#include <cstring>
+
+
+namespace {
+
+    struct Input
+    {
+        std::string mName;
+        uint32_t mStage;
+        std::filesystem::path mPath;
+    };
+
+    /// @brief VkShaderStageFlagBits value from the glslang stage extension, 0 if unknown.
+    uint32_t getStage(const std::filesystem::path & aStageExtension)
+    {
+        struct Mapping
+        {
+            const char * mExtension;
+            uint32_t mStage;
+        };
+        constexpr Mapping mappings[]{
+            {".vert", 0x01}, // VK_SHADER_STAGE_VERTEX_BIT
+            {".tesc", 0x02}, // VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT
+            {".tese", 0x04}, // VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT
+            {".geom", 0x08}, // VK_SHADER_STAGE_GEOMETRY_BIT
+            {".frag", 0x10}, // VK_SHADER_STAGE_FRAGMENT_BIT
+            {".comp", 0x20}, // VK_SHADER_STAGE_COMPUTE_BIT
+            {".task", 0x40}, // VK_SHADER_STAGE_TASK_BIT_EXT
+            {".mesh", 0x80}, // VK_SHADER_STAGE_MESH_BIT_EXT
+        };
+        for(const Mapping & mapping : mappings)
+        {
+            if(aStageExtension == mapping.mExtension)
+            {
+                return mapping.mStage;
+            }
+        }
+        return 0;
+    }
+
+    uint64_t alignUp(uint64_t aValue, uint64_t aAlignment)
+    {
+        return (aValue + aAlignment - 1) / aAlignment * aAlignment;
+    }
+
+} // anonymous namespace
+
+
+int main(int argc, char ** argv)
+{
+    if(argc != 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <spirv directory> <output pack>\n";
+        return 1;
+    }
+    const std::filesystem::path inputDirectory{argv[1]};
+    const std::filesystem::path outputPath{argv[2]};
+
+    std::vector<Input> inputs;
+    for(const std::filesystem::directory_entry & file : std::filesystem::directory_iterator{inputDirectory})
+    {
+        if(!file.is_regular_file() || file.path().extension() != ".spv")
+        {
+            continue;
+        }
+        const std::filesystem::path name = file.path().stem();
+        const uint32_t stage = getStage(name.extension());
+        if(stage == 0)
+        {
+            std::cerr << "Skipping " << file.path() << ": unknown stage extension.\n";
+            continue;
+        }
+        if(name.string().size() >= sizeof(shaderpack::Entry::mName))
+        {
+            std::cerr << "Shader name " << name << " is too long.\n";
+            return 1;
+        }
+        inputs.push_back({.mName = name.string(), .mStage = stage, .mPath = file.path()});
+    }
+    // The runtime binary searches the index
+    std::ranges::sort(inputs, {}, &Input::mName);
+
+    // Blobs follow the index
+    const shaderpack::Header header{
+        .mMagic = shaderpack::gMagic,
+        .mVersion = shaderpack::gVersion,
+        .mEntryCount = (uint32_t)inputs.size(),
+        .mReserved = 0,
+    };
+    std::vector<shaderpack::Entry> index(inputs.size());
+    std::vector<std::byte> blobs;
+    const uint64_t blobsOffset = sizeof(shaderpack::Header) + index.size() * sizeof(shaderpack::Entry);
+    for(std::size_t inputIdx = 0; inputIdx != inputs.size(); ++inputIdx)
+    {
+        const MappedFile code{inputs[inputIdx].mPath};
+        if(code.getBytes().size() % sizeof(uint32_t) != 0)
+        {
+            std::cerr << inputs[inputIdx].mPath << " is not a SPIR-V module.\n";
+            return 1;
+        }
+
+        blobs.resize(alignUp(blobs.size(), shaderpack::gBlobAlignment));
+        shaderpack::Entry & entry = index[inputIdx];
+        // The entries are zero initialized, and the name length checked, so the name stays null terminated
+        std::memcpy(entry.mName, inputs[inputIdx].mName.data(), inputs[inputIdx].mName.size());
+        entry.mStage = inputs[inputIdx].mStage;
+        entry.mSize = (uint32_t)code.getBytes().size();
+        entry.mHash = hashBytes(code.getBytes());
+        entry.mOffset = blobsOffset + blobs.size();
+        blobs.insert(blobs.end(), code.getBytes().begin(), code.getBytes().end());
+    }
+
+    std::ofstream output{outputPath, std::ios_base::binary | std::ios_base::trunc};
+    output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    output.write(reinterpret_cast<const char *>(index.data()), index.size() * sizeof(shaderpack::Entry));
+    output.write(reinterpret_cast<const char *>(blobs.data()), blobs.size());
+    if(!output)
+    {
+        std::cerr << "Failed to write " << outputPath << ".\n";
+        return 1;
+    }
+
+    std::cout << "Packed " << inputs.size() << " shaders into " << outputPath << " (" << blobsOffset + blobs.size() << " bytes).\n";
+    return 0;
+}
@@ -0,0 +1,228 @@
+// Offline tool, stressing the lock-free slot allocator of the bindless heap (see DescriptorSlotAllocator in BindlessDescriptors.h),
+// and measuring it against a free-list behind a mutex. CPU only, no device is created.
+//
+// Usage: SlotBenchmark [slot count] [threads] [rounds]
+//
+// * Drain: the threads acquire slots concurrently until none is left.
+// * Churn: each thread repeatedly acquires a batch of slots and releases them in another order, `rounds` times.
+// * Refill: once the threads are joined, a single thread acquires all the slots again.
+// Each acquired slot is marked as owned, and unmarked before its release: acquiring an owned slot means two threads
+// got the same one. All the slots must be acquired by the drain and the refill, so none was lost on the way.
+
+#include "../BindlessDescriptors.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cstdint>
+
+
+namespace {
+
+    constexpr uint32_t gBatchSize = 64;
+
+    /// @brief A free-list behind a mutex, as a baseline.
+    class LockedSlotAllocator
+    {
+    public:
+        explicit LockedSlotAllocator(uint32_t aCapacity)
+        {
+            mFree.reserve(aCapacity);
+            for(uint32_t slot = aCapacity; slot != 0; --slot)
+            {
+                mFree.push_back(slot - 1);
+            }
+        }
+
+        uint32_t acquire()
+        {
+            std::lock_guard lock{mMutex};
+            if(mFree.empty())
+            {
+                return DescriptorSlotAllocator::gNoSlot;
+            }
+            const uint32_t slot = mFree.back();
+            mFree.pop_back();
+            return slot;
+        }
+
+        void release(uint32_t aSlot)
+        {
+            std::lock_guard lock{mMutex};
+            mFree.push_back(aSlot);
+        }
+
+    private:
+        std::mutex mMutex;
+        std::vector<uint32_t> mFree;
+    };
+
+    /// @brief Marks the slots owned by a thread, counting the slots acquired while owned or released while not.
+    class Ownership
+    {
+    public:
+        explicit Ownership(uint32_t aCapacity) :
+            mOwned(aCapacity)
+        {}
+
+        void acquired(uint32_t aSlot)
+        {
+            if(aSlot >= mOwned.size() || mOwned[aSlot].exchange(1, std::memory_order_relaxed) != 0)
+            {
+                mErrors.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        void released(uint32_t aSlot)
+        {
+            if(mOwned[aSlot].exchange(0, std::memory_order_relaxed) != 1)
+            {
+                mErrors.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        uint32_t getErrors() const
+        {
+            return mErrors.load();
+        }
+
+    private:
+        std::vector<std::atomic<uint8_t>> mOwned;
+        std::atomic<uint32_t> mErrors{0};
+    };
+
+    /// @brief Runs aFunction(threadIdx) on aThreadCount threads.
+    /// @return The time until all of them returned, in milliseconds.
+    template <class T_function>
+    double runThreads(unsigned int aThreadCount, T_function && aFunction)
+    {
+        std::vector<std::thread> threads;
+        const auto start = std::chrono::steady_clock::now();
+        for(unsigned int threadIdx = 0; threadIdx != aThreadCount; ++threadIdx)
+        {
+            threads.emplace_back(aFunction, threadIdx);
+        }
+        for(std::thread & thread : threads)
+        {
+            thread.join();
+        }
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    /// @return The time of the churn, in milliseconds.
+    template <class T_allocator>
+    double churn(T_allocator & aAllocator, Ownership & aOwnership, unsigned int aThreadCount, uint32_t aRounds)
+    {
+        return runThreads(aThreadCount, [&](unsigned int aThreadIdx)
+        {
+            std::mt19937 generator{aThreadIdx};
+            std::vector<uint32_t> batch;
+            batch.reserve(gBatchSize);
+            for(uint32_t roundIdx = 0; roundIdx != aRounds; ++roundIdx)
+            {
+                for(uint32_t slotIdx = 0; slotIdx != gBatchSize; ++slotIdx)
+                {
+                    const uint32_t slot = aAllocator.acquire();
+                    if(slot == DescriptorSlotAllocator::gNoSlot)
+                    {
+                        break;
+                    }
+                    aOwnership.acquired(slot);
+                    batch.push_back(slot);
+                }
+                std::shuffle(batch.begin(), batch.end(), generator);
+                for(uint32_t slot : batch)
+                {
+                    aOwnership.released(slot);
+                    aAllocator.release(slot);
+                }
+                batch.clear();
+            }
+        });
+    }
+
+} // anonymous namespace
+
+
+int main(int argc, char ** argv)
+{
+    const uint32_t capacity = argc > 1 ? (uint32_t)std::stoul(argv[1]) : 100'000;
+    const unsigned int threadCount = argc > 2
+        ? (unsigned int)std::stoul(argv[2])
+        : std::max(1u, std::thread::hardware_concurrency());
+    const uint32_t rounds = argc > 3 ? (uint32_t)std::stoul(argv[3]) : 10'000;
+
+    std::cout << capacity << " slots, " << threadCount << " threads, " << rounds << " rounds of "
+              << gBatchSize << " slots per thread.\n";
+
+    DescriptorSlotAllocator allocator{capacity};
+    Ownership ownership{capacity};
+
+    // Drain
+    std::vector<std::vector<uint32_t>> drained(threadCount);
+    const double drainMs = runThreads(threadCount, [&](unsigned int aThreadIdx)
+    {
+        // Bounded, in case a broken allocator kept handing out slots
+        for(uint32_t slot = allocator.acquire();
+            slot != DescriptorSlotAllocator::gNoSlot && drained[aThreadIdx].size() != capacity;
+            slot = allocator.acquire())
+        {
+            ownership.acquired(slot);
+            drained[aThreadIdx].push_back(slot);
+        }
+    });
+    std::size_t drainedCount = 0;
+    for(const std::vector<uint32_t> & slots : drained)
+    {
+        drainedCount += slots.size();
+    }
+    std::cout << "Drain: " << drainedCount << " slots in " << drainMs << " ms.\n";
+    runThreads(threadCount, [&](unsigned int aThreadIdx)
+    {
+        for(uint32_t slot : drained[aThreadIdx])
+        {
+            ownership.released(slot);
+            allocator.release(slot);
+        }
+    });
+
+    // Churn
+    const double lockFreeMs = churn(allocator, ownership, threadCount, rounds);
+    LockedSlotAllocator lockedAllocator{capacity};
+    Ownership lockedOwnership{capacity};
+    const double lockedMs = churn(lockedAllocator, lockedOwnership, threadCount, rounds);
+    const double operations = 2. * threadCount * rounds * gBatchSize;
+    std::cout << "Churn, lock-free: " << lockFreeMs << " ms, " << operations / lockFreeMs / 1e3 << " M acquire or release/s.\n"
+              << "Churn, mutex: " << lockedMs << " ms, " << operations / lockedMs / 1e3 << " M acquire or release/s.\n"
+              << "Lock-free speedup: x" << lockedMs / lockFreeMs << "\n";
+
+    // Refill
+    uint32_t refilledCount = 0;
+    for(uint32_t slot = allocator.acquire();
+        slot != DescriptorSlotAllocator::gNoSlot && refilledCount != capacity;
+        slot = allocator.acquire())
+    {
+        ownership.acquired(slot);
+        ++refilledCount;
+    }
+    std::cout << "Refill: " << refilledCount << " slots.\n";
+
+    if(drainedCount != capacity || refilledCount != capacity)
+    {
+        std::cerr << "Slots were lost.\n";
+        return 1;
+    }
+    if(ownership.getErrors() != 0 || lockedOwnership.getErrors() != 0)
+    {
+        std::cerr << ownership.getErrors() + lockedOwnership.getErrors() << " slots were handed out twice.\n";
+        return 1;
+    }
+    return 0;
+}
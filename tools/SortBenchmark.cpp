@@ -0,0 +1,103 @@
+// Offline tool, measuring the draw sorting (see DrawSorting.h) against the number of worker threads,
+// and the binds it saves when recording.
+//
+// Usage: SortBenchmark [draw count] [max threads] [repetitions]
+//
+// The draws are spread over 2 passes, 32 pipelines and 512 materials, at random depths, in submission order.
+// Each thread count sorts them `repetitions` times, the best time is reported, and the order is checked
+// against std::stable_sort.
+
+#include "../DrawSorting.h"
+#include "../WorkerPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cstdint>
+
+
+namespace {
+
+    std::vector<SortedDraw> generateDraws(uint32_t aCount)
+    {
+        std::mt19937 generator{0};
+        std::uniform_int_distribution<uint32_t> pass{0, 1};
+        std::uniform_int_distribution<uint32_t> pipeline{0, 31};
+        std::uniform_int_distribution<uint32_t> material{0, 511};
+        std::uniform_real_distribution<float> depth{0.1f, 1000.f};
+
+        std::vector<SortedDraw> result(aCount);
+        for(uint32_t drawIdx = 0; drawIdx != aCount; ++drawIdx)
+        {
+            // The second pass is blended, drawn back to front
+            const uint32_t drawPass = pass(generator);
+            result[drawIdx] = SortedDraw{
+                .mKey = drawkey::make(drawPass, pipeline(generator), material(generator), depth(generator), drawPass == 1),
+                .mDrawIdx = drawIdx,
+            };
+        }
+        return result;
+    }
+
+    void reportBinds(const char * aName, const std::vector<SortedDraw> & aDraws)
+    {
+        const drawsort::BindCounts binds = drawsort::record(aDraws, [](uint32_t, uint32_t){}, [](uint32_t){}, [](uint32_t){});
+        std::cout << aName << ": " << binds.mPipelines << " pipeline binds, " << binds.mMaterials << " material binds, "
+                  << binds.mDraws << " draws per frame.\n";
+    }
+
+} // anonymous namespace
+
+
+int main(int argc, char ** argv)
+{
+    const uint32_t drawCount = argc > 1 ? (uint32_t)std::stoul(argv[1]) : 100'000;
+    const unsigned int maxThreads = argc > 2
+        ? (unsigned int)std::stoul(argv[2])
+        : std::max(1u, std::thread::hardware_concurrency());
+    const unsigned int repetitions = argc > 3 ? (unsigned int)std::stoul(argv[3]) : 20;
+
+    const std::vector<SortedDraw> draws = generateDraws(drawCount);
+    std::vector<SortedDraw> reference = draws;
+    const auto referenceStart = std::chrono::steady_clock::now();
+    std::stable_sort(reference.begin(), reference.end(),
+                     [](const SortedDraw & aLeft, const SortedDraw & aRight){ return aLeft.mKey < aRight.mKey; });
+    const double referenceMs =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - referenceStart).count();
+    std::cout << drawCount << " draws.\n";
+    reportBinds("Submission order", draws);
+    reportBinds("Sorted", reference);
+    std::cout << "std::stable_sort: " << referenceMs << " ms.\n";
+
+    std::vector<SortedDraw> sorted;
+    std::vector<SortedDraw> scratch;
+    double singleThreadMs = 0.;
+    for(unsigned int threadCount = 1; threadCount <= maxThreads; ++threadCount)
+    {
+        // The calling thread runs jobs too
+        WorkerPool workers{threadCount - 1};
+        double bestMs = INFINITY;
+        for(unsigned int repetitionIdx = 0; repetitionIdx != repetitions; ++repetitionIdx)
+        {
+            sorted = draws;
+            const auto start = std::chrono::steady_clock::now();
+            drawsort::sort(sorted, scratch, workers);
+            bestMs = std::min(bestMs, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        if(!std::equal(sorted.begin(), sorted.end(), reference.begin(),
+                       [](const SortedDraw & aLeft, const SortedDraw & aRight){ return aLeft.mDrawIdx == aRight.mDrawIdx; }))
+        {
+            std::cerr << "The radix sort order differs from std::stable_sort with " << threadCount << " thread(s).\n";
+            return 1;
+        }
+        singleThreadMs = threadCount == 1 ? bestMs : singleThreadMs;
+        std::cout << threadCount << " thread(s): radix sort " << bestMs << " ms (x" << singleThreadMs / bestMs << ").\n";
+    }
+    return 0;
+}
@@ -0,0 +1,285 @@
+// Offline tool, measuring the throughput of the upload service (see UploadService.h) on the transfer queue.
+//
+// Usage: UploadBenchmark [total MiB] [producer threads] [staging MiB]
+//
+// The producer threads request uploads of mixed sizes (log-uniform, from 256 B to 64 MiB) into device local buffers,
+// while the main thread plays the render thread: each frame submits the ready copies, then a graphics submission
+// acquires the uploaded buffers, waiting on the upload timeline, with two frames in flight.
+// Reports the throughput, and the time the render thread spends in submit(), the cost of streaming to a frame.
+
+#include "../UploadService.h"
+#include "../VulkanHelpers.h"
+#include "../VulkanLoading.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <random>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cstdint>
+
+
+namespace {
+
+    constexpr VkDeviceSize gMinRequestSize = 256;
+    constexpr VkDeviceSize gMaxRequestSize = 64 * 1024 * 1024;
+    // Requests are spread over that many destination buffers of gMaxRequestSize
+    constexpr std::size_t gDestinationCount = 8;
+    constexpr std::size_t gFramesInFlight = 2;
+
+    /// @brief A headless device, with only the features used by the upload service
+    /// (so the benchmark also runs on devices without the features of the sample).
+    VkDevice createUploadDevice(VkPhysicalDevice vkPhysicalDevice, const QueueSelection & aQueueSelection)
+    {
+        std::map<uint32_t/*family*/, std::vector<float>/*priorities*/> familyPriorities;
+        for(const QueueSelection::Queue & queue : {aQueueSelection.mGraphics,
+                                                   aQueueSelection.mCompute,
+                                                   aQueueSelection.mTransfer})
+        {
+            std::vector<float> & priorities = familyPriorities[queue.mFamilyIndex];
+            if(priorities.size() <= queue.mQueueIndex)
+            {
+                priorities.resize(queue.mQueueIndex + 1, 0.f);
+            }
+            priorities[queue.mQueueIndex] = std::max(priorities[queue.mQueueIndex], queue.mPriority);
+        }
+
+        std::vector<VkDeviceQueueCreateInfo> deviceQueueCreateInfos;
+        for(const auto & [familyIndex, priorities] : familyPriorities)
+        {
+            deviceQueueCreateInfos.push_back(VkDeviceQueueCreateInfo{
+                .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+                .queueFamilyIndex = familyIndex,
+                .queueCount = (uint32_t)priorities.size(),
+                .pQueuePriorities = priorities.data(),
+            });
+        }
+
+        VkPhysicalDeviceVulkan12Features physicalDeviceVulkan12Features{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+            .timelineSemaphore = VK_TRUE,
+        };
+        VkPhysicalDeviceVulkan13Features physicalDeviceVulkan13Features{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
+            .pNext = &physicalDeviceVulkan12Features,
+            .synchronization2 = VK_TRUE,
+        };
+        VkDeviceCreateInfo deviceCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+            .pNext = &physicalDeviceVulkan13Features,
+            .queueCreateInfoCount = (uint32_t)deviceQueueCreateInfos.size(),
+            .pQueueCreateInfos = deviceQueueCreateInfos.data(),
+        };
+
+        VkDevice vkDevice;
+        assertVkSuccess(vkCreateDevice(vkPhysicalDevice, &deviceCreateInfo, pAllocator, &vkDevice));
+        return vkDevice;
+    }
+
+    /// @brief The sizes of the requests, totalling at least aTotalSize.
+    std::vector<VkDeviceSize> generateRequestSizes(VkDeviceSize aTotalSize)
+    {
+        std::mt19937 generator{0};
+        std::uniform_real_distribution<double> logSize{std::log((double)gMinRequestSize), std::log((double)gMaxRequestSize)};
+        std::vector<VkDeviceSize> result;
+        for(VkDeviceSize total = 0; total < aTotalSize; total += result.back())
+        {
+            result.push_back(std::clamp<VkDeviceSize>((VkDeviceSize)std::exp(logSize(generator)),
+                                                      gMinRequestSize, gMaxRequestSize));
+        }
+        return result;
+    }
+
+    std::string formatSize(VkDeviceSize aSize)
+    {
+        return aSize >= 1024 * 1024 ? std::to_string(aSize / (1024 * 1024)) + " MiB"
+             : aSize >= 1024 ? std::to_string(aSize / 1024) + " KiB"
+             : std::to_string(aSize) + " B";
+    }
+
+} // anonymous namespace
+
+
+int main(int argc, char ** argv)
+{
+    const VkDeviceSize totalSize = (argc > 1 ? std::stoull(argv[1]) : 4096) * 1024 * 1024;
+    const unsigned int producerCount = argc > 2 ? (unsigned int)std::stoul(argv[2]) : 4;
+    const VkDeviceSize stagingCapacity = (argc > 3 ? std::stoull(argv[3]) : 64) * 1024 * 1024;
+
+    initializeVulkan();
+    VkInstance vkInstance = createInstance("upload_benchmark", VK_API_VERSION_1_3);
+    initializeForInstance(vkInstance);
+    VkPhysicalDevice vkPhysicalDevice = enumeratePhysicalDevices(vkInstance).front();
+    const QueueSelection queueSelection = pickQueueFamily(vkInstance, vkPhysicalDevice);
+    VkDevice vkDevice = createUploadDevice(vkPhysicalDevice, queueSelection);
+    initializeForDevice(vkDevice);
+    const Queues queues = getQueues(vkDevice, queueSelection);
+
+    VkPhysicalDeviceMemoryProperties2 memoryProperties2{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2,
+    };
+    vkGetPhysicalDeviceMemoryProperties2(vkPhysicalDevice, &memoryProperties2);
+    const uint32_t deviceLocalMemoryTypeIndex =
+        findMemoryTypeIndex(memoryProperties2.memoryProperties, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    const TransferContext transferContext{
+        .vkDevice = vkDevice,
+        .mQueueSelection = queueSelection,
+        .mQueues = queues,
+        .mStagingMemoryTypeIndex = findMemoryTypeIndex(memoryProperties2.memoryProperties,
+                                                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
+    };
+
+    // Each request overwrites the start of a destination buffer, whose previous content is discarded:
+    // the transfer queue writes it without acquiring it back from the graphics family (see discardBuffer()).
+    std::array<std::pair<VkBuffer, VkDeviceMemory>, gDestinationCount> destinations;
+    for(auto & destination : destinations)
+    {
+        destination = createBuffer(vkDevice, gMaxRequestSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, deviceLocalMemoryTypeIndex);
+    }
+    std::vector<std::byte> source(gMaxRequestSize);
+    std::mt19937 generator{1};
+    std::ranges::generate(source, [&generator]{ return (std::byte)generator(); });
+
+    const std::vector<VkDeviceSize> requestSizes = generateRequestSizes(totalSize);
+    // Written by the producers, 0 until the request is made
+    std::vector<std::atomic<UploadService::Ticket>> tickets(requestSizes.size());
+
+    // The render thread resources: a command buffer and a fence per frame in flight
+    VkCommandPool vkCommandPool;
+    VkCommandPoolCreateInfo commandPoolCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+        .queueFamilyIndex = queueSelection.mGraphics.mFamilyIndex,
+    };
+    assertVkSuccess(vkCreateCommandPool(vkDevice, &commandPoolCreateInfo, pAllocator, &vkCommandPool));
+    std::array<VkCommandBuffer, gFramesInFlight> vkCommandBuffers;
+    VkCommandBufferAllocateInfo commandBufferAllocateInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandPool = vkCommandPool,
+        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = gFramesInFlight,
+    };
+    assertVkSuccess(vkAllocateCommandBuffers(vkDevice, &commandBufferAllocateInfo, vkCommandBuffers.data()));
+    std::array<VkFence, gFramesInFlight> frameFences{VK_NULL_HANDLE, VK_NULL_HANDLE};
+
+    std::cout << "Uploading " << formatSize(totalSize) << " in " << requestSizes.size() << " requests ("
+              << formatSize(gMinRequestSize) << " to " << formatSize(gMaxRequestSize) << "), from "
+              << producerCount << " threads, through a " << formatSize(stagingCapacity) << " staging ring.\n";
+
+    using Clock = std::chrono::steady_clock;
+    std::optional<UploadService> uploadService;
+    uploadService.emplace(transferContext, stagingCapacity);
+    const auto start = Clock::now();
+
+    std::atomic<std::size_t> nextRequest{0};
+    std::vector<std::jthread> producers;
+    for(unsigned int producerIdx = 0; producerIdx != producerCount; ++producerIdx)
+    {
+        producers.emplace_back([&]()
+        {
+            for(std::size_t requestIdx = nextRequest++; requestIdx < requestSizes.size(); requestIdx = nextRequest++)
+            {
+                const VkBuffer destination = destinations[requestIdx % gDestinationCount].first;
+                uploadService->discardBuffer(destination);
+                tickets[requestIdx] = uploadService->uploadBuffer(
+                    destination,
+                    0,
+                    std::span{source}.first(requestSizes[requestIdx]),
+                    VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT,
+                    VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT);
+            }
+        });
+    }
+
+    // Render thread
+    std::size_t frameCount = 0;
+    Clock::duration submitTotal{0};
+    Clock::duration submitMax{0};
+    auto isDone = [&]()
+    {
+        return std::ranges::all_of(tickets, [&](const std::atomic<UploadService::Ticket> & aTicket)
+        {
+            const UploadService::Ticket ticket = aTicket.load();
+            return ticket != 0 && uploadService->isSubmitted(ticket);
+        });
+    };
+    for(bool done = false; !done; ++frameCount)
+    {
+        // Checked before submitting, so the last frame acquires the last copies
+        done = isDone();
+
+        const std::size_t frameIdx = frameCount % gFramesInFlight;
+        if(frameFences[frameIdx] != VK_NULL_HANDLE)
+        {
+            assertVkSuccess(vkWaitForFences(vkDevice, 1, &frameFences[frameIdx], VK_TRUE, UINT64_MAX));
+            vkDestroyFence(vkDevice, frameFences[frameIdx], pAllocator);
+        }
+
+        const auto submitStart = Clock::now();
+        uploadService->submit();
+        const Clock::duration submitDuration = Clock::now() - submitStart;
+        submitTotal += submitDuration;
+        submitMax = std::max(submitMax, submitDuration);
+
+        VkCommandBuffer vkCommandBuffer = vkCommandBuffers[frameIdx];
+        VkCommandBufferBeginInfo commandBufferBeginInfo{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        };
+        assertVkSuccess(vkBeginCommandBuffer(vkCommandBuffer, &commandBufferBeginInfo));
+        const uint64_t uploadWaitValue = uploadService->recordAcquireBarriers(vkCommandBuffer);
+        assertVkSuccess(vkEndCommandBuffer(vkCommandBuffer));
+
+        VkSemaphoreSubmitInfo waitSemaphoreSubmitInfo{
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+            .semaphore = uploadService->getTimelineSemaphore(),
+            .value = uploadWaitValue,
+            .stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+        };
+        VkCommandBufferSubmitInfo commandBufferSubmitInfo{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+            .commandBuffer = vkCommandBuffer,
+        };
+        VkSubmitInfo2 submitInfo2{
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+            .waitSemaphoreInfoCount = uploadWaitValue != 0 ? 1u : 0u,
+            .pWaitSemaphoreInfos = &waitSemaphoreSubmitInfo,
+            .commandBufferInfoCount = 1,
+            .pCommandBufferInfos = &commandBufferSubmitInfo,
+        };
+        frameFences[frameIdx] = createFence(vkDevice);
+        assertVkSuccess(vkQueueSubmit2(queues.mGraphics, 1, &submitInfo2, frameFences[frameIdx]));
+    }
+    assertVkSuccess(vkDeviceWaitIdle(vkDevice));
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    using Microseconds = std::chrono::duration<double, std::micro>;
+    std::cout << "Uploaded in " << seconds * 1000. << " ms: " << totalSize / seconds / (1024. * 1024. * 1024.) << " GiB/s.\n"
+              << "Render thread submit(): " << Microseconds{submitTotal}.count() / frameCount << " us average, "
+              << Microseconds{submitMax}.count() << " us max, over " << frameCount << " frames.\n";
+
+    producers.clear();
+    uploadService.reset();
+    for(VkFence fence : frameFences)
+    {
+        vkDestroyFence(vkDevice, fence, pAllocator);
+    }
+    vkDestroyCommandPool(vkDevice, vkCommandPool, pAllocator);
+    for(auto [buffer, memory] : destinations)
+    {
+        vkDestroyBuffer(vkDevice, buffer, pAllocator);
+        vkFreeMemory(vkDevice, memory, pAllocator);
+    }
+    vkDestroyDevice(vkDevice, pAllocator);
+    vkDestroyInstance(vkInstance, pAllocator);
+    return 0;
+}